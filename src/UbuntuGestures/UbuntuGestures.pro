@@ -9,6 +9,7 @@ HEADERS += \
     $$PWD/timer_p.h \
     $$PWD/timesource_p.h \
     $$PWD/touchownershipevent_p.h \
+    $$PWD/touchrecording_p.h \
     $$PWD/touchregistry_p.h \
     $$PWD/ubuntugesturesglobal.h \
     $$PWD/ubuntugesturesmodule.h \
@@ -23,6 +24,7 @@ SOURCES += \
     $$PWD/timer.cpp \
     $$PWD/timesource.cpp \
     $$PWD/touchownershipevent.cpp \
+    $$PWD/touchrecording.cpp \
     $$PWD/touchregistry.cpp \
     $$PWD/ubuntugesturesmodule.cpp \
     $$PWD/ucswipearea.cpp \
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "touchrecording_p.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtGui/QWindow>
+
+UG_NAMESPACE_BEGIN
+
+static const quint32 recordingMagic = 0x55475452;  // "UGTR"
+static const quint32 recordingVersion = 1;
+
+static const QEvent::Type eventTypes[] = {
+    QEvent::TouchBegin, QEvent::TouchUpdate, QEvent::TouchEnd, QEvent::TouchCancel
+};
+static const int eventTypeCount = sizeof(eventTypes) / sizeof(eventTypes[0]);
+
+void TouchRecording::append(const QTouchEvent *event)
+{
+    QVector<Point> points;
+    points.reserve(event->touchPoints().count());
+    Q_FOREACH(const QTouchEvent::TouchPoint &touchPoint, event->touchPoints()) {
+        points.append({touchPoint.id(), touchPoint.state(), touchPoint.pos()});
+    }
+    append(event->type(), event->timestamp(), points);
+}
+
+void TouchRecording::append(QEvent::Type type, qint64 timestamp, const QVector<Point> &points)
+{
+    m_events.append({type, timestamp, points});
+}
+
+qint64 TouchRecording::duration() const
+{
+    return m_events.isEmpty() ? 0 : m_events.last().timestamp - m_events.first().timestamp;
+}
+
+QTouchEvent *TouchRecording::createTouchEvent(int index, QTouchDevice *device,
+                                              QWindow *window) const
+{
+    const Event &event = m_events.at(index);
+    QList<QTouchEvent::TouchPoint> touchPoints;
+    Qt::TouchPointStates states = 0;
+    touchPoints.reserve(event.points.count());
+    Q_FOREACH(const Point &point, event.points) {
+        QTouchEvent::TouchPoint touchPoint(point.id);
+        touchPoint.setState(point.state);
+        touchPoint.setPos(point.pos);
+        touchPoint.setScenePos(point.pos);
+        touchPoint.setScreenPos(window ? window->mapToGlobal(point.pos.toPoint()) : point.pos);
+        touchPoints.append(touchPoint);
+        states |= point.state;
+    }
+
+    QTouchEvent *touchEvent =
+        new QTouchEvent(event.type, device, Qt::NoModifier, states, touchPoints);
+    touchEvent->setWindow(window);
+    touchEvent->setTimestamp(event.timestamp);
+    return touchEvent;
+}
+
+bool TouchRecording::save(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream << recordingMagic << recordingVersion << static_cast<quint32>(m_events.count());
+    qint64 previousTimestamp = m_events.isEmpty() ? 0 : m_events.first().timestamp;
+    Q_FOREACH(const Event &event, m_events) {
+        quint8 type = 0;
+        while (type < eventTypeCount && eventTypes[type] != event.type) {
+            type++;
+        }
+        stream << type << static_cast<quint32>(qMax(Q_INT64_C(0),
+                                                    event.timestamp - previousTimestamp))
+               << static_cast<quint8>(qMin(event.points.count(), 255));
+        for (int i = 0; i < qMin(event.points.count(), 255); i++) {
+            const Point &point = event.points.at(i);
+            stream << static_cast<qint32>(point.id) << static_cast<quint8>(point.state)
+                   << static_cast<float>(point.pos.x()) << static_cast<float>(point.pos.y());
+        }
+        previousTimestamp = event.timestamp;
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+bool TouchRecording::load(const QString &fileName)
+{
+    m_events.clear();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != recordingMagic
+        || version != recordingVersion) {
+        return false;
+    }
+
+    // The timestamps of a loaded recording start at 0.
+    qint64 timestamp = 0;
+    m_events.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        quint8 type, pointCount;
+        quint32 delta;
+        stream >> type >> delta >> pointCount;
+        if (type >= eventTypeCount) {
+            m_events.clear();
+            return false;
+        }
+        timestamp += delta;
+        Event event = {eventTypes[type], timestamp, QVector<Point>(pointCount)};
+        for (int j = 0; j < pointCount; j++) {
+            qint32 id;
+            quint8 state;
+            float x, y;
+            stream >> id >> state >> x >> y;
+            event.points[j] = {id, static_cast<Qt::TouchPointState>(state), QPointF(x, y)};
+        }
+        m_events.append(event);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        m_events.clear();
+        return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////// TouchRecorder ///////////////////////////////////////////
+
+TouchRecorder::TouchRecorder(const QString &fileName, QObject *parent)
+    : QObject(parent)
+    , m_fileName(fileName)
+{
+}
+
+TouchRecorder::~TouchRecorder()
+{
+    if (m_recording.count() > 0 && !m_recording.save(m_fileName)) {
+        qWarning("TouchRecorder: can't save the touch recording to '%s'", qPrintable(m_fileName));
+    }
+}
+
+// static
+void TouchRecorder::installFromEnvironment(QWindow *window)
+{
+    static const QString fileName =
+        QString::fromLocal8Bit(qgetenv("UBUNTU_GESTURES_TOUCH_RECORDING"));
+    static int windowCount = 0;
+    if (fileName.isEmpty() || window->findChild<TouchRecorder*>(QString(),
+                                                                 Qt::FindDirectChildrenOnly)) {
+        return;
+    }
+
+    // Windows after the first one get a numbered file.
+    const QString windowFileName =
+        windowCount > 0 ? fileName + QStringLiteral(".%1").arg(windowCount) : fileName;
+    windowCount++;
+    window->installEventFilter(new TouchRecorder(windowFileName, window));
+}
+
+bool TouchRecorder::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_UNUSED(watched);
+
+    switch (event->type()) {
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    case QEvent::TouchCancel:
+        m_recording.append(static_cast<QTouchEvent*>(event));
+        break;
+    default:
+        break;
+    }
+
+    // Just monitoring.
+    return false;
+}
+
+UG_NAMESPACE_END
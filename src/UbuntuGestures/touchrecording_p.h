@@ -0,0 +1,95 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOUCHRECORDING_P_H
+#define TOUCHRECORDING_P_H
+
+#include <QtCore/QObject>
+#include <QtCore/QPointF>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QTouchEvent>
+
+#include <UbuntuGestures/ubuntugesturesglobal.h>
+
+class QWindow;
+
+UG_NAMESPACE_BEGIN
+
+/*
+  A stream of touch events in window coordinates, as needed to replay gestures deterministically.
+
+  The file format is compact: after a header, each event takes 6 bytes plus 13 bytes per touch
+  point. Timestamps are stored as deltas to the previous event.
+ */
+class UBUNTUGESTURES_EXPORT TouchRecording
+{
+public:
+    struct Point {
+        int id;
+        Qt::TouchPointState state;
+        QPointF pos;
+    };
+    struct Event {
+        QEvent::Type type;
+        qint64 timestamp;  // In milliseconds.
+        QVector<Point> points;
+    };
+
+    void append(const QTouchEvent *event);
+    void append(QEvent::Type type, qint64 timestamp, const QVector<Point> &points);
+    void clear() { m_events.clear(); }
+
+    int count() const { return m_events.count(); }
+    const Event &at(int index) const { return m_events.at(index); }
+    qint64 duration() const;
+
+    // Creates the QTouchEvent at the given index, to be sent to the given window.
+    QTouchEvent *createTouchEvent(int index, QTouchDevice *device, QWindow *window) const;
+
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+private:
+    QVector<Event> m_events;
+};
+
+/*
+  Records the touch events received by a window. Recording is enabled for the windows of all
+  the SwipeAreas by setting UBUNTU_GESTURES_TOUCH_RECORDING to the name of the file to write, the
+  recording is saved when the window is destroyed.
+ */
+class UBUNTUGESTURES_EXPORT TouchRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    TouchRecorder(const QString &fileName, QObject *parent = nullptr);
+    ~TouchRecorder();
+
+    // Installs a recorder on the given window if requested by the environment and not done yet.
+    static void installFromEnvironment(QWindow *window);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    const TouchRecording &recording() const { return m_recording; }
+
+private:
+    TouchRecording m_recording;
+    QString m_fileName;
+};
+
+UG_NAMESPACE_END
+
+#endif // TOUCHRECORDING_P_H
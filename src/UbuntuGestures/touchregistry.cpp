@@ -18,6 +18,7 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
+#include <algorithm>
 #include <QtQuick/private/qquickitem_p.h>
 
 #include "candidateinactivitytimer_p.h"
@@ -86,40 +87,39 @@ void TouchRegistry::update(const QTouchEvent *event)
 
 void TouchRegistry::deliverTouchUpdatesToUndecidedCandidatesAndWatchers(const QTouchEvent *event)
 {
-    // TODO: Look into how we could optimize this whole thing.
-    //       Although it's not really a problem as we should have at most two candidates
-    //       for each point and there should not be many active points at any given moment.
-    //       But having three nested for-loops does scare.
-
     const QList<QTouchEvent::TouchPoint> &updatedTouchPoints = event->touchPoints();
 
-    // Maps an item to the touches in this event he should be informed about.
+    // Lists the items along with the touches in this event they should be informed about.
     // E.g.: a QTouchEvent might have three touches but a given item might be interested in only
     // one of them. So he will get a UnownedTouchEvent from this QTouchEvent containing only that
     // touch point.
-    QHash<QQuickItem*, QList<int>> touchIdsForItems;
+    // An item could update the registry from its event handler, a nested dispatch gets its own
+    // table so that the outer one isn't invalidated.
+    QVector<DispatchEntry> nestedDispatchTable;
+    QVector<DispatchEntry> &dispatchTable =
+        m_inDispatchLoop ? nestedDispatchTable : m_dispatchTable;
+    dispatchTable.clear();
 
-    // Build touchIdsForItems
     m_touchInfoPool.forEach([&](Pool<TouchInfo>::Iterator &touchInfo) {
-        if (touchInfo->isOwned() && touchInfo->watchers.isEmpty())
+        const bool owned = touchInfo->isOwned();
+        if (owned && touchInfo->watchers.isEmpty())
             return true;
 
         for (int j = 0; j < updatedTouchPoints.count(); ++j) {
             if (updatedTouchPoints[j].id() == touchInfo->id) {
-                if (!touchInfo->isOwned()) {
-                    for (int i = 0; i < touchInfo->candidates.count(); ++i) {
-                        CandidateInfo &candidate = touchInfo->candidates[i];
-                        Q_ASSERT(!candidate.item.isNull());
-                        if (candidate.state != CandidateInfo::InterimOwner) {
-                            touchIdsForItems[candidate.item.data()].append(touchInfo->id);
+                if (!owned) {
+                    for (int i = 0; i < touchInfo->candidateCount(); ++i) {
+                        Q_ASSERT(!touchInfo->candidateItems[i].isNull());
+                        if (touchInfo->candidateStates[i] != CandidateInfo::InterimOwner) {
+                            dispatchTable.append({touchInfo->candidateItems[i].data(),
+                                                  touchInfo->id});
                         }
                     }
                 }
 
-                const QList<QPointer<QQuickItem>> &watchers = touchInfo->watchers;
-                for (int i = 0; i < watchers.count(); ++i) {
-                    if (!watchers[i].isNull()) {
-                        touchIdsForItems[watchers[i].data()].append(touchInfo->id);
+                for (int i = 0; i < touchInfo->watchers.count(); ++i) {
+                    if (!touchInfo->watchers[i].isNull()) {
+                        dispatchTable.append({touchInfo->watchers[i].data(), touchInfo->id});
                     }
                 }
 
@@ -130,17 +130,27 @@ void TouchRegistry::deliverTouchUpdatesToUndecidedCandidatesAndWatchers(const QT
         return true;
     });
 
+    // Group the touches per item, the table is small so a quadratic scan beats hashing. Entries
+    // are cleared once their item has been served.
     // TODO: Consider what happens if an item calls any of TouchRegistry's public methods
     // from the event handler callback.
+    const bool wasInDispatchLoop = m_inDispatchLoop;
     m_inDispatchLoop = true;
-    auto it = touchIdsForItems.constBegin();
-    while (it != touchIdsForItems.constEnd()) {
-        QQuickItem *item = it.key();
-        const QList<int> &touchIds = it.value();
-        dispatchPointsToItem(event, touchIds, item);
-        ++it;
-    };
-    m_inDispatchLoop = false;
+    QVarLengthArray<int, 16> touchIds;
+    for (int i = 0; i < dispatchTable.count(); ++i) {
+        QQuickItem *item = dispatchTable[i].item;
+        if (!item)
+            continue;
+        touchIds.clear();
+        for (int j = i; j < dispatchTable.count(); ++j) {
+            if (dispatchTable[j].item == item) {
+                touchIds.append(dispatchTable[j].touchId);
+                dispatchTable[j].item = nullptr;
+            }
+        }
+        dispatchPointsToItem(event, touchIds.constData(), touchIds.count(), item);
+    }
+    m_inDispatchLoop = wasInDispatchLoop;
 }
 
 void TouchRegistry::freeEndedTouchInfos()
@@ -156,12 +166,15 @@ void TouchRegistry::freeEndedTouchInfos()
 /*
    Extracts the touches with the given touchIds from event and send them in a
    UnownedTouchEvent to the given item
+
+   The touch points are copied into m_touchPoints, whose elements and capacity are kept across
+   items and updates, and the event for the item lives on the stack.
  */
-void TouchRegistry::dispatchPointsToItem(const QTouchEvent *event, const QList<int> &touchIds,
-        QQuickItem *item)
+void TouchRegistry::dispatchPointsToItem(const QTouchEvent *event, const int *touchIds,
+        int touchIdCount, QQuickItem *item)
 {
     Qt::TouchPointStates touchPointStates = 0;
-    QList<QTouchEvent::TouchPoint> touchPoints;
+    int touchPointCount = 0;
 
     const QList<QTouchEvent::TouchPoint> &allTouchPoints = event->touchPoints();
 
@@ -170,8 +183,14 @@ void TouchRegistry::dispatchPointsToItem(const QTouchEvent *event, const QList<i
 
     for (int i = 0; i < allTouchPoints.count(); ++i) {
         const QTouchEvent::TouchPoint &originalTouchPoint = allTouchPoints[i];
-        if (touchIds.contains(originalTouchPoint.id())) {
-            QTouchEvent::TouchPoint touchPoint = originalTouchPoint;
+        if (std::find(touchIds, touchIds + touchIdCount, originalTouchPoint.id())
+                != touchIds + touchIdCount) {
+            if (touchPointCount < m_touchPoints.count()) {
+                m_touchPoints[touchPointCount] = originalTouchPoint;
+            } else {
+                m_touchPoints.append(originalTouchPoint);
+            }
+            QTouchEvent::TouchPoint &touchPoint = m_touchPoints[touchPointCount++];
 
             translateTouchPointFromScreenToWindowCoords(touchPoint);
 
@@ -181,23 +200,21 @@ void TouchRegistry::dispatchPointsToItem(const QTouchEvent *event, const QList<i
             touchPoint.setLastPos(windowToCandidateTransform.map(touchPoint.lastScenePos()));
             touchPoint.setVelocity(windowToCandidateMatrix.mapVector(touchPoint.velocity()).toVector2D());
 
-            touchPoints.append(touchPoint);
             touchPointStates |= touchPoint.state();
         }
     }
+    // erase() keeps the capacity, unlike clear()
+    m_touchPoints.erase(m_touchPoints.begin() + touchPointCount, m_touchPoints.end());
 
-    QTouchEvent *eventForItem = new QTouchEvent(event->type(),
-                                                event->device(),
-                                                event->modifiers(),
-                                                touchPointStates,
-                                                touchPoints);
-    eventForItem->setWindow(event->window());
-    eventForItem->setTimestamp(event->timestamp());
-    eventForItem->setTarget(event->target());
+    QTouchEvent eventForItem(event->type(), event->device(), event->modifiers(),
+                             touchPointStates, m_touchPoints);
+    eventForItem.setWindow(event->window());
+    eventForItem.setTimestamp(event->timestamp());
+    eventForItem.setTarget(event->target());
 
-    UnownedTouchEvent unownedTouchEvent(eventForItem);
+    UnownedTouchEvent unownedTouchEvent(&eventForItem);
 
-    UG_DEBUG << "Sending unowned" << qPrintable(touchEventToString(eventForItem))
+    UG_DEBUG << "Sending unowned" << qPrintable(touchEventToString(&eventForItem))
         << "to" << item;
 
     QCoreApplication::sendEvent(item, &unownedTouchEvent);
@@ -252,16 +269,12 @@ void TouchRegistry::addCandidateOwnerForTouch(int id, QQuickItem *candidate)
 
     // TODO: Check if candidate already exists
 
-    CandidateInfo candidateInfo;
-    candidateInfo.state = CandidateInfo::Undecided;
-    candidateInfo.item = candidate;
-    candidateInfo.inactivityTimer = new CandidateInactivityTimer(id, candidate,
-                                                                 m_timerFactory->createTimer(),
-                                                                 this);
-    connect(candidateInfo.inactivityTimer.data(), &CandidateInactivityTimer::candidateDefaulted,
+    CandidateInactivityTimer *inactivityTimer =
+        new CandidateInactivityTimer(id, candidate, m_timerFactory->createTimer(), this);
+    connect(inactivityTimer, &CandidateInactivityTimer::candidateDefaulted,
             this, &TouchRegistry::rejectCandidateOwnerForTouch);
 
-    touchInfo->candidates.append(candidateInfo);
+    touchInfo->appendCandidate(CandidateInfo::Undecided, candidate, inactivityTimer);
 
     connect(candidate, &QObject::destroyed, this, [=](){ pruneNullCandidatesForTouch(id); });
 }
@@ -293,12 +306,9 @@ void TouchRegistry::removeCandidateOwnerForTouch(int id, QQuickItem *candidate)
 
     // TODO: check if the candidate is in fact the owner of the touch
 
-    bool removed = false;
-    for (int i = 0; i < touchInfo->candidates.count() && !removed; ++i) {
-        if (touchInfo->candidates[i].item == candidate) {
-            removeCandidateOwnerForTouchByIndex(touchInfo, i);
-            removed = true;
-        }
+    const int candidateIndex = touchInfo->indexOfCandidate(candidate);
+    if (candidateIndex >= 0) {
+        removeCandidateOwnerForTouchByIndex(touchInfo, candidateIndex);
     }
 }
 
@@ -313,8 +323,8 @@ void TouchRegistry::pruneNullCandidatesForTouch(int touchId)
     }
 
     int i = 0;
-    while (i < touchInfo->candidates.count()) {
-        if (touchInfo->candidates[i].item.isNull()) {
+    while (i < touchInfo->candidateCount()) {
+        if (touchInfo->candidateItems[i].isNull()) {
             removeCandidateOwnerForTouchByIndex(touchInfo, i);
         } else {
             ++i;
@@ -327,9 +337,9 @@ void TouchRegistry::removeCandidateOwnerForTouchByIndex(Pool<TouchRegistry::Touc
 {
     // TODO: check if the candidate is in fact the owner of the touch
 
-    Q_ASSERT(candidateIndex < touchInfo->candidates.count());
+    Q_ASSERT(candidateIndex < touchInfo->candidateCount());
 
-    if (candidateIndex == 0 && touchInfo->candidates[candidateIndex].state != CandidateInfo::Undecided) {
+    if (candidateIndex == 0 && touchInfo->candidateStates[candidateIndex] != CandidateInfo::Undecided) {
         qCritical("TouchRegistry: touch owner is being removed.");
     }
     removeCandidateHelper(touchInfo, candidateIndex);
@@ -359,27 +369,18 @@ void TouchRegistry::requestTouchOwnership(int id, QQuickItem *candidate)
 
     Q_ASSERT(!touchInfo->isOwned());
 
-    int candidateIndex = -1;
-    for (int i = 0; i < touchInfo->candidates.count(); ++i) {
-        CandidateInfo &candidateInfo = touchInfo->candidates[i];
-        if (candidateInfo.item == candidate) {
-            candidateInfo.state = CandidateInfo::Requested;
-            delete candidateInfo.inactivityTimer;
-            candidateInfo.inactivityTimer = nullptr;
-            candidateIndex = i;
-            break;
-        }
+    int candidateIndex = touchInfo->indexOfCandidate(candidate);
+    if (candidateIndex >= 0) {
+        touchInfo->candidateStates[candidateIndex] = CandidateInfo::Requested;
+        delete touchInfo->candidateInactivityTimers[candidateIndex];
+        touchInfo->candidateInactivityTimers[candidateIndex] = nullptr;
     }
 
     // add it as a candidate if not present yet
     if (candidateIndex < 0) {
-        CandidateInfo candidateInfo;
-        candidateInfo.state = CandidateInfo::InterimOwner;
-        candidateInfo.item = candidate;
-        candidateInfo.inactivityTimer = nullptr;
-        touchInfo->candidates.append(candidateInfo);
+        touchInfo->appendCandidate(CandidateInfo::InterimOwner, candidate, nullptr);
         // it's the last one
-        candidateIndex = touchInfo->candidates.count() - 1;
+        candidateIndex = touchInfo->candidateCount() - 1;
         connect(candidate, &QObject::destroyed, this, [=](){ pruneNullCandidatesForTouch(id); });
     }
 
@@ -424,11 +425,11 @@ void TouchRegistry::rejectCandidateOwnerForTouch(int id, QQuickItem *candidate)
     int rejectedCandidateIndex = -1;
 
     // Check if the given candidate is valid and still undecided
-    for (int i = 0; i < touchInfo->candidates.count() && rejectedCandidateIndex == -1; ++i) {
-        CandidateInfo &candidateInfo = touchInfo->candidates[i];
-        if (candidateInfo.item == candidate) {
-            Q_ASSERT(i > 0 || candidateInfo.state == CandidateInfo::Undecided);
-            if (i == 0 && candidateInfo.state != CandidateInfo::Undecided) {
+    for (int i = 0; i < touchInfo->candidateCount() && rejectedCandidateIndex == -1; ++i) {
+        if (touchInfo->candidateItems[i] == candidate) {
+            const CandidateInfo::State state = touchInfo->candidateStates[i];
+            Q_ASSERT(i > 0 || state == CandidateInfo::Undecided);
+            if (i == 0 && state != CandidateInfo::Undecided) {
                 qCritical() << "TouchRegistry: Can't reject item (" << (void*)candidate
                     << ") as it already owns touch" << id;
                 return;
@@ -441,7 +442,7 @@ void TouchRegistry::rejectCandidateOwnerForTouch(int id, QQuickItem *candidate)
 
     // If we reached this point it's because the given candidate exists and is indeed undecided.
 
-    Q_ASSERT(rejectedCandidateIndex >= 0 && rejectedCandidateIndex < touchInfo->candidates.size());
+    Q_ASSERT(rejectedCandidateIndex >= 0 && rejectedCandidateIndex < touchInfo->candidateCount());
 
     {
         TouchOwnershipEvent lostOwnershipEvent(id, false /*gained*/);
@@ -461,17 +462,14 @@ void TouchRegistry::rejectCandidateOwnerForTouch(int id, QQuickItem *candidate)
 
 void TouchRegistry::removeCandidateHelper(Pool<TouchInfo>::Iterator &touchInfo, int candidateIndex)
 {
-    {
-        CandidateInfo &candidateInfo = touchInfo->candidates[candidateIndex];
-
-        delete candidateInfo.inactivityTimer;
-        candidateInfo.inactivityTimer = nullptr;
+    delete touchInfo->candidateInactivityTimers[candidateIndex];
+    touchInfo->candidateInactivityTimers[candidateIndex] = nullptr;
 
-        if (candidateInfo.item) {
-            disconnect(candidateInfo.item.data(), nullptr, this, nullptr);
-        }
+    QQuickItem *item = touchInfo->candidateItems[candidateIndex].data();
+    if (item) {
+        disconnect(item, nullptr, this, nullptr);
     }
-    touchInfo->candidates.removeAt(candidateIndex);
+    touchInfo->removeCandidateAt(candidateIndex);
 }
 
 ////////////////////////////////////// TouchRegistry::TouchInfo ////////////////////////////////////
@@ -485,10 +483,9 @@ void TouchRegistry::TouchInfo::reset()
 {
     id = -1;
 
-    for (int i = 0; i < candidates.count(); ++i) {
-        CandidateInfo &candidate = candidates[i];
-        delete candidate.inactivityTimer;
-        candidate.inactivityTimer.clear(); // shoundn't be needed but anyway...
+    for (int i = 0; i < candidateInactivityTimers.count(); ++i) {
+        delete candidateInactivityTimers[i];
+        candidateInactivityTimers[i].clear(); // shoundn't be needed but anyway...
     }
 }
 
@@ -496,19 +493,46 @@ void TouchRegistry::TouchInfo::init(int id)
 {
     this->id = id;
     physicallyEnded = false;
-    candidates.clear();
+    candidateStates.clear();
+    candidateItems.clear();
+    candidateInactivityTimers.clear();
     watchers.clear();
 }
 
 bool TouchRegistry::TouchInfo::isOwned() const
 {
-    return !candidates.isEmpty() && candidates.first().state != CandidateInfo::Undecided;
+    return !candidateStates.isEmpty() && candidateStates.first() != CandidateInfo::Undecided;
 }
 
 bool TouchRegistry::TouchInfo::ended() const
 {
     Q_ASSERT(isValid());
-    return physicallyEnded && (isOwned() || candidates.isEmpty());
+    return physicallyEnded && (isOwned() || candidateStates.isEmpty());
+}
+
+int TouchRegistry::TouchInfo::indexOfCandidate(const QQuickItem *item) const
+{
+    for (int i = 0; i < candidateItems.count(); ++i) {
+        if (candidateItems[i] == item) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TouchRegistry::TouchInfo::appendCandidate(CandidateInfo::State state, QQuickItem *item,
+                                               CandidateInactivityTimer *inactivityTimer)
+{
+    candidateStates.append(state);
+    candidateItems.append(item);
+    candidateInactivityTimers.append(inactivityTimer);
+}
+
+void TouchRegistry::TouchInfo::removeCandidateAt(int index)
+{
+    candidateStates.remove(index);
+    candidateItems.remove(index);
+    candidateInactivityTimers.remove(index);
 }
 
 void TouchRegistry::TouchInfo::notifyCandidatesOfOwnershipResolution()
@@ -516,14 +540,11 @@ void TouchRegistry::TouchInfo::notifyCandidatesOfOwnershipResolution()
     Q_ASSERT(isOwned());
 
     UG_DEBUG << "sending TouchOwnershipEvent(id =" << id
-        << " gained) to candidate" << candidates[0].item;
+        << " gained) to candidate" << candidateItems[0];
 
     // need to take a copy of the item list in case
     // we call back in to remove candidate during the lost ownership event.
-    QList<QPointer<QQuickItem>> items;
-    Q_FOREACH(const CandidateInfo& info, candidates) {
-        items << info.item;
-    }
+    const QVarLengthArray<QPointer<QQuickItem>, inlineCandidateCount> items(candidateItems);
 
     TouchOwnershipEvent gainedOwnershipEvent(id, true /*gained*/);
     QCoreApplication::sendEvent(items[0], &gainedOwnershipEvent);
@@ -20,6 +20,7 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
+#include <QtCore/QVarLengthArray>
 #include <QtCore/QVector>
 #include <QtGui/QTouchEvent>
 #include <QtQuick/QQuickItem>
@@ -138,7 +139,7 @@ private:
 
     class CandidateInfo {
     public:
-        enum {
+        enum State {
             // A candidate owner that doesn't yet know for sure whether he wants the touch point
             // (gesture recognition is stilll going on)
             Undecided = 0,
@@ -150,11 +151,14 @@ private:
             // It wants to keep its touch ownership but hasn't been granted it by TouchRegistry
             // yet because of undecided candidates higher up.
             InterimOwner = 2
-        } state;
-        QPointer<QQuickItem> item;
-        QPointer<UG_PREPEND_NAMESPACE(CandidateInactivityTimer)> inactivityTimer;
+        };
     };
 
+    // Number of candidates and watchers per touch stored without allocating. There's rarely
+    // more than two or three of them, more are spilled to the heap.
+    static const int inlineCandidateCount = 4;
+    static const int inlineWatcherCount = 4;
+
     class TouchInfo {
     public:
         TouchInfo() : id(-1), physicallyEnded(false) {}
@@ -168,9 +172,26 @@ private:
         bool ended() const;
         void notifyCandidatesOfOwnershipResolution();
 
-        // TODO optimize storage (s/QList/Pool)
-        QList<CandidateInfo> candidates;
-        QList<QPointer<QQuickItem>> watchers;
+        int candidateCount() const { return candidateItems.count(); }
+        int indexOfCandidate(const QQuickItem *item) const;
+        void appendCandidate(CandidateInfo::State state, QQuickItem *item,
+                             UG_PREPEND_NAMESPACE(CandidateInactivityTimer) *inactivityTimer);
+        void removeCandidateAt(int index);
+
+        // Candidates ordered by priority, stored as parallel arrays so that the dispatch loop
+        // only touches the states and items.
+        QVarLengthArray<CandidateInfo::State, inlineCandidateCount> candidateStates;
+        QVarLengthArray<QPointer<QQuickItem>, inlineCandidateCount> candidateItems;
+        QVarLengthArray<QPointer<UG_PREPEND_NAMESPACE(CandidateInactivityTimer)>,
+                        inlineCandidateCount> candidateInactivityTimers;
+        QVarLengthArray<QPointer<QQuickItem>, inlineWatcherCount> watchers;
+    };
+
+    // An item along with a touch from the event being dispatched that he should be informed
+    // about.
+    struct DispatchEntry {
+        QQuickItem *item;
+        int touchId;
     };
 
     void pruneNullCandidatesForTouch(int touchId);
@@ -183,12 +204,16 @@ private:
 
     static void translateTouchPointFromScreenToWindowCoords(QTouchEvent::TouchPoint &touchPoint);
 
-    static void dispatchPointsToItem(const QTouchEvent *event, const QList<int> &touchIds,
-                                     QQuickItem *item);
+    void dispatchPointsToItem(const QTouchEvent *event, const int *touchIds,
+                              int touchIdCount, QQuickItem *item);
     void freeEndedTouchInfos();
 
     Pool<TouchInfo> m_touchInfoPool;
 
+    // Reused across touch updates, the capacity is kept once reached.
+    QVector<DispatchEntry> m_dispatchTable;
+    QList<QTouchEvent::TouchPoint> m_touchPoints;
+
     // the singleton instance
     static TouchRegistry *m_instance;
 
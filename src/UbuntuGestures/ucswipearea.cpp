@@ -23,6 +23,7 @@
 #include <QtQuick/private/qquickwindow_p.h>
 
 #include "touchownershipevent_p.h"
+#include "touchrecording_p.h"
 #include "touchregistry_p.h"
 #include "unownedtouchevent_p.h"
 
@@ -853,6 +854,7 @@ void UCSwipeArea::itemChange(ItemChange change, const ItemChangeData &value)
     if (change == QQuickItem::ItemSceneChange) {
         if (value.window != nullptr) {
             value.window->installEventFilter(TouchRegistry::instance());
+            TouchRecorder::installFromEnvironment(value.window);
 
             // FIXME: Handle window->screen() changes (ie window changing screens)
             Q_D(UCSwipeArea);
@@ -37,7 +37,7 @@ QEvent::Type UnownedTouchEvent::unownedTouchEventType()
 
 QTouchEvent *UnownedTouchEvent::touchEvent()
 {
-    return m_touchEvent.data();
+    return m_touchEvent;
 }
 
 UG_NAMESPACE_END
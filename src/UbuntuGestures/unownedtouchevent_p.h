@@ -17,7 +17,6 @@
 #ifndef UNOWNEDTOUCHEVENT_P_H
 #define UNOWNEDTOUCHEVENT_P_H
 
-#include <QtCore/QScopedPointer>
 #include <QtGui/QTouchEvent>
 
 #include <UbuntuGestures/ubuntugesturesglobal.h>
@@ -26,6 +25,8 @@ UG_NAMESPACE_BEGIN
 /*
  A touch event with touch points that do not belong the item receiving it.
 
+ The touch event is not owned and must outlive the UnownedTouchEvent.
+
  See TouchRegistry::addCandidateOwnerForTouch and TouchRegistry::addTouchWatcher
  */
 class UBUNTUGESTURES_EXPORT UnownedTouchEvent : public QEvent
@@ -41,7 +42,7 @@ public:
 
 private:
     static Type m_unownedTouchEventType;
-    QScopedPointer<QTouchEvent> m_touchEvent;
+    QTouchEvent *m_touchEvent;
 };
 
 UG_NAMESPACE_END
@@ -25,18 +25,30 @@
 //     that's not monitored because the max count was reached, enable monitoring
 //     on it if possible.
 
-const int logQueueSize = 16;
 const int logQueueAlignment = 64;
+const int logBatchSize = 16;
+// Time in milliseconds the logging thread sleeps when the log queue is empty.
+const unsigned long logFlushInterval = 100;
 
-LoggingThread::LoggingThread()
+LoggingThread::LoggingThread(int capacity, QAtomicInteger<quint32>* droppedCount)
     : m_loggerCount(0)
     , m_refCount(1)
-    , m_queueIndex(0)
-    , m_queueSize(0)
+    , m_droppedCount(droppedCount)
+    , m_waiting(0)
+    , m_tail(0)
+    , m_head(0)
+    , m_mask(capacity - 1)
+    , m_wakeMask(qMax(1, capacity / 4) - 1)
     , m_flags(0)
 {
-    m_queue = static_cast<UMEvent*>(
-        alignedAlloc(logQueueAlignment, logQueueSize * sizeof(UMEvent)));
+    DASSERT(IS_POWER_OF_TWO(capacity));
+    DASSERT(capacity >= UMApplicationMonitorPrivate::minLogQueueCapacity);
+    DASSERT(droppedCount);
+
+    m_queue = static_cast<Slot*>(alignedAlloc(logQueueAlignment, capacity * sizeof(Slot)));
+    for (int i = 0; i < capacity; ++i) {
+        new (&m_queue[i].sequence) QAtomicInteger<quint32>(i);
+    }
 
 #if !defined(QT_NO_DEBUG)
     setObjectName(QStringLiteral("UbuntuMetrics logging"));  // Thread name.
@@ -48,76 +60,116 @@ LoggingThread::~LoggingThread()
 {
     m_mutex.lock();
     m_flags |= JoinRequested;
-    if (m_flags & Waiting) {
-        m_condition.wakeOne();
-    }
+    m_condition.wakeOne();
     m_mutex.unlock();
     wait();
 
     free(m_queue);
 }
 
-#define BREAK_ON_JOIN_REQUEST()                \
-    if (Q_UNLIKELY(m_flags & JoinRequested)) { \
-        m_mutex.unlock();                      \
-        break;                                 \
+// Whether there's no event ready to be consumed at the head of the queue.
+bool LoggingThread::isEmpty()
+{
+    return m_queue[m_head & m_mask].sequence.loadAcquire() != m_head + 1;
+}
+
+// Unqueues at most maxCount events from the head of the queue and releases the
+// slots to the producers. Returns the number of events unqueued.
+int LoggingThread::drain(UMEvent* events, int maxCount)
+{
+    int count = 0;
+    while (count < maxCount) {
+        Slot* slot = &m_queue[m_head & m_mask];
+        if (slot->sequence.loadAcquire() != m_head + 1) {
+            break;
+        }
+        memcpy(&events[count++], &slot->event, sizeof(UMEvent));
+        slot->sequence.storeRelease(m_head + m_mask + 1);
+        m_head++;
     }
+    return count;
+}
 
 // Logging thread entry point.
 void LoggingThread::run()
 {
     DLOG("Entering logging thread.");
+    alignas(logQueueAlignment) UMEvent events[logBatchSize];
     while (true) {
-        // Wait for new events in the log queue.
-        m_mutex.lock();
-        DASSERT(m_queueSize >= 0);
-        if (m_queueSize == 0) {
-            BREAK_ON_JOIN_REQUEST();
-            m_flags |= Waiting;
-            m_condition.wait(&m_mutex);
-            if (m_queueSize == 0) {
-                BREAK_ON_JOIN_REQUEST();
+        // Wait for new events in the log queue. Producers only wake up the
+        // thread once a batch of events is queued, the events pushed in between
+        // are picked up after the flush interval. The waiting flag is set with
+        // the lock held so that a producer claiming it can't wake up before
+        // the wait.
+        if (isEmpty()) {
+            m_mutex.lock();
+            m_waiting.fetchAndStoreOrdered(1);
+            if (isEmpty() && !(m_flags & JoinRequested)) {
+                m_condition.wait(&m_mutex, logFlushInterval);
             }
-            m_flags &= ~Waiting;
+            m_waiting.storeRelease(0);
+            if (Q_UNLIKELY(m_flags & JoinRequested) && isEmpty()) {
+                m_mutex.unlock();
+                break;
+            }
+            m_mutex.unlock();
         }
 
-        // Unqueue oldest events from the log queue.
-        DASSERT(m_queueSize > 0);
-        UMEvent event;
-        memcpy(&event, &m_queue[m_queueIndex], sizeof(UMEvent));
-        m_queueIndex = (m_queueIndex + 1) % logQueueSize;
-        m_queueSize--;
+        // Unqueue a batch of the oldest events from the log queue.
+        const int count = drain(events, logBatchSize);
 
-        // Log.
+        // Log the batch.
+        m_mutex.lock();
         const int loggerCount = m_loggerCount;
         UMLogger* loggers[UMApplicationMonitorPrivate::maxLoggers];
         memcpy(loggers, m_loggers, loggerCount * sizeof(UMLogger*));
         m_mutex.unlock();
         for (int i = 0; i < loggerCount; ++i) {
-            loggers[i]->log(event);
+            for (int j = 0; j < count; ++j) {
+                loggers[i]->log(events[j]);
+            }
         }
     }
     DLOG("Leaving logging thread.");
 }
 
-void LoggingThread::push(const UMEvent* event)
+// Pushes an event to the log queue. Lock-free, the slot reservation retries when
+// other producers win the race, and the lock is only taken by the producer
+// waking up the sleeping consumer once per batch of events. Returns false if the
+// event has been dropped because the log queue is full.
+bool LoggingThread::push(const UMEvent* event)
 {
-    // Ensure the log queue is not full.
-    m_mutex.lock();
-    DASSERT(m_queueSize <= logQueueSize);
-    while (m_queueSize == logQueueSize) {
-        m_mutex.unlock();
-        QThread::yieldCurrentThread();
-        m_mutex.lock();
+    // Reserve a slot.
+    quint32 tail = m_tail.loadAcquire();
+    Slot* slot;
+    while (true) {
+        slot = &m_queue[tail & m_mask];
+        const qint32 difference =
+            static_cast<qint32>(slot->sequence.loadAcquire() - tail);
+        if (difference == 0) {
+            if (m_tail.testAndSetOrdered(tail, tail + 1, tail)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Full, the consumer still hasn't released that slot.
+            m_droppedCount->fetchAndAddRelaxed(1);
+            return false;
+        } else {
+            tail = m_tail.loadAcquire();
+        }
     }
 
-    // Push event to the log queue.
-    DASSERT(m_queueSize < logQueueSize);
-    memcpy(&m_queue[(m_queueIndex + m_queueSize++) % logQueueSize], event, sizeof(UMEvent));
-    if (m_flags & Waiting) {
+    // Publish the event and wake up the consumer at the end of a batch, the
+    // producer resetting the waiting flag is the only one taking the lock.
+    memcpy(&slot->event, event, sizeof(UMEvent));
+    slot->sequence.fetchAndStoreOrdered(tail + 1);
+    if (((tail + 1) & m_wakeMask) == 0 && m_waiting.loadAcquire()
+        && m_waiting.testAndSetOrdered(1, 0)) {
+        m_mutex.lock();
         m_condition.wakeOne();
+        m_mutex.unlock();
     }
-    m_mutex.unlock();
+    return true;
 }
 
 void LoggingThread::setLoggers(UMLogger** loggers, int count)
@@ -165,6 +217,9 @@ UMApplicationMonitorPrivate::UMApplicationMonitorPrivate(UMApplicationMonitor* a
     , m_loggingThread(nullptr)
     , m_monitorCount(0)
     , m_loggerCount(0)
+    , m_logQueueCapacity(defaultLogQueueCapacity)
+    , m_droppedEventCount(0)
+    , m_statisticsPeriod(defaultStatisticsPeriod)
     , m_updateInterval{1000, -1, -1}
     , m_flags(UMApplicationMonitor::AllEvents)
 {
@@ -282,7 +337,7 @@ void UMApplicationMonitorPrivate::start()
     DASSERT(!(m_flags & Started));
     DASSERT(!m_loggingThread);
 
-    m_loggingThread = new LoggingThread;
+    m_loggingThread = new LoggingThread(m_logQueueCapacity, &m_droppedEventCount);
     m_loggingThread->setLoggers(m_loggers, m_loggerCount);
 
     QWindowList windows = QGuiApplication::allWindows();
@@ -550,6 +605,56 @@ void UMApplicationMonitor::clearLoggers(bool free)
     }
 }
 
+void UMApplicationMonitor::setLogQueueCapacity(int capacity)
+{
+    Q_D(UMApplicationMonitor);
+
+    // Round up to the next power-of-two.
+    capacity = qBound(UMApplicationMonitorPrivate::minLogQueueCapacity, capacity,
+                      UMApplicationMonitorPrivate::maxLogQueueCapacity);
+    int powerOfTwo = 1;
+    while (powerOfTwo < capacity) {
+        powerOfTwo <<= 1;
+    }
+    d->m_logQueueCapacity = powerOfTwo;
+}
+
+int UMApplicationMonitor::logQueueCapacity()
+{
+    return d_func()->m_logQueueCapacity;
+}
+
+quint32 UMApplicationMonitor::droppedEventCount()
+{
+    return d_func()->m_droppedEventCount.load();
+}
+
+QList<UMFrameStatistics> UMApplicationMonitor::frameStatistics()
+{
+    Q_D(UMApplicationMonitor);
+
+    QList<UMFrameStatistics> list;
+    d->m_monitorsMutex.lock();
+    for (int i = 0; i < d->m_monitorCount; ++i) {
+        DASSERT(d->m_monitors[i]);
+        UMFrameStatistics statistics;
+        d->m_monitors[i]->frameStatistics(&statistics);
+        list.append(statistics);
+    }
+    d->m_monitorsMutex.unlock();
+    return list;
+}
+
+void UMApplicationMonitor::setStatisticsPeriod(int period)
+{
+    d_func()->m_statisticsPeriod.store(qMax(2, period));
+}
+
+int UMApplicationMonitor::statisticsPeriod()
+{
+    return d_func()->m_statisticsPeriod.load();
+}
+
 quint32 UMApplicationMonitor::registerGenericEvent()
 {
     static quint32 id = 0;  // 0 is reserved for UMApplicationMonitor events.
@@ -692,7 +797,11 @@ static const char* const defaultOverlayText =
     "  SG sync. : %9syncTime ms\n"
     " SG render : %9renderTime ms\n"
     "       GPU : %9gpuTime ms\n"
-    "     Total : %9totalTime ms\r"
+    "     Total : %9totalTime ms\n"
+    "       p50 : %9p50Time ms\n"
+    "       p90 : %9p90Time ms\n"
+    "       p99 : %9p99Time ms\n"
+    "       Max : %9maxTime ms\r"
     "  VSZ mem. : %9vszMemory kB\n"
     "  RSS mem. : %9rssMemory kB\n"
     "   Threads : %9threadCount   \n"
@@ -736,6 +845,7 @@ WindowMonitor::WindowMonitor(
     memset(&m_frameEvent, 0, sizeof(m_frameEvent));
     m_frameEvent.type = UMEvent::Frame;
     m_frameEvent.frame.window = id;
+    m_statisticsTimer.start();
 
     if ((flags & UMApplicationMonitorPrivate::Logging)
         && (flags & UMApplicationMonitor::WindowEvent)) {
@@ -856,9 +966,15 @@ void WindowMonitor::windowAfterRendering()
         m_frameEvent.frame.renderTime = m_sceneGraphTimer.nsecsElapsed();
         m_frameEvent.frame.gpuTime = (m_flags & GpuTimerAvailable) ? m_gpuTimer.stop() : 0;
         m_frameEvent.frame.number++;
+        const int period =
+            UMApplicationMonitorPrivate::get(m_applicationMonitor)->m_statisticsPeriod.load();
+        m_frameTimeHistogram.record(
+            m_frameEvent.frame.syncTime + m_frameEvent.frame.renderTime
+            + m_frameEvent.frame.gpuTime, m_statisticsTimer.elapsed(), period);
+        publishStatistics();
         if (m_flags & UMApplicationMonitorPrivate::Overlay) {
             m_mutex.lock();
-            m_overlay.render(m_frameEvent, m_frameSize);
+            m_overlay.render(m_frameEvent, m_frameSize, m_frameTimeHistogram.histogram());
             m_mutex.unlock();
         }
         m_sceneGraphTimer.start();
@@ -899,6 +1015,43 @@ void WindowMonitor::windowSceneGraphAboutToStop()
     delete this;
 }
 
+// Publishes the statistics of the histogram owned by the render thread so that
+// they can be read from other threads without blocking rendering.
+void WindowMonitor::publishStatistics()
+{
+    const float percentiles[3] = { 50.0f, 90.0f, 99.0f };
+    quint64 values[3];
+    const UMHistogram& histogram = m_frameTimeHistogram.histogram();
+    histogram.percentiles(percentiles, values, 3);
+
+    m_statisticsSequence.fetchAndAddOrdered(1);
+    m_statisticsFrameCount.storeRelease(histogram.count());
+    m_statisticsTimes[0].storeRelease(values[0]);
+    m_statisticsTimes[1].storeRelease(values[1]);
+    m_statisticsTimes[2].storeRelease(values[2]);
+    m_statisticsTimes[3].storeRelease(histogram.max());
+    m_statisticsSequence.fetchAndAddRelease(1);
+}
+
+void WindowMonitor::frameStatistics(UMFrameStatistics* statistics)
+{
+    DASSERT(statistics);
+
+    statistics->window = m_id;
+    int sequence;
+    do {
+        // Retry while the render thread publishes new statistics.
+        while ((sequence = m_statisticsSequence.loadAcquire()) & 1) {
+            QThread::yieldCurrentThread();
+        }
+        statistics->frameCount = m_statisticsFrameCount.loadAcquire();
+        statistics->p50Time = m_statisticsTimes[0].loadAcquire();
+        statistics->p90Time = m_statisticsTimes[1].loadAcquire();
+        statistics->p99Time = m_statisticsTimes[2].loadAcquire();
+        statistics->maxTime = m_statisticsTimes[3].loadAcquire();
+    } while (m_statisticsSequence.loadAcquire() != sequence);
+}
+
 void WindowMonitor::setProcessEvent(const UMEvent& event)
 {
     DASSERT(event.type == UMEvent::Process);
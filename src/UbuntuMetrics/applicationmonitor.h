@@ -26,6 +26,26 @@
 
 class UMApplicationMonitorPrivate;
 
+// Frame time statistics of a window over the statistics period. The frame time
+// is the sum of the scene graph synchronization, render and GPU times. Times
+// are in nanoseconds, percentiles have a relative precision of about 6%.
+struct UBUNTU_METRICS_EXPORT UMFrameStatistics
+{
+    // Window id.
+    quint32 window;
+
+    // Number of frames rendered over the period.
+    quint32 frameCount;
+
+    // Frame time percentiles.
+    quint64 p50Time;
+    quint64 p90Time;
+    quint64 p99Time;
+
+    // Max frame time.
+    quint64 maxTime;
+};
+
 // Monitor a QtQuick application by automatically tracking QtQuick windows and
 // process metrics. The metrics gathered can be logged and displayed by an
 // overlay rendered on top of each frame.
@@ -77,6 +97,26 @@ public:
     bool removeLogger(UMLogger* logger, bool free = true);
     void clearLoggers(bool free = true);
 
+    // Set the capacity of the log queue in number of events. The logging
+    // thread consumes events asynchronously, events pushed while the queue is
+    // full are dropped (see droppedEventCount()). The capacity is rounded up
+    // to the next power-of-two and applied at the next start of the
+    // monitoring, default value is 256, min value is 2 and max value is 65536.
+    void setLogQueueCapacity(int capacity);
+    int logQueueCapacity();
+
+    // Get the number of events dropped because the log queue was full.
+    quint32 droppedEventCount();
+
+    // Get the frame time statistics of the monitored windows. The statistics
+    // are aggregated on the render thread over a rolling period set in
+    // milliseconds by setStatisticsPeriod(), frames older than the period are
+    // progressively dropped. Default period is 10000 ms. Statistics are only
+    // aggregated while monitoring (overlay or logging enabled).
+    QList<UMFrameStatistics> frameStatistics();
+    void setStatisticsPeriod(int period);
+    int statisticsPeriod();
+
     // Generic event system allowing to log application specific
     // events. registerGenericEvent() returns a unique integer id to be used as
     // first argument to logGenericEvent(). logGenericEvent() logs a generic
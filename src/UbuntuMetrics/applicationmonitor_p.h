@@ -30,6 +30,7 @@
 
 #include <UbuntuMetrics/private/overlay_p.h>
 #include <UbuntuMetrics/private/gputimer_p.h>
+#include <UbuntuMetrics/private/histogram_p.h>
 #include <UbuntuMetrics/private/ubuntumetricsglobal_p.h>
 
 class LoggingThread;
@@ -41,6 +42,11 @@ class UBUNTU_METRICS_PRIVATE_EXPORT UMApplicationMonitorPrivate
 public:
     static const int maxMonitors = 16;
     static const int maxLoggers = 8;
+    static const int defaultLogQueueCapacity = 256;
+    static const int defaultStatisticsPeriod = 10000;
+    static const int maxLogQueueCapacity = 65536;
+    // A single slot would be both the next slot to read and to write.
+    static const int minLogQueueCapacity = 2;
 
     static inline UMApplicationMonitorPrivate* get(UMApplicationMonitor* applicationMonitor) {
         return applicationMonitor->d_func();
@@ -84,38 +90,60 @@ public:
     QMutex m_monitorsMutex;
     int m_monitorCount;
     int m_loggerCount;
+    int m_logQueueCapacity;
+    QAtomicInteger<quint32> m_droppedEventCount;
+    QAtomicInt m_statisticsPeriod;
     int m_updateInterval[UMEvent::TypeCount];
     quint32 m_flags;
     alignas(64) UMEvent m_processEvent;
 };
 
+// Logging thread consuming the events pushed by the application and window
+// monitors. Events are stored in a bounded multi-producer/single-consumer ring
+// buffer so that pushing never blocks on the producer side (the render threads
+// in particular), events are dropped when the buffer is full. The consumer
+// sleeps for a flush interval when the queue is empty, producers only take the
+// lock to wake it up once per batch of a quarter of the capacity.
 class UBUNTU_METRICS_PRIVATE_EXPORT LoggingThread : public QThread
 {
 public:
-    LoggingThread();
+    LoggingThread(int capacity, QAtomicInteger<quint32>* droppedCount);
 
     void run() override;
-    void push(const UMEvent* event);
+    bool push(const UMEvent* event);
     void setLoggers(UMLogger** loggers, int count);
     LoggingThread* ref();
     void deref();
 
 private:
     enum {
-        Waiting       = (1 << 0),
-        JoinRequested = (1 << 1)
+        JoinRequested = (1 << 0)
+    };
+
+    // Ring buffer slot. The sequence number tells the slot state for the
+    // position being read or written.
+    struct alignas(64) Slot {
+        UMEvent event;
+        QAtomicInteger<quint32> sequence;
     };
 
     ~LoggingThread();
 
-    UMEvent* m_queue;
+    bool isEmpty();
+    int drain(UMEvent* events, int maxCount);
+
+    Slot* m_queue;
     UMLogger* m_loggers[UMApplicationMonitorPrivate::maxLoggers];
     int m_loggerCount;
     QMutex m_mutex;
     QWaitCondition m_condition;
     QAtomicInteger<quint32> m_refCount;
-    qint8 m_queueIndex;
-    qint8 m_queueSize;
+    QAtomicInteger<quint32>* m_droppedCount;
+    QAtomicInteger<quint32> m_waiting;
+    alignas(64) QAtomicInteger<quint32> m_tail;  // Written by producers.
+    alignas(64) quint32 m_head;  // Written by the consumer.
+    quint32 m_mask;
+    quint32 m_wakeMask;
     quint8 m_flags;
 };
 
@@ -169,7 +197,9 @@ public:
     ~WindowMonitor();
 
     QQuickWindow* window() const { return m_window; }
+    quint32 id() const { return m_id; }
     void setProcessEvent(const UMEvent& event);
+    void frameStatistics(UMFrameStatistics* statistics);
 
 private Q_SLOTS:
     void windowSceneGraphInitialized();
@@ -196,6 +226,7 @@ private:
     }
     void initializeGpuResources();
     void finalizeGpuResources();
+    void publishStatistics();
 
     UMApplicationMonitor* m_applicationMonitor;
     LoggingThread* m_loggingThread;
@@ -205,6 +236,13 @@ private:
     QMutex m_mutex;
     QElapsedTimer m_sceneGraphTimer;
     QElapsedTimer m_deltaTimer;
+    QElapsedTimer m_statisticsTimer;
+    UMRollingHistogram m_frameTimeHistogram;  // Only accessed from the render thread.
+    // Statistics published by the render thread, read under a sequence lock
+    // (odd while being written).
+    QAtomicInt m_statisticsSequence;
+    QAtomicInteger<quint32> m_statisticsFrameCount;
+    QAtomicInteger<quint64> m_statisticsTimes[4];  // p50, p90, p99 and max.
     quint32 m_id;
     quint32 m_flags;
     QSize m_frameSize;
@@ -0,0 +1,134 @@
+// Copyright © 2016 Canonical Ltd.
+//
+// This file is part of Ubuntu UI Toolkit.
+//
+// Ubuntu UI Toolkit is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; version 3.
+//
+// Ubuntu UI Toolkit is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Ubuntu UI Toolkit. If not, see <http://www.gnu.org/licenses/>.
+
+#include "histogram_p.h"
+
+#include <string.h>
+
+void UMHistogram::reset()
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_max = 0;
+}
+
+// Values lower than subBucketCount get a bucket each (first group), the others
+// are bucketed by power-of-two (group) and subBucketBits of mantissa.
+int UMHistogram::bucketIndex(quint64 usecs)
+{
+    if (usecs < static_cast<quint64>(subBucketCount)) {
+        return static_cast<int>(usecs);
+    }
+    const int msb = 63 - __builtin_clzll(usecs);
+    const int group = msb - subBucketBits + 1;
+    if (group >= groupCount) {
+        return bucketCount - 1;
+    }
+    const int subBucket = static_cast<int>(usecs >> (msb - subBucketBits)) - subBucketCount;
+    return group * subBucketCount + subBucket;
+}
+
+// Upper bound in nanoseconds of the bucket at the given index.
+quint64 UMHistogram::bucketUpperBound(int index)
+{
+    const int group = index / subBucketCount;
+    const quint64 subBucket = index % subBucketCount;
+    const quint64 usecs = group == 0
+        ? subBucket + 1 : (subBucketCount + subBucket + 1) << (group - 1);
+    return usecs * 1000;
+}
+
+void UMHistogram::record(quint64 nsecs)
+{
+    m_buckets[bucketIndex(nsecs / 1000)]++;
+    m_count++;
+    if (nsecs > m_max) {
+        m_max = nsecs;
+    }
+}
+
+void UMHistogram::add(const UMHistogram& histogram)
+{
+    for (int i = 0; i < bucketCount; ++i) {
+        m_buckets[i] += histogram.m_buckets[i];
+    }
+    m_count += histogram.m_count;
+    if (histogram.m_max > m_max) {
+        m_max = histogram.m_max;
+    }
+}
+
+void UMHistogram::subtract(const UMHistogram& histogram)
+{
+    for (int i = 0; i < bucketCount; ++i) {
+        DASSERT(m_buckets[i] >= histogram.m_buckets[i]);
+        m_buckets[i] -= histogram.m_buckets[i];
+    }
+    DASSERT(m_count >= histogram.m_count);
+    m_count -= histogram.m_count;
+}
+
+void UMHistogram::percentiles(const float* percentiles, quint64* values, int count) const
+{
+    DASSERT(percentiles);
+    DASSERT(values);
+
+    quint64 accumulated = 0;
+    int bucket = -1;
+    for (int i = 0; i < count; ++i) {
+        DASSERT(i == 0 || percentiles[i] >= percentiles[i-1]);
+        if (m_count == 0) {
+            values[i] = 0;
+            continue;
+        }
+        // Rank of the value at that percentile, 1 based.
+        const quint64 rank = qMax(static_cast<quint64>(1), static_cast<quint64>(
+            qBound(0.0f, percentiles[i], 100.0f) * 0.01f * m_count + 0.5f));
+        while (accumulated < rank && bucket < bucketCount - 1) {
+            accumulated += m_buckets[++bucket];
+        }
+        values[i] = qMin(bucketUpperBound(qMax(bucket, 0)), m_max);
+    }
+}
+
+void UMRollingHistogram::reset()
+{
+    m_halves[0].reset();
+    m_halves[1].reset();
+    m_total.reset();
+    m_current = 0;
+    m_halfPeriodStart = 0;
+}
+
+void UMRollingHistogram::record(quint64 nsecs, qint64 msecs, int period)
+{
+    if (msecs - m_halfPeriodStart >= period / 2) {
+        // Drop the oldest half and start recording in it. Skip both halves if
+        // more than a period elapsed since the last record.
+        m_current ^= 1;
+        if (msecs - m_halfPeriodStart >= period) {
+            m_total.reset();
+            m_halves[m_current ^ 1].reset();
+        } else {
+            m_total.subtract(m_halves[m_current]);
+            m_total.setMax(m_halves[m_current ^ 1].max());
+        }
+        m_halves[m_current].reset();
+        m_halfPeriodStart = msecs;
+    }
+    m_halves[m_current].record(nsecs);
+    m_total.record(nsecs);
+}
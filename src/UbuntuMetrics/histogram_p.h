@@ -0,0 +1,87 @@
+// Copyright © 2016 Canonical Ltd.
+//
+// This file is part of Ubuntu UI Toolkit.
+//
+// Ubuntu UI Toolkit is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; version 3.
+//
+// Ubuntu UI Toolkit is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Ubuntu UI Toolkit. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HISTOGRAM_P_H
+#define HISTOGRAM_P_H
+
+#include <UbuntuMetrics/private/ubuntumetricsglobal_p.h>
+
+// Histogram of durations with logarithmically spaced buckets, in the spirit of
+// HDR histograms. Durations are stored in microseconds with a relative
+// precision of 1/subBucketCount (6.25%) up to 2^32 µs. Recording never
+// allocates memory.
+class UBUNTU_METRICS_PRIVATE_EXPORT UMHistogram
+{
+public:
+    static const int subBucketBits = 4;
+    static const int subBucketCount = 1 << subBucketBits;
+    static const int groupCount = 32 - subBucketBits + 1;
+    static const int bucketCount = groupCount * subBucketCount;
+
+    UMHistogram() { reset(); }
+
+    void reset();
+
+    // Records a duration in nanoseconds.
+    void record(quint64 nsecs);
+
+    // Adds (or subtracts) the counts of another histogram. The max value is
+    // not updated by subtract().
+    void add(const UMHistogram& histogram);
+    void subtract(const UMHistogram& histogram);
+
+    // Gets the durations in nanoseconds at the given percentiles (in the range
+    // [0, 100]). The returned values are the upper bounds of the buckets,
+    // clamped to the max value. percentiles must be sorted in increasing order.
+    void percentiles(const float* percentiles, quint64* values, int count) const;
+
+    quint32 count() const { return m_count; }
+    quint64 max() const { return m_max; }
+    void setMax(quint64 max) { m_max = max; }
+
+private:
+    static int bucketIndex(quint64 usecs);
+    static quint64 bucketUpperBound(int index);
+
+    quint32 m_buckets[bucketCount];
+    quint32 m_count;
+    quint64 m_max;
+};
+
+// Histogram of durations over a rolling period. Values are recorded in two
+// alternating halves, the oldest one being dropped every half period so that
+// the statistics always cover between a half and a full period.
+class UBUNTU_METRICS_PRIVATE_EXPORT UMRollingHistogram
+{
+public:
+    UMRollingHistogram() : m_current(0), m_halfPeriodStart(0) {}
+
+    void reset();
+
+    // Records a duration in nanoseconds at a given time in milliseconds.
+    void record(quint64 nsecs, qint64 msecs, int period);
+
+    // Histogram covering the rolling period.
+    const UMHistogram& histogram() const { return m_total; }
+
+private:
+    UMHistogram m_halves[2];
+    UMHistogram m_total;
+    int m_current;
+    qint64 m_halfPeriodStart;
+};
+
+#endif  // HISTOGRAM_P_H
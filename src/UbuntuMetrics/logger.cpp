@@ -231,6 +231,90 @@ bool UMFileLogger::parsable()
     return !!(d_func()->m_flags & UMFileLoggerPrivate::Parsable);
 }
 
+UMBinaryLogger::UMBinaryLogger(const QString& fileName, quint32 maxSize)
+    : d_ptr(new UMBinaryLoggerPrivate(fileName, maxSize))
+{
+}
+
+UMBinaryLoggerPrivate::UMBinaryLoggerPrivate(const QString& fileName, quint32 maxSize)
+    : m_header(nullptr)
+    , m_events(nullptr)
+{
+    if (QDir::isRelativePath(fileName)) {
+        m_file.setFileName(QString(QDir::currentPath() + QDir::separator() + fileName));
+    } else {
+        m_file.setFileName(fileName);
+    }
+
+    const quint32 capacity = maxSize > sizeof(UMBinaryLogHeader)
+        ? (maxSize - sizeof(UMBinaryLogHeader)) / sizeof(UMEvent) : 0;
+    if (capacity == 0) {
+        WARN("BinaryLogger: Max size %u too small.", maxSize);
+        return;
+    }
+    const qint64 size = sizeof(UMBinaryLogHeader) + capacity * sizeof(UMEvent);
+
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        WARN("BinaryLogger: Can't open file %s '%s'.", fileName.toLatin1().constData(),
+             m_file.errorString().toLatin1().constData());
+        return;
+    }
+    uchar* data = m_file.resize(size) ? m_file.map(0, size) : nullptr;
+    if (!data) {
+        WARN("BinaryLogger: Can't map file %s '%s'.", fileName.toLatin1().constData(),
+             m_file.errorString().toLatin1().constData());
+        m_file.close();
+        return;
+    }
+
+    m_header = reinterpret_cast<UMBinaryLogHeader*>(data);
+    m_events = reinterpret_cast<UMEvent*>(data + sizeof(UMBinaryLogHeader));
+    memset(m_header, 0, sizeof(UMBinaryLogHeader));
+    memcpy(m_header->magic, "UMTRACE", sizeof(m_header->magic));
+    m_header->version = UMBinaryLogHeader::currentVersion;
+    m_header->byteOrder = UMBinaryLogHeader::byteOrderMark;
+    m_header->headerSize = sizeof(UMBinaryLogHeader);
+    m_header->eventSize = sizeof(UMEvent);
+    m_header->eventCapacity = capacity;
+    m_header->eventCount = 0;
+}
+
+UMBinaryLogger::~UMBinaryLogger()
+{
+    delete d_ptr;
+}
+
+UMBinaryLoggerPrivate::~UMBinaryLoggerPrivate()
+{
+    if (m_header) {
+        // Shrink the file if the ring buffer has not been filled.
+        const quint64 count = m_header->eventCount;
+        const quint32 capacity = m_header->eventCapacity;
+        m_file.unmap(reinterpret_cast<uchar*>(m_header));
+        if (count < capacity) {
+            m_file.resize(sizeof(UMBinaryLogHeader) + count * sizeof(UMEvent));
+        }
+    }
+}
+
+bool UMBinaryLogger::isOpen()
+{
+    return !!d_func()->m_header;
+}
+
+void UMBinaryLogger::log(const UMEvent& event)
+{
+    d_func()->log(event);
+}
+
+void UMBinaryLoggerPrivate::log(const UMEvent& event)
+{
+    if (Q_LIKELY(m_header)) {
+        memcpy(&m_events[m_header->eventCount % m_header->eventCapacity], &event, sizeof(UMEvent));
+        m_header->eventCount++;
+    }
+}
+
 #if defined(Q_OS_LINUX)
 
 UMLTTNGPlugin* UMLTTNGLogger::m_plugin = nullptr;
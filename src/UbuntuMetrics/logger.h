@@ -23,6 +23,7 @@
 #include <UbuntuMetrics/ubuntumetricsglobal.h>
 
 class UMFileLoggerPrivate;
+class UMBinaryLoggerPrivate;
 struct UMLTTNGPlugin;
 struct UMEvent;
 
@@ -58,6 +59,27 @@ private:
     Q_DECLARE_PRIVATE(UMFileLogger)
 };
 
+// Log events to a binary file. Events are stored unformatted as raw UMEvent
+// records in a memory-mapped file, which makes it the cheapest logger to keep
+// enabled. The file size is capped to maxSize bytes, the oldest events being
+// overwritten once the cap is reached. The um-trace-decoder tool converts the
+// file to the parsable text format of UMFileLogger or to CSV.
+class UBUNTU_METRICS_EXPORT UMBinaryLogger : public UMLogger
+{
+public:
+    static const quint32 defaultMaxSize = 16 * 1024 * 1024;
+
+    UMBinaryLogger(const QString& fileName, quint32 maxSize = defaultMaxSize);
+    ~UMBinaryLogger();
+
+    void log(const UMEvent& event) Q_DECL_OVERRIDE;
+    bool isOpen() Q_DECL_OVERRIDE;
+
+private:
+    UMBinaryLoggerPrivate* const d_ptr;
+    Q_DECLARE_PRIVATE(UMBinaryLogger)
+};
+
 #if defined(Q_OS_LINUX)
 
 // Log events to LTTng.
@@ -45,4 +45,57 @@ public:
     quint8 m_flags;
 };
 
+// Header of the files written by UMBinaryLogger. The header is followed by an
+// array of eventCapacity UMEvent records used as a ring buffer, eventCount
+// being the total number of events logged. Records are stored in host byte
+// order, the byteOrder field allows decoders to detect mismatches.
+struct UMBinaryLogHeader
+{
+    static const quint32 currentVersion = 1;
+    static const quint32 byteOrderMark = 0x01020304;
+
+    // "UMTRACE" with the null-terminating character.
+    char magic[8];
+
+    // Layout version of the file, currently 1.
+    quint32 version;
+
+    // byteOrderMark written in host byte order.
+    quint32 byteOrder;
+
+    // Size of the header in bytes, records start right after it.
+    quint32 headerSize;
+
+    // Size of a record in bytes (sizeof(UMEvent)).
+    quint32 eventSize;
+
+    // Max number of records stored in the file.
+    quint32 eventCapacity;
+
+    // Padding to keep eventCount 8 bytes aligned.
+    quint32 __reserved0;
+
+    // Number of events logged since the file creation. The oldest record is at
+    // index (eventCount % eventCapacity) once eventCount exceeds eventCapacity.
+    quint64 eventCount;
+
+    // The whole struct must take 128 bytes so that records are aligned the same
+    // way UMEvent is.
+    quint8 __reserved[/*40 bytes taken,*/ 88 /*bytes free*/];
+};
+Q_STATIC_ASSERT(sizeof(UMBinaryLogHeader) == 128);
+
+class UBUNTU_METRICS_PRIVATE_EXPORT UMBinaryLoggerPrivate
+{
+public:
+    UMBinaryLoggerPrivate(const QString& fileName, quint32 maxSize);
+    ~UMBinaryLoggerPrivate();
+
+    void log(const UMEvent& event);
+
+    QFile m_file;
+    UMBinaryLogHeader* m_header;
+    UMEvent* m_events;
+};
+
 #endif  // LOGGER_P_H
@@ -62,11 +62,15 @@ static const struct {
     { "syncTime",    sizeof("syncTime") - 1,    7, UMEvent::Frame   },
     { "renderTime",  sizeof("renderTime") - 1,  7, UMEvent::Frame   },
     { "gpuTime",     sizeof("gpuTime") - 1,     7, UMEvent::Frame   },
-    { "totalTime",   sizeof("totalTime") - 1,   7, UMEvent::Frame   }
+    { "totalTime",   sizeof("totalTime") - 1,   7, UMEvent::Frame   },
+    { "p50Time",     sizeof("p50Time") - 1,     7, UMEvent::Frame   },
+    { "p90Time",     sizeof("p90Time") - 1,     7, UMEvent::Frame   },
+    { "p99Time",     sizeof("p99Time") - 1,     7, UMEvent::Frame   },
+    { "maxTime",     sizeof("maxTime") - 1,     7, UMEvent::Frame   }
 };
 enum {
     CpuUsage = 0, ThreadCount, VszMemory, RssMemory, WindowId, WindowSize, FrameNumber, DeltaTime,
-    SyncTime, RenderTime, GpuTime, TotalTime, MetricCount
+    SyncTime, RenderTime, GpuTime, TotalTime, P50Time, P90Time, P99Time, MaxTime, MetricCount
 };
 Q_STATIC_ASSERT(ARRAY_SIZE(metricInfo) == MetricCount);
 
@@ -150,7 +154,8 @@ void Overlay::setProcessEvent(const UMEvent& processEvent)
     m_flags |= DirtyProcessEvent;
 }
 
-void Overlay::render(const UMEvent& frameEvent, const QSize& frameSize)
+void Overlay::render(
+    const UMEvent& frameEvent, const QSize& frameSize, const UMHistogram& frameTimeHistogram)
 {
     DASSERT(m_flags & Initialized);
     DASSERT(m_context == QOpenGLContext::currentContext());
@@ -170,7 +175,7 @@ void Overlay::render(const UMEvent& frameEvent, const QSize& frameSize)
         updateProcessMetrics();
         m_flags &= ~DirtyProcessEvent;
     }
-    updateFrameMetrics(frameEvent);
+    updateFrameMetrics(frameEvent, frameTimeHistogram);
     m_bitmapText.render();
 }
 
@@ -233,11 +238,16 @@ static int timeMetricToText(quint64 metric, char* text, int width)
     return width;
 }
 
-void Overlay::updateFrameMetrics(const UMEvent& event)
+void Overlay::updateFrameMetrics(const UMEvent& event, const UMHistogram& frameTimeHistogram)
 {
     DASSERT(m_flags & Initialized);
     Q_STATIC_ASSERT(IS_POWER_OF_TWO(maxMetricWidth));
 
+    // Percentiles are computed lazily, at most once per frame.
+    const float percentiles[3] = { 50.0f, 90.0f, 99.0f };
+    quint64 percentileValues[3];
+    bool percentilesComputed = false;
+
     char* text = static_cast<char*>(m_buffer);
     for (int i = 0; i < m_metricsSize[UMEvent::Frame]; i++) {
         int textWidth = m_metrics[UMEvent::Frame][i].width;
@@ -272,6 +282,19 @@ void Overlay::updateFrameMetrics(const UMEvent& event)
             timeMetricToText(time, text, textWidth);
             break;
         }
+        case P50Time:
+        case P90Time:
+        case P99Time:
+            if (!percentilesComputed) {
+                frameTimeHistogram.percentiles(percentiles, percentileValues, 3);
+                percentilesComputed = true;
+            }
+            timeMetricToText(
+                percentileValues[m_metrics[UMEvent::Frame][i].index - P50Time], text, textWidth);
+            break;
+        case MaxTime:
+            timeMetricToText(frameTimeHistogram.max(), text, textWidth);
+            break;
         default:
             DNOT_REACHED();
             break;
@@ -22,6 +22,7 @@
 
 #include <UbuntuMetrics/events.h>
 #include <UbuntuMetrics/private/bitmaptext_p.h>
+#include <UbuntuMetrics/private/histogram_p.h>
 #include <UbuntuMetrics/private/ubuntumetricsglobal_p.h>
 
 #if !defined QT_NO_DEBUG
@@ -46,11 +47,13 @@ public:
     void setProcessEvent(const UMEvent& processEvent);
 
     // Renders the overlay. Must be called in a thread with the same OpenGL
-    // context bound than at initialize().
-    void render(const UMEvent& frameEvent, const QSize& frameSize);
+    // context bound than at initialize(). The frame time histogram provides
+    // the percentile metrics.
+    void render(const UMEvent& frameEvent, const QSize& frameSize,
+                const UMHistogram& frameTimeHistogram);
 
 private:
-    void updateFrameMetrics(const UMEvent& frameEvent);
+    void updateFrameMetrics(const UMEvent& frameEvent, const UMHistogram& frameTimeHistogram);
     void updateWindowMetrics(quint32 windowId, const QSize& frameSize);
     void updateProcessMetrics();
     int keywordString(int index, char* buffer, int bufferSize);
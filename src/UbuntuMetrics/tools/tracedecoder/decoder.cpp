@@ -0,0 +1,128 @@
+// Copyright © 2017 Canonical Ltd.
+//
+// This file is part of Ubuntu UI Toolkit.
+//
+// Ubuntu UI Toolkit is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; version 3.
+//
+// Ubuntu UI Toolkit is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Ubuntu UI Toolkit. If not, see <http://www.gnu.org/licenses/>.
+
+#include "decoder.h"
+
+#include <string.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <UbuntuMetrics/logger.h>
+#include <UbuntuMetrics/private/logger_p.h>
+
+// CSV rows have a fixed number of columns, the meaning of the fields depends on
+// the event type:
+//   process: cpuUsage, vszMemory, rssMemory, threadCount
+//   window:  id, state, width, height
+//   frame:   window, number, deltaTime, syncTime, renderTime, gpuTime, swapTime
+//   generic: id, string
+static void logCsv(QTextStream& stream, const UMEvent& event)
+{
+    switch (event.type) {
+    case UMEvent::Process:
+        stream << "process," << event.timeStamp << ','
+               << event.process.cpuUsage << ','
+               << event.process.vszMemory << ','
+               << event.process.rssMemory << ','
+               << event.process.threadCount << ",,,,\n";
+        break;
+    case UMEvent::Window:
+        stream << "window," << event.timeStamp << ','
+               << event.window.id << ','
+               << event.window.state << ','
+               << event.window.width << ','
+               << event.window.height << ",,,,\n";
+        break;
+    case UMEvent::Frame:
+        stream << "frame," << event.timeStamp << ','
+               << event.frame.window << ','
+               << event.frame.number << ','
+               << event.frame.deltaTime << ','
+               << event.frame.syncTime << ','
+               << event.frame.renderTime << ','
+               << event.frame.gpuTime << ','
+               << event.frame.swapTime << ",\n";
+        break;
+    case UMEvent::Generic: {
+        // Quote the string, doubling embedded quotes.
+        const quint32 size = qMin(event.generic.stringSize, quint32(UMGenericEvent::maxStringSize));
+        QString string = QString::fromLatin1(event.generic.string, size ? size - 1 : 0);
+        string.replace(QLatin1Char('"'), QLatin1String("\"\""));
+        stream << "generic," << event.timeStamp << ','
+               << event.generic.id << ",,,,,,,\"" << string << "\"\n";
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+bool umDecodeTrace(const uchar* data, qint64 size, bool csv, FILE* output, QString* error)
+{
+    if (!data || size < static_cast<qint64>(sizeof(UMBinaryLogHeader))) {
+        *error = QStringLiteral("Trace too small.");
+        return false;
+    }
+
+    const UMBinaryLogHeader* header = reinterpret_cast<const UMBinaryLogHeader*>(data);
+    if (memcmp(header->magic, "UMTRACE", sizeof(header->magic))) {
+        *error = QStringLiteral("Not a binary metrics trace.");
+        return false;
+    }
+    if (header->byteOrder != UMBinaryLogHeader::byteOrderMark
+        || header->version != UMBinaryLogHeader::currentVersion
+        || header->eventSize != sizeof(UMEvent) || header->eventCapacity == 0) {
+        *error = QStringLiteral("Unsupported trace layout (version %1, %2 bytes events).")
+            .arg(header->version).arg(header->eventSize);
+        return false;
+    }
+    // Records are read right after the header, which must lie in the file.
+    if (header->headerSize < sizeof(UMBinaryLogHeader) || header->headerSize > size) {
+        *error = QStringLiteral("Invalid header size %1.").arg(header->headerSize);
+        return false;
+    }
+
+    // Records stored in the file, the file might have been truncated if the
+    // application crashed before the ring buffer has been filled. Once it
+    // wrapped, every record of the ring buffer is read.
+    const quint64 available = (size - header->headerSize) / sizeof(UMEvent);
+    const bool wrapped = header->eventCount > header->eventCapacity;
+    if (wrapped && available < header->eventCapacity) {
+        *error = QStringLiteral("Truncated trace (%1 of %2 records).")
+            .arg(available).arg(header->eventCapacity);
+        return false;
+    }
+    const quint32 count = static_cast<quint32>(
+        qMin(qMin(header->eventCount, static_cast<quint64>(header->eventCapacity)), available));
+    const quint32 first = wrapped ? header->eventCount % header->eventCapacity : 0;
+    const UMEvent* events = reinterpret_cast<const UMEvent*>(data + header->headerSize);
+
+    if (csv) {
+        QFile file;
+        file.open(output, QIODevice::WriteOnly | QIODevice::Text);
+        QTextStream stream(&file);
+        stream << "type,timeStamp,field1,field2,field3,field4,field5,field6,field7,string\n";
+        for (quint32 i = 0; i < count; ++i) {
+            logCsv(stream, events[(first + i) % header->eventCapacity]);
+        }
+    } else {
+        UMFileLogger logger(output, true);
+        for (quint32 i = 0; i < count; ++i) {
+            logger.log(events[(first + i) % header->eventCapacity]);
+        }
+    }
+    return true;
+}
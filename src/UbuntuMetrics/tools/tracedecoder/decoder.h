@@ -0,0 +1,29 @@
+// Copyright © 2017 Canonical Ltd.
+//
+// This file is part of Ubuntu UI Toolkit.
+//
+// Ubuntu UI Toolkit is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; version 3.
+//
+// Ubuntu UI Toolkit is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Ubuntu UI Toolkit. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DECODER_H
+#define DECODER_H
+
+#include <stdio.h>
+
+#include <QtCore/QString>
+
+// Writes the events of the size bytes long binary trace to output, in the
+// parsable text format of UMFileLogger or in CSV. Returns false and sets error
+// if the trace can't be decoded, nothing is written then.
+bool umDecodeTrace(const uchar* data, qint64 size, bool csv, FILE* output, QString* error);
+
+#endif  // DECODER_H
@@ -0,0 +1,74 @@
+// Copyright © 2016 Canonical Ltd.
+//
+// This file is part of Ubuntu UI Toolkit.
+//
+// Ubuntu UI Toolkit is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation; version 3.
+//
+// Ubuntu UI Toolkit is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Ubuntu UI Toolkit. If not, see <http://www.gnu.org/licenses/>.
+
+// Converts the binary traces written by UMBinaryLogger to the parsable text
+// format of UMFileLogger or to CSV.
+//
+// $ um-trace-decoder [--csv] trace.bin [output]
+
+#include <stdio.h>
+#include <string.h>
+
+#include <QtCore/QFile>
+
+#include "decoder.h"
+
+int main(int argc, char* argv[])
+{
+    bool csv = false;
+    int argument = 1;
+    if (argument < argc && !strcmp(argv[argument], "--csv")) {
+        csv = true;
+        argument++;
+    }
+    if (argument >= argc) {
+        fprintf(stderr, "Usage: %s [--csv] trace [output]\n", argv[0]);
+        return 1;
+    }
+
+    QFile input(QString::fromLocal8Bit(argv[argument++]));
+    if (!input.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Can't open '%s': %s\n", qPrintable(input.fileName()),
+                qPrintable(input.errorString()));
+        return 1;
+    }
+    const uchar* data = input.map(0, input.size());
+    if (!data) {
+        fprintf(stderr, "Can't read '%s'.\n", qPrintable(input.fileName()));
+        return 1;
+    }
+
+    FILE* output = stdout;
+    if (argument < argc) {
+        output = fopen(argv[argument], "w");
+        if (!output) {
+            fprintf(stderr, "Can't open '%s'.\n", argv[argument]);
+            return 1;
+        }
+    }
+
+    QString error;
+    const bool decoded = umDecodeTrace(data, input.size(), csv, output, &error);
+    if (!decoded) {
+        fprintf(stderr, "Can't decode '%s': %s\n", qPrintable(input.fileName()),
+                qPrintable(error));
+    }
+
+    if (output != stdout) {
+        fclose(output);
+    }
+    return decoded ? 0 : 1;
+}
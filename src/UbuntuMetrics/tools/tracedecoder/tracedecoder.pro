@@ -0,0 +1,6 @@
+TEMPLATE = app
+TARGET = um-trace-decoder
+QT = core UbuntuMetrics-private
+CONFIG += c++11
+HEADERS += decoder.h
+SOURCES += decoder.cpp tracedecoder.cpp
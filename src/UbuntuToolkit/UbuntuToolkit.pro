@@ -22,6 +22,7 @@ unix {
 HEADERS += \
     $$PWD/actionlist_p.h \
     $$PWD/adapters/actionsproxy_p.h \
+    $$PWD/adapters/alarmjournal_p.h \
     $$PWD/adapters/alarmsadapter_p.h \
     $$PWD/adapters/dbuspropertywatcher_p.h \
     $$PWD/alarmmanager_p.h \
@@ -48,6 +49,7 @@ HEADERS += \
     $$PWD/privates/frame_p.h \
     $$PWD/privates/listitemdragarea_p.h \
     $$PWD/privates/listitemdraghandler_p.h \
+    $$PWD/privates/listitempool_p.h \
     $$PWD/privates/listitemselection_p.h \
     $$PWD/privates/listviewextensions_p.h \
     $$PWD/privates/splitviewhandler_p.h \
@@ -131,6 +133,7 @@ HEADERS += \
     $$PWD/ucubuntuanimation_p.h \
     $$PWD/ucubuntushape_p.h \
     $$PWD/ucubuntushapeoverlay_p.h \
+    $$PWD/ucubuntushapetexturecache_p.h \
     $$PWD/ucubuntushapetextures_p.h \
     $$PWD/ucunits_p.h \
     $$PWD/ucurihandler_p.h \
@@ -140,6 +143,7 @@ HEADERS += \
 SOURCES += \
     $$PWD/actionlist.cpp \
     $$PWD/adapters/actionsproxy_p.cpp \
+    $$PWD/adapters/alarmjournal_p.cpp \
     $$PWD/adapters/alarmsadapter_organizer.cpp \
     $$PWD/adapters/dbuspropertywatcher_p.cpp \
     $$PWD/alarmmanager_p.cpp \
@@ -161,6 +165,7 @@ SOURCES += \
     $$PWD/privates/listitemdragarea.cpp \
     $$PWD/privates/listitemdraghandler.cpp \
     $$PWD/privates/listitemexpansion.cpp \
+    $$PWD/privates/listitempool.cpp \
     $$PWD/privates/listitemselection.cpp \
     $$PWD/privates/listviewextensions.cpp \
     $$PWD/privates/splitviewhandler.cpp \
@@ -223,6 +228,7 @@ SOURCES += \
     $$PWD/ucubuntuanimation.cpp \
     $$PWD/ucubuntushape.cpp \
     $$PWD/ucubuntushapeoverlay.cpp \
+    $$PWD/ucubuntushapetexturecache.cpp \
     $$PWD/ucubuntushapetextures.cpp \
     $$PWD/ucunits.cpp \
     $$PWD/ucurihandler.cpp \
@@ -237,6 +243,9 @@ OTHER_FILES += \
     $$PWD/shaders/shape.vert \
     $$PWD/shaders/shape.frag \
     $$PWD/shaders/shape_no_dfdy.frag \
+    $$PWD/shaders/shape_batched.vert \
+    $$PWD/shaders/shape_batched.frag \
+    $$PWD/shaders/shape_batched_mipmap.frag \
     $$PWD/shaders/shapeoverlay.vert \
     $$PWD/shaders/shapeoverlay.frag \
     $$PWD/shaders/shapeoverlay_no_dfdy.frag \
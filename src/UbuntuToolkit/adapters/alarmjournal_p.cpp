@@ -0,0 +1,221 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "adapters/alarmjournal_p.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMap>
+#include <QtCore/QSaveFile>
+
+UT_NAMESPACE_BEGIN
+
+static const quint32 journalMagic = 0x5554414a;  // "UTAJ"
+static const quint32 journalVersion = 1;
+static const qint64 headerSize = 8;
+// Records bigger than that can only come from a damaged size field.
+static const quint32 maxRecordSize = 64 * 1024;
+
+enum RecordOperation {
+    PutRecord = 1,
+    RemoveRecord
+};
+
+// A record is made of its payload size, the payload and the checksum of the payload.
+static QByteArray encodeRecord(RecordOperation operation, const AlarmRecord &alarm)
+{
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream.setVersion(QDataStream::Qt_5_6);
+    payloadStream << static_cast<quint8>(operation) << alarm.key;
+    if (operation == PutRecord) {
+        payloadStream << alarm.message << alarm.date << alarm.sound << alarm.type << alarm.days
+                      << alarm.enabled;
+    }
+
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream << static_cast<quint32>(payload.size());
+    stream.writeRawData(payload.constData(), payload.size());
+    stream << qChecksum(payload.constData(), payload.size());
+    return record;
+}
+
+static bool writeHeader(QIODevice *device)
+{
+    QDataStream stream(device);
+    stream << journalMagic << journalVersion;
+    return stream.status() == QDataStream::Ok;
+}
+
+AlarmJournal::AlarmJournal(const QString &fileName)
+    : m_fileName(fileName)
+    , m_validSize(0)
+    , m_recordCount(0)
+    , m_nextKey(1)
+{
+}
+
+bool AlarmJournal::exists() const
+{
+    return QFile::exists(m_fileName);
+}
+
+QVector<AlarmRecord> AlarmJournal::load()
+{
+    m_validSize = 0;
+    m_recordCount = 0;
+    m_nextKey = 1;
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QVector<AlarmRecord>();
+    }
+    QDataStream stream(&file);
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != journalMagic
+        || version != journalVersion) {
+        qWarning("AlarmJournal: '%s' is not an alarm journal, it will be overwritten",
+                 qPrintable(m_fileName));
+        return QVector<AlarmRecord>();
+    }
+    m_validSize = headerSize;
+
+    // Records are streamed one by one, the first one which can't be read ends the journal.
+    QMap<quint32, AlarmRecord> alarms;
+    QByteArray payload;
+    while (!stream.atEnd()) {
+        quint32 size;
+        stream >> size;
+        if (stream.status() != QDataStream::Ok || size > maxRecordSize) {
+            break;
+        }
+        payload.resize(size);
+        quint16 checksum;
+        if (stream.readRawData(payload.data(), size) != static_cast<int>(size)) {
+            break;
+        }
+        stream >> checksum;
+        if (stream.status() != QDataStream::Ok
+            || checksum != qChecksum(payload.constData(), payload.size())) {
+            break;
+        }
+
+        QDataStream payloadStream(payload);
+        payloadStream.setVersion(QDataStream::Qt_5_6);
+        quint8 operation;
+        AlarmRecord alarm = AlarmRecord();
+        payloadStream >> operation >> alarm.key;
+        if (operation == PutRecord) {
+            payloadStream >> alarm.message >> alarm.date >> alarm.sound >> alarm.type
+                          >> alarm.days >> alarm.enabled;
+        }
+        if (payloadStream.status() != QDataStream::Ok || alarm.key == 0
+            || (operation != PutRecord && operation != RemoveRecord)) {
+            break;
+        }
+
+        if (operation == PutRecord) {
+            alarms.insert(alarm.key, alarm);
+        } else {
+            alarms.remove(alarm.key);
+        }
+        m_nextKey = qMax(m_nextKey, alarm.key + 1);
+        m_recordCount++;
+        m_validSize = file.pos();
+    }
+
+    if (m_validSize < file.size()) {
+        qWarning("AlarmJournal: dropping %lld damaged bytes at the end of '%s'",
+                 file.size() - m_validSize, qPrintable(m_fileName));
+    }
+
+    QVector<AlarmRecord> result;
+    result.reserve(alarms.count());
+    for (QMap<quint32, AlarmRecord>::const_iterator i = alarms.constBegin();
+         i != alarms.constEnd(); ++i) {
+        result.append(i.value());
+    }
+    return result;
+}
+
+bool AlarmJournal::put(const AlarmRecord &record)
+{
+    Q_ASSERT(record.key != 0);
+    return append(encodeRecord(PutRecord, record));
+}
+
+bool AlarmJournal::remove(quint32 key)
+{
+    AlarmRecord record = AlarmRecord();
+    record.key = key;
+    return append(encodeRecord(RemoveRecord, record));
+}
+
+bool AlarmJournal::compact(const QVector<AlarmRecord> &records)
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly) || !writeHeader(&file)) {
+        qWarning("AlarmJournal: can't write '%s'", qPrintable(m_fileName));
+        return false;
+    }
+    Q_FOREACH(const AlarmRecord &record, records) {
+        Q_ASSERT(record.key != 0);
+        file.write(encodeRecord(PutRecord, record));
+        m_nextKey = qMax(m_nextKey, record.key + 1);
+    }
+    const qint64 size = file.size();
+    if (!file.commit()) {
+        qWarning("AlarmJournal: can't write '%s'", qPrintable(m_fileName));
+        return false;
+    }
+    m_validSize = size;
+    m_recordCount = records.count();
+    return true;
+}
+
+bool AlarmJournal::append(const QByteArray &record)
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qWarning("AlarmJournal: can't write '%s'", qPrintable(m_fileName));
+        return false;
+    }
+    // Starts a new journal or cuts a damaged tail before appending.
+    if (m_validSize < headerSize) {
+        if (!file.resize(0) || !writeHeader(&file)) {
+            qWarning("AlarmJournal: can't write '%s'", qPrintable(m_fileName));
+            return false;
+        }
+        m_validSize = headerSize;
+    } else if (file.size() != m_validSize) {
+        file.resize(m_validSize);
+    }
+    if (!file.seek(m_validSize) || file.write(record) != record.size() || !file.flush()) {
+        qWarning("AlarmJournal: can't write '%s'", qPrintable(m_fileName));
+        return false;
+    }
+    m_validSize += record.size();
+    m_recordCount++;
+    return true;
+}
+
+UT_NAMESPACE_END
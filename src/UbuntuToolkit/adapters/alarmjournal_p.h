@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALARMJOURNAL_P_H
+#define ALARMJOURNAL_P_H
+
+#include <QtCore/QDateTime>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include <UbuntuToolkit/ubuntutoolkitglobal.h>
+
+UT_NAMESPACE_BEGIN
+
+// Alarm data stored by the fallback alarm manager. A key of 0 marks an alarm not in the journal.
+struct AlarmRecord
+{
+    quint32 key;
+    QString message;
+    QDateTime date;
+    QString sound;
+    qint32 type;
+    qint32 days;
+    bool enabled;
+};
+
+/*
+  Alarm database of the fallback alarm manager. Alarm changes are appended to the file as
+  checksummed records putting or removing the alarm of a key, a damaged tail left by an
+  interrupted write is dropped on load. Once the removed and replaced records outweigh the live
+  ones, the journal is compacted by rewriting it with the live alarms only.
+ */
+class UBUNTUTOOLKIT_EXPORT AlarmJournal
+{
+public:
+    explicit AlarmJournal(const QString &fileName);
+
+    QString fileName() const { return m_fileName; }
+    bool exists() const;
+
+    // Reads the journal and returns the live alarms ordered by key. Can be called from any
+    // thread as long as the journal isn't written meanwhile.
+    QVector<AlarmRecord> load();
+
+    // Returns an unused key.
+    quint32 takeKey() { return m_nextKey++; }
+
+    bool put(const AlarmRecord &record);
+    bool remove(quint32 key);
+
+    // Rewrites the journal with the given live alarms.
+    bool compact(const QVector<AlarmRecord> &records);
+    bool needsCompaction(int liveCount) const
+    {
+        return m_recordCount > 2 * liveCount + compactionSlack;
+    }
+
+    int recordCount() const { return m_recordCount; }
+
+    static const int compactionSlack = 64;
+
+private:
+    bool append(const QByteArray &record);
+
+    QString m_fileName;
+    qint64 m_validSize;
+    int m_recordCount;
+    quint32 m_nextKey;
+};
+
+UT_NAMESPACE_END
+
+#endif // ALARMJOURNAL_P_H
@@ -19,19 +19,21 @@
 #include "adapters/alarmsadapter_p.h"
 
 #include <QtCore/QFile>
-#include <QtCore/QDir>
 #include <QtCore/QTimeZone>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
 #include <QtCore/QDebug>
+#include <QtCore/QRunnable>
 #include <QtOrganizer/QtOrganizer>
 
 #include "alarmmanager_p_p.h"
 #include "ucalarm_p_p.h"
 
-static const QString alarmDatabase = QStringLiteral("%1/alarms.json");
+static const QString alarmDatabase = QStringLiteral("%1/alarms.journal");
+// JSON database used by earlier releases, migrated to the journal
+static const QString legacyAlarmDatabase = QStringLiteral("%1/alarms.json");
 
 // The main alarm manager engine used from Saucy onwards is EDS (Evolution Data
 // Server) based. Any previous release uses the generic "memory" manager engine
@@ -388,9 +390,17 @@ AlarmsAdapter::AlarmsAdapter(AlarmManager *qq)
     : QObject(qq)
     , AlarmManagerPrivate(qq)
     , manager(0)
+    , journal(alarmDatabase.arg(QStandardPaths::writableLocation(QStandardPaths::DataLocation)))
+    , loading(false)
+    , savingLoadedAlarms(false)
+    , journalOutdated(false)
 {
     // register QOrganizerItemId comparators so QVariant == operator can compare them
     QMetaType::registerComparators<QOrganizerItemId>();
+    // and the string conversion so models can tell alarms apart
+    if (!QMetaType::hasRegisteredConverterFunction<QOrganizerItemId, QString>()) {
+        QMetaType::registerConverter<QOrganizerItemId, QString>(&QOrganizerItemId::toString);
+    }
 
     QString envManager = QString::fromLocal8Bit(qgetenv("ALARM_BACKEND"));
     if (envManager.isEmpty())
@@ -427,6 +437,10 @@ AlarmsAdapter::AlarmsAdapter(AlarmManager *qq)
 
 void AlarmsAdapter::alarmOperation(QList<QPair<QOrganizerItemId,QOrganizerManager::Operation> > list)
 {
+    if (savingLoadedAlarms) {
+        // completeLoadAlarms() lists the loaded alarms in one go
+        return;
+    }
     typedef QPair<QOrganizerItemId,QOrganizerManager::Operation> OperationPair;
     Q_FOREACH(const OperationPair &op, list) {
         switch (op.second) {
@@ -440,12 +454,12 @@ void AlarmsAdapter::alarmOperation(QList<QPair<QOrganizerItemId,QOrganizerManage
         }
         case QOrganizerManager::Remove: {
             removeAlarm(op.first);
-            // save alarm data
             break;
         }
         }
+        // save alarm data
+        journalOperation(op.first, op.second);
     }
-    saveAlarms();
 }
 
 void AlarmsAdapter::init()
@@ -462,6 +476,8 @@ void AlarmsAdapter::init()
 
 AlarmsAdapter::~AlarmsAdapter()
 {
+    // the load job must not outlive the adapter
+    loadPool.waitForDone();
 }
 
 UCAlarmPrivate * AlarmsAdapter::createAlarmData(UCAlarm *alarm)
@@ -469,72 +485,194 @@ UCAlarmPrivate * AlarmsAdapter::createAlarmData(UCAlarm *alarm)
     return new AlarmDataAdapter(alarm);
 }
 
-// load fallback manager data
-void AlarmsAdapter::loadAlarms()
+static AlarmRecord alarmRecord(const UCAlarm &alarm, quint32 key)
 {
-    if (manager->managerName() != alarmManagerFallback) {
-        return;
-    }
-    QFile file(alarmDatabase.arg(QStandardPaths::writableLocation(QStandardPaths::DataLocation)));
+    AlarmRecord record;
+    record.key = key;
+    record.message = alarm.message();
+    record.date = alarm.date();
+    record.sound = alarm.sound().toString();
+    record.type = alarm.type();
+    record.days = alarm.daysOfWeek();
+    record.enabled = alarm.enabled();
+    return record;
+}
+
+// reads the JSON database of earlier releases, the alarms get journal keys once saved
+static QVector<AlarmRecord> loadLegacyAlarms(const QString &fileName)
+{
+    QVector<AlarmRecord> alarms;
+    QFile file(fileName);
     if (!file.open(QFile::ReadOnly)) {
-        return;
+        return alarms;
     }
-    QByteArray data = file.readAll();
-    QJsonDocument document(QJsonDocument::fromJson(data));
+    QJsonDocument document(QJsonDocument::fromJson(file.readAll()));
     QJsonArray array = document.array();
+    alarms.reserve(array.size());
     for (int i = 0; i < array.size(); i++) {
         QJsonObject object = array[i].toObject();
+        AlarmRecord record;
+        record.key = 0;
+        record.message = object[QStringLiteral("message")].toString();
+        record.date = QDateTime::fromString(object[QStringLiteral("date")].toString());
+        record.sound = object[QStringLiteral("sound")].toString();
+        record.type = object[QStringLiteral("type")].toInt();
+        record.days = object[QStringLiteral("days")].toInt();
+        record.enabled = object[QStringLiteral("enabled")].toBool();
+        alarms.append(record);
+    }
+    return alarms;
+}
 
-        // use UCAlarm to save store JSON data
-        UCAlarm alarm;
-        alarm.setMessage(object[QStringLiteral("message")].toString());
-        alarm.setDate(QDateTime::fromString(object[QStringLiteral("date")].toString()));
-        alarm.setSound(object[QStringLiteral("sound")].toString());
-        alarm.setType(static_cast<UCAlarm::AlarmType>(object[QStringLiteral("type")].toInt()));
-        alarm.setDaysOfWeek(
-            static_cast<UCAlarm::DaysOfWeek>(object[QStringLiteral("days")].toInt()));
-        alarm.setEnabled(object[QStringLiteral("enabled")].toBool());
+// reads the fallback manager database off the GUI thread
+class AlarmLoadJob : public QRunnable
+{
+public:
+    AlarmLoadJob(AlarmsAdapter *adapter)
+        : m_adapter(adapter)
+    {
+    }
 
-        AlarmDataAdapter *pAlarm = static_cast<AlarmDataAdapter*>(UCAlarmPrivate::get(&alarm));
+    void run() override
+    {
+        AlarmJournal &journal = m_adapter->journal;
+        if (journal.exists()) {
+            m_adapter->loadedAlarms = journal.load();
+        } else {
+            m_adapter->loadedAlarms = loadLegacyAlarms(legacyAlarmDatabase.arg(
+                QStandardPaths::writableLocation(QStandardPaths::DataLocation)));
+        }
+        QMetaObject::invokeMethod(m_adapter, "completeLoadAlarms", Qt::QueuedConnection);
+    }
+
+private:
+    AlarmsAdapter *m_adapter;
+};
+
+// load fallback manager data
+void AlarmsAdapter::loadAlarms()
+{
+    if (manager->managerName() != alarmManagerFallback) {
+        loadTime = 0;
+        return;
+    }
+    loading = true;
+    loadTimer.start();
+    loadPool.start(new AlarmLoadJob(this));
+}
+
+// stores the loaded alarms in the manager and lists them
+void AlarmsAdapter::completeLoadAlarms()
+{
+    // use one UCAlarm to convert the stored data
+    UCAlarm alarm;
+    AlarmDataAdapter *pAlarm = static_cast<AlarmDataAdapter*>(UCAlarmPrivate::get(&alarm));
+    QList<QOrganizerItem> items;
+    items.reserve(loadedAlarms.count());
+    Q_FOREACH(const AlarmRecord &record, loadedAlarms) {
+        pAlarm->reset();
+        alarm.setMessage(record.message);
+        alarm.setDate(record.date);
+        alarm.setSound(record.sound);
+        alarm.setType(static_cast<UCAlarm::AlarmType>(record.type));
+        alarm.setDaysOfWeek(static_cast<UCAlarm::DaysOfWeek>(record.days));
+        alarm.setEnabled(record.enabled);
         // call checkAlarm to complete field checks (i.e. type vs daysOfWeek, kick date, etc)
         pAlarm->checkAlarm();
-        QOrganizerTodo event = pAlarm->data();
-        manager->saveItem(&event);
+        items.append(pAlarm->data());
+    }
+
+    savingLoadedAlarms = true;
+    if (!items.isEmpty() && !manager->saveItems(&items)) {
+        qWarning() << "WARNING: not all the stored alarms could be loaded, error"
+                   << manager->error();
+    }
+    savingLoadedAlarms = false;
+
+    Q_EMIT q_ptr->alarmsRefreshStarted();
+    for (int i = 0; i < items.count(); i++) {
+        const QOrganizerItemId id = items[i].id();
+        if (id.isNull()) {
+            continue;
+        }
+        if (loadedAlarms[i].key) {
+            journalKeys.insert(id, loadedAlarms[i].key);
+        } else {
+            journalOutdated = true;
+        }
+        pAlarm->setData(static_cast<QOrganizerTodo>(items[i]));
+        adjustAlarmOccurrence(*pAlarm);
+        alarmList.add(alarm);
+    }
+    Q_EMIT q_ptr->alarmsRefreshed();
+
+    loadedAlarms.clear();
+    loading = false;
+    loadTime = loadTimer.elapsed();
+    // alarms changed while loading or migrated are saved with the loaded ones
+    if (journalOutdated || journal.needsCompaction(alarmList.count())) {
+        saveAlarms();
     }
-    file.close();
 }
 
-// save fallback manager data only
+// rewrites the fallback manager journal with the current alarms
 void AlarmsAdapter::saveAlarms()
 {
     if (manager->managerName() != alarmManagerFallback) {
         return;
     }
-    QDir dir(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
-    if (!dir.exists()) {
-        dir.mkpath(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
+    QVector<AlarmRecord> records;
+    QHash<QOrganizerItemId, quint32> keys;
+    records.reserve(alarmList.count());
+    Q_FOREACH(const UCAlarm *alarm, alarmList.alarms()) {
+        const QOrganizerItemId id = alarm->cookie().value<QOrganizerItemId>();
+        quint32 key = journalKeys.value(id);
+        if (!key) {
+            key = journal.takeKey();
+        }
+        keys.insert(id, key);
+        records.append(alarmRecord(*alarm, key));
+    }
+    journalKeys = keys;
+    journalOutdated = !journal.compact(records);
+}
+
+// appends an alarm change to the fallback manager journal
+void AlarmsAdapter::journalOperation(const QOrganizerItemId &id,
+                                     QOrganizerManager::Operation operation)
+{
+    if (manager->managerName() != alarmManagerFallback) {
+        return;
     }
-    QFile file(alarmDatabase.arg(dir.path()));
-    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    if (loading) {
+        // the journal gets rewritten once loaded
+        journalOutdated = true;
+        return;
+    }
+    if (journalOutdated) {
+        saveAlarms();
         return;
     }
-    QJsonArray data;
-    for(int i = 0; i < alarmList.count(); i++) {
-        // create an UCAlarm and set its event to ease conversions
-        const UCAlarm *alarm = alarmList[i];
-        QJsonObject object;
-        object[QStringLiteral("message")] = alarm->message();
-        object[QStringLiteral("date")] = alarm->date().toString();
-        object[QStringLiteral("sound")] = alarm->sound().toString();
-        object[QStringLiteral("type")] = QJsonValue(alarm->type());
-        object[QStringLiteral("days")] = QJsonValue((int)alarm->daysOfWeek());
-        object[QStringLiteral("enabled")] = QJsonValue(alarm->enabled());
-        data.append(object);
 
+    if (operation == QOrganizerManager::Remove) {
+        if (journalKeys.contains(id)) {
+            journalOutdated = !journal.remove(journalKeys.take(id));
+        }
+    } else {
+        QOrganizerTodo event = todoItem(id);
+        int index = event.isEmpty() ? -1 : alarmList.indexOf(event.id());
+        if (index < 0) {
+            return;
+        }
+        quint32 &key = journalKeys[event.id()];
+        if (!key) {
+            key = journal.takeKey();
+        }
+        journalOutdated = !journal.put(alarmRecord(*alarmList[index], key));
+    }
+    if (journalOutdated || journal.needsCompaction(alarmList.count())) {
+        saveAlarms();
     }
-    QJsonDocument document(data);
-    file.write(document.toJson());
-    file.close();
 }
 
 /*-----------------------------------------------------------------------------
@@ -785,7 +923,7 @@ void AlarmsAdapter::completeFetchAlarms()
         AlarmDataAdapter *pAlarm = static_cast<AlarmDataAdapter*>(UCAlarmPrivate::get(&alarm));
         pAlarm->setData(event);
         adjustAlarmOccurrence(*pAlarm);
-        alarmList.insert(alarm);
+        alarmList.add(alarm);
     }
 
     completed = true;
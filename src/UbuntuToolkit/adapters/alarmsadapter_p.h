@@ -19,6 +19,8 @@
 #ifndef ALARMSADAPTER_P_H
 #define ALARMSADAPTER_P_H
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThreadPool>
 #include <QtOrganizer/QOrganizerManager>
 #include <QtOrganizer/QOrganizerAbstractRequest>
 #include <QtOrganizer/QOrganizerItemFetchRequest>
@@ -27,6 +29,7 @@
 #include <UbuntuToolkit/ubuntutoolkitglobal.h>
 #include <UbuntuToolkit/private/ucalarm_p_p.h>
 #include <UbuntuToolkit/private/alarmmanager_p_p.h>
+#include <UbuntuToolkit/private/alarmjournal_p.h>
 
 QTORGANIZER_USE_NAMESPACE
 
@@ -123,6 +126,12 @@ public:
     }
     // insert an alarm event into the list
     int insert(const UCAlarm &alarm)
+    {
+        add(alarm);
+        return indexOf(alarm.cookie().value<QOrganizerItemId>());
+    }
+    // insert an alarm event without looking up its index
+    void add(const UCAlarm &alarm)
     {
         QDateTime dt = alarm.date();
         QOrganizerItemId id = alarm.cookie().value<QOrganizerItemId>();
@@ -130,7 +139,11 @@ public:
         UCAlarm *newAlarm = new UCAlarm;
         UCAlarmPrivate::get(newAlarm)->copyAlarmData(alarm);
         data.insert(QPair<QDateTime, QOrganizerItemId>(dt, id), newAlarm);
-        return indexOf(id);
+    }
+    // alarms in list order
+    QList<UCAlarm*> alarms() const
+    {
+        return data.values();
     }
     // returns the index of the alarm matching the id, -1 on error
     int indexOf(const QOrganizerItemId &id)
@@ -192,6 +205,7 @@ public:
 
     void loadAlarms();
     void saveAlarms();
+    void journalOperation(const QOrganizerItemId &id, QOrganizerManager::Operation operation);
 
     bool verifyChange(UCAlarm *alarm, AlarmManager::Change change, const QVariant &value) override;
     UCAlarmPrivate *createAlarmData(UCAlarm *alarm) override;
@@ -201,6 +215,7 @@ public:
     void removeAlarm(const QOrganizerItemId &id);
 
 private Q_SLOTS:
+    void completeLoadAlarms();
     void completeFetchAlarms();
     bool fetchAlarms() override;
     void alarmOperation(QList<QPair<QOrganizerItemId,QOrganizerManager::Operation> >);
@@ -209,6 +224,19 @@ protected:
     QPointer<QOrganizerItemFetchRequest> fetchRequest;
     AlarmList alarmList;
     QOrganizerTodo todoItem(const QOrganizerItemId &id);
+
+    // fallback manager database, journal keys are only valid for the session
+    AlarmJournal journal;
+    QHash<QOrganizerItemId, quint32> journalKeys;
+    // filled by the load job before completeLoadAlarms() is called
+    QVector<AlarmRecord> loadedAlarms;
+    QThreadPool loadPool;
+    QElapsedTimer loadTimer;
+    bool loading:1;
+    bool savingLoadedAlarms:1;
+    bool journalOutdated:1;
+
+    friend class AlarmLoadJob;
 };
 
 UT_NAMESPACE_END
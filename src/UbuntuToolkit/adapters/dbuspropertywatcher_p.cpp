@@ -19,6 +19,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCallWatcher>
 #include <QtDBus/QDBusReply>
 #include <QtQml/QQmlInfo>
 
@@ -38,7 +40,7 @@ DBusServiceProperties::DBusServiceProperties(UCServiceProperties *qq)
     : UCServicePropertiesPrivate(qq)
     , connection(QStringLiteral(""))
     , watcher(0)
-    , iface(0)
+    , readScheduled(false)
 {
 }
 
@@ -46,10 +48,14 @@ bool DBusServiceProperties::init()
 {
     // crear previous connections
     setStatus(UCServiceProperties::Inactive);
-    delete iface;
-    iface = 0;
     delete watcher;
     watcher = 0;
+    if (!objectPath.isEmpty()) {
+        connection.disconnect(service, objectPath, dbusInterface,
+                              QStringLiteral("PropertiesChanged"), this,
+                              SLOT(updateProperties(QString,QVariantMap,QStringList)));
+        objectPath.clear();
+    }
     setError(QString());
 
     if (service.isEmpty() || path.isEmpty()) {
@@ -76,17 +82,15 @@ bool DBusServiceProperties::init()
             return false;
         }
     }
+    if (!connection.isConnected()) {
+        setStatus(UCServiceProperties::ConnectionError);
+        setError(connection.lastError().message());
+        return false;
+    }
 
     Q_Q(UCServiceProperties);
     // connect dbus watcher to catch OwnerChanged
     watcher = new QDBusServiceWatcher(service, connection, QDBusServiceWatcher::WatchForOwnerChange, q);
-    // connect interface
-    iface = new QDBusInterface(service, path, interface, connection, q);
-    if (!iface->isValid()) {
-        setStatus(UCServiceProperties::ConnectionError);
-        setError(iface->lastError().message());
-        return false;
-    }
     // connect watcher to get owner changes
     QObject::connect(watcher, SIGNAL(serviceOwnerChanged(QString,QString,QString)),
                      this, SLOT(changeServiceOwner(QString,QString,QString)));
@@ -95,15 +99,18 @@ bool DBusServiceProperties::init()
 
 /*
  * Connect dbus signal identified by (service, path, iface, name) quaduple to a
- * slot to receive property changes.
+ * slot to receive property changes. The calls are built by hand, a QDBusInterface
+ * would introspect the service synchronously.
  */
 bool DBusServiceProperties::setupInterface()
 {
-    QDBusReply<QDBusObjectPath> dbusObjectPath =
-        iface->call(QStringLiteral("FindUserById"), qlonglong(getuid()));
+    QDBusMessage findUser = QDBusMessage::createMethodCall(
+        service, path, interface, QStringLiteral("FindUserById"));
+    findUser << qlonglong(getuid());
+    QDBusReply<QDBusObjectPath> dbusObjectPath = connection.call(findUser);
     if (dbusObjectPath.isValid()) {
         objectPath = dbusObjectPath.value().path();
-        iface->connection().connect(
+        connection.connect(
             service,
             objectPath,
             dbusInterface,
@@ -121,30 +128,54 @@ bool DBusServiceProperties::setupInterface()
 bool DBusServiceProperties::fetchPropertyValues()
 {
     scannedProperties = properties;
-    Q_FOREACH(QString property, properties) {
-        readProperty(property);
-    }
-    return true;
+    pendingProperties.clear();
+    return readProperties(properties);
 }
 
 /*
- * Reads a property value from the adaptorInterface asynchronously.
+ * Queues a property to be read from the adaptorInterface. The properties queued
+ * within an event loop iteration are read together.
  */
 bool DBusServiceProperties::readProperty(const QString &property)
 {
     if ((status < UCServiceProperties::Synchronizing) || objectPath.isEmpty()) {
         return false;
     }
-    Q_Q(UCServiceProperties);
-    QDBusInterface readIFace(iface->interface(), objectPath, dbusInterface, connection);
-    if (!readIFace.isValid()) {
-        // report invalid interface only if the property's first letter was with capital one!
-        if (property[0].isUpper()) {
-            warning(readIFace.lastError().message());
-        }
+    if (!pendingProperties.contains(property)) {
+        pendingProperties.append(property);
+    }
+    if (!readScheduled) {
+        readScheduled = true;
+        QMetaObject::invokeMethod(this, "readPendingProperties", Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void DBusServiceProperties::readPendingProperties()
+{
+    readScheduled = false;
+    if (pendingProperties.isEmpty()) {
+        return;
+    }
+    const QStringList names = pendingProperties;
+    pendingProperties.clear();
+    readProperties(names);
+}
+
+/*
+ * Reads property values from the adaptorInterface asynchronously, with a single
+ * GetAll round-trip.
+ */
+bool DBusServiceProperties::readProperties(const QStringList &names)
+{
+    if ((status < UCServiceProperties::Synchronizing) || objectPath.isEmpty()) {
         return false;
     }
-    QDBusPendingCall pending = readIFace.asyncCall(QStringLiteral("Get"), adaptor, property);
+    Q_Q(UCServiceProperties);
+    QDBusMessage getAll = QDBusMessage::createMethodCall(
+        service, objectPath, dbusInterface, QStringLiteral("GetAll"));
+    getAll << adaptor;
+    QDBusPendingCall pending = connection.asyncCall(getAll);
     if (pending.isError()) {
         warning(pending.error().message());
         return false;
@@ -153,11 +184,19 @@ bool DBusServiceProperties::readProperty(const QString &property)
     QObject::connect(callWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
                      this, SLOT(readFinished(QDBusPendingCallWatcher*)));
 
-    // set a dynamic property so we know which property are we reading
-    callWatcher->setProperty(dynamicProperty, property);
+    // set a dynamic property so we know which properties are we reading
+    callWatcher->setProperty(dynamicProperty, names);
     return true;
 }
 
+void DBusServiceProperties::setPropertyValue(QString property, const QVariant &value)
+{
+    Q_Q(UCServiceProperties);
+    // make sure we have lower case when the property value is updated
+    property[0] = property[0].toLower();
+    q->setProperty(property.toLocal8Bit().constData(), value);
+}
+
 /*
  * Writes a property value to theadaptorInterface synchronously. It is for pure testing purposes.
  */
@@ -166,13 +205,10 @@ bool DBusServiceProperties::testProperty(const QString &property, const QVariant
     if (objectPath.isEmpty()) {
         return false;
     }
-    QDBusInterface writeIFace(iface->interface(), objectPath, dbusInterface, connection);
-    if (!writeIFace.isValid()) {
-        // invalid interface
-        return false;
-    }
-    QDBusMessage msg = writeIFace.call(
-        QStringLiteral("Set"), adaptor, property, QVariant::fromValue(QDBusVariant(value)));
+    QDBusMessage set = QDBusMessage::createMethodCall(
+        service, objectPath, dbusInterface, QStringLiteral("Set"));
+    set << adaptor << property << QVariant::fromValue(QDBusVariant(value));
+    QDBusMessage msg = connection.call(set);
     return msg.type() == QDBusMessage::ReplyMessage;
 }
 
@@ -181,22 +217,29 @@ bool DBusServiceProperties::testProperty(const QString &property, const QVariant
  */
 void DBusServiceProperties::readFinished(QDBusPendingCallWatcher *call)
 {
-    Q_Q(UCServiceProperties);
-    QDBusPendingReply<QVariant> reply = *call;
-    QString property = call->property(dynamicProperty).toString();
-    scannedProperties.removeAll(property);
+    QDBusPendingReply<QVariantMap> reply = *call;
+    const QStringList names = call->property(dynamicProperty).toStringList();
+    Q_FOREACH(const QString &property, names) {
+        scannedProperties.removeAll(property);
+    }
     if (reply.isError()) {
-        // remove the property from being watched, as it has no property like that
-        properties.removeAll(property);
-        if (property[0].isUpper()) {
-            // report error!
-            warning(reply.error().message());
-        }
+        warning(reply.error().message());
     } else {
-        // update watched property value
-        // make sure we have lower case when the property value is updated
-        property[0] = property[0].toLower();
-        q->setProperty(property.toLocal8Bit().constData(), reply.value());
+        const QVariantMap values = reply.value();
+        Q_FOREACH(const QString &property, names) {
+            QVariantMap::const_iterator value = values.constFind(property);
+            if (value != values.constEnd()) {
+                // update watched property value
+                setPropertyValue(property, value.value());
+                continue;
+            }
+            // remove the property from being watched, as it has no property like that
+            properties.removeAll(property);
+            if (property[0].isUpper()) {
+                // report error!
+                warning(QStringLiteral("No such property '%1'").arg(property));
+            }
+        }
     }
 
     if ((status == UCServiceProperties::Synchronizing) && scannedProperties.isEmpty()) {
@@ -222,14 +265,23 @@ void DBusServiceProperties::changeServiceOwner(const QString &serviceName, const
 }
 
 /*
- * Slot called when the properties are changed in the service.
+ * Slot called when the properties are changed in the service. Changed values come
+ * with the signal, invalidated ones are read back.
  */
 void DBusServiceProperties::updateProperties(const QString &onInterface, const QVariantMap &map, const QStringList &invalidated)
 {
-    Q_UNUSED(onInterface);
-    Q_UNUSED(map);
+    if (!adaptor.isEmpty() && onInterface != adaptor) {
+        return;
+    }
+    for (QVariantMap::const_iterator i = map.constBegin(); i != map.constEnd(); ++i) {
+        if (properties.contains(i.key())) {
+            setPropertyValue(i.key(), i.value());
+        }
+    }
     Q_FOREACH(const QString &property, invalidated) {
-        readProperty(property);
+        if (properties.contains(property)) {
+            readProperty(property);
+        }
     }
 }
 
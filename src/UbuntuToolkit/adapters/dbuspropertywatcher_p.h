@@ -20,7 +20,6 @@
 #include <QtCore/QObject>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusServiceWatcher>
-#include <QtDBus/QDBusInterface>
 
 #include <UbuntuToolkit/private/ucserviceproperties_p_p.h>
 
@@ -42,14 +41,18 @@ public:
     bool testProperty(const QString &property, const QVariant &value) override;
 
     QStringList scannedProperties;
+    QStringList pendingProperties;
     QDBusConnection connection;
     QDBusServiceWatcher *watcher;
-    QDBusInterface *iface;
     QString objectPath;
+    bool readScheduled:1;
 
     bool setupInterface();
+    bool readProperties(const QStringList &names);
+    void setPropertyValue(QString property, const QVariant &value);
 
 public Q_SLOTS:
+    void readPendingProperties();
     void readFinished(QDBusPendingCallWatcher *watcher);
     void changeServiceOwner(const QString &serviceName, const QString &oldOwner, const QString &newOwner);
     void updateProperties(const QString &iface, const QVariantMap &map, const QStringList &invalidated);
@@ -24,6 +24,7 @@ UT_NAMESPACE_BEGIN
 
 AlarmManagerPrivate::AlarmManagerPrivate(AlarmManager *qq)
     : q_ptr(qq)
+    , loadTime(-1)
     , completed(false)
 {
 }
@@ -64,6 +65,11 @@ int AlarmManager::alarmCount()
     return d_ptr->alarmCount();
 }
 
+qint64 AlarmManager::loadTime() const
+{
+    return d_ptr->loadTime;
+}
+
 UCAlarm *AlarmManager::alarmAt(int index)
 {
     return d_ptr->getAlarmAt(index);
@@ -100,6 +100,7 @@ public:
 
     bool fetchAlarms();
     int alarmCount();
+    qint64 loadTime() const;
     UCAlarm *alarmAt(int index);
     UCAlarm *findAlarm(const QVariant &cookie) const;
 
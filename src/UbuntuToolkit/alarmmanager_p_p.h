@@ -43,6 +43,8 @@ public:
     }
 
     AlarmManager *q_ptr;
+    // time spent loading the stored alarms in milliseconds, -1 while loading
+    qint64 loadTime;
     bool completed:1;
 
     virtual void init() = 0;
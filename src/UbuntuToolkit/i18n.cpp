@@ -57,6 +57,183 @@ UT_NAMESPACE_BEGIN
  */
 UbuntuI18n *UbuntuI18n::m_i18 = nullptr;
 
+// the cache is dropped when it grows beyond this many translations
+static const int maxCachedTranslations = 4096;
+
+/*
+ * Evaluates the plural expression of a catalog's Plural-Forms header, which
+ * is a C expression of n, in order to key plural translations by the index of
+ * the plural form rather than by n. Untranslated messages take the English form
+ * instead, so the keys also tell whether n is 1.
+ */
+class PluralExpression
+{
+public:
+    PluralExpression(const QByteArray &expression, unsigned long n)
+        : m_p(expression.constData()), m_n(n), m_valid(true)
+    {}
+
+    // returns -1 if the expression cannot be evaluated
+    int evaluate()
+    {
+        unsigned long result = conditional();
+        skipSpaces();
+        return (m_valid && !*m_p) ? int(result) : -1;
+    }
+
+private:
+    void skipSpaces()
+    {
+        while (*m_p == ' ' || *m_p == '\t') {
+            m_p++;
+        }
+    }
+    bool accept(const char *token)
+    {
+        skipSpaces();
+        int length = qstrlen(token);
+        if (qstrncmp(m_p, token, length) != 0) {
+            return false;
+        }
+        // do not take the first character of a two characters operator
+        if (length == 1 && (m_p[1] == '=' || (m_p[1] == *token && (*token == '|' || *token == '&')))) {
+            return false;
+        }
+        m_p += length;
+        return true;
+    }
+
+    unsigned long conditional()
+    {
+        unsigned long condition = logicalOr();
+        if (!accept("?")) {
+            return condition;
+        }
+        unsigned long ifTrue = conditional();
+        if (!accept(":")) {
+            m_valid = false;
+            return 0;
+        }
+        unsigned long ifFalse = conditional();
+        return condition ? ifTrue : ifFalse;
+    }
+    unsigned long logicalOr()
+    {
+        unsigned long result = logicalAnd();
+        while (accept("||")) {
+            unsigned long right = logicalAnd();
+            result = result || right;
+        }
+        return result;
+    }
+    unsigned long logicalAnd()
+    {
+        unsigned long result = equality();
+        while (accept("&&")) {
+            unsigned long right = equality();
+            result = result && right;
+        }
+        return result;
+    }
+    unsigned long equality()
+    {
+        unsigned long result = relational();
+        Q_FOREVER {
+            if (accept("==")) {
+                result = result == relational();
+            } else if (accept("!=")) {
+                result = result != relational();
+            } else {
+                return result;
+            }
+        }
+    }
+    unsigned long relational()
+    {
+        unsigned long result = additive();
+        Q_FOREVER {
+            if (accept("<=")) {
+                result = result <= additive();
+            } else if (accept(">=")) {
+                result = result >= additive();
+            } else if (accept("<")) {
+                result = result < additive();
+            } else if (accept(">")) {
+                result = result > additive();
+            } else {
+                return result;
+            }
+        }
+    }
+    unsigned long additive()
+    {
+        unsigned long result = multiplicative();
+        Q_FOREVER {
+            if (accept("+")) {
+                result += multiplicative();
+            } else if (accept("-")) {
+                result -= multiplicative();
+            } else {
+                return result;
+            }
+        }
+    }
+    unsigned long multiplicative()
+    {
+        unsigned long result = unary();
+        Q_FOREVER {
+            if (accept("*")) {
+                result *= unary();
+            } else if (accept("/") || accept("%")) {
+                const bool modulo = m_p[-1] == '%';
+                unsigned long right = unary();
+                if (!right) {
+                    m_valid = false;
+                    return 0;
+                }
+                result = modulo ? result % right : result / right;
+            } else {
+                return result;
+            }
+        }
+    }
+    unsigned long unary()
+    {
+        if (accept("!")) {
+            return !unary();
+        }
+        return primary();
+    }
+    unsigned long primary()
+    {
+        skipSpaces();
+        if (*m_p == 'n') {
+            m_p++;
+            return m_n;
+        }
+        if (*m_p >= '0' && *m_p <= '9') {
+            unsigned long value = 0;
+            while (*m_p >= '0' && *m_p <= '9') {
+                value = value * 10 + (*m_p++ - '0');
+            }
+            return value;
+        }
+        if (accept("(")) {
+            unsigned long value = conditional();
+            if (!accept(")")) {
+                m_valid = false;
+            }
+            return value;
+        }
+        m_valid = false;
+        return 0;
+    }
+
+    const char *m_p;
+    unsigned long m_n;
+    bool m_valid;
+};
+
 UbuntuI18n::UbuntuI18n(QObject* parent) : QObject(parent)
 {
     /*
@@ -76,6 +253,89 @@ UbuntuI18n::~UbuntuI18n()
     m_i18 = nullptr;
 }
 
+/*!
+ * \internal
+ * Returns the translation cache hit and miss counts.
+ */
+UbuntuI18n::CacheStatistics UbuntuI18n::cacheStatistics() const
+{
+    return m_cacheStatistics;
+}
+
+/*!
+ * \internal
+ * Drops the cached translations, along with the statistics.
+ */
+void UbuntuI18n::clearCache()
+{
+    m_cache.clear();
+    m_pluralForms.clear();
+    m_cacheStatistics = CacheStatistics();
+}
+
+bool UbuntuI18n::cachedTranslation(const TranslationKey &key, QString *translation)
+{
+    if (!key.plural.isNull() && key.pluralIndex < 0) {
+        // unknown plural form
+        m_cacheStatistics.misses++;
+        return false;
+    }
+    QHash<TranslationKey, QString>::const_iterator i = m_cache.constFind(key);
+    if (i == m_cache.constEnd()) {
+        m_cacheStatistics.misses++;
+        return false;
+    }
+    m_cacheStatistics.hits++;
+    *translation = *i;
+    return true;
+}
+
+QString UbuntuI18n::cacheTranslation(const TranslationKey &key, const QString &translation)
+{
+    // plural translations whose form could not be determined are not cached
+    if (key.plural.isNull() || key.pluralIndex >= 0) {
+        if (m_cache.size() >= maxCachedTranslations) {
+            m_cache.clear();
+        }
+        m_cache.insert(key, translation);
+    }
+    return translation;
+}
+
+// returns the index of the plural form to be used for n in the catalog of the domain
+int UbuntuI18n::pluralIndex(const QString &domain, int n)
+{
+    QHash<QString, QByteArray>::const_iterator i = m_pluralForms.constFind(domain);
+    if (i == m_pluralForms.constEnd()) {
+        // the catalog header is the translation of the empty string
+        const QByteArray header(domain.isEmpty() ? C::gettext("") : C::dgettext(domain.toUtf8(), ""));
+        // gettext defaults to germanic plural forms without catalog
+        QByteArray expression("n != 1");
+        const int formsPosition = header.indexOf("Plural-Forms:");
+        int pluralPosition = formsPosition >= 0 ? header.indexOf("plural=", formsPosition) : -1;
+        if (pluralPosition >= 0) {
+            pluralPosition += qstrlen("plural=");
+            int end = pluralPosition;
+            while (end < header.size() && header.at(end) != ';' && header.at(end) != '\n') {
+                end++;
+            }
+            expression = header.mid(pluralPosition, end - pluralPosition);
+        }
+        i = m_pluralForms.insert(domain, expression);
+    }
+    return evaluatePluralExpression(*i, (unsigned long)n);
+}
+
+/*!
+ * \internal
+ * Evaluates the C expression of n given as plural= in a catalog's Plural-Forms
+ * header, returns the index of the plural form or -1 if the expression is invalid.
+ */
+int UbuntuI18n::evaluatePluralExpression(const QByteArray &expression, unsigned long n)
+{
+    return PluralExpression(expression, n).evaluate();
+}
+
 /*!
  * \qmlproperty string i18n::domain
  * The gettext domain to be used for the translation. The default domain
@@ -105,6 +365,7 @@ QString UbuntuI18n::language() const {
  */
 void UbuntuI18n::bindtextdomain(const QString& domain_name, const QString& dir_name) {
     C::bindtextdomain(domain_name.toUtf8(), dir_name.toUtf8());
+    clearCache();
     Q_EMIT domainChanged();
 }
 
@@ -113,6 +374,7 @@ void UbuntuI18n::setDomain(const QString &domain) {
         return;
 
     m_domain = domain;
+    clearCache();
     C::textdomain(domain.toUtf8());
     /*
      The default is /usr/share/locale if we don't set a folder
@@ -133,6 +395,7 @@ void UbuntuI18n::setLanguage(const QString &lang) {
         return;
 
     m_language = lang;
+    clearCache();
 
     /*
      This is needed for LP: #1263163.
@@ -162,7 +425,12 @@ void UbuntuI18n::setLanguage(const QString &lang) {
  */
 QString UbuntuI18n::tr(const QString& text)
 {
-    return QString::fromUtf8(C::gettext(text.toUtf8()));
+    TranslationKey key(m_domain, QString(), text);
+    QString translation;
+    if (cachedTranslation(key, &translation)) {
+        return translation;
+    }
+    return cacheTranslation(key, QString::fromUtf8(C::gettext(text.toUtf8())));
 }
 
 /*!
@@ -175,7 +443,12 @@ QString UbuntuI18n::tr(const QString& text)
  */
 QString UbuntuI18n::tr(const QString &singular, const QString &plural, int n)
 {
-    return QString::fromUtf8(C::ngettext(singular.toUtf8(), plural.toUtf8(), n));
+    TranslationKey key(m_domain, QString(), singular, plural, pluralIndex(m_domain, n), n == 1);
+    QString translation;
+    if (cachedTranslation(key, &translation)) {
+        return translation;
+    }
+    return cacheTranslation(key, QString::fromUtf8(C::ngettext(singular.toUtf8(), plural.toUtf8(), n)));
 }
 
 /*!
@@ -184,11 +457,14 @@ QString UbuntuI18n::tr(const QString &singular, const QString &plural, int n)
  */
 QString UbuntuI18n::dtr(const QString& domain, const QString& text)
 {
-    if (domain.isNull()) {
-        return QString::fromUtf8(C::dgettext(NULL, text.toUtf8()));
-    } else {
-        return QString::fromUtf8(C::dgettext(domain.toUtf8(), text.toUtf8()));
+    TranslationKey key(domain.isNull() ? m_domain : domain, QString(), text);
+    QString translation;
+    if (cachedTranslation(key, &translation)) {
+        return translation;
     }
+    return cacheTranslation(key, domain.isNull()
+        ? QString::fromUtf8(C::dgettext(NULL, text.toUtf8()))
+        : QString::fromUtf8(C::dgettext(domain.toUtf8(), text.toUtf8())));
 }
 
 /*!
@@ -200,11 +476,15 @@ QString UbuntuI18n::dtr(const QString& domain, const QString& text)
  */
 QString UbuntuI18n::dtr(const QString& domain, const QString& singular, const QString& plural, int n)
 {
-    if (domain.isNull()) {
-        return QString::fromUtf8(C::dngettext(NULL, singular.toUtf8(), plural.toUtf8(), n));
-    } else {
-        return QString::fromUtf8(C::dngettext(domain.toUtf8(), singular.toUtf8(), plural.toUtf8(), n));
+    const QString keyDomain(domain.isNull() ? m_domain : domain);
+    TranslationKey key(keyDomain, QString(), singular, plural, pluralIndex(keyDomain, n), n == 1);
+    QString translation;
+    if (cachedTranslation(key, &translation)) {
+        return translation;
     }
+    return cacheTranslation(key, domain.isNull()
+        ? QString::fromUtf8(C::dngettext(NULL, singular.toUtf8(), plural.toUtf8(), n))
+        : QString::fromUtf8(C::dngettext(domain.toUtf8(), singular.toUtf8(), plural.toUtf8(), n)));
 }
 
 /*!
@@ -224,11 +504,14 @@ QString UbuntuI18n::ctr(const QString& context, const QString& text)
  */
 QString UbuntuI18n::dctr(const QString& domain, const QString& context, const QString& text)
 {
-    if (domain.isNull()) {
-        return QString::fromUtf8(C::g_dpgettext2(NULL, context.toUtf8(), text.toUtf8()));
-    } else {
-        return QString::fromUtf8(C::g_dpgettext2(domain.toUtf8(), context.toUtf8(), text.toUtf8()));
+    TranslationKey key(domain.isNull() ? m_domain : domain, context, text);
+    QString translation;
+    if (cachedTranslation(key, &translation)) {
+        return translation;
     }
+    return cacheTranslation(key, domain.isNull()
+        ? QString::fromUtf8(C::g_dpgettext2(NULL, context.toUtf8(), text.toUtf8()))
+        : QString::fromUtf8(C::g_dpgettext2(domain.toUtf8(), context.toUtf8(), text.toUtf8())));
 }
 
 /*!
@@ -19,6 +19,7 @@
 #ifndef I18N_P_H
 #define I18N_P_H
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 
 #include <UbuntuToolkit/ubuntutoolkitglobal.h>
@@ -61,6 +62,20 @@ public:
     Q_INVOKABLE QString tag(const QString& context, const QString& text);
     Q_INVOKABLE QString relativeDateTime(const QDateTime& datetime);
 
+    // translation cache statistics
+    struct CacheStatistics {
+        CacheStatistics() :
+            hits(0), misses(0)
+        {}
+        quint32 hits;
+        quint32 misses;
+    };
+    CacheStatistics cacheStatistics() const;
+    void clearCache();
+
+    // evaluates the plural expression of a Plural-Forms header, returns -1 if invalid
+    static int evaluatePluralExpression(const QByteArray &expression, unsigned long n);
+
     // getter
     QString domain() const;
     QString language() const;
@@ -74,9 +89,44 @@ Q_SIGNALS:
     void languageChanged();
 
 private:
+    struct TranslationKey {
+        TranslationKey(const QString &domain, const QString &context, const QString &text,
+                       const QString &plural = QString(), int pluralIndex = -1, bool one = false)
+            : domain(domain), context(context), text(text), plural(plural), pluralIndex(pluralIndex)
+            , one(one)
+        {}
+        bool operator==(const TranslationKey &other) const
+        {
+            return pluralIndex == other.pluralIndex && one == other.one && text == other.text
+                && context == other.context && plural == other.plural && domain == other.domain;
+        }
+        friend uint qHash(const TranslationKey &key, uint seed = 0)
+        {
+            return qHash(key.text, seed) ^ qHash(key.context, seed) ^ qHash(key.domain, seed)
+                ^ qHash(key.plural, seed) ^ uint(key.pluralIndex + 1) ^ (uint(key.one) << 16);
+        }
+
+        QString domain;
+        QString context;
+        QString text;
+        QString plural;
+        int pluralIndex;
+        // gettext falls back to the English forms for untranslated messages, which do not
+        // follow the plural forms of the catalog
+        bool one;
+    };
+
+    bool cachedTranslation(const TranslationKey &key, QString *translation);
+    QString cacheTranslation(const TranslationKey &key, const QString &translation);
+    int pluralIndex(const QString &domain, int n);
+
     static UbuntuI18n *m_i18;
     QString m_domain;
     QString m_language;
+    QHash<TranslationKey, QString> m_cache;
+    // plural form expression of the catalogs, per domain
+    QHash<QString, QByteArray> m_pluralForms;
+    CacheStatistics m_cacheStatistics;
 };
 
 UT_NAMESPACE_END
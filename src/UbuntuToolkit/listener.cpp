@@ -16,7 +16,11 @@
 
 #include "listener_p.h"
 
+#include <QtCore/QPointer>
+#include <QtCore/QThread>
 #include <QtQml/QQmlContext>
+#include <QtQml/private/qqmlengine_p.h>
+#include <QtQml/private/qqmljavascriptexpression_p.h>
 
 UT_NAMESPACE_BEGIN
 
@@ -33,4 +37,37 @@ void ContextPropertyChangeListener::updateContextProperty()
     m_context->setContextProperty(m_contextProperty, value);
 }
 
+static QList<QPointer<QQmlEngine> > &trackedEngines()
+{
+    static QList<QPointer<QQmlEngine> > engines;
+    return engines;
+}
+
+void BindingNotifier::registerEngine(QQmlEngine *engine)
+{
+    QList<QPointer<QQmlEngine> > &engines = trackedEngines();
+    engines.removeAll(QPointer<QQmlEngine>());
+    if (!engines.contains(engine)) {
+        engines.append(engine);
+    }
+}
+
+void BindingNotifier::capture()
+{
+    const QList<QPointer<QQmlEngine> > &engines = trackedEngines();
+    for (int i = 0; i < engines.count(); i++) {
+        QQmlEngine *engine = engines.at(i);
+        // the functions can be called from the render thread too
+        if (!engine || engine->thread() != QThread::currentThread()) {
+            continue;
+        }
+        // only set while an engine evaluates a binding
+        QQmlPropertyCapture *propertyCapture = QQmlEnginePrivate::get(engine)->propertyCapture;
+        if (propertyCapture) {
+            propertyCapture->captureProperty(&m_notifier);
+            return;
+        }
+    }
+}
+
 UT_NAMESPACE_END
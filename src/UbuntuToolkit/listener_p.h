@@ -18,10 +18,12 @@
 #define LISTENER_P_H
 
 #include <QtCore/QObject>
+#include <QtQml/private/qqmlnotifier_p.h>
 
 #include <UbuntuToolkit/ubuntutoolkitglobal.h>
 
 class QQmlContext;
+class QQmlEngine;
 
 UT_NAMESPACE_BEGIN
 
@@ -35,6 +37,29 @@ public:
     QString m_contextProperty;
 };
 
+/*
+  Lets bindings depend on the result of invokable functions. A binding calling a function which
+  captures the notifier is re-evaluated when the notifier is notified, as if it had read a
+  NOTIFYable property. Contrary to re-setting a context property, bindings only using other
+  members of the context property are left alone.
+ */
+class UBUNTUTOOLKIT_EXPORT BindingNotifier
+{
+public:
+    // Tracks the bindings evaluated by the given engine.
+    static void registerEngine(QQmlEngine *engine);
+
+    // Makes the binding being evaluated in the GUI thread, if any, depend on the notifier.
+    void capture();
+    void notify()
+    {
+        m_notifier.notify();
+    }
+
+private:
+    QQmlNotifier m_notifier;
+};
+
 UT_NAMESPACE_END
 
 #endif // LISTENER_P_H
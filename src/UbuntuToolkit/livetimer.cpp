@@ -53,6 +53,10 @@ LiveTimer::LiveTimer(QObject *parent)
     , m_frequency(Disabled)
     , m_effectiveFrequency(Disabled)
     , m_lastUpdate(0)
+    , m_bucketIndex(-1)
+    , m_wheelSlot(-1)
+    , m_wheelIndex(-1)
+    , m_transitionSecs(0)
 {
 }
 
@@ -126,7 +130,8 @@ void LiveTimer::registerTimer()
 {
     SharedLiveTimer::instance().registerTimer(this);
 
-    QObject::connect(&SharedLiveTimer::instance(), &SharedLiveTimer::trigger, this, &LiveTimer::trigger);
+    QObject::connect(&SharedLiveTimer::instance(), &SharedLiveTimer::trigger, this, &LiveTimer::trigger,
+                     Qt::UniqueConnection);
 }
 
 void LiveTimer::unregisterTimer()
@@ -24,6 +24,146 @@ static const QString dbusService = QStringLiteral("org.freedesktop.timedate1");
 
 UT_NAMESPACE_BEGIN
 
+// Returns the time in milliseconds since the epoch from which the effective frequency of a relative
+// timer can change, following the thresholds of getDateProximity(), or 0 if it can't change anymore.
+static qint64 nextFrequencyTransition(const QDateTime &now, const QDateTime &time)
+{
+    const qint64 nowMs = now.toMSecsSinceEpoch();
+    const qint64 timeMs = time.toMSecsSinceEpoch();
+    // Hour to minute, minute to second, second to minute and minute to hour, then disabled once
+    // the time is before the last week.
+    const qint64 transitions[] = {
+        timeMs - 3600000 + 1,
+        timeMs - 30000 + 1,
+        timeMs + 30000,
+        timeMs + 3600000,
+        QDateTime(time.toLocalTime().date().addDays(7), QTime(0, 0, 0, 0)).toMSecsSinceEpoch()
+    };
+
+    qint64 next = 0;
+    for (qint64 transition : transitions) {
+        if (transition > nowMs && (next == 0 || transition < next)) {
+            next = transition;
+        }
+    }
+    return next;
+}
+
+LiveTimerWheel::LiveTimerWheel()
+    : m_currentSecs(0)
+    , m_count(0)
+{
+}
+
+void LiveTimerWheel::reset(qint64 nowSecs)
+{
+    Q_ASSERT(m_count == 0);
+    m_currentSecs = nowSecs;
+}
+
+void LiveTimerWheel::insert(LiveTimer *timer, qint64 dueSecs)
+{
+    remove(timer);
+    // The slot of the current second has already been expired.
+    timer->m_transitionSecs = qMax(dueSecs, m_currentSecs + 1);
+    place(timer);
+}
+
+void LiveTimerWheel::remove(LiveTimer *timer)
+{
+    if (timer->m_wheelSlot < 0) {
+        return;
+    }
+
+    QVector<LiveTimer*> &slot = m_slots[timer->m_wheelSlot];
+    LiveTimer *last = slot.last();
+    slot[timer->m_wheelIndex] = last;
+    last->m_wheelIndex = timer->m_wheelIndex;
+    slot.removeLast();
+    timer->m_wheelSlot = -1;
+    m_count--;
+}
+
+void LiveTimerWheel::advance(qint64 nowSecs, QVector<LiveTimer*> *expired)
+{
+    if (nowSecs < m_currentSecs || nowSecs - m_currentSecs >= (1 << (2 * slotBits))) {
+        for (int slot = 0; slot <= overflowSlot; slot++) {
+            takeSlot(slot, expired);
+        }
+        m_currentSecs = nowSecs;
+        return;
+    }
+
+    while (m_currentSecs < nowSecs && m_count > 0) {
+        const qint64 secs = ++m_currentSecs;
+
+        // Cascade the slots of the levels starting a new turn, from the top one so that timers
+        // can go down several levels at once.
+        int level = 0;
+        while (level < levelCount
+               && (secs & ((Q_INT64_C(1) << (slotBits * (level + 1))) - 1)) == 0) {
+            level++;
+        }
+        for (; level > 0; level--) {
+            if (level == levelCount) {
+                cascade(overflowSlot);
+            } else {
+                cascade(level * slotCount + ((secs >> (slotBits * level)) & (slotCount - 1)));
+            }
+        }
+
+        takeSlot(secs & (slotCount - 1), expired);
+    }
+    m_currentSecs = nowSecs;
+}
+
+void LiveTimerWheel::insertAt(LiveTimer *timer, int slot)
+{
+    timer->m_wheelSlot = slot;
+    timer->m_wheelIndex = m_slots[slot].count();
+    m_slots[slot].append(timer);
+    m_count++;
+}
+
+void LiveTimerWheel::place(LiveTimer *timer)
+{
+    const qint64 due = timer->m_transitionSecs;
+    const qint64 delta = due - m_currentSecs;
+    for (int level = 0; level < levelCount; level++) {
+        if (delta < (Q_INT64_C(1) << (slotBits * (level + 1)))) {
+            insertAt(timer, level * slotCount + ((due >> (slotBits * level)) & (slotCount - 1)));
+            return;
+        }
+    }
+    insertAt(timer, overflowSlot);
+}
+
+void LiveTimerWheel::cascade(int slot)
+{
+    if (m_slots[slot].isEmpty()) {
+        return;
+    }
+
+    QVector<LiveTimer*> timers;
+    takeSlot(slot, &timers);
+    for (LiveTimer *timer : timers) {
+        place(timer);
+    }
+}
+
+void LiveTimerWheel::takeSlot(int slot, QVector<LiveTimer*> *timers)
+{
+    QVector<LiveTimer*> &slotTimers = m_slots[slot];
+    for (LiveTimer *timer : slotTimers) {
+        timer->m_wheelSlot = -1;
+        timers->append(timer);
+    }
+    m_count -= slotTimers.count();
+    slotTimers.resize(0);
+}
+
+////////////////////////////////////////// SharedLiveTimer /////////////////////////////////////////
+
 SharedLiveTimer::SharedLiveTimer(QObject* parent)
     : QObject(parent)
     , m_frequency(LiveTimer::Disabled)
@@ -39,38 +179,78 @@ SharedLiveTimer::SharedLiveTimer(QObject* parent)
 
 void SharedLiveTimer::registerTimer(LiveTimer *timer)
 {
-    if (m_liveTimers.contains(timer)) {
-        unregisterTimer(timer);
-    }
-    m_liveTimers.append(timer);
+    evaluate(timer, QDateTime::currentDateTime());
     updateFrequency();
 }
 
 void SharedLiveTimer::unregisterTimer(LiveTimer *timer)
 {
-    if (!m_liveTimers.contains(timer)) return;
+    if (timer->m_bucketIndex < 0) return;
 
-    m_liveTimers.removeAll(timer);
+    removeFromBucket(timer);
+    m_transitions.remove(timer);
     updateFrequency();
 }
 
-void SharedLiveTimer::updateFrequency()
+// Puts the timer in the bucket of its effective frequency, relative timers are scheduled for
+// re-evaluation when their proximity can change.
+void SharedLiveTimer::evaluate(LiveTimer *timer, const QDateTime &now)
 {
-    LiveTimer::Frequency newFreq = LiveTimer::Disabled;
-    if (m_liveTimers.count() == 0) {
-        newFreq = LiveTimer::Disabled;
-    } else {
-        Q_FOREACH(LiveTimer* timer, m_liveTimers) {
-            LiveTimer::Frequency freq = timer->frequency();
-            if (freq == LiveTimer::Relative) {
-                date_proximity_t proximity = getDateProximity(QDateTime::currentDateTime(), timer->relativeTime());
-                freq = frequencyForProximity(proximity);
-            }
-            timer->setEffectiveFrequency(freq);
+    if (timer->m_bucketIndex >= 0) {
+        removeFromBucket(timer);
+        m_transitions.remove(timer);
+    }
+
+    LiveTimer::Frequency freq = timer->frequency();
+    if (freq == LiveTimer::Relative) {
+        date_proximity_t proximity = getDateProximity(now, timer->relativeTime());
+        freq = frequencyForProximity(proximity);
 
-            if (freq != LiveTimer::Disabled && (newFreq == LiveTimer::Disabled || freq < newFreq)) {
-                newFreq =  freq;
+        const qint64 transition = nextFrequencyTransition(now, timer->relativeTime());
+        if (transition > 0) {
+            if (m_transitions.count() == 0) {
+                m_transitions.reset(now.toMSecsSinceEpoch() / 1000);
             }
+            m_transitions.insert(timer, (transition + 999) / 1000);
+        }
+    }
+    timer->setEffectiveFrequency(freq);
+    addToBucket(timer, freq);
+}
+
+void SharedLiveTimer::addToBucket(LiveTimer *timer, LiveTimer::Frequency frequency)
+{
+    QVector<LiveTimer*> &bucket = m_buckets[frequency];
+    timer->m_bucketIndex = bucket.count();
+    bucket.append(timer);
+}
+
+void SharedLiveTimer::removeFromBucket(LiveTimer *timer)
+{
+    QVector<LiveTimer*> &bucket = m_buckets[timer->effectiveFrequency()];
+    LiveTimer *last = bucket.last();
+    bucket[timer->m_bucketIndex] = last;
+    last->m_bucketIndex = timer->m_bucketIndex;
+    bucket.removeLast();
+    timer->m_bucketIndex = -1;
+}
+
+void SharedLiveTimer::triggerBucket(LiveTimer::Frequency frequency)
+{
+    // Slots can register and unregister timers, go through a shallow copy.
+    const QVector<LiveTimer*> timers(m_buckets[frequency]);
+    for (LiveTimer *timer : timers) {
+        Q_EMIT timer->trigger();
+    }
+}
+
+void SharedLiveTimer::updateFrequency()
+{
+    LiveTimer::Frequency newFreq = LiveTimer::Disabled;
+    for (int freq = LiveTimer::Second; freq <= LiveTimer::Hour; freq++) {
+        if (!m_buckets[freq].isEmpty()) {
+            newFreq = static_cast<LiveTimer::Frequency>(freq);
+            break;
         }
     }
     if (newFreq != m_frequency) {
@@ -119,6 +299,12 @@ void SharedLiveTimer::timeout()
         return;
     }
 
+    update(now);
+    reInitTimer();
+}
+
+void SharedLiveTimer::update(const QDateTime &now)
+{
     bool isHourUpdate = m_lastUpdate.date() != now.date() ||
             m_lastUpdate.time().hour() != now.time().hour();
     bool isMinuteUpdate = isHourUpdate ||
@@ -126,36 +312,24 @@ void SharedLiveTimer::timeout()
     bool isSecondUpdate = isMinuteUpdate ||
             m_lastUpdate.time().second() != now.time().second();
 
-    bool needsFrequencyUpdate = false;
-    QList<LiveTimer*> tmpTimers(m_liveTimers);
-    Q_FOREACH(LiveTimer* timer, tmpTimers) {
-
-        LiveTimer::Frequency effectiveFrequency = timer->effectiveFrequency();
-        if (effectiveFrequency == LiveTimer::Disabled) continue;
-
-        if (isHourUpdate) {
-            Q_EMIT timer->trigger();
-        } else if (isMinuteUpdate) {
-            if (effectiveFrequency >= LiveTimer::Second && effectiveFrequency <= LiveTimer::Minute) {
-                Q_EMIT timer->trigger();
-            }
-        } else if (isSecondUpdate) {
-            if (effectiveFrequency == LiveTimer::Second) {
-                Q_EMIT timer->trigger();
-            }
-        }
-
-        // re-evaluate relative timer frequency
-        if (timer->frequency() == LiveTimer::Relative) {
-            date_proximity_t newProximity = getDateProximity(now, timer->relativeTime());
-            needsFrequencyUpdate |= effectiveFrequency != frequencyForProximity(newProximity);
-        }
+    if (isHourUpdate) {
+        triggerBucket(LiveTimer::Hour);
+    }
+    if (isMinuteUpdate) {
+        triggerBucket(LiveTimer::Minute);
+    }
+    if (isSecondUpdate) {
+        triggerBucket(LiveTimer::Second);
     }
 
-    if (needsFrequencyUpdate) {
-        updateFrequency();
+    // Only the relative timers crossing a proximity threshold are re-evaluated.
+    m_transitions.advance(now.toMSecsSinceEpoch() / 1000, &m_expired);
+    for (LiveTimer *timer : m_expired) {
+        evaluate(timer, now);
     }
-    reInitTimer();
+    m_expired.resize(0);
+
+    updateFrequency();
     m_lastUpdate = now;
 }
 
@@ -164,10 +338,22 @@ void SharedLiveTimer::timedate1PropertiesChanged(const QString &interface, const
     if (interface != dbusService) return;
     if (!changed.contains(QStringLiteral("Timezone"))) return;
 
-    QList<LiveTimer*> tmpTimers(m_liveTimers);
-    Q_FOREACH(LiveTimer* timer, tmpTimers) {
-        Q_EMIT timer->trigger();
+    QVector<LiveTimer*> relativeTimers;
+    for (int freq = LiveTimer::Disabled; freq <= LiveTimer::Hour; freq++) {
+        triggerBucket(static_cast<LiveTimer::Frequency>(freq));
+        for (LiveTimer *timer : m_buckets[freq]) {
+            if (timer->frequency() == LiveTimer::Relative) {
+                relativeTimers.append(timer);
+            }
+        }
     }
+
+    // The local dates changed, so do the transitions of the relative timers.
+    const QDateTime now(QDateTime::currentDateTime());
+    for (LiveTimer *timer : relativeTimers) {
+        evaluate(timer, now);
+    }
+    updateFrequency();
     reInitTimer();
 }
 
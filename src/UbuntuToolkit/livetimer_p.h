@@ -66,7 +66,14 @@ private:
     QDateTime m_relativeTime;
     quint64 m_lastUpdate;
 
+    // Bookkeeping of SharedLiveTimer.
+    int m_bucketIndex;
+    int m_wheelSlot;
+    int m_wheelIndex;
+    qint64 m_transitionSecs;
+
     friend class SharedLiveTimer;
+    friend class LiveTimerWheel;
 };
 
 UT_NAMESPACE_END
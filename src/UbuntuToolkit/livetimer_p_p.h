@@ -20,10 +20,46 @@
 #include <UbuntuToolkit/private/livetimer_p.h>
 
 #include <QtCore/QTimer>
+#include <QtCore/QVector>
 
 UT_NAMESPACE_BEGIN
 
-class SharedLiveTimer : public QObject
+// Hierarchical timing wheel of live timers keyed by the second at which they're due. Each level
+// has 64 slots, a slot of a level spanning a whole turn of the level below. Timers due beyond the
+// last level are kept in an overflow slot and cascaded down as time advances.
+class UBUNTUTOOLKIT_EXPORT LiveTimerWheel
+{
+public:
+    LiveTimerWheel();
+
+    // Restarts an empty wheel at the given time.
+    void reset(qint64 nowSecs);
+    void insert(LiveTimer *timer, qint64 dueSecs);
+    void remove(LiveTimer *timer);
+    int count() const { return m_count; }
+
+    // Appends the timers due at or before the given time to expired and removes them from the
+    // wheel. Going back in time or advancing by more than a turn of the second level expires all
+    // the timers, it's up to the caller to reschedule them.
+    void advance(qint64 nowSecs, QVector<LiveTimer*> *expired);
+
+private:
+    static const int slotBits = 6;
+    static const int slotCount = 1 << slotBits;
+    static const int levelCount = 4;
+    static const int overflowSlot = levelCount * slotCount;
+
+    void insertAt(LiveTimer *timer, int slot);
+    void place(LiveTimer *timer);
+    void cascade(int slot);
+    void takeSlot(int slot, QVector<LiveTimer*> *timers);
+
+    QVector<LiveTimer*> m_slots[overflowSlot + 1];
+    qint64 m_currentSecs;
+    int m_count;
+};
+
+class UBUNTUTOOLKIT_EXPORT SharedLiveTimer : public QObject
 {
     Q_OBJECT
 public:
@@ -38,6 +74,10 @@ public:
     void registerTimer(LiveTimer* timer);
     void unregisterTimer(LiveTimer* timer);
 
+    // Triggers the timers due at the given time and updates the frequency of the relative timers
+    // whose proximity changed. Called on each tick, exposed for the tests.
+    void update(const QDateTime &now);
+
 private Q_SLOTS:
     void timeout();
     void timedate1PropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList&);
@@ -46,10 +86,18 @@ Q_SIGNALS:
     void trigger();
 
 private:
+    void evaluate(LiveTimer *timer, const QDateTime &now);
+    void addToBucket(LiveTimer *timer, LiveTimer::Frequency frequency);
+    void removeFromBucket(LiveTimer *timer);
+    void triggerBucket(LiveTimer::Frequency frequency);
     void updateFrequency();
     void reInitTimer();
 
-    QList<LiveTimer*> m_liveTimers;
+    // Registered timers by effective frequency, disabled ones included.
+    QVector<LiveTimer*> m_buckets[LiveTimer::Hour + 1];
+    // Relative timers by the time at which their effective frequency may change.
+    LiveTimerWheel m_transitions;
+    QVector<LiveTimer*> m_expired;
     QTimer m_timer;
     LiveTimer::Frequency m_frequency;
 
@@ -18,8 +18,12 @@
 
 #include "privates/frame_p.h"
 
+#include <QtCore/QtMath>
 #include <QtGui/QOpenGLContext>
 #include <QtGui/QOpenGLFunctions>
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGImageNode>
+#include <QtQuick/QSGRendererInterface>
 
 #include "privates/textures_p.h"
 
@@ -415,6 +419,81 @@ void UCFrameNode::updateGeometry(
     markDirty(QSGNode::DirtyGeometry);
 }
 
+// --- Software rendering ---
+
+// Bilinearly samples a mipmap level of the shape texture with clamp to edge wrapping.
+static float sampleShape(const unsigned char* data, int size, float s, float t)
+{
+    const float u = qBound(0.0f, s * size - 0.5f, size - 1.0f);
+    const float v = qBound(0.0f, t * size - 0.5f, size - 1.0f);
+    const int x0 = static_cast<int>(u);
+    const int y0 = static_cast<int>(v);
+    const int x1 = qMin(x0 + 1, size - 1);
+    const int y1 = qMin(y0 + 1, size - 1);
+    const float fx = u - x0;
+    const float fy = v - y0;
+    const float top = data[y0 * size + x0] + (data[y0 * size + x1] - data[y0 * size + x0]) * fx;
+    const float bottom = data[y1 * size + x0] + (data[y1 * size + x1] - data[y1 * size + x0]) * fx;
+    return (top + (bottom - top) * fy) * (1.0f / 255.0f);
+}
+
+// Rasterizes the frame in a premultiplied image for the software scene graph backend, this is
+// the CPU counterpart of the frame shader using the same shape texture and coordinates. Sizes
+// are in physical pixels.
+static QImage rasterizeFrame(const QSize& size, float thickness, float radius, QRgb color)
+{
+    const int w = size.width();
+    const int h = size.height();
+    const float maxSize = qMin(w, h) * 0.5f;
+    const float clampedThickness = qMin(thickness, maxSize);
+    const float radiusOut = qBound(0.01f, radius, maxSize);
+    const float radiusIn = radiusOut * ((maxSize - clampedThickness) / maxSize);
+
+    // Pick the mipmap level matching the texels per pixel ratio of the outer contour (the GPU
+    // uses trilinear filtering with the highest level clamped to 4).
+    const float texelsPerPixel = (shapeMipmapBaseSize * (1.0f - shapeOffset)) / radiusOut;
+    const int level = qBound(0, static_cast<int>(std::log2(qMax(1.0f, texelsPerPixel))), 4);
+    const int levelSize = shapeMipmapBaseSize >> level;
+    const unsigned char* data = &shapeMipmapData[shapeMipmapOffsets[level]];
+
+    // The shape coordinates only depend on the distance to the closest edge on each axis.
+    auto coordinates = [=](int length, QVector<float>* outer, QVector<float>* inner) {
+        outer->resize(length);
+        inner->resize(length);
+        for (int i = 0; i < length; i++) {
+            const float distance = qMin(i, length - 1 - i) + 0.5f;
+            (*outer)[i] = ((1.0f - shapeOffset) / radiusOut) * distance + shapeOffset;
+            (*inner)[i] = radiusIn > 0.0f ?
+                ((1.0f - shapeOffset) / radiusIn) * (distance - clampedThickness) + shapeOffset :
+                0.0f;
+        }
+    };
+    QVector<float> outerS, innerS, outerT, innerT;
+    coordinates(w, &outerS, &innerS);
+    coordinates(h, &outerT, &innerT);
+
+    const quint32 a = qAlpha(color);
+    const QRgb premultipliedColor = qRgba(
+        (qRed(color) * a) / 255, (qGreen(color) * a) / 255, (qBlue(color) * a) / 255, a);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < h; y++) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < w; x++) {
+            const float shapeOut = sampleShape(data, levelSize, outerS[x], outerT[y]);
+            const float shapeIn = radiusIn > 0.0f ?
+                sampleShape(data, levelSize, innerS[x], innerT[y]) : 0.0f;
+            const float shape = (shapeOut * -shapeIn) + shapeOut;
+            const int factor = qRound(shape * shape * 255.0f);
+            line[x] = qRgba((qRed(premultipliedColor) * factor) / 255,
+                            (qGreen(premultipliedColor) * factor) / 255,
+                            (qBlue(premultipliedColor) * factor) / 255,
+                            (qAlpha(premultipliedColor) * factor) / 255);
+        }
+    }
+    return image;
+}
+
 // --- Item ---
 
 UCFrame::UCFrame(QQuickItem* parent)
@@ -466,6 +545,23 @@ QSGNode* UCFrame::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data)
         return NULL;
     }
 
+    QQuickWindow* window = this->window();
+    if (window->rendererInterface()->graphicsApi() == QSGRendererInterface::Software) {
+        // Rasterized at every update, frames are rarely updated.
+        const qreal dpr = window->effectiveDevicePixelRatio();
+        const QSize imageSize(qCeil(itemSize.width() * dpr), qCeil(itemSize.height() * dpr));
+        QSGImageNode* node = static_cast<QSGImageNode*>(oldNode);
+        if (!node) {
+            node = window->createImageNode();
+            node->setOwnsTexture(true);
+        }
+        node->setTexture(window->createTextureFromImage(
+            rasterizeFrame(imageSize, m_thickness * dpr, m_radius * dpr, m_color)));
+        node->setRect(QRectF(QPointF(0.0, 0.0), itemSize));
+        node->setSourceRect(QRectF(QPointF(0.0, 0.0), imageSize));
+        return node;
+    }
+
     UCFrameNode* node = oldNode ? static_cast<UCFrameNode*>(oldNode) : new UCFrameNode();
     node->updateGeometry(itemSize, m_thickness, m_radius, m_color);
 
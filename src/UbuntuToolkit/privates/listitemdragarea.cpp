@@ -117,7 +117,7 @@ void ListItemDragArea::mousePressEvent(QMouseEvent *event)
     UCViewItemsAttachedPrivate *pViewAttached = UCViewItemsAttachedPrivate::get(viewAttached);
     if (pViewAttached->isDragUpdatedConnected()) {
         UCDragEvent drag(UCDragEvent::Started, index, -1, -1, -1);
-        Q_EMIT viewAttached->dragUpdated(&drag);
+        pViewAttached->emitDragUpdated(&drag);
         start = drag.m_accept;
         min = drag.m_minimum;
         max = drag.m_maximum;
@@ -149,7 +149,7 @@ void ListItemDragArea::mouseReleaseEvent(QMouseEvent *event)
     UCViewItemsAttachedPrivate *pViewAttached = UCViewItemsAttachedPrivate::get(viewAttached);
     if (pViewAttached->isDragUpdatedConnected()) {
         UCDragEvent drag(UCDragEvent::Dropped, fromIndex, toIndex, min, max);
-        Q_EMIT viewAttached->dragUpdated(&drag);
+        pViewAttached->emitDragUpdated(&drag);
         updateDraggedItem();
         if (drag.m_accept) {
             pViewAttached->updateSelectedIndices(fromIndex, toIndex);
@@ -225,7 +225,7 @@ void ListItemDragArea::mouseMoveEvent(QMouseEvent *event)
         UCViewItemsAttachedPrivate *pViewAttached = UCViewItemsAttachedPrivate::get(viewAttached);
         if (pViewAttached->isDragUpdatedConnected()) {
             UCDragEvent drag(UCDragEvent::Moving, fromIndex, toIndex, min, max);
-            Q_EMIT viewAttached->dragUpdated(&drag);
+            pViewAttached->emitDragUpdated(&drag);
             update = drag.m_accept;
             if (update) {
                 pViewAttached->updateSelectedIndices(fromIndex, toIndex);
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "privates/listitempool_p.h"
+
+#include <QtQml/private/qqmldelegatemodel_p.h>
+#include <QtQuick/private/qquickitemview_p_p.h>
+
+#include "uclistitem_p_p.h"
+
+UT_NAMESPACE_BEGIN
+
+ListItemPool::ListItemPool(QQuickFlickable *listView, UCViewItemsAttached *viewItems)
+    : QObject(viewItems)
+    , m_listView(listView)
+    , m_viewItems(viewItems)
+    , m_capacity(0)
+    , m_sweepPending(false)
+{
+    // the DelegateModel of the view is created when the delegate is set
+    connect(m_listView, SIGNAL(modelChanged()), this, SLOT(attachToModel()));
+    connect(m_listView, SIGNAL(delegateChanged()), this, SLOT(attachToModel()));
+    connect(m_listView, &QQuickFlickable::contentXChanged, this, &ListItemPool::scheduleSweep);
+    connect(m_listView, &QQuickFlickable::contentYChanged, this, &ListItemPool::scheduleSweep);
+    attachToModel();
+}
+
+ListItemPool::~ListItemPool()
+{
+    releaseAll();
+}
+
+void ListItemPool::setCapacity(int capacity)
+{
+    capacity = qMax(0, capacity);
+    if (m_capacity == capacity) {
+        return;
+    }
+    m_capacity = capacity;
+    scheduleSweep();
+}
+
+int ListItemPool::parkedCount() const
+{
+    int count = 0;
+    Q_FOREACH(const Entry &entry, m_entries) {
+        if (entry.parked && entry.item) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// follows the DelegateModel of the view, ObjectModels have their own items which are never
+// released by the view
+void ListItemPool::attachToModel()
+{
+    QQuickItemViewPrivate *view =
+        static_cast<QQuickItemViewPrivate*>(QQuickItemPrivate::get(m_listView));
+    QQmlDelegateModel *model = qobject_cast<QQmlDelegateModel*>(view->model);
+    if (m_model.data() == model) {
+        return;
+    }
+    if (m_model) {
+        releaseAll();
+        disconnect(m_model.data(), 0, this, 0);
+    }
+    m_model = model;
+    if (m_model) {
+        connect(m_model.data(), &QQmlInstanceModel::createdItem,
+                this, &ListItemPool::onCreatedItem);
+        // removed rows leave parked items without index
+        connect(m_model.data(), &QQmlInstanceModel::modelUpdated,
+                this, &ListItemPool::scheduleSweep);
+    }
+}
+
+// takes a reference on the new delegate, the model keeps it alive until the pool releases it
+void ListItemPool::onCreatedItem(int index, QObject *object)
+{
+    UCListItem *item = qobject_cast<UCListItem*>(object);
+    if (!item || !m_model || m_model->object(index) != object) {
+        return;
+    }
+    m_entries.append({item, false});
+    scheduleSweep();
+}
+
+void ListItemPool::release(UCListItem *item)
+{
+    if (item && m_model) {
+        m_model->release(item);
+    }
+}
+
+void ListItemPool::releaseAll()
+{
+    QVector<Entry> entries;
+    entries.swap(m_entries);
+    Q_FOREACH(const Entry &entry, entries) {
+        release(entry.item.data());
+    }
+}
+
+// returns true if the view holds the item, either laid out or being the current item
+bool ListItemPool::isInView(QQuickItem *item) const
+{
+    QQuickItemViewPrivate *view =
+        static_cast<QQuickItemViewPrivate*>(QQuickItemPrivate::get(m_listView));
+    if (view->currentItem && static_cast<QQuickItem*>(view->currentItem->item) == item) {
+        return true;
+    }
+    Q_FOREACH(FxViewItem *viewItem, view->visibleItems) {
+        if (static_cast<QQuickItem*>(viewItem->item) == item) {
+            return true;
+        }
+    }
+    Q_FOREACH(FxViewItem *viewItem, view->releasePendingTransition) {
+        if (static_cast<QQuickItem*>(viewItem->item) == item) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the view refills on every content move, items are parked and reused once per event loop
+// iteration
+void ListItemPool::scheduleSweep()
+{
+    if (m_sweepPending || m_entries.isEmpty()) {
+        return;
+    }
+    m_sweepPending = true;
+    QMetaObject::invokeMethod(this, "sweep", Qt::QueuedConnection);
+}
+
+void ListItemPool::sweep()
+{
+    m_sweepPending = false;
+    UCViewItemsAttachedPrivate *viewItems = UCViewItemsAttachedPrivate::get(m_viewItems);
+
+    // park the items the view released, moving them to the end so the entries are ordered by
+    // the time they were parked; the view un-hides the items it takes back
+    int count = m_entries.count();
+    int parked = 0;
+    for (int i = 0; i < count;) {
+        Entry &entry = m_entries[i];
+        UCListItem *item = entry.item.data();
+        if (!item) {
+            m_entries.remove(i);
+            count--;
+            continue;
+        }
+        if (isInView(item)) {
+            if (entry.parked) {
+                entry.parked = false;
+                viewItems->reuseItem(item);
+            }
+        } else if (!entry.parked) {
+            m_entries.remove(i);
+            count--;
+            viewItems->parkItem(item);
+            m_entries.append({item, true});
+            parked++;
+            continue;
+        } else {
+            parked++;
+        }
+        i++;
+    }
+
+    // drop the least recently parked items beyond capacity and the ones removed from the model
+    for (int i = 0; i < m_entries.count();) {
+        const Entry &entry = m_entries.at(i);
+        if (entry.parked && (!entry.item || parked > m_capacity
+                             || UCListItemPrivate::get(entry.item.data())->index() < 0)) {
+            UCListItem *item = entry.item.data();
+            m_entries.remove(i);
+            parked--;
+            release(item);
+            continue;
+        }
+        i++;
+    }
+}
+
+UT_NAMESPACE_END
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LISTITEMPOOL_P_H
+#define LISTITEMPOOL_P_H
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+
+#include <UbuntuToolkit/ubuntutoolkitglobal.h>
+
+class QQmlDelegateModel;
+class QQuickFlickable;
+class QQuickItem;
+
+UT_NAMESPACE_BEGIN
+
+class UCListItem;
+class UCViewItemsAttached;
+
+/*
+  Keeps the ListItem delegates of a ListView alive once the view scrolls them out, so scrolling
+  back to them reuses the items instead of creating them again. The pool holds a reference on
+  each delegate of the view's DelegateModel, the delegates the view releases stay parked, hidden
+  and reset, until the view requests their index again or they are the least recently parked
+  ones beyond the capacity.
+ */
+class ListItemPool : public QObject
+{
+    Q_OBJECT
+public:
+    ListItemPool(QQuickFlickable *listView, UCViewItemsAttached *viewItems);
+    ~ListItemPool();
+
+    int capacity() const
+    {
+        return m_capacity;
+    }
+    void setCapacity(int capacity);
+    int parkedCount() const;
+
+    Q_SLOT void attachToModel();
+
+private:
+    struct Entry {
+        QPointer<UCListItem> item;
+        bool parked;
+    };
+
+    void releaseAll();
+    void release(UCListItem *item);
+    bool isInView(QQuickItem *item) const;
+    void scheduleSweep();
+    Q_SLOT void sweep();
+    void onCreatedItem(int index, QObject *object);
+
+    QVector<Entry> m_entries;
+    QPointer<QQmlDelegateModel> m_model;
+    QQuickFlickable *m_listView;
+    UCViewItemsAttached *m_viewItems;
+    int m_capacity;
+    bool m_sweepPending;
+};
+
+UT_NAMESPACE_END
+
+#endif // LISTITEMPOOL_P_H
@@ -126,6 +126,15 @@ void ListItemSelection::setSelected(bool selected)
     }
 }
 
+// updates the selected state of an item which may have got a new index
+void ListItemSelection::updateSelected()
+{
+    if (viewItems && selected != isSelected()) {
+        selected = !selected;
+        Q_EMIT hostItem->selectedChanged();
+    }
+}
+
 void ListItemSelection::onSelectModeChanged()
 {
     UCListItemPrivate *d = UCListItemPrivate::get(hostItem);
@@ -39,6 +39,7 @@ public:
 
     bool isSelected() const;
     void setSelected(bool selected);
+    void updateSelected();
 
     void onSelectModeChanged();
     void onSelectedIndicesChanged(const QList<int> &indices);
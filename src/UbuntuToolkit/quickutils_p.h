@@ -73,6 +73,8 @@ public:
     {
         return m_keyboardAttached;
     }
+    void setMouseAttached(bool set);
+    void setKeyboardAttached(bool set);
 
 Q_SIGNALS:
     void rootObjectChanged();
@@ -102,8 +104,6 @@ private:
 
     void lookupQuickView();
     void registerDevice(QInputDevice *device, const QString &deviceId);
-    void setMouseAttached(bool set);
-    void setKeyboardAttached(bool set);
 private Q_SLOTS:
     void onInputInfoReady();
     void onDeviceAdded(QInputDevice *device);
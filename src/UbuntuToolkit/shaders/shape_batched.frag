@@ -0,0 +1,65 @@
+#extension GL_OES_standard_derivatives : enable  // Enable dFdy() on OpenGL ES 2.
+
+// Copyright © 2017 Canonical Ltd.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; version 3.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Untextured shapes rendered in merged batches. The per-item parameters are passed as a constant
+// per shape vertex attribute, so contrary to shape.frag the aspect branches are dynamic. All the
+// fragments of a given shape take the same path though, which keeps the divergence low.
+
+uniform sampler2D shapeTexture;
+uniform sampler2D dropShadowShapeTexture;
+uniform lowp float opacity;
+uniform lowp float distanceAA;
+
+varying mediump vec2 shapeCoord;
+varying lowp float yCoord;
+varying lowp vec4 backgroundColor;
+varying lowp vec4 shapeParams;  // distanceAA factor, shape texture index, pressed factor, aspect.
+
+void main(void)
+{
+    lowp vec4 shapeData = mix(texture2D(shapeTexture, shapeCoord),
+                              texture2D(dropShadowShapeTexture, shapeCoord), shapeParams.y);
+    lowp vec4 color = backgroundColor;
+
+    // Get the normalized distance between two pixels using screen-space derivatives of shape
+    // texture coordinate. dFd*() functions have to be called outside of branches in order to work
+    // correctly with VMware's "Gallium 0.4 on SVGA3D".
+    lowp float dist = length(vec2(dFdx(shapeCoord.s), dFdy(shapeCoord.s)));
+    lowp float distanceMin = abs(dist) * -(distanceAA * shapeParams.x) + 0.5;
+    lowp float distanceMax = abs(dist) * (distanceAA * shapeParams.x) + 0.5;
+
+    if (shapeParams.w > 0.83) {  // Drop shadow.
+        lowp int shapeSide = yCoord <= 0.0 ? 0 : 1;
+        lowp float mask = smoothstep(distanceMin, distanceMax, shapeData[shapeSide]);
+        lowp float shadow = (shapeData.b * -mask) + shapeData.b;  // -ab + a = a(1 - b)
+        color = (color * vec4(mask)) + vec4(0.0, 0.0, 0.0, shadow);
+
+    } else if (shapeParams.w > 0.5) {  // Inset.
+        lowp float shapeSide = yCoord <= 0.0 ? 0.0 : 1.0;
+        lowp float shadow = shapeData[int(shapeSide)];
+        color = vec4(1.0 - shadow) * color + vec4(0.0, 0.0, 0.0, shadow);
+        lowp vec2 mask = smoothstep(distanceMin, distanceMax, shapeData.ba);
+        lowp float bevel = (mask.x * -mask.y) + mask.x;  // -ab + a = a(1 - b)
+        lowp float gradient = clamp((shapeSide * -shapeCoord.t) + shapeSide, 0.0, 1.0);
+        bevel *= gradient * 0.6;
+        color = (color * vec4(mask[int(shapeSide)])) + vec4(bevel);
+
+    } else if (shapeParams.w > 0.17) {  // Flat.
+        color *= smoothstep(distanceMin, distanceMax, shapeData.b);
+    }
+
+    gl_FragColor = color * vec4(vec3(shapeParams.z * opacity), opacity);
+}
@@ -0,0 +1,36 @@
+// Copyright © 2017 Canonical Ltd.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; version 3.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+uniform highp mat4 matrix;  // mediump was interpreted as lowp on PowerVR Rogue G6200 (arale).
+
+attribute highp vec4 positionAttrib;  // highp because of matrix precision qualifier.
+attribute mediump vec2 shapeCoordAttrib;
+attribute lowp float yCoordAttrib;
+attribute lowp vec4 backgroundColorAttrib;
+attribute lowp vec4 shapeParamsAttrib;
+
+varying mediump vec2 shapeCoord;
+varying lowp float yCoord;
+varying lowp vec4 backgroundColor;
+varying lowp vec4 shapeParams;
+
+void main()
+{
+    shapeCoord = shapeCoordAttrib;
+    yCoord = yCoordAttrib;
+    backgroundColor = backgroundColorAttrib;
+    shapeParams = shapeParamsAttrib;
+
+    gl_Position = matrix * positionAttrib;
+}
@@ -0,0 +1,53 @@
+// Copyright © 2017 Canonical Ltd.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; version 3.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Untextured shapes rendered in merged batches, see shape_batched.frag.
+
+uniform sampler2D shapeTexture;
+uniform sampler2D dropShadowShapeTexture;
+uniform lowp float opacity;
+
+varying mediump vec2 shapeCoord;
+varying lowp float yCoord;
+varying lowp vec4 backgroundColor;
+varying lowp vec4 shapeParams;  // distanceAA factor, shape texture index, pressed factor, aspect.
+
+void main(void)
+{
+    lowp vec4 shapeData = mix(texture2D(shapeTexture, shapeCoord),
+                              texture2D(dropShadowShapeTexture, shapeCoord), shapeParams.y);
+    lowp vec4 color = backgroundColor;
+
+    if (shapeParams.w > 0.83) {  // Drop shadow.
+        lowp int shapeSide = yCoord <= 0.0 ? 0 : 1;
+        lowp float mask = shapeData[shapeSide];
+        lowp float shadow = (shapeData.b * -mask) + shapeData.b;  // -ab + a = a(1 - b)
+        color = (color * vec4(mask)) + vec4(0.0, 0.0, 0.0, shadow);
+
+    } else if (shapeParams.w > 0.5) {  // Inset.
+        lowp float shapeSide = yCoord <= 0.0 ? 0.0 : 1.0;
+        lowp float shadow = shapeData[int(shapeSide)];
+        color = vec4(1.0 - shadow) * color + vec4(0.0, 0.0, 0.0, shadow);
+        lowp vec2 mask = shapeData.ba;
+        lowp float bevel = (mask.x * -mask.y) + mask.x;  // -ab + a = a(1 - b)
+        lowp float gradient = clamp((shapeSide * -shapeCoord.t) + shapeSide, 0.0, 1.0);
+        bevel *= gradient * 0.6;
+        color = (color * vec4(mask[int(shapeSide)])) + vec4(bevel);
+
+    } else if (shapeParams.w > 0.17) {  // Flat.
+        color *= shapeData.b;
+    }
+
+    gl_FragColor = color * vec4(vec3(shapeParams.z * opacity), opacity);
+}
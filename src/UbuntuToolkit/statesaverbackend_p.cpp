@@ -19,7 +19,12 @@
 #include "statesaverbackend_p.h"
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSettings>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QStringList>
 #include <QtQml/QtQml>
@@ -34,20 +39,211 @@
 
 UT_NAMESPACE_BEGIN
 
+/*
+ * INI archive, storing the properties of an id in a group. The type of each
+ * property is saved along with its value, as QSettings deserializes values as
+ * QString. Setting these strings to QML properties usually works because the
+ * implicit type conversion from string to the type of the QML property usually
+ * works. In some cases cases however (e.g. enum) it fails.
+ *
+ * See Qt Bug: https://bugreports.qt-project.org/browse/QTBUG-40474
+ */
+class IniStateSaverArchive : public StateSaverArchive
+{
+public:
+    IniStateSaverArchive(const QString &fileName)
+        : m_settings(fileName, QSettings::NativeFormat)
+    {
+        m_settings.setFallbacksEnabled(false);
+    }
+
+    QString fileName() const override
+    {
+        return m_settings.fileName();
+    }
+
+    QVariantHash take(const QString &id) override
+    {
+        QVariantHash properties;
+        m_settings.beginGroup(id);
+        Q_FOREACH(const QString &key, m_settings.childKeys()) {
+            if (key.endsWith(QStringLiteral("_TYPE"))) {
+                continue;
+            }
+            QVariant value = m_settings.value(key);
+            value.convert(m_settings.value(key + QStringLiteral("_TYPE")).toInt());
+            properties.insert(key, value);
+        }
+        m_settings.remove(QStringLiteral(""));
+        m_settings.endGroup();
+        return properties;
+    }
+
+    void store(const QString &id, const QVariantHash &properties) override
+    {
+        m_settings.beginGroup(id);
+        for (QVariantHash::const_iterator i = properties.constBegin(); i != properties.constEnd(); ++i) {
+            m_settings.setValue(i.key(), i.value());
+            m_settings.setValue(i.key() + QStringLiteral("_TYPE"), QVariant::fromValue((int)i.value().type()));
+        }
+        m_settings.endGroup();
+    }
+
+    void sync() override
+    {
+        m_settings.sync();
+    }
+
+    bool remove() override
+    {
+        m_settings.sync();
+        bool result = QFile::remove(m_settings.fileName());
+        // reload the now empty archive
+        m_settings.sync();
+        return result;
+    }
+
+private:
+    QSettings m_settings;
+};
+
+/*
+ * Binary archive, holding the properties in memory as typed QDataStream
+ * records. The whole archive is written at once when synced, replacing the
+ * previous file atomically.
+ */
+class BinaryStateSaverArchive : public StateSaverArchive
+{
+public:
+    BinaryStateSaverArchive(const QString &fileName)
+        : m_fileName(fileName)
+        , m_dirty(false)
+    {
+        read();
+    }
+    ~BinaryStateSaverArchive()
+    {
+        sync();
+    }
+
+    QString fileName() const override
+    {
+        return m_fileName;
+    }
+
+    QVariantHash take(const QString &id) override
+    {
+        QHash<QString, QVariantHash>::iterator i = m_groups.find(id);
+        if (i == m_groups.end()) {
+            return QVariantHash();
+        }
+        QVariantHash properties = *i;
+        m_groups.erase(i);
+        m_dirty = true;
+        return properties;
+    }
+
+    void store(const QString &id, const QVariantHash &properties) override
+    {
+        QVariantHash &group = m_groups[id];
+        for (QVariantHash::const_iterator i = properties.constBegin(); i != properties.constEnd(); ++i) {
+            if (!isStreamable(i.value())) {
+                qWarning() << "[StateSaver] Cannot save property" << i.key() << "of" << id
+                           << "with type" << i.value().typeName();
+                continue;
+            }
+            group.insert(i.key(), i.value());
+        }
+        m_dirty = true;
+    }
+
+    void sync() override
+    {
+        if (!m_dirty) {
+            read();
+            return;
+        }
+        m_dirty = false;
+        QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+        QSaveFile file(m_fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qCritical() << "[StateSaver] Cannot write appstate file" << m_fileName;
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << magic << version << m_groups;
+        if (stream.status() != QDataStream::Ok || !file.commit()) {
+            qCritical() << "[StateSaver] Cannot write appstate file" << m_fileName;
+        }
+    }
+
+    bool remove() override
+    {
+        m_groups.clear();
+        m_dirty = false;
+        return QFile::remove(m_fileName);
+    }
+
+private:
+    static const quint32 magic = 0x55535341; // USSA
+    static const quint32 version = 1;
+
+    // a value without stream operator would fail the whole archive
+    bool isStreamable(const QVariant &value)
+    {
+        QDataStream stream(&m_scratch, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << value;
+        return stream.status() == QDataStream::Ok;
+    }
+
+    void read()
+    {
+        m_groups.clear();
+        QFile file(m_fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 fileMagic, fileVersion;
+        stream >> fileMagic >> fileVersion;
+        if (fileMagic != magic || fileVersion != version) {
+            qWarning() << "[StateSaver] Invalid appstate file" << m_fileName;
+            return;
+        }
+        stream >> m_groups;
+        if (stream.status() != QDataStream::Ok) {
+            qWarning() << "[StateSaver] Corrupted appstate file" << m_fileName;
+            m_groups.clear();
+        }
+    }
+
+    QString m_fileName;
+    QHash<QString, QVariantHash> m_groups;
+    QByteArray m_scratch;
+    bool m_dirty;
+};
+
 StateSaverBackend *StateSaverBackend::m_instance = nullptr;
 
 StateSaverBackend::StateSaverBackend(QObject *parent)
     : QObject(parent)
-    , m_archive(0)
+    , m_archiveFormat(IniFormat)
     , m_globalEnabled(true)
 {
+    if (qgetenv("UC_STATESAVER_FORMAT") == "binary") {
+        m_archiveFormat = BinaryFormat;
+    }
+
     // connect to application quit signal so when that is called, we can clean the states saved
     QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
                      this, &StateSaverBackend::cleanup);
     QObject::connect(QuickUtils::instance(), &QuickUtils::activated,
                      this, &StateSaverBackend::reset);
     QObject::connect(QuickUtils::instance(), &QuickUtils::deactivated,
-                     this, &StateSaverBackend::initiateStateSaving);
+                     this, &StateSaverBackend::saveStates);
     // catch eventual app name changes so we can have different path for the states if needed
     QObject::connect(UCApplication::instance(), &UCApplication::applicationNameChanged,
                      this, &StateSaverBackend::initialize);
@@ -63,9 +259,6 @@ StateSaverBackend::StateSaverBackend(QObject *parent)
 
 StateSaverBackend::~StateSaverBackend()
 {
-    if (m_archive) {
-        delete m_archive;
-    }
     m_instance = nullptr;
 }
 
@@ -73,10 +266,8 @@ void StateSaverBackend::initialize()
 {
     if (m_archive) {
         // delete previous archive
-        QFile archiveFile(m_archive.data()->fileName());
-        archiveFile.remove();
-        delete m_archive.data();
-        m_archive.clear();
+        m_archive->remove();
+        m_archive.reset();
     }
     QString applicationName(UCApplication::instance()->applicationName());
     if (applicationName.isEmpty()) {
@@ -97,22 +288,35 @@ void StateSaverBackend::initialize()
         qCritical() << "[StateSaver] No XDG_RUNTIME_DIR path set, cannot create appstate file.";
         return;
     }
-    m_archive = new QSettings(QStringLiteral("%1/%2/statesaver.appstate").
-                              arg(runtimeDir).
-                              arg(applicationName), QSettings::NativeFormat);
-    m_archive->setFallbacksEnabled(false);
+    QString archivePath(QStringLiteral("%1/%2/statesaver.appstate").arg(runtimeDir).arg(applicationName));
+    if (m_archiveFormat == BinaryFormat) {
+        m_archive.reset(new BinaryStateSaverArchive(archivePath + QStringLiteral(".bin")));
+    } else {
+        m_archive.reset(new IniStateSaverArchive(archivePath));
+    }
 }
 
 void StateSaverBackend::cleanup()
 {
     reset();
-    m_archive.clear();
+    m_archive.reset();
+}
+
+/*
+ * Saves the state of all the state savers, and writes the archive once done.
+ */
+void StateSaverBackend::saveStates()
+{
+    Q_EMIT initiateStateSaving();
+    if (m_archive) {
+        m_archive->sync();
+    }
 }
 
 void StateSaverBackend::signalHandler(int type)
 {
     if (type == UnixSignalHandler::Interrupt) {
-        Q_EMIT initiateStateSaving();
+        saveStates();
         // disconnect aboutToQuit() so the state file doesn't get wiped upon quit
         QObject::disconnect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
                          this, &StateSaverBackend::cleanup);
@@ -149,93 +353,80 @@ void StateSaverBackend::removeId(const QString &id)
     m_register.remove(id);
 }
 
-int StateSaverBackend::load(const QString &id, QObject *item, const QStringList &properties)
+StateSaverBackend::ArchiveFormat StateSaverBackend::archiveFormat() const
+{
+    return m_archiveFormat;
+}
+void StateSaverBackend::setArchiveFormat(ArchiveFormat format)
+{
+    if (m_archiveFormat != format) {
+        m_archiveFormat = format;
+        if (!UCApplication::instance()->applicationName().isEmpty()) {
+            initialize();
+        }
+    }
+}
+
+int StateSaverBackend::load(const QString &id, QObject *item, const QVector<QQmlProperty> &properties)
 {
     if (m_archive.isNull()) {
         return 0;
     }
 
     int result = 0;
-    // save the previous group
-    bool restorePreviousGroup = !m_archive->group().isEmpty();
-    if (restorePreviousGroup) {
-        m_groupStack.push(m_archive->group());
-        // leave the group so we can read the next one
-        m_archive->endGroup();
-    }
-    m_archive.data()->beginGroup(id);
-    QStringList propertyNames = m_archive.data()->childKeys();
-    Q_FOREACH(const QString &propertyName, propertyNames) {
-        QVariant value = m_archive.data()->value(propertyName);
-        if (!properties.contains(propertyName)) {
-            // skip the property
+    // take the values first, so that property writes loading nested states
+    // do not interfere with this group
+    const QVariantHash values = m_archive->take(id);
+    if (values.isEmpty()) {
+        return 0;
+    }
+    Q_FOREACH(const QQmlProperty &qmlProperty, properties) {
+        QVariantHash::const_iterator value = values.constFind(qmlProperty.name());
+        if (value == values.constEnd()) {
             continue;
         }
-        QQmlProperty qmlProperty(
-            item, QString::fromLatin1(propertyName.toLocal8Bit().constData()), qmlContext(item));
-        if (qmlProperty.isValid() && qmlProperty.isWritable()) {
-            QVariant type = m_archive.data()->value(propertyName + "_TYPE");
-            value.convert(type.toInt());
-            bool writeSuccess = qmlProperty.write(value);
+        if (qmlProperty.isWritable()) {
+            bool writeSuccess = qmlProperty.write(*value);
             if (writeSuccess) {
                 result++;
             } else {
                 qmlWarning(item) << QStringLiteral("property \"%1\" of "
                     "object %2 has type %3 and cannot be set to value \"%4\" of"
-                    " type %5").arg(propertyName)
+                    " type %5").arg(qmlProperty.name())
                                .arg(qmlContext(item)->nameForObject(item))
                                .arg(QString::fromLatin1(qmlProperty.propertyTypeName()))
-                               .arg(value.toString())
-                               .arg(QString::fromLatin1(value.typeName()));
+                               .arg(value->toString())
+                               .arg(QString::fromLatin1(value->typeName()));
             }
         } else {
             qmlWarning(item) << QStringLiteral("property \"%1\" does not exist or is not writable for object %2")
-                             .arg(propertyName).arg(qmlContext(item)->nameForObject(item));
+                             .arg(qmlProperty.name()).arg(qmlContext(item)->nameForObject(item));
         }
     }
-    // drop cache once properties are successfully restored
-    m_archive.data()->remove(QStringLiteral(""));
-    m_archive.data()->endGroup();
-    // restore leaved group if needed
-    if (restorePreviousGroup) {
-        m_archive->beginGroup(m_groupStack.pop());
-    }
     return result;
 }
 
-int StateSaverBackend::save(const QString &id, QObject *item, const QStringList &properties)
+int StateSaverBackend::save(const QString &id, QObject *item, const QVector<QQmlProperty> &properties)
 {
+    Q_UNUSED(item);
     if (m_archive.isNull()) {
         return 0;
     }
-    m_archive.data()->beginGroup(id);
-    int result = 0;
-    Q_FOREACH(const QString &propertyName, properties) {
-        QQmlProperty qmlProperty(
-            item, QString::fromLatin1(propertyName.toLocal8Bit().constData()));
+    QVariantHash values;
+    Q_FOREACH(const QQmlProperty &qmlProperty, properties) {
         if (qmlProperty.isValid()) {
             QVariant value = qmlProperty.read();
             if (static_cast<QMetaType::Type>(value.type()) != QMetaType::QObjectStar) {
                 if (value.userType() == qMetaTypeId<QJSValue>()) {
                     value = value.value<QJSValue>().toVariant();
                 }
-                m_archive.data()->setValue(propertyName, value);
-                /* Save the type of the property along with its value.
-                 * This is important because QSettings deserializes values as QString.
-                 * Setting these strings to QML properties usually works because the
-                 * implicit type conversion from string to the type of the QML property
-                 * usually works. In some cases cases however (e.g. enum) it fails.
-                 *
-                 * See Qt Bug: https://bugreports.qt-project.org/browse/QTBUG-40474
-                 */
-                m_archive.data()->setValue(propertyName + "_TYPE", QVariant::fromValue((int)value.type()));
-                result++;
+                values.insert(qmlProperty.name(), value);
             }
         }
     }
-    m_archive.data()->endGroup();
-    m_archive.data()->sync();
-    return result;
+    // the archive is written once all the states are saved
+    m_archive->store(id, values);
+    return values.size();
 }
 
 /*
@@ -245,8 +436,7 @@ bool StateSaverBackend::reset()
 {
     m_register.clear();
     if (m_archive) {
-        QFile archiveFile(m_archive.data()->fileName());
-        return archiveFile.remove();
+        return m_archive->remove();
     }
     return true;
 }
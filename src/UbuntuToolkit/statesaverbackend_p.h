@@ -20,20 +20,43 @@
 #define STATESAVERBACKEND_P_H
 
 #include <QtCore/QObject>
-#include <QtCore/QPointer>
+#include <QtCore/QScopedPointer>
 #include <QtCore/QSet>
-#include <QtCore/QSettings>
-#include <QtCore/QStack>
 #include <QtCore/QTimer>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
+#include <QtQml/QQmlProperty>
 
 #include <UbuntuToolkit/ubuntutoolkitglobal.h>
 
 UT_NAMESPACE_BEGIN
 
+// Storage of the saved properties, grouped by state saver id.
+class UBUNTUTOOLKIT_EXPORT StateSaverArchive
+{
+public:
+    virtual ~StateSaverArchive() {}
+
+    virtual QString fileName() const = 0;
+    // returns the properties saved for the given id and drops them from the archive
+    virtual QVariantHash take(const QString &id) = 0;
+    virtual void store(const QString &id, const QVariantHash &properties) = 0;
+    // writes pending changes to the file and reloads it
+    virtual void sync() = 0;
+    // drops the archive content along with its file
+    virtual bool remove() = 0;
+};
+
 class UBUNTUTOOLKIT_EXPORT StateSaverBackend : public QObject
 {
     Q_OBJECT
 public:
+    enum ArchiveFormat {
+        IniFormat,
+        // QDataStream records, written at once at the end of a saving session
+        BinaryFormat
+    };
+
     ~StateSaverBackend();
 
     // FIXME: with multiple engines/views in an application, we must provide
@@ -52,8 +75,11 @@ public:
     bool registerId(const QString &id);
     void removeId(const QString &id);
 
-    int load(const QString &id, QObject *item, const QStringList &properties);
-    int save(const QString &id, QObject *item, const QStringList &properties);
+    ArchiveFormat archiveFormat() const;
+    void setArchiveFormat(ArchiveFormat format);
+
+    int load(const QString &id, QObject *item, const QVector<QQmlProperty> &properties);
+    int save(const QString &id, QObject *item, const QVector<QQmlProperty> &properties);
 
 public Q_SLOTS:
     bool reset();
@@ -69,11 +95,12 @@ private Q_SLOTS:
     void initialize();
     void cleanup();
     void signalHandler(int type);
+    void saveStates();
 
 private:
-    QPointer<QSettings> m_archive;
+    QScopedPointer<StateSaverArchive> m_archive;
     QSet<QString> m_register;
-    QStack<QString> m_groupStack;
+    ArchiveFormat m_archiveFormat;
     bool m_globalEnabled;
 
     static StateSaverBackend *m_instance;
@@ -179,18 +179,13 @@ void UbuntuToolkitModule::initializeContextProperties(QQmlEngine *engine)
     // Give the application object access to the engine
     UCApplication::instance()->setContext(context);
 
+    // units.dp(), units.gu() and FontUtils.sizeToPixels() make the bindings calling them
+    // depend on the grid unit, there is no need to re-set the context properties
+    BindingNotifier::registerEngine(engine);
     context->setContextProperty(QStringLiteral("units"), UCUnits::instance());
-    ContextPropertyChangeListener *unitsChangeListener =
-        new ContextPropertyChangeListener(context, QStringLiteral("units"));
-    QObject::connect(UCUnits::instance(), SIGNAL(gridUnitChanged()),
-                     unitsChangeListener, SLOT(updateContextProperty()));
 
     // register FontUtils
     context->setContextProperty(QStringLiteral("FontUtils"), UCFontUtils::instance());
-    ContextPropertyChangeListener *fontUtilsListener =
-        new ContextPropertyChangeListener(context, QStringLiteral("FontUtils"));
-    QObject::connect(UCUnits::instance(), SIGNAL(gridUnitChanged()),
-                     fontUtilsListener, SLOT(updateContextProperty()));
 
     // Make the context property 'window' available even before there is a window,
     // so that in QML we do not have to check whether 'window' is defined, and no new
@@ -319,6 +314,8 @@ void UbuntuToolkitModule::initializeModule(QQmlEngine *engine, const QUrl &plugi
         } else if (metricsLogging == "lttng") {
             logger = new UMLTTNGLogger();
 #endif  // defined(Q_OS_LINUX)
+        } else if (metricsLogging.startsWith("binary:")) {
+            logger = new UMBinaryLogger(QString::fromLocal8Bit(metricsLogging.mid(7)));
         } else {
             logger = new UMFileLogger(QString::fromLocal8Bit(metricsLogging));
         }
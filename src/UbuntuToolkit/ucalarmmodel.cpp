@@ -18,6 +18,7 @@
 
 #include "ucalarmmodel_p.h"
 
+#include <QtCore/QHash>
 #include <QtQml/QQmlEngine>
 #include <QtQml/QQmlInfo>
 #include <QtQml/QQmlPropertyMap>
@@ -37,9 +38,10 @@ UT_NAMESPACE_BEGIN
  * The AlarmModel is a simple container of \l Alarm definitions stored in the alarm
  * collection. The data provided by the model are read only, adding, modifying or
  * removing data is only possible through \l Alarm functions. Any modification on
- * the alarms or any new alarm added to the collection will refresh all the model
- * instances. This also means that the delegates visualizing the model elements will
- * also be re-created.
+ * the alarms or any new alarm added to the collection will update all the model
+ * instances. When the alarms are refreshed, only the rows of the alarms added,
+ * removed or moved in the collection are changed, the delegates visualizing the
+ * other alarms are kept.
  *
  * Example usage:
  * \qml
@@ -126,13 +128,55 @@ UT_NAMESPACE_BEGIN
  * \endqml
  */
 
+// identifies an alarm across refreshes, the alarm manager recreates the alarm objects
+static QString alarmKey(UCAlarm *alarm)
+{
+    return alarm->cookie().toString();
+}
+
+// flags the values, between 0 and range, in the longest increasing subsequence of the given values
+static QVector<bool> longestIncreasingRun(const QVector<int> &values, int range)
+{
+    QVector<int> tails;
+    QVector<int> previous(values.count(), -1);
+    for (int i = 0; i < values.count(); i++) {
+        // binary search of the first tail not smaller than the value
+        int low = 0;
+        int high = tails.count();
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (values[tails[middle]] < values[i]) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        previous[i] = low > 0 ? tails[low - 1] : -1;
+        if (low == tails.count()) {
+            tails.append(i);
+        } else {
+            tails[low] = i;
+        }
+    }
+
+    QVector<bool> result(range, false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous[i]) {
+        result[values[i]] = true;
+    }
+    return result;
+}
+
 UCAlarmModel::UCAlarmModel(QObject *parent)
     : QAbstractListModel(parent)
     , m_moved(false)
+    , m_updating(false)
 {
+    for (int i = 0; i < AlarmManager::instance().alarmCount(); i++) {
+        m_keys.append(alarmKey(AlarmManager::instance().alarmAt(i)));
+    }
+
     // keep in sync with alarms collection changes
     // some of the connections can be asynchronous, others synchronous
-    connect(&AlarmManager::instance(), SIGNAL(alarmsRefreshStarted()), this, SLOT(refreshStart()), Qt::DirectConnection);
     connect(&AlarmManager::instance(), SIGNAL(alarmsRefreshed()), this, SLOT(refreshEnd()), Qt::DirectConnection);
     // get individual alarm data updates
     connect(&AlarmManager::instance(), SIGNAL(alarmUpdated(int)), this, SLOT(update(int)), Qt::DirectConnection);
@@ -162,7 +206,7 @@ void UCAlarmModel::componentComplete()
 int UCAlarmModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return count();
+    return m_updating ? m_rows.count() : count();
 }
 QVariant UCAlarmModel::data(const QModelIndex &index, int role) const
 {
@@ -171,6 +215,10 @@ QVariant UCAlarmModel::data(const QModelIndex &index, int role) const
     }
 
     int idx = index.row();
+    if (m_updating) {
+        // rows are mapped to the refreshed alarms while the changes are notified
+        idx = (idx >= 0 && idx < m_rows.count()) ? m_rows[idx] : -1;
+    }
     if ((idx >= AlarmManager::instance().alarmCount()) || (idx < 0)) {
         return QVariant();
     }
@@ -237,6 +285,16 @@ int UCAlarmModel::count() const
     return AlarmManager::instance().alarmCount();
 }
 
+/*!
+ * \internal
+ * The time spent loading the alarms stored by the fallback alarm manager, -1 while
+ * the alarms are being loaded.
+ */
+qint64 UCAlarmModel::loadTime() const
+{
+    return AlarmManager::instance().loadTime();
+}
+
 /*!
  * \qmlmethod AlarmModel::refresh()
  * The function refreshes the model by invalidating the alarm cache. Use this
@@ -250,21 +308,96 @@ void UCAlarmModel::refresh()
 
 /*!
  * \internal
- * The slot prepares the model reset.
- */
-void UCAlarmModel::refreshStart()
-{
-    beginResetModel();
-}
-
-/*!
- * \internal
- * The slot finalizes the model reset.
+ * The slot notifies the differences between the alarms before and after the refresh
+ * as row removals, insertions and moves. The alarms which stay in place are reported
+ * as changed, their alarm objects got recreated.
  */
 void UCAlarmModel::refreshEnd()
 {
-    endResetModel();
-    Q_EMIT countChanged();
+    AlarmManager &manager = AlarmManager::instance();
+    const int oldCount = m_keys.count();
+    QStringList keys;
+    QHash<QString, int> indexes;
+    keys.reserve(manager.alarmCount());
+    for (int i = 0; i < manager.alarmCount(); i++) {
+        keys.append(alarmKey(manager.alarmAt(i)));
+        indexes.insert(keys.last(), i);
+    }
+    if (indexes.count() != keys.count() || indexes.contains(QString())) {
+        // the alarms can't be told apart
+        beginResetModel();
+        m_keys = keys;
+        endResetModel();
+        Q_EMIT countChanged();
+        return;
+    }
+
+    // the rows as indexes in the refreshed alarm list, -1 for the removed alarms
+    m_rows.clear();
+    m_rows.reserve(qMax(oldCount, keys.count()));
+    Q_FOREACH(const QString &key, m_keys) {
+        m_rows.append(indexes.value(key, -1));
+    }
+    m_updating = true;
+
+    // remove the rows of the alarms gone, in ranges
+    for (int last = m_rows.count() - 1; last >= 0; last--) {
+        if (m_rows[last] >= 0) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && m_rows[first - 1] < 0) {
+            first--;
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.remove(first, last - first + 1);
+        endRemoveRows();
+        last = first;
+    }
+
+    // the longest run of rows already in order stays, every other alarm is moved or inserted
+    // right after the alarm preceding it, which gives the least moves
+    const QVector<bool> stable = longestIncreasingRun(m_rows, keys.count());
+    QVector<bool> present(keys.count(), false);
+    Q_FOREACH(int index, m_rows) {
+        present[index] = true;
+    }
+    for (int index = 0; index < keys.count(); index++) {
+        if (stable[index]) {
+            continue;
+        }
+        const int to = index > 0 ? m_rows.indexOf(index - 1) + 1 : 0;
+        if (!present[index]) {
+            int last = index;
+            while (last + 1 < keys.count() && !present[last + 1]) {
+                last++;
+            }
+            beginInsertRows(QModelIndex(), to, to + last - index);
+            for (int i = index; i <= last; i++) {
+                m_rows.insert(to + i - index, i);
+            }
+            endInsertRows();
+            index = last;
+            continue;
+        }
+        const int from = m_rows.indexOf(index);
+        if (from != to) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
+            m_rows.remove(from);
+            m_rows.insert(to > from ? to - 1 : to, index);
+            endMoveRows();
+        }
+    }
+
+    m_updating = false;
+    m_rows.clear();
+    m_keys = keys;
+    if (!m_keys.isEmpty()) {
+        Q_EMIT dataChanged(createIndex(0, 0), createIndex(m_keys.count() - 1, 0));
+    }
+    if (m_keys.count() != oldCount) {
+        Q_EMIT countChanged();
+    }
 }
 
 /*!
@@ -285,6 +418,7 @@ void UCAlarmModel::update(int index)
 void UCAlarmModel::removeStarted(int index)
 {
     beginRemoveRows(QModelIndex(), index, index);
+    m_keys.removeAt(index);
 }
 
 /*!
@@ -304,6 +438,7 @@ void UCAlarmModel::removeFinished()
 void UCAlarmModel::insertStarted(int index)
 {
     beginInsertRows(QModelIndex(), index, index);
+    m_keys.insert(index, alarmKey(AlarmManager::instance().alarmAt(index)));
 }
 
 /*!
@@ -322,6 +457,7 @@ void UCAlarmModel::insertFinished()
  */
 void UCAlarmModel::moveStarted(int from, int to)
 {
+    m_keys.move(from, to);
     if (m_moved) {
         return;
     }
@@ -20,6 +20,8 @@
 #define UCALARMSMODEL_P_H
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
 #include <QtQml/QQmlParserStatus>
 
 #include <UbuntuToolkit/private/ucalarm_p_p.h>
@@ -49,7 +51,10 @@ public:
 
     // property getters
     int count() const;
-    
+
+    // time spent loading the stored alarms in milliseconds, -1 while loading
+    qint64 loadTime() const;
+
 Q_SIGNALS:
     void countChanged();
 
@@ -57,7 +62,6 @@ public Q_SLOTS:
     Q_REVISION(1) void refresh();
 
 private Q_SLOTS:
-    void refreshStart();
     void refreshEnd();
     void update(int index);
     void removeStarted(int index);
@@ -68,7 +72,12 @@ private Q_SLOTS:
     void moveFinished();
 
 private:
+    // alarm keys of the rows
+    QStringList m_keys;
+    // rows mapped to the refreshed alarms while notifying the changes
+    QVector<int> m_rows;
     bool m_moved:1;
+    bool m_updating:1;
 };
 
 UT_NAMESPACE_END
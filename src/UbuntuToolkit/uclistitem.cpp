@@ -495,6 +495,22 @@ void UCListItemPrivate::snapOut()
     }
 }
 
+/*
+ * Resets the ListItem scrolled out of a ListView to its initial state, so it can be shown
+ * again by the view. Unlike snapOut(), the contentItem is put back in place without animation.
+ */
+void UCListItemPrivate::park()
+{
+    snapOut();
+    if (styleItem && listItemStyle()->m_snapAnimation) {
+        listItemStyle()->m_snapAnimation->stop();
+    }
+    setSwiped(false);
+    lockContentItem(true);
+    setContentMoving(false);
+    button = Qt::NoButton;
+}
+
 // emits the style signal swipeEvent()
 void UCListItemPrivate::swipeEvent(const QPointF &localPos, UCSwipeEvent::Status status)
 {
@@ -188,6 +188,7 @@ class UBUNTUTOOLKIT_EXPORT UCViewItemsAttached : public QObject
     // https://bugs.launchpad.net/ubuntu/+source/qtdeclarative-opensource-src/+bug/1389721
     Q_PROPERTY(QList<int> expandedIndices READ expandedIndices WRITE setExpandedIndices NOTIFY expandedIndicesChanged)
     Q_PROPERTY(int expansionFlags READ expansionFlags WRITE setExpansionFlags NOTIFY expansionFlagsChanged)
+    Q_PROPERTY(int poolSize READ poolSize WRITE setPoolSize NOTIFY poolSizeChanged)
 public:
     enum ExpansionFlag {
         Exclusive = 0x01,
@@ -218,10 +219,15 @@ public:
     void setExpandedIndices(QList<int> indices);
     int expansionFlags() const;
     void setExpansionFlags(int flags);
+    int poolSize() const;
+    void setPoolSize(int size);
 
 private Q_SLOTS:
     void unbindItem();
     void completed();
+    Q_PRIVATE_SLOT(d_func(), void _q_attachToModel())
+    Q_PRIVATE_SLOT(d_func(), void _q_rowsInserted(const QModelIndex &parent, int first, int last))
+    Q_PRIVATE_SLOT(d_func(), void _q_rowsRemoved(const QModelIndex &parent, int first, int last))
 
 Q_SIGNALS:
     void selectModeChanged();
@@ -234,6 +240,7 @@ Q_SIGNALS:
     void expandedIndicesChanged(const QList<int> &indices);
     void expansionFlagsChanged();
     void effectiveCurrentIndexChanged();
+    void poolSizeChanged();
 private:
     Q_DECLARE_PRIVATE(UCViewItemsAttached)
 };
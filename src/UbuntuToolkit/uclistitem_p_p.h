@@ -19,8 +19,10 @@
 
 #include <UbuntuToolkit/private/uclistitem_p.h>
 
+#include <QtCore/QAbstractItemModel>
 #include <QtCore/QPointer>
 #include <QtCore/QBasicTimer>
+#include <QtCore/QVector>
 #include <QtQuick/private/qquickrectangle_p.h>
 
 #include <UbuntuToolkit/private/uclistitemstyle_p.h>
@@ -72,6 +74,7 @@ public:
     void lockContentItem(bool lock);
     void update();
     void snapOut();
+    void park();
     void swipeEvent(const QPointF &localPos, UCSwipeEvent::Status status);
     bool swipedOverThreshold(const QPointF &mousePos, const QPointF relativePos);
     void handleLeftButtonPress(QMouseEvent *event);
@@ -137,6 +140,7 @@ UCListItemStyle *UCListItemPrivate::listItemStyle() const
 
 class PropertyChange;
 class ListItemDragArea;
+class ListItemPool;
 class ListViewProxy;
 class UCViewItemsAttachedPrivate : public QObjectPrivate
 {
@@ -159,7 +163,11 @@ public:
     void enterDragMode();
     void leaveDragMode();
     bool isDragUpdatedConnected();
+    void emitDragUpdated(UCDragEvent *event);
     void updateSelectedIndices(int fromIndex, int toIndex);
+    int selectedPosition(int index) const;
+    bool isIndexSelected(int index) const;
+    void selectedListChanged();
 
     // expansion
     void expand(int index, UCListItem *listItem, bool emitChangeSignal = true);
@@ -167,16 +175,31 @@ public:
     void collapseAll();
     void toggleExpansionFlags(bool enable);
 
-    QSet<int> selectedList;
+    // delegate pool
+    void parkItem(UCListItem *item);
+    void reuseItem(UCListItem *item);
+
+    // model changes
+    void _q_attachToModel();
+    void _q_rowsInserted(const QModelIndex &parent, int first, int last);
+    void _q_rowsRemoved(const QModelIndex &parent, int first, int last);
+    void shiftIndices(int index, int count);
+
+    // sorted selected indices, and their list reported by selectedIndices
+    QVector<int> selectedList;
+    QList<int> selectedIndices;
     QMap<int, QPointer<UCListItem> > expansionList;
     QList< QPointer<QQuickFlickable> > flickables;
     QPointer<UCListItem> boundItem;
+    QPointer<QAbstractItemModel> model;
     ListViewProxy *listView;
     ListItemDragArea *dragArea;
+    ListItemPool *pool;
     UCViewItemsAttached::ExpansionFlags expansionFlags;
     bool selectable:1;
     bool draggable:1;
     bool ready:1;
+    bool dragUpdating:1;
 };
 
 UT_NAMESPACE_END
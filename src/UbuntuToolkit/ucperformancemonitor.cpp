@@ -18,7 +18,16 @@
 
 #include "ucperformancemonitor_p.h"
 
+#include <algorithm>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
 #include <QtGui/QGuiApplication>
+#include <QtQuick/private/qquickitem_p.h>
+#include <QtQuick/private/qquickwindow_p.h>
+#include <UbuntuMetrics/applicationmonitor.h>
 
 Q_LOGGING_CATEGORY(ucPerformance, "[PERFORMANCE]")
 
@@ -29,6 +38,11 @@ static int multipleFrameThreshold = 17;
 static int framesCountThreshold = 10;
 static int warningCountThreshold = 30;
 
+// Bounds the work done per frame to record the polished and updated items.
+static const int maxRecordedItems = 4096;
+// Item classes listed in a report.
+static const int maxReportedClasses = 8;
+
 // TODO Qt 5.5. switch to qEnvironmentVariableIntValue
 static int getenvInt(const char* name, int defaultValue)
 {
@@ -42,118 +56,489 @@ static int getenvInt(const char* name, int defaultValue)
     }
 }
 
+static UCFrameReport::ItemClasses itemClasses(const QVector<const QMetaObject*> &metaObjects)
+{
+    QHash<const QMetaObject*, int> counts;
+    Q_FOREACH(const QMetaObject *metaObject, metaObjects) {
+        counts[metaObject]++;
+    }
+    UCFrameReport::ItemClasses classes;
+    classes.reserve(counts.count());
+    for (QHash<const QMetaObject*, int>::const_iterator i = counts.constBegin();
+         i != counts.constEnd(); ++i) {
+        classes.append(qMakePair(QByteArray(i.key()->className()), i.value()));
+    }
+    std::sort(classes.begin(), classes.end(),
+              [](const QPair<QByteArray, int> &a, const QPair<QByteArray, int> &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    });
+    if (classes.count() > maxReportedClasses) {
+        classes.resize(maxReportedClasses);
+    }
+    return classes;
+}
+
+/*
+ * Times the frames of a window. The scene graph signals are received in the render thread, the
+ * polished items are recorded in the GUI thread before the frame is polished. The connections
+ * of the render thread hold a reference on the monitor, stop() waits for their calls in progress
+ * so that no report is sent once it returns.
+ */
+class UCWindowPerformanceMonitor
+{
+public:
+    UCWindowPerformanceMonitor(UCPerformanceMonitor *monitor, QQuickWindow *window);
+
+    void start(const QSharedPointer<UCWindowPerformanceMonitor> &self);
+    void stop();
+    void setActive(bool active) { m_active.store(active); }
+    void setCaptureItems(bool capture) { m_captureItems.store(capture); }
+    void recordPolishedItems();
+
+private:
+    template <typename Signal, typename Function>
+    void connectRenderThread(const QSharedPointer<UCWindowPerformanceMonitor> &self,
+                             Signal signal, Function function);
+    void beforeSynchronizing();
+    void frameSwapped();
+    void report(int frameCount);
+
+    UCPerformanceMonitor *m_monitor;
+    QQuickWindow *m_window;
+    QList<QMetaObject::Connection> m_connections;
+    QAtomicInt m_active;
+    QAtomicInt m_captureItems;
+    QAtomicInt m_stopped;
+    QAtomicInt m_renderCalls;
+
+    // GUI thread, taken by the render thread at the synchronization
+    QMutex m_polishedItemsMutex;
+    QVector<const QMetaObject*> m_pendingPolishedItems;
+
+    // render thread
+    QElapsedTimer m_timer;
+    qint64 m_syncEnd;
+    qint64 m_renderStart;
+    qint64 m_renderEnd;
+    quint32 m_frameNumber;
+    int m_framesAboveThreshold;
+    QString m_windowTitle;
+    QVector<const QMetaObject*> m_polishedItems;
+    QVector<const QMetaObject*> m_updatedItems;
+};
+
+UCWindowPerformanceMonitor::UCWindowPerformanceMonitor(UCPerformanceMonitor *monitor,
+                                                       QQuickWindow *window)
+    : m_monitor(monitor)
+    , m_window(window)
+    , m_active(1)
+    , m_captureItems(0)
+    , m_stopped(0)
+    , m_renderCalls(0)
+    , m_syncEnd(0)
+    , m_renderStart(0)
+    , m_renderEnd(0)
+    , m_frameNumber(0)
+    , m_framesAboveThreshold(0)
+{
+}
+
+template <typename Signal, typename Function>
+void UCWindowPerformanceMonitor::connectRenderThread(
+        const QSharedPointer<UCWindowPerformanceMonitor> &self, Signal signal, Function function)
+{
+    // a call may still be on its way once disconnected, it then finds the monitor stopped
+    m_connections << QObject::connect(m_window, signal, m_monitor, [self, function]() {
+        self->m_renderCalls.ref();
+        if (!self->m_stopped.loadAcquire()) {
+            function(self.data());
+        }
+        self->m_renderCalls.deref();
+    }, Qt::DirectConnection);
+}
+
+void UCWindowPerformanceMonitor::start(const QSharedPointer<UCWindowPerformanceMonitor> &self)
+{
+    connectRenderThread(self, &QQuickWindow::beforeSynchronizing,
+                        [](UCWindowPerformanceMonitor *monitor) {
+        monitor->beforeSynchronizing();
+    });
+    connectRenderThread(self, &QQuickWindow::afterSynchronizing,
+                        [](UCWindowPerformanceMonitor *monitor) {
+        if (monitor->m_timer.isValid()) {
+            monitor->m_syncEnd = monitor->m_timer.nsecsElapsed();
+        }
+    });
+    connectRenderThread(self, &QQuickWindow::beforeRendering,
+                        [](UCWindowPerformanceMonitor *monitor) {
+        if (monitor->m_timer.isValid()) {
+            monitor->m_renderStart = monitor->m_timer.nsecsElapsed();
+        }
+    });
+    connectRenderThread(self, &QQuickWindow::afterRendering,
+                        [](UCWindowPerformanceMonitor *monitor) {
+        if (monitor->m_timer.isValid()) {
+            monitor->m_renderEnd = monitor->m_timer.nsecsElapsed();
+        }
+    });
+    connectRenderThread(self, &QQuickWindow::frameSwapped,
+                        [](UCWindowPerformanceMonitor *monitor) {
+        monitor->frameSwapped();
+    });
+}
+
+// Called in the GUI thread, which the render thread does not wait for outside of the
+// synchronization.
+void UCWindowPerformanceMonitor::stop()
+{
+    m_stopped.fetchAndStoreOrdered(1);
+    Q_FOREACH(const QMetaObject::Connection &connection, m_connections) {
+        QObject::disconnect(connection);
+    }
+    m_connections.clear();
+    while (m_renderCalls.loadAcquire() > 0) {
+        QThread::yieldCurrentThread();
+    }
+}
+
+// Called in the GUI thread before the polish of a frame.
+void UCWindowPerformanceMonitor::recordPolishedItems()
+{
+    if (!m_active.load() || !m_captureItems.load()) {
+        return;
+    }
+    QQuickWindowPrivate *d = QQuickWindowPrivate::get(m_window);
+    if (d->itemsToPolish.isEmpty()) {
+        return;
+    }
+    QMutexLocker lock(&m_polishedItemsMutex);
+    Q_FOREACH(QQuickItem *item, d->itemsToPolish) {
+        if (m_pendingPolishedItems.count() >= maxRecordedItems) {
+            break;
+        }
+        m_pendingPolishedItems.append(item->metaObject());
+    }
+}
+
+void UCWindowPerformanceMonitor::beforeSynchronizing()
+{
+    m_polishedItems.clear();
+    m_updatedItems.clear();
+    if (!m_active.load()) {
+        m_timer.invalidate();
+        return;
+    }
+    m_frameNumber++;
+    m_timer.start();
+    m_syncEnd = m_renderStart = m_renderEnd = 0;
+
+    // the GUI thread is blocked, the window and its items can be accessed
+    m_windowTitle = m_window->title();
+    if (!m_captureItems.load()) {
+        return;
+    }
+    {
+        QMutexLocker lock(&m_polishedItemsMutex);
+        m_polishedItems.swap(m_pendingPolishedItems);
+    }
+    QQuickWindowPrivate *d = QQuickWindowPrivate::get(m_window);
+    for (QQuickItem *item = d->dirtyItemList;
+         item && m_updatedItems.count() < maxRecordedItems;
+         item = QQuickItemPrivate::get(item)->nextDirtyItem) {
+        m_updatedItems.append(item->metaObject());
+    }
+}
+
+void UCWindowPerformanceMonitor::frameSwapped()
+{
+    if (!m_timer.isValid() || m_renderEnd == 0) {
+        return;
+    }
+    const qint64 totalTime = m_renderEnd;
+    const qint64 singleFrameTime = singleFrameThreshold * Q_INT64_C(1000000);
+    const qint64 multipleFrameTime = multipleFrameThreshold * Q_INT64_C(1000000);
+
+    if (totalTime >= singleFrameTime) {
+        report(1);
+    }
+    if (totalTime >= multipleFrameTime) {
+        m_framesAboveThreshold++;
+        if (m_framesAboveThreshold >= framesCountThreshold) {
+            report(m_framesAboveThreshold);
+            m_framesAboveThreshold = 0;
+        }
+    } else {
+        m_framesAboveThreshold = 0;
+    }
+}
+
+void UCWindowPerformanceMonitor::report(int frameCount)
+{
+    UCFrameReport report;
+    report.window = m_windowTitle;
+    if (report.window.isEmpty()) {
+        report.window = QStringLiteral("%1(0x%2)")
+            .arg(QString::fromLatin1(m_window->metaObject()->className()))
+            .arg(reinterpret_cast<quintptr>(m_window), 0, 16);
+    }
+    report.frameNumber = m_frameNumber;
+    report.frameCount = frameCount;
+    report.totalTime = m_renderEnd;
+    report.syncTime = m_syncEnd;
+    report.renderTime = m_renderEnd - m_renderStart;
+    report.swapTime = m_timer.nsecsElapsed() - m_renderEnd;
+    report.polishedItems = itemClasses(m_polishedItems);
+    report.updatedItems = itemClasses(m_updatedItems);
+    QMetaObject::invokeMethod(m_monitor, "deliverReport", Qt::QueuedConnection,
+                              Q_ARG(UT_PREPEND_NAMESPACE(UCFrameReport), report));
+}
+
+/*
+ * Logs the reports.
+ */
+class UCFrameReportLogger : public UCFrameReportSink
+{
+public:
+    void report(const UCFrameReport &report) override;
+    bool wantsItemClasses() const override { return false; }
+};
+
+static QString itemClassesString(const UCFrameReport::ItemClasses &classes)
+{
+    QStringList strings;
+    for (int i = 0; i < classes.count(); i++) {
+        strings.append(QStringLiteral("%1 x%2").arg(QString::fromLatin1(classes[i].first))
+                       .arg(classes[i].second));
+    }
+    return strings.isEmpty() ? QStringLiteral("none") : strings.join(QStringLiteral(", "));
+}
+
+void UCFrameReportLogger::report(const UCFrameReport &report)
+{
+    const int totalTimeInMs = report.totalTime / 1000000;
+    const QString phases = QStringLiteral("sync: %1 ms, render: %2 ms, swap: %3 ms")
+        .arg(report.syncTime / 1e6, 0, 'f', 1).arg(report.renderTime / 1e6, 0, 'f', 1)
+        .arg(report.swapTime / 1e6, 0, 'f', 1);
+    if (report.frameCount == 1) {
+        qCWarning(ucPerformance, "Last frame took %d ms to render (%s) in %s.", totalTimeInMs,
+                  qPrintable(phases), qPrintable(report.window));
+    } else {
+        qCWarning(ucPerformance,
+                  "Last %d frames took over %d ms to render (last frame: %d ms, %s) in %s.",
+                  report.frameCount, multipleFrameThreshold, totalTimeInMs, qPrintable(phases),
+                  qPrintable(report.window));
+    }
+    // the items are only recorded on demand
+    if (!report.polishedItems.isEmpty() || !report.updatedItems.isEmpty()) {
+        qCWarning(ucPerformance, "  polished items: %s",
+                  qPrintable(itemClassesString(report.polishedItems)));
+        qCWarning(ucPerformance, "  updated items: %s",
+                  qPrintable(itemClassesString(report.updatedItems)));
+    }
+}
+
+/*
+ * Publishes the reports as UMApplicationMonitor generic events, which are logged when the
+ * application monitor logs events.
+ */
+class UCFrameReportMetricsSink : public UCFrameReportSink
+{
+public:
+    UCFrameReportMetricsSink()
+        : m_eventId(UMApplicationMonitor::instance()->registerGenericEvent())
+    {
+    }
+    void report(const UCFrameReport &report) override;
+    bool wantsItemClasses() const override { return false; }
+
+private:
+    quint32 m_eventId;
+};
+
+void UCFrameReportMetricsSink::report(const UCFrameReport &report)
+{
+    // the string must fit in UMGenericEvent::maxStringSize
+    const QByteArray string = QStringLiteral("SlowFrame %1 %2 %3 %4 %5")
+        .arg(report.frameCount).arg(report.syncTime / 1000).arg(report.renderTime / 1000)
+        .arg(report.swapTime / 1000)
+        .arg(report.updatedItems.isEmpty() ? QByteArray("-") : report.updatedItems[0].first)
+        .toLatin1().left(UMGenericEvent::maxStringSize - 1);
+    UMApplicationMonitor::instance()->logGenericEvent(m_eventId, string.constData(),
+                                                      string.size() + 1);
+}
+
+// Windows are monitored by the first monitor reaching them, so that applications with several
+// engines get a single report per frame.
+static QHash<QQuickWindow*, UCPerformanceMonitor*> monitoredWindows;
+
+static bool warningCountReached(int count)
+{
+    return warningCountThreshold != -1 && count >= warningCountThreshold;
+}
+
 UCPerformanceMonitor::UCPerformanceMonitor(QObject* parent) :
     QObject(parent),
-    m_framesAboveThreshold(0),
-    m_warningCount(0),
-    m_window(NULL)
+    m_reportCount(0),
+    m_captureItemsSet(qEnvironmentVariableIsSet("UC_PERFORMANCE_MONITOR_ITEM_CLASSES")),
+    m_captureItems(false)
 {
-    QObject::connect((QGuiApplication*)QGuiApplication::instance(), &QGuiApplication::applicationStateChanged,
+    qRegisterMetaType<UT_PREPEND_NAMESPACE(UCFrameReport)>();
+    QGuiApplication *application = static_cast<QGuiApplication*>(QGuiApplication::instance());
+    QObject::connect(application, &QGuiApplication::applicationStateChanged,
                      this, &UCPerformanceMonitor::onApplicationStateChanged);
+    // windows are monitored once the application is active or once they get the focus
+    QObject::connect(application, &QGuiApplication::focusWindowChanged,
+                     this, &UCPerformanceMonitor::onFocusWindowChanged);
 
     singleFrameThreshold = getenvInt("UC_PERFORMANCE_MONITOR_SINGLE_FRAME_THRESHOLD", singleFrameThreshold);
     multipleFrameThreshold = getenvInt("UC_PERFORMANCE_MONITOR_MULTIPLE_FRAME_THRESHOLD", multipleFrameThreshold);
     framesCountThreshold = getenvInt("UC_PERFORMANCE_MONITOR_FRAMES_COUNT_THRESHOLD", framesCountThreshold);
     warningCountThreshold = getenvInt("UC_PERFORMANCE_MONITOR_WARNING_COUNT_THRESHOLD", warningCountThreshold);
+
+    installSink(new UCFrameReportLogger);
+    installSink(new UCFrameReportMetricsSink);
+    onApplicationStateChanged(QGuiApplication::applicationState());
 }
 
 UCPerformanceMonitor::~UCPerformanceMonitor()
 {
+    Q_FOREACH(QQuickWindow *window, m_windows.keys()) {
+        stopMonitoring(window);
+    }
+    qDeleteAll(m_sinks);
 }
 
-QQuickWindow* UCPerformanceMonitor::findQQuickWindow()
+void UCPerformanceMonitor::installSink(UCFrameReportSink *sink)
 {
-    Q_FOREACH (QWindow *w, QGuiApplication::topLevelWindows()) {
-        QQuickWindow* rootWindow = qobject_cast<QQuickWindow*>(w);
-        if (rootWindow) {
-            return rootWindow;
-        }
+    if (sink && !m_sinks.contains(sink)) {
+        m_sinks.append(sink);
+        updateItemCapture();
     }
-    return NULL;
 }
 
-void UCPerformanceMonitor::onApplicationStateChanged(Qt::ApplicationState state)
+void UCPerformanceMonitor::removeSink(UCFrameReportSink *sink, bool free)
 {
-    if (m_warningCount >= warningCountThreshold && warningCountThreshold != -1) {
-        // do not monitor performance if the warning count threshold was reached
-        return;
+    if (m_sinks.removeOne(sink)) {
+        updateItemCapture();
+        if (free) {
+            delete sink;
+        }
     }
+}
 
-    if (state == Qt::ApplicationActive) {
-        connectToWindow(findQQuickWindow());
-    } else {
-        connectToWindow(NULL);
+// the polished items are recorded from the update requests of the monitored windows
+bool UCPerformanceMonitor::eventFilter(QObject *object, QEvent *event)
+{
+    if (event->type() == QEvent::UpdateRequest) {
+        QSharedPointer<UCWindowPerformanceMonitor> monitor =
+            m_windows.value(static_cast<QQuickWindow*>(object));
+        if (monitor) {
+            monitor->recordPolishedItems();
+        }
     }
+    return QObject::eventFilter(object, event);
 }
 
-void UCPerformanceMonitor::connectToWindow(QQuickWindow* window)
+void UCPerformanceMonitor::updateItemCapture()
 {
-    if (window != m_window) {
-        if (m_window != NULL) {
-            QObject::disconnect(m_window, &QQuickWindow::beforeSynchronizing,
-                                this, &UCPerformanceMonitor::startTimer);
-            QObject::disconnect(m_window, &QQuickWindow::afterRendering,
-                                this, &UCPerformanceMonitor::stopTimer);
-            QObject::disconnect(m_window, &QWindow::destroyed,
-                                this, &UCPerformanceMonitor::windowDestroyed);
+    bool captureItems = m_captureItemsSet;
+    Q_FOREACH(UCFrameReportSink *sink, m_sinks) {
+        captureItems |= sink->wantsItemClasses();
+    }
+    if (m_captureItems == captureItems) {
+        return;
+    }
+    m_captureItems = captureItems;
+    for (QHash<QQuickWindow*, QSharedPointer<UCWindowPerformanceMonitor> >::const_iterator i =
+             m_windows.constBegin(); i != m_windows.constEnd(); ++i) {
+        i.value()->setCaptureItems(captureItems);
+        if (captureItems) {
+            i.key()->installEventFilter(this);
+        } else {
+            i.key()->removeEventFilter(this);
         }
+    }
+}
 
-        m_window = window;
-
-        if (m_window != NULL) {
-            QObject::connect(m_window, &QQuickWindow::beforeSynchronizing,
-                             this, &UCPerformanceMonitor::startTimer,
-                             Qt::DirectConnection);
-            QObject::connect(m_window, &QQuickWindow::afterRendering,
-                             this, &UCPerformanceMonitor::stopTimer,
-                             Qt::DirectConnection);
-            QObject::connect(m_window, &QWindow::destroyed,
-                             this, &UCPerformanceMonitor::windowDestroyed);
+void UCPerformanceMonitor::onApplicationStateChanged(Qt::ApplicationState state)
+{
+    // only the frames of active applications are monitored
+    Q_FOREACH(const QSharedPointer<UCWindowPerformanceMonitor> &monitor, m_windows) {
+        monitor->setActive(state == Qt::ApplicationActive);
+    }
+    if (state == Qt::ApplicationActive) {
+        Q_FOREACH(QWindow *window, QGuiApplication::topLevelWindows()) {
+            QQuickWindow *quickWindow = qobject_cast<QQuickWindow*>(window);
+            if (quickWindow && quickWindow->isVisible()) {
+                startMonitoring(quickWindow);
+            }
         }
     }
 }
 
-void UCPerformanceMonitor::startTimer()
+void UCPerformanceMonitor::onFocusWindowChanged(QWindow *window)
 {
-    m_timer.start();
+    QQuickWindow *quickWindow = qobject_cast<QQuickWindow*>(window);
+    if (quickWindow) {
+        startMonitoring(quickWindow);
+    }
 }
 
-void UCPerformanceMonitor::stopTimer()
+void UCPerformanceMonitor::onWindowDestroyed(QObject *object)
 {
-    if (!m_timer.isValid()) {
+    // the window stopped rendering by then
+    stopMonitoring(static_cast<QQuickWindow*>(object));
+}
+
+void UCPerformanceMonitor::deliverReport(const UCFrameReport &report)
+{
+    // reports may have been queued before the monitoring stopped
+    if (warningCountReached(m_reportCount)) {
         return;
     }
-
-    const int totalTimeInMs = m_timer.elapsed();
-    m_timer.invalidate();
-
-    if (totalTimeInMs >= singleFrameThreshold) {
-        qCWarning(ucPerformance, "Last frame took %d ms to render.", totalTimeInMs);
-        m_warningCount++;
+    Q_FOREACH(UCFrameReportSink *sink, m_sinks) {
+        sink->report(report);
     }
+    m_reportCount++;
 
-    if (totalTimeInMs >= multipleFrameThreshold) {
-        m_framesAboveThreshold++;
-        if (m_framesAboveThreshold >= framesCountThreshold) {
-            qCWarning(ucPerformance,
-                      "Last %d frames took over %d ms to render (last frame: %d ms)",
-                      m_framesAboveThreshold, multipleFrameThreshold, totalTimeInMs);
-            m_framesAboveThreshold = 0;
-            m_warningCount++;
+    if (warningCountReached(m_reportCount)) {
+        qCWarning(ucPerformance, "Too many warnings were given. Performance monitoring stops.");
+        Q_FOREACH(QQuickWindow *window, m_windows.keys()) {
+            stopMonitoring(window);
         }
-    } else {
-        m_framesAboveThreshold = 0;
     }
+}
 
-    if (m_warningCount >= warningCountThreshold && warningCountThreshold != -1) {
-        qCWarning(ucPerformance, "Too many warnings were given. Performance monitoring stops.");
-        connectToWindow(NULL);
+void UCPerformanceMonitor::startMonitoring(QQuickWindow *window)
+{
+    if (warningCountReached(m_reportCount) || monitoredWindows.contains(window)) {
+        return;
+    }
+    QSharedPointer<UCWindowPerformanceMonitor> monitor(
+        new UCWindowPerformanceMonitor(this, window));
+    monitor->setActive(QGuiApplication::applicationState() == Qt::ApplicationActive);
+    monitor->setCaptureItems(m_captureItems);
+    monitor->start(monitor);
+    m_windows.insert(window, monitor);
+    monitoredWindows.insert(window, this);
+    if (m_captureItems) {
+        window->installEventFilter(this);
     }
+    QObject::connect(window, &QObject::destroyed, this, &UCPerformanceMonitor::onWindowDestroyed,
+                     Qt::UniqueConnection);
 }
 
-void UCPerformanceMonitor::windowDestroyed()
+void UCPerformanceMonitor::stopMonitoring(QQuickWindow *window)
 {
-    connectToWindow(NULL);
+    QSharedPointer<UCWindowPerformanceMonitor> monitor = m_windows.take(window);
+    if (!monitor) {
+        return;
+    }
+    monitor->stop();
+    monitoredWindows.remove(window);
+    window->removeEventFilter(this);
+    QObject::disconnect(window, &QObject::destroyed,
+                        this, &UCPerformanceMonitor::onWindowDestroyed);
 }
 
 UT_NAMESPACE_END
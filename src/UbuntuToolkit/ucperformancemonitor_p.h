@@ -19,16 +19,56 @@
 #ifndef UCPERFORMANCEMONITOR_P_H
 #define UCPERFORMANCEMONITOR_P_H
 
-#include <QtCore/QElapsedTimer>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QMetaType>
 #include <QtCore/QObject>
+#include <QtCore/QPair>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QVector>
 #include <QtQuick/QQuickWindow>
 
 #include <UbuntuToolkit/ubuntutoolkitglobal.h>
 
 UT_NAMESPACE_BEGIN
 
+// A frame which took too long to be synchronized and rendered, or the last frame of a series of
+// such frames. Times are in nanoseconds. The classes of the items polished and updated in the
+// frame are listed by decreasing count.
+struct UBUNTUTOOLKIT_EXPORT UCFrameReport
+{
+    typedef QVector<QPair<QByteArray, int> > ItemClasses;
+
+    // Title of the window, or its class and address if it has none.
+    QString window;
+    // Number of the frame in the window, since the monitoring started.
+    quint32 frameNumber;
+    // Number of consecutive slow frames, 1 for a single slow frame.
+    int frameCount;
+    // Time from the start of the synchronization to the end of the rendering.
+    qint64 totalTime;
+    qint64 syncTime;
+    qint64 renderTime;
+    qint64 swapTime;
+    ItemClasses polishedItems;
+    ItemClasses updatedItems;
+};
+
+// Receives the frame reports in the GUI thread.
+class UBUNTUTOOLKIT_EXPORT UCFrameReportSink
+{
+public:
+    virtual ~UCFrameReportSink() {}
+    virtual void report(const UCFrameReport &report) = 0;
+    // The polished and updated items are only recorded when a sink lists their classes or when
+    // UC_PERFORMANCE_MONITOR_ITEM_CLASSES is set.
+    virtual bool wantsItemClasses() const { return true; }
+};
+
+class UCWindowPerformanceMonitor;
 class UBUNTUTOOLKIT_EXPORT UCPerformanceMonitor : public QObject
 {
     Q_OBJECT
@@ -37,25 +77,35 @@ public:
     explicit UCPerformanceMonitor(QObject* parent = 0);
     ~UCPerformanceMonitor();
 
+    // The monitor owns the installed sinks. A sink logging the reports and a sink publishing
+    // them as UMApplicationMonitor generic events are installed by default.
+    void installSink(UCFrameReportSink *sink);
+    void removeSink(UCFrameReportSink *sink, bool free = true);
+    QList<UCFrameReportSink*> sinks() const { return m_sinks; }
+
+    bool eventFilter(QObject *object, QEvent *event) override;
+
 private Q_SLOTS:
     void onApplicationStateChanged(Qt::ApplicationState state);
-    void connectToWindow(QQuickWindow* window);
-    void startTimer();
-    void stopTimer();
-    void windowDestroyed();
+    void onFocusWindowChanged(QWindow *window);
+    void onWindowDestroyed(QObject *object);
+    void deliverReport(const UT_PREPEND_NAMESPACE(UCFrameReport) &report);
 
 private:
-    QQuickWindow* findQQuickWindow();
+    void startMonitoring(QQuickWindow *window);
+    void stopMonitoring(QQuickWindow *window);
+    void updateItemCapture();
 
-private:
-    int m_framesAboveThreshold;
-    int m_warningCount;
-    QElapsedTimer m_timer;
-    QQuickWindow* m_window;
+    QHash<QQuickWindow*, QSharedPointer<UCWindowPerformanceMonitor> > m_windows;
+    QList<UCFrameReportSink*> m_sinks;
+    int m_reportCount;
+    bool m_captureItemsSet;
+    bool m_captureItems;
 };
 
 UT_NAMESPACE_END
 
+Q_DECLARE_METATYPE(UT_PREPEND_NAMESPACE(UCFrameReport))
 Q_DECLARE_LOGGING_CATEGORY(ucPerformance)
 
 #endif // UCPERFORMANCEMONITOR_P_H
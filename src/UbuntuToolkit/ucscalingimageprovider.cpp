@@ -18,7 +18,12 @@
 
 #include "ucscalingimageprovider_p.h"
 
+#include <QtCore/QCache>
 #include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
 #include <QtGui/QImageReader>
 
 UT_NAMESPACE_BEGIN
@@ -33,19 +38,128 @@ UT_NAMESPACE_BEGIN
 
     Example:
      * image://scaling/0.5/arrow.png
+
+    Images are decoded asynchronously on a bounded thread pool. Concurrent
+    requests of the same image (path, scale and requested size) are served by
+    a single decoding, and decoded images are kept in a cache limited in bytes
+    so that scrolling back through image heavy views does not decode again.
 */
-UCScalingImageProvider::UCScalingImageProvider() : QQuickImageProvider(QQuickImageProvider::Image)
+
+struct ScalingImageKey
+{
+    ScalingImageKey(const QString &id, const QSize &requestedSize)
+        : requestedSize(requestedSize)
+    {
+        int separatorPosition = id.indexOf(QLatin1Char('/'));
+        scaleFactor = id.leftRef(separatorPosition).toFloat();
+        int fragmentPosition = id.lastIndexOf(QLatin1Char('#'));
+        int pathLength = fragmentPosition > -1 ? fragmentPosition - separatorPosition - 1 : -1;
+        path = id.mid(separatorPosition + 1, pathLength);
+    }
+    bool operator==(const ScalingImageKey &other) const
+    {
+        return scaleFactor == other.scaleFactor && requestedSize == other.requestedSize
+            && path == other.path;
+    }
+
+    QString path;
+    QSize requestedSize;
+    float scaleFactor;
+};
+
+inline uint qHash(const ScalingImageKey &key, uint seed = 0)
 {
+    return qHash(key.path, seed) ^ qHash(key.scaleFactor, seed)
+        ^ qHash(key.requestedSize.width(), seed) ^ (qHash(key.requestedSize.height(), seed) << 1);
 }
 
-QImage UCScalingImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+struct ScalingImage
+{
+    ScalingImage(const QImage &image, const QSize &size)
+        : image(image), size(size)
+    {}
+    QImage image;
+    QSize size;
+};
+
+class UCScalingImageResponse : public QQuickImageResponse
 {
-    int separatorPosition = id.indexOf(QStringLiteral("/"));
-    float scaleFactor = id.left(separatorPosition).toFloat();
-    int fragmentPosition = id.lastIndexOf(QStringLiteral("#"));
-    int pathLength = fragmentPosition > -1 ? fragmentPosition - separatorPosition - 1 : -1;
-    QString path = id.mid(separatorPosition + 1, pathLength);
-    QFile file(path);
+public:
+    UCScalingImageResponse(const QSharedPointer<ScalingImageStore> &store, const ScalingImageKey &key)
+        : m_store(store), m_key(key)
+    {}
+    ~UCScalingImageResponse();
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        QMutexLocker lock(&m_mutex);
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+    QString errorString() const override
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_image.isNull() ? QStringLiteral("Cannot load image %1").arg(m_key.path) : QString();
+    }
+    void cancel() override;
+
+    // finished() is always queued to the thread of the response: the engine connects to it only
+    // once the response is returned, which the decoding job may not wait for
+    void setImage(const QImage &image)
+    {
+        m_mutex.lock();
+        m_image = image;
+        m_mutex.unlock();
+        QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QSharedPointer<ScalingImageStore> m_store;
+    ScalingImageKey m_key;
+    QImage m_image;
+};
+
+// State shared between the provider, the decoding jobs and the responses, which
+// may outlive the provider.
+class ScalingImageStore
+{
+public:
+    ScalingImageStore()
+        : cache(UCScalingImageProvider::defaultCacheSize / 1024)
+    {}
+
+    // returns false if the response is not waiting for the decoding anymore
+    bool removeResponse(const ScalingImageKey &key, UCScalingImageResponse *response)
+    {
+        QMutexLocker lock(&mutex);
+        QHash<ScalingImageKey, QList<UCScalingImageResponse*> >::iterator i = pending.find(key);
+        return i != pending.end() && i->removeOne(response);
+    }
+
+    QMutex mutex;
+    // cost is in kB
+    QCache<ScalingImageKey, ScalingImage> cache;
+    // responses waiting for the decoding of an image
+    QHash<ScalingImageKey, QList<UCScalingImageResponse*> > pending;
+};
+
+UCScalingImageResponse::~UCScalingImageResponse()
+{
+    m_store->removeResponse(m_key, this);
+}
+
+void UCScalingImageResponse::cancel()
+{
+    // the decoding is not interrupted as the image may be requested by others; the engine only
+    // deletes the response once finished, which the decoding won't emit anymore
+    if (m_store->removeResponse(m_key, this)) {
+        QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+    }
+}
+
+static QImage decodeImage(const ScalingImageKey &key, QSize *size)
+{
+    QFile file(key.path);
 
     if (file.open(QIODevice::ReadOnly)) {
         QImage image;
@@ -53,9 +167,10 @@ QImage UCScalingImageProvider::requestImage(const QString &id, QSize *size, cons
         QSize realSize = imageReader.size();
         QSize scaledSize = realSize;
         QSize constrainedSize;
+        const QSize &requestedSize = key.requestedSize;
 
-        if (!qFuzzyCompare(scaleFactor, (float)1.0)) {
-            scaledSize = realSize * scaleFactor;
+        if (!qFuzzyCompare(key.scaleFactor, (float)1.0)) {
+            scaledSize = realSize * key.scaleFactor;
         }
         if (requestedSize.isValid() && (requestedSize.width() < realSize.width() || requestedSize.height() < realSize.height())) {
             if (requestedSize.width() > 0 && requestedSize.height() == 0 && scaledSize.width() > 0) {
@@ -83,4 +198,127 @@ QImage UCScalingImageProvider::requestImage(const QString &id, QSize *size, cons
     }
 }
 
+// caches a decoded image, the store must be locked
+static void cacheImage(ScalingImageStore *store, const ScalingImageKey &key, const QImage &image, const QSize &size)
+{
+    if (!image.isNull()) {
+        store->cache.insert(key, new ScalingImage(image, size), qMax(1, image.byteCount() / 1024));
+    }
+}
+
+class ScalingImageJob : public QRunnable
+{
+public:
+    ScalingImageJob(const QSharedPointer<ScalingImageStore> &store, const ScalingImageKey &key)
+        : m_store(store), m_key(key)
+    {}
+
+    void run() override
+    {
+        QSize size;
+        QImage image = decodeImage(m_key, &size);
+
+        // responses are notified with the store locked so that they cannot be
+        // destroyed meanwhile
+        QMutexLocker lock(&m_store->mutex);
+        cacheImage(m_store.data(), m_key, image, size);
+        Q_FOREACH(UCScalingImageResponse *response, m_store->pending.take(m_key)) {
+            response->setImage(image);
+        }
+    }
+
+private:
+    QSharedPointer<ScalingImageStore> m_store;
+    ScalingImageKey m_key;
+};
+
+UCScalingImageProvider::UCScalingImageProvider()
+    : QQuickAsyncImageProvider()
+    , m_store(new ScalingImageStore)
+{
+    m_threadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+}
+
+UCScalingImageProvider::~UCScalingImageProvider()
+{
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+
+    // the responses of the dropped decodings finish without image
+    QMutexLocker lock(&m_store->mutex);
+    QHash<ScalingImageKey, QList<UCScalingImageResponse*> > pending;
+    pending.swap(m_store->pending);
+    Q_FOREACH(const QList<UCScalingImageResponse*> &responses, pending) {
+        Q_FOREACH(UCScalingImageResponse *response, responses) {
+            response->setImage(QImage());
+        }
+    }
+}
+
+QQuickImageResponse *UCScalingImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    ScalingImageKey key(id, requestedSize);
+    UCScalingImageResponse *response = new UCScalingImageResponse(m_store, key);
+
+    m_store->mutex.lock();
+    ScalingImage *cached = m_store->cache.object(key);
+    if (cached) {
+        QImage image = cached->image;
+        m_store->mutex.unlock();
+        response->setImage(image);
+        return response;
+    }
+    QHash<ScalingImageKey, QList<UCScalingImageResponse*> >::iterator i = m_store->pending.find(key);
+    if (i != m_store->pending.end()) {
+        // the image is being decoded already
+        i->append(response);
+        m_store->mutex.unlock();
+        return response;
+    }
+    m_store->pending.insert(key, QList<UCScalingImageResponse*>() << response);
+    m_store->mutex.unlock();
+
+    m_threadPool.start(new ScalingImageJob(m_store, key));
+    return response;
+}
+
+QImage UCScalingImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    ScalingImageKey key(id, requestedSize);
+
+    m_store->mutex.lock();
+    ScalingImage *cached = m_store->cache.object(key);
+    if (cached) {
+        QImage image = cached->image;
+        *size = cached->size;
+        m_store->mutex.unlock();
+        return image;
+    }
+    m_store->mutex.unlock();
+
+    QImage image = decodeImage(key, size);
+    m_store->mutex.lock();
+    cacheImage(m_store.data(), key, image, *size);
+    m_store->mutex.unlock();
+    return image;
+}
+
+void UCScalingImageProvider::setCacheSize(int bytes)
+{
+    QMutexLocker lock(&m_store->mutex);
+    m_store->cache.setMaxCost(qMax(0, bytes / 1024));
+}
+
+int UCScalingImageProvider::cacheSize() const
+{
+    QMutexLocker lock(&m_store->mutex);
+    return m_store->cache.maxCost() * 1024;
+}
+
+void UCScalingImageProvider::clearCache()
+{
+    QMutexLocker lock(&m_store->mutex);
+    m_store->cache.clear();
+}
+
 UT_NAMESPACE_END
@@ -19,6 +19,8 @@
 #ifndef UCSCALINGIMAGEPROVIDER_P_H
 #define UCSCALINGIMAGEPROVIDER_P_H
 
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
 #include <QtGui/QImage>
 #include <QtQuick/QQuickImageProvider>
 
@@ -26,11 +28,25 @@
 
 UT_NAMESPACE_BEGIN
 
-class UBUNTUTOOLKIT_EXPORT UCScalingImageProvider : public QQuickImageProvider
+class ScalingImageStore;
+class UBUNTUTOOLKIT_EXPORT UCScalingImageProvider : public QQuickAsyncImageProvider
 {
 public:
+    static const int defaultCacheSize = 16 * 1024 * 1024;
+
     explicit UCScalingImageProvider();
+    ~UCScalingImageProvider();
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    // size of the decoded images cache in bytes
+    void setCacheSize(int bytes);
+    int cacheSize() const;
+    void clearCache();
+
+private:
+    QThreadPool m_threadPool;
+    QSharedPointer<ScalingImageStore> m_store;
 };
 
 UT_NAMESPACE_END
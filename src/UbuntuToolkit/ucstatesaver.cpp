@@ -76,7 +76,7 @@ void UCStateSaverAttachedPrivate::_q_init()
 void UCStateSaverAttachedPrivate::_q_save()
 {
     if (m_enabled && StateSaverBackend::instance()->enabled() && !m_properties.isEmpty() && !m_absoluteId.isEmpty()) {
-        StateSaverBackend::instance()->save(m_absoluteId, m_attachee, m_properties);
+        StateSaverBackend::instance()->save(m_absoluteId, m_attachee, qmlProperties());
     }
 }
 
@@ -123,11 +123,23 @@ QString UCStateSaverAttachedPrivate::absoluteId(const QString &id)
     return path;
 }
 
+const QVector<QQmlProperty> &UCStateSaverAttachedPrivate::qmlProperties()
+{
+    if (m_qmlProperties.isEmpty()) {
+        QQmlContext *context = qmlContext(m_attachee);
+        m_qmlProperties.reserve(m_properties.size());
+        Q_FOREACH(const QString &property, m_properties) {
+            m_qmlProperties.append(QQmlProperty(m_attachee, property, context));
+        }
+    }
+    return m_qmlProperties;
+}
+
 void UCStateSaverAttachedPrivate::restore()
 {
     if (m_enabled && !m_absoluteId.isEmpty() && !m_properties.isEmpty()) {
         // load group
-        StateSaverBackend::instance()->load(m_absoluteId, m_attachee, m_properties);
+        StateSaverBackend::instance()->load(m_absoluteId, m_attachee, qmlProperties());
     }
 }
 
@@ -332,6 +344,7 @@ void UCStateSaverAttached::setProperties(const QString &list)
     Q_D(UCStateSaverAttached);
     if (d->m_properties != propertyList) {
         d->m_properties = propertyList;
+        d->m_qmlProperties.clear();
         Q_EMIT propertiesChanged();
         d->restore();
     }
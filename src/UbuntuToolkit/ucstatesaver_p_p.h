@@ -22,6 +22,8 @@
 #include <UbuntuToolkit/private/ucstatesaver_p.h>
 
 #include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtQml/QQmlProperty>
 #include <QtCore/private/qobject_p.h>
 
 UT_NAMESPACE_BEGIN
@@ -38,8 +40,11 @@ public:
     QString m_id;
     QString m_absoluteId;
     QStringList m_properties;
+    // m_properties resolved on the attachee, lazily
+    QVector<QQmlProperty> m_qmlProperties;
 
     QString absoluteId(const QString &id);
+    const QVector<QQmlProperty> &qmlProperties();
     void restore();
     void watchComponent(bool watch);
 
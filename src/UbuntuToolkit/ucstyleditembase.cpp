@@ -18,7 +18,10 @@
 
 #include "ucstyleditembase_p_p.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtQml/QQmlEngine>
+#include <QtQml/QQmlIncubator>
+#include <QtQuick/QQuickWindow>
 #include <QtQuick/private/qquickanchors_p.h>
 
 #include "ucstylehints_p.h"
@@ -27,15 +30,73 @@
 
 UT_NAMESPACE_BEGIN
 
+static QHash<QString, UCStyleCreationCounter> &styleCounters()
+{
+    static QHash<QString, UCStyleCreationCounter> counters;
+    return counters;
+}
+
+static void countStyleCreation(const QString &key, qint64 time, bool asynchronous)
+{
+    UCStyleCreationCounter &counter = styleCounters()[key];
+    counter.count++;
+    if (asynchronous) {
+        counter.asynchronousCount++;
+    }
+    counter.totalTime += time;
+    counter.maximumTime = qMax(counter.maximumTime, time);
+}
+
+// incubates the style of a StyledItem, the style item is parented to the StyledItem before its
+// bindings are evaluated, same as when created synchronously
+class UCStyleIncubator : public QQmlIncubator
+{
+public:
+    UCStyleIncubator(UCStyledItemBasePrivate *styledItem, const QString &key)
+        : QQmlIncubator(Asynchronous)
+        , m_styledItem(styledItem)
+        , m_key(key)
+    {
+    }
+
+    QString key() const
+    {
+        return m_key;
+    }
+
+protected:
+    void setInitialState(QObject *object) override
+    {
+        m_styledItem->setupStyleObject(object);
+    }
+    void statusChanged(Status status) override
+    {
+        // the incubator cannot be deleted from here, complete the style later
+        if (status != Loading) {
+            QMetaObject::invokeMethod(m_styledItem->q_func(), "_q_loadDeferredStyle",
+                                      Qt::QueuedConnection);
+        }
+    }
+
+private:
+    UCStyledItemBasePrivate *m_styledItem;
+    QString m_key;
+};
+
 UCStyledItemBasePrivate::UCStyledItemBasePrivate()
     : oldParentItem(Q_NULLPTR)
     , styleComponent(Q_NULLPTR)
     , styleItem(Q_NULLPTR)
+    , styleIncubator(Q_NULLPTR)
     , styleVersion(0)
+    , styleLoadingMode(UCStyledItemBase::Immediate)
     , keyNavigationFocus(false)
     , activeFocusOnPress(false)
     , wasStyleLoaded(false)
     , isFocusScope(true)
+    , deferStyleLoading(false)
+    , waitsForVisibility(false)
+    , wasStyleDeferred(false)
 {
 }
 
@@ -180,6 +241,13 @@ UCStyledItemBase::UCStyledItemBase(UCStyledItemBasePrivate &dd, QQuickItem *pare
     d->init();
 }
 
+UCStyledItemBase::~UCStyledItemBase()
+{
+    // the style being incubated must go before the children
+    Q_D(UCStyledItemBase);
+    d->cancelDeferredStyle();
+}
+
 /*!
  * \qmlmethod void StyledItemBase::requestFocus(Qt::FocusReason reason)
  * \since Ubuntu.Components 1.1
@@ -339,10 +407,125 @@ void UCStyledItemBasePrivate::setStyleName(const QString &name)
     loadStyleItem();
 }
 
+/*!
+ * \qmlproperty enumeration StyledItem::styleLoading
+ * \since Ubuntu.Components 1.3
+ * The property specifies when the style is created once the component is completed.
+ * \list
+ *  \li \b StyledItem.Immediate - the style is created on completion, this is the default
+ *  \li \b StyledItem.WhenVisible - the style is created in the first frame the item is
+ *      visible on screen, delegates created off-screen by views skip the style until they
+ *      are scrolled in
+ *  \li \b StyledItem.Asynchronous - the style is incubated asynchronously, the item is
+ *      shown without its style meanwhile
+ * \endlist
+ * Styles changed after completion, or needed by the component, are created immediately.
+ * \qml
+ * ListView {
+ *     model: 1000
+ *     delegate: Button {
+ *         styleLoading: StyledItem.WhenVisible
+ *         text: "Button #" + index
+ *     }
+ * }
+ * \endqml
+ */
+UCStyledItemBase::StyleLoading UCStyledItemBasePrivate::styleLoading() const
+{
+    return static_cast<UCStyledItemBase::StyleLoading>(styleLoadingMode);
+}
+void UCStyledItemBasePrivate::setStyleLoading(UCStyledItemBase::StyleLoading loading)
+{
+    if (styleLoadingMode == loading) {
+        return;
+    }
+    styleLoadingMode = loading;
+    Q_EMIT q_func()->styleLoadingChanged();
+    if (loading == UCStyledItemBase::Immediate && isStyleDeferred() && !loadStyleItem(false)) {
+        cancelDeferredStyle();
+    }
+}
+
+bool UCStyledItemBasePrivate::isStyleDeferred() const
+{
+    return waitsForVisibility || styleIncubator;
+}
+
+// drops the style waiting for the item to be visible or being incubated
+void UCStyledItemBasePrivate::cancelDeferredStyle()
+{
+    Q_Q(UCStyledItemBase);
+    waitsForVisibility = false;
+    QObject::disconnect(visibilityConnection);
+    visibilityConnection = QMetaObject::Connection();
+    if (styleIncubator) {
+        // the incubator deletes the objects it didn't complete
+        QObject *object = styleIncubator->isReady() ? styleIncubator->object() : Q_NULLPTR;
+        delete styleIncubator;
+        styleIncubator = Q_NULLPTR;
+        if (object) {
+            QQuickItem *item = qobject_cast<QQuickItem*>(object);
+            if (item) {
+                item->setParentItem(Q_NULLPTR);
+            }
+            object->deleteLater();
+        }
+        if (styleItemContext && styleItemContext->parent() == q) {
+            delete styleItemContext.data();
+        }
+    }
+}
+
+// the item is visible if it intersects the window and its clipping ancestors; items
+// without size are visible if their position is
+bool UCStyledItemBasePrivate::isOnScreen() const
+{
+    Q_Q(const UCStyledItemBase);
+    if (!window || !effectiveVisible) {
+        return false;
+    }
+    QRectF visibleRect(QPointF(), window->size());
+    for (QQuickItem *item = parentItem; item; item = item->parentItem()) {
+        if (item->clip()) {
+            visibleRect &= item->mapRectToScene(QRectF(0, 0, item->width(), item->height()));
+        }
+    }
+    QRectF rect = q->mapRectToScene(QRectF(0, 0, width, height));
+    return rect.isEmpty() ? visibleRect.contains(rect.topLeft()) : visibleRect.intersects(rect);
+}
+
+// checks the visibility of the item in each frame of its window until the style is loaded
+void UCStyledItemBasePrivate::watchVisibility()
+{
+    Q_Q(UCStyledItemBase);
+    QObject::disconnect(visibilityConnection);
+    visibilityConnection = QMetaObject::Connection();
+    if (waitsForVisibility && window) {
+        // animations are advanced by then, and the new items are still to be polished
+        visibilityConnection = QObject::connect(window, SIGNAL(afterAnimating()),
+                                                q, SLOT(_q_loadDeferredStyle()),
+                                                Qt::DirectConnection);
+        window->update();
+    }
+}
+
+void UCStyledItemBasePrivate::_q_loadDeferredStyle()
+{
+    if (!isStyleDeferred() || (styleIncubator && styleIncubator->isLoading())
+            || (waitsForVisibility && !isOnScreen())) {
+        return;
+    }
+    // derived components may not need the style at this point, drop it then
+    if (!loadStyleItem(false)) {
+        cancelDeferredStyle();
+    }
+}
+
 // performs pre-style change actions, removes style item size change
 // connections and destroys the style component
 void UCStyledItemBasePrivate::preStyleChanged()
 {
+    cancelDeferredStyle();
     if (styleItem) {
         // make sure the context holder is reset too
         styleItemContext.clear();
@@ -364,19 +547,49 @@ bool UCStyledItemBasePrivate::loadStyleItem(bool animated)
         // the style loading is delayed
         return false;
     }
+    if (isStyleDeferred()) {
+        if (deferStyleLoading) {
+            return false;
+        }
+        // the style is needed now
+        if (styleIncubator) {
+            return completeStyleIncubation();
+        }
+        waitsForVisibility = false;
+        watchVisibility();
+    }
+    if (deferStyleLoading && styleLoadingMode == UCStyledItemBase::WhenVisible) {
+        waitsForVisibility = true;
+        watchVisibility();
+        return false;
+    }
     Q_Q(UCStyledItemBase);
+    QElapsedTimer timer;
+    timer.start();
     // either styleComponent or styleName is valid
     QQmlComponent *component = styleComponent;
     UCTheme *theme = q->getTheme();
+    const QString styleName = styleDocument + ".qml";
+    bool cachedComponent = false;
+    bool temporaryComponent = false;
     if (!component && theme) {
-        component = theme->createStyleComponent(styleDocument + ".qml", q, styleVersion);
+        component = theme->cachedStyleComponent(styleName, q, styleVersion);
+        cachedComponent = component;
+        if (component && theme->cachedStyleCreations(styleName, q, styleVersion) > 0) {
+            // the shared style component is creating an instance further up in
+            // the stack, use a temporary component for this one
+            component = theme->createStyleComponent(styleName, q, styleVersion);
+            cachedComponent = false;
+            temporaryComponent = true;
+        }
     }
     if (!component) {
         return false;
     }
     // create context
-    // use creation context as parent to create the context we load the style item with
-    QQmlContext *creationContext = component->creationContext();
+    // use creation context as parent to create the context we load the style item with;
+    // theme styles are shared between items, those are created in the item's context
+    QQmlContext *creationContext = styleComponent ? component->creationContext() : Q_NULLPTR;
     if (!creationContext) {
         creationContext = qmlContext(q);
     }
@@ -384,45 +597,140 @@ bool UCStyledItemBasePrivate::loadStyleItem(bool animated)
         // we are having the changes in the component being under deletion
         return false;
     }
+    const QString key = styleComponent ? component->url().toString() : styleDocument;
+    if (deferStyleLoading && styleLoadingMode == UCStyledItemBase::Asynchronous
+            && !temporaryComponent && startStyleIncubation(component, creationContext, key)) {
+        return false;
+    }
     styleItemContext = new QQmlContext(creationContext);
     styleItemContext->setContextObject(q);
     styleItemContext->setContextProperty(QStringLiteral("styledItem"), q);
     styleItemContext->setContextProperty(QStringLiteral("animated"), animated);
+    if (cachedComponent) {
+        theme->cachedStyleCreations(styleName, q, styleVersion, 1);
+    }
     QObject *object = component->beginCreate(styleItemContext);
     if (!object) {
+        if (cachedComponent) {
+            theme->cachedStyleCreations(styleName, q, styleVersion, -1);
+        }
         delete styleItemContext;
         return false;
     }
+    setupStyleObject(object);
+    styleItem = qobject_cast<::QQuickItem*>(object);
+    if (!styleItem) {
+        delete object;
+    }
+    component->completeCreate();
+    if (cachedComponent) {
+        theme->cachedStyleCreations(styleName, q, styleVersion, -1);
+    }
+    if (temporaryComponent) {
+        delete component;
+    }
+    countStyleCreation(key, timer.nsecsElapsed(), false);
+
+    finishStyleItem(animated);
+    return true;
+}
+
+// parents the style object to the styled item, before its bindings are evaluated
+void UCStyledItemBasePrivate::setupStyleObject(QObject *object)
+{
+    Q_Q(UCStyledItemBase);
     // link context to the style item to delete them together
     QQml_setParent_noEvent(styleItemContext, object);
-    styleItem = qobject_cast<::QQuickItem*>(object);
-    if (styleItem) {
-        QQml_setParent_noEvent(styleItem, q);
-        styleItem->setParentItem(q);
+    QQuickItem *item = qobject_cast<::QQuickItem*>(object);
+    if (item) {
+        QQml_setParent_noEvent(item, q);
+        item->setParentItem(q);
         // put the style behind evenrything
-        styleItem->setZ(-1);
+        item->setZ(-1);
         // anchor fill to the styled component
-        QQuickAnchors *styleAnchors = QQuickItemPrivate::get(styleItem)->anchors();
+        QQuickAnchors *styleAnchors = QQuickItemPrivate::get(item)->anchors();
         styleAnchors->setFill(q);
-    } else {
-        delete object;
     }
-    component->completeCreate();
-    // delete temporary component
-    if (!styleComponent) {
-        delete component;
+}
+
+// starts incubating the style, returns false if the engine cannot incubate asynchronously
+bool UCStyledItemBasePrivate::startStyleIncubation(QQmlComponent *component,
+                                                   QQmlContext *creationContext,
+                                                   const QString &key)
+{
+    Q_Q(UCStyledItemBase);
+    QQmlEngine *engine = qmlEngine(q);
+    if (!engine || !engine->incubationController()) {
+        return false;
+    }
+    // the context is owned by the item until the style object is created
+    styleItemContext = new QQmlContext(creationContext);
+    QQml_setParent_noEvent(styleItemContext, q);
+    styleItemContext->setContextObject(q);
+    styleItemContext->setContextProperty(QStringLiteral("styledItem"), q);
+    styleItemContext->setContextProperty(QStringLiteral("animated"), false);
+    styleIncubator = new UCStyleIncubator(this, key);
+    component->create(*styleIncubator, styleItemContext);
+    return true;
+}
+
+// takes the incubated style, completing the incubation if needed
+bool UCStyledItemBasePrivate::completeStyleIncubation()
+{
+    Q_Q(UCStyledItemBase);
+    QElapsedTimer timer;
+    timer.start();
+    UCStyleIncubator *incubator = styleIncubator;
+    styleIncubator = Q_NULLPTR;
+    if (incubator->isLoading()) {
+        incubator->forceCompletion();
+    }
+    if (incubator->isError()) {
+        Q_FOREACH(const QQmlError &error, incubator->errors()) {
+            qWarning().noquote() << error.toString().trimmed();
+        }
+    }
+    // ready objects are not deleted with the incubator
+    QObject *object = incubator->isReady() ? incubator->object() : Q_NULLPTR;
+    const QString key = incubator->key();
+    delete incubator;
+    if (!object) {
+        if (styleItemContext && styleItemContext->parent() == q) {
+            delete styleItemContext.data();
+        }
+        return false;
+    }
+    styleItem = qobject_cast<::QQuickItem*>(object);
+    if (!styleItem) {
+        delete object;
     }
+    countStyleCreation(key, timer.nsecsElapsed(), true);
+
+    finishStyleItem(false);
+    return true;
+}
 
+void UCStyledItemBasePrivate::finishStyleItem(bool animated)
+{
     // make sure we reset the animated property to true
-    if (!animated) {
+    if (!animated && styleItemContext) {
         styleItemContext->setContextProperty(QStringLiteral("animated"), true);
     }
 
     // set implicit size
     _q_styleResized();
     connectStyleSizeChanges(true);
-    Q_EMIT q->styleInstanceChanged();
-    return true;
+    Q_EMIT q_func()->styleInstanceChanged();
+}
+
+QHash<QString, UCStyleCreationCounter> UCStyledItemBasePrivate::styleCreationCounters()
+{
+    return styleCounters();
+}
+
+void UCStyledItemBasePrivate::resetStyleCreationCounters()
+{
+    styleCounters().clear();
 }
 
 /*!
@@ -506,7 +814,8 @@ void UCStyledItemBasePrivate::_q_styleResized()
 void UCStyledItemBase::preThemeChanged()
 {
     Q_D(UCStyledItemBase);
-    d->wasStyleLoaded = (d->styleItem != Q_NULLPTR);
+    d->wasStyleDeferred = d->isStyleDeferred();
+    d->wasStyleLoaded = (d->styleItem != Q_NULLPTR) || d->wasStyleDeferred;
     d->preStyleChanged();
 }
 void UCStyledItemBase::postThemeChanged()
@@ -517,7 +826,10 @@ void UCStyledItemBase::postThemeChanged()
         return;
     }
     d->postStyleChanged();
-    d->loadStyleItem();
+    // a deferred style stays deferred with the new theme
+    d->deferStyleLoading = d->wasStyleDeferred;
+    d->loadStyleItem(!d->wasStyleDeferred);
+    d->deferStyleLoading = false;
 }
 
 QString UCStyledItemBasePrivate::propertyForVersion(quint16 version) const
@@ -538,7 +850,9 @@ void UCStyledItemBasePrivate::completeComponentInitialization()
     // no animation at this time
     // prepare style context if not been done yet
     postStyleChanged();
+    deferStyleLoading = (styleLoadingMode != UCStyledItemBase::Immediate);
     loadStyleItem(false);
+    deferStyleLoading = false;
 }
 
 void UCStyledItemBase::classBegin()
@@ -572,6 +886,8 @@ void UCStyledItemBase::itemChange(ItemChange change, const ItemChangeData &data)
     if (change == ItemParentHasChanged) {
         // update parentItem
         d_func()->oldParentItem = data.item;
+    } else if (change == ItemSceneChange && d_func()->waitsForVisibility) {
+        d_func()->watchVisibility();
     } else if (change == ItemActiveFocusHasChanged) {
         // Children may retain focus as if it was the StyledItem itself
         if (!hasActiveFocus())
@@ -49,8 +49,17 @@ class UBUNTUTOOLKIT_EXPORT UCStyledItemBase : public QQuickItem, public UCThemin
     Q_PRIVATE_PROPERTY(UCStyledItemBase::d_func(), QQuickItem *__styleInstance READ styleInstance NOTIFY styleInstanceChanged FINAL DESIGNABLE false)
     Q_PRIVATE_PROPERTY(UCStyledItemBase::d_func(), QString styleName READ styleName WRITE setStyleName NOTIFY styleNameChanged FINAL REVISION 2)
     Q_PROPERTY(UT_PREPEND_NAMESPACE(UCTheme) *theme READ getTheme WRITE setTheme RESET resetTheme NOTIFY themeChanged FINAL REVISION 2)
+    Q_PRIVATE_PROPERTY(UCStyledItemBase::d_func(), StyleLoading styleLoading READ styleLoading WRITE setStyleLoading NOTIFY styleLoadingChanged FINAL REVISION 2)
+    Q_ENUMS(StyleLoading)
 public:
+    enum StyleLoading {
+        Immediate,
+        WhenVisible,
+        Asynchronous
+    };
+
     explicit UCStyledItemBase(QQuickItem *parent = 0);
+    ~UCStyledItemBase();
 
     virtual bool keyNavigationFocus() const;
     bool activefocusOnPress() const;
@@ -69,6 +78,7 @@ Q_SIGNALS:
     Q_REVISION(1) void activeFocusOnTabChanged2();
     Q_REVISION(2) void themeChanged();
     Q_REVISION(2) void styleNameChanged();
+    Q_REVISION(2) void styleLoadingChanged();
 
 protected:
     UCStyledItemBase(UCStyledItemBasePrivate &, QQuickItem *parent);
@@ -88,6 +98,7 @@ protected:
 private:
     Q_DECLARE_PRIVATE(UCStyledItemBase)
     Q_PRIVATE_SLOT(d_func(), void _q_styleResized())
+    Q_PRIVATE_SLOT(d_func(), void _q_loadDeferredStyle())
 };
 
 UT_NAMESPACE_END
@@ -21,6 +21,7 @@
 
 #include <UbuntuToolkit/private/ucstyleditembase_p.h>
 
+#include <QtCore/QHash>
 #include <QtQuick/private/qquickitem_p.h>
 
 #include <UbuntuToolkit/private/ucthemingextension_p.h>
@@ -30,6 +31,17 @@ class QQuickMouseArea;
 
 UT_NAMESPACE_BEGIN
 
+// Number of style instances created from a style and the time spent creating them, in
+// nanoseconds. The time of asynchronous creations only covers their completion.
+struct UCStyleCreationCounter
+{
+    int count;
+    int asynchronousCount;
+    qint64 totalTime;
+    qint64 maximumTime;
+};
+
+class UCStyleIncubator;
 class UCStyledItemBase;
 class UBUNTUTOOLKIT_EXPORT UCStyledItemBasePrivate : public QQuickItemPrivate, public UCImportVersionChecker
 {
@@ -42,6 +54,7 @@ public:
     }
 
     void _q_styleResized();
+    void _q_loadDeferredStyle();
 
     UCStyledItemBasePrivate();
     virtual ~UCStyledItemBasePrivate();
@@ -58,6 +71,13 @@ public:
     QString styleName() const;
     void setStyleName(const QString &name);
 
+    UCStyledItemBase::StyleLoading styleLoading() const;
+    void setStyleLoading(UCStyledItemBase::StyleLoading loading);
+    bool isStyleDeferred() const;
+    void cancelDeferredStyle();
+    bool isOnScreen() const;
+    void watchVisibility();
+
     virtual void preStyleChanged();
     virtual void postStyleChanged() {}
     virtual bool loadStyleItem(bool animated = true);
@@ -66,6 +86,10 @@ public:
     // from UCImportVersionChecker
     QString propertyForVersion(quint16 version) const override;
 
+    // Style creation counters by style document or component URL, GUI thread only.
+    static QHash<QString, UCStyleCreationCounter> styleCreationCounters();
+    static void resetStyleCreationCounters();
+
 public:
 
     QPointer<QQmlContext> styleItemContext;
@@ -73,15 +97,28 @@ public:
     QQuickItem *oldParentItem;
     QQmlComponent *styleComponent;
     QQuickItem *styleItem;
+    UCStyleIncubator *styleIncubator;
+    QMetaObject::Connection visibilityConnection;
     quint16 styleVersion;
+    quint8 styleLoadingMode:2;
     bool keyNavigationFocus:1;
     bool activeFocusOnPress:1;
     bool wasStyleLoaded:1;
     bool isFocusScope:1;
+    bool deferStyleLoading:1;
+    bool waitsForVisibility:1;
+    bool wasStyleDeferred:1;
 
 protected:
 
     void connectStyleSizeChanges(bool attach);
+    void setupStyleObject(QObject *object);
+    bool startStyleIncubation(QQmlComponent *component, QQmlContext *creationContext,
+                              const QString &key);
+    bool completeStyleIncubation();
+    void finishStyleItem(bool animated);
+
+    friend class UCStyleIncubator;
 };
 
 UT_NAMESPACE_END
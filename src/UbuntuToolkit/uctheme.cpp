@@ -419,6 +419,60 @@ UCTheme *UCTheme::defaultTheme(QQmlEngine *engine)
     return theme;
 }
 
+// the style cache is shared by all themes of an engine, and is held by the
+// default theme of the engine
+UCTheme::StyleCache *UCTheme::styleCache(QQmlEngine *engine)
+{
+    UCTheme *theme = defaultTheme(engine);
+    return theme ? &theme->m_styleCache : Q_NULLPTR;
+}
+
+UCTheme::StyleCacheStatistics UCTheme::styleCacheStatistics(QQmlEngine *engine)
+{
+    StyleCache *cache = styleCache(engine);
+    return cache ? cache->statistics : StyleCacheStatistics();
+}
+
+void UCTheme::clearStyleCache(QQmlEngine *engine)
+{
+    StyleCache *cache = styleCache(engine);
+    if (cache) {
+        cache->clear();
+        cache->statistics = StyleCacheStatistics();
+    }
+}
+
+// drops the resolved URLs and compiled components of the given theme
+void UCTheme::StyleCache::invalidate(const QString &themeName)
+{
+    for (QHash<Key, UrlEntry>::iterator i = urls.begin(); i != urls.end();) {
+        if (i.key().theme == themeName) {
+            i = urls.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    for (QHash<Key, ComponentEntry>::iterator i = components.begin(); i != components.end();) {
+        if (i.key().theme == themeName) {
+            // components are owned by the default theme, delay deletion
+            // in case one is still in use
+            i.value().component->deleteLater();
+            i = components.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void UCTheme::StyleCache::clear()
+{
+    Q_FOREACH(const ComponentEntry &entry, components) {
+        entry.component->deleteLater();
+    }
+    components.clear();
+    urls.clear();
+}
+
 void UCTheme::setupDefault()
 {
     // FIXME: move this into QPA
@@ -474,6 +528,14 @@ void UCTheme::updateThemePaths()
     m_themePaths.clear();
 
     QString themeName = name();
+    // theme paths may have changed, drop the cached styles of the theme
+    QQmlEngine *engine = qmlEngine(this);
+    if (engine) {
+        StyleCache *cache = styleCache(engine);
+        if (cache) {
+            cache->invalidate(themeName);
+        }
+    }
     while (!themeName.isEmpty()) {
         ThemeRecord themePath = pathFromThemeName(themeName);
         if (themePath.isValid()) {
@@ -685,6 +747,35 @@ QUrl UCTheme::styleUrl(const QString& styleName, quint16 version, bool *isFallba
     return QUrl();
 }
 
+// returns the style URL from the engine's style cache, resolving it on cache miss
+QUrl UCTheme::cachedStyleUrl(QQmlEngine *engine, const QString& styleName, quint16 version, bool *isFallback)
+{
+    StyleCache *cache = styleCache(engine);
+    if (!cache) {
+        return styleUrl(styleName, version, isFallback);
+    }
+
+    const StyleCache::Key key(name(), styleName, version);
+    QHash<StyleCache::Key, StyleCache::UrlEntry>::const_iterator i = cache->urls.constFind(key);
+    if (i != cache->urls.constEnd()) {
+        cache->statistics.urlHits++;
+        if (isFallback) {
+            (*isFallback) = i->fallback;
+        }
+        return i->url;
+    }
+
+    cache->statistics.urlMisses++;
+    bool fallback = false;
+    QUrl url = styleUrl(styleName, version, &fallback);
+    // cache unresolved styles as well so we don't stat them again
+    cache->urls.insert(key, StyleCache::UrlEntry(url, fallback));
+    if (isFallback) {
+        (*isFallback) = fallback;
+    }
+    return url;
+}
+
 // registers the default theme property to the root context
 void UCTheme::createDefaultTheme(QQmlEngine* engine)
 {
@@ -742,6 +833,23 @@ void UCTheme::checkMixedVersionImports(QQuickItem *item, quint16 version)
     previousVersion = version;
 }
 
+// resolves the style URL through the engine's style cache and warns about
+// missing styles and version fallbacks
+QUrl UCTheme::resolveStyleUrl(QQmlEngine *engine, const QString& styleName, QObject *parent, quint16 version)
+{
+    bool fallback = false;
+    QUrl url = cachedStyleUrl(engine, styleName, version, &fallback);
+    if (!url.isValid()) {
+        qmlWarning(parent) <<
+           QStringLiteral("Warning: Style %1 not found in theme %2").arg(styleName).arg(name());
+    } else if (fallback) {
+        qmlWarning(parent) << QStringLiteral("Theme '%1' has no '%2' style for version %3.%4, fall back to version %5.%6.")
+                           .arg(name()).arg(styleName).arg(MAJOR_VERSION(version)).arg(MINOR_VERSION(version))
+                           .arg(MAJOR_VERSION(LATEST_UITK_VERSION)).arg(MINOR_VERSION(LATEST_UITK_VERSION));
+    }
+    return url;
+}
+
 /*
  * Returns an instance of the style component named \a styleName and parented
  * to \a parent.
@@ -759,14 +867,8 @@ QQmlComponent* UCTheme::createStyleComponent(const QString& styleName, QObject*
             return Q_NULLPTR;
         }
         // make sure we have the paths
-        bool fallback = false;
-        QUrl url = styleUrl(styleName, version, &fallback);
+        QUrl url = resolveStyleUrl(engine, styleName, parent, version);
         if (url.isValid()) {
-            if (fallback) {
-                qmlWarning(parent) << QStringLiteral("Theme '%1' has no '%2' style for version %3.%4, fall back to version %5.%6.")
-                                   .arg(name()).arg(styleName).arg(MAJOR_VERSION(version)).arg(MINOR_VERSION(version))
-                                   .arg(MAJOR_VERSION(LATEST_UITK_VERSION)).arg(MINOR_VERSION(LATEST_UITK_VERSION));
-            }
             component = new QQmlComponent(engine, url, QQmlComponent::PreferSynchronous, parent);
             if (component->isError()) {
                 qmlWarning(parent) << component->errorString();
@@ -776,15 +878,76 @@ QQmlComponent* UCTheme::createStyleComponent(const QString& styleName, QObject*
                 // set context for the component
                 QQmlEngine::setContextForObject(component, qmlContext(parent));
             }
-        } else {
-            qmlWarning(parent) <<
-               QStringLiteral("Warning: Style %1 not found in theme %2").arg(styleName).arg(name());
         }
     }
 
     return component;
 }
 
+/*
+ * Returns the compiled style component named \a styleName from the engine's
+ * style cache, compiling it on first use. The component is owned by the cache
+ * and must not be deleted by the caller. As the component is shared between
+ * all the styled items using the same theme, its creation context is not the
+ * one of \a parent, callers must provide the context to create the style in.
+ */
+QQmlComponent* UCTheme::cachedStyleComponent(const QString& styleName, QObject* parent, quint16 version)
+{
+    Q_ASSERT(version);
+    QQmlEngine* engine = parent ? qmlEngine(parent) : Q_NULLPTR;
+    UCTheme *owner = engine ? defaultTheme(engine) : Q_NULLPTR;
+    if (!owner) {
+        // we may be in the phase when the qml context is not yet defined for the parent
+        return Q_NULLPTR;
+    }
+
+    StyleCache &cache = owner->m_styleCache;
+    const StyleCache::Key key(name(), styleName, version);
+    QQmlComponent *component = cache.components.value(key).component;
+    if (component) {
+        cache.statistics.componentHits++;
+        return component;
+    }
+    cache.statistics.componentMisses++;
+
+    QUrl url = resolveStyleUrl(engine, styleName, parent, version);
+    if (!url.isValid()) {
+        return Q_NULLPTR;
+    }
+    component = new QQmlComponent(engine, url, QQmlComponent::PreferSynchronous, owner);
+    if (component->isError()) {
+        qmlWarning(parent) << component->errorString();
+        delete component;
+        return Q_NULLPTR;
+    }
+    cache.components.insert(key, StyleCache::ComponentEntry(component));
+    return component;
+}
+
+/*
+ * Returns the number of styles being created from the cached style component
+ * named \a styleName after adjusting it by \a delta. Styled items count their
+ * creation from beginCreate() to completeCreate(), so a style created while the
+ * shared component is still creating another one can use a component of its own.
+ */
+int UCTheme::cachedStyleCreations(const QString& styleName, QObject* parent, quint16 version,
+                                  int delta)
+{
+    QQmlEngine* engine = parent ? qmlEngine(parent) : Q_NULLPTR;
+    StyleCache *cache = engine ? styleCache(engine) : Q_NULLPTR;
+    if (!cache) {
+        return 0;
+    }
+    QHash<StyleCache::Key, StyleCache::ComponentEntry>::iterator i =
+        cache->components.find(StyleCache::Key(name(), styleName, version));
+    if (i == cache->components.end()) {
+        // the entry may have been invalidated during the creation
+        return 0;
+    }
+    i->creations = qMax(0, i->creations + delta);
+    return i->creations;
+}
+
 void UCTheme::loadPalette(QQmlEngine *engine, bool notify)
 {
     if (!engine) {
@@ -20,6 +20,7 @@
 #ifndef UCTHEME_P_H
 #define UCTHEME_P_H
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 #include <QtCore/QString>
@@ -71,8 +72,21 @@ public:
         bool deprecated:1;
     };
 
+    // style lookup cache statistics, per engine
+    struct StyleCacheStatistics {
+        StyleCacheStatistics() :
+            urlHits(0), urlMisses(0), componentHits(0), componentMisses(0)
+        {}
+        quint32 urlHits;
+        quint32 urlMisses;
+        quint32 componentHits;
+        quint32 componentMisses;
+    };
+
     explicit UCTheme(QObject *parent = 0);
     static UCTheme *defaultTheme(QQmlEngine *engine);
+    static StyleCacheStatistics styleCacheStatistics(QQmlEngine *engine);
+    static void clearStyleCache(QQmlEngine *engine);
 
     // getter/setters
     UCTheme *parentTheme();
@@ -86,6 +100,11 @@ public:
 
     // internal, used by the deprecated Theme.createStyledComponent()
     QQmlComponent* createStyleComponent(const QString& styleName, QObject* parent, quint16 version = 0);
+    // internal, the returned component is owned by the engine's style cache
+    QQmlComponent* cachedStyleComponent(const QString& styleName, QObject* parent, quint16 version);
+    // internal, the number of styles being created from a cached style component, adjusted by delta
+    int cachedStyleCreations(const QString& styleName, QObject* parent, quint16 version,
+                             int delta = 0);
     void attachItem(QQuickItem *item, bool attach);
 
     // helper functions
@@ -115,6 +134,8 @@ private:
     void updateEnginePaths(QQmlEngine *engine);
     void updateThemePaths();
     QUrl styleUrl(const QString& styleName, quint16 version, bool *isFallback = NULL);
+    QUrl cachedStyleUrl(QQmlEngine *engine, const QString& styleName, quint16 version, bool *isFallback = NULL);
+    QUrl resolveStyleUrl(QQmlEngine *engine, const QString& styleName, QObject *parent, quint16 version);
     void loadPalette(QQmlEngine *engine, bool notify = true);
     void updateThemedItems();
 
@@ -167,6 +188,55 @@ private:
         QList<Data> configList;
     };
 
+    // resolved style URLs and compiled style components, keyed by theme name,
+    // style document and version; lives in the engine's default theme
+    class StyleCache
+    {
+    public:
+        struct Key {
+            Key(const QString &theme, const QString &style, quint16 version)
+                : theme(theme), style(style), version(version)
+            {}
+            bool operator==(const Key &other) const
+            {
+                return version == other.version && style == other.style && theme == other.theme;
+            }
+            friend inline uint qHash(const Key &key, uint seed = 0)
+            {
+                return qHash(key.theme, seed) ^ qHash(key.style, seed) ^ key.version;
+            }
+
+            QString theme;
+            QString style;
+            quint16 version;
+        };
+        struct UrlEntry {
+            UrlEntry() : fallback(false) {}
+            UrlEntry(const QUrl &url, bool fallback) : url(url), fallback(fallback) {}
+            QUrl url;
+            bool fallback;
+        };
+
+        struct ComponentEntry {
+            ComponentEntry() : component(Q_NULLPTR), creations(0) {}
+            explicit ComponentEntry(QQmlComponent *component)
+                : component(component), creations(0)
+            {}
+            QQmlComponent *component;
+            // styles being created from the component, a re-entrant creation needs its own
+            int creations;
+        };
+
+        void invalidate(const QString &themeName);
+        void clear();
+
+        QHash<Key, UrlEntry> urls;
+        QHash<Key, ComponentEntry> components;
+        StyleCacheStatistics statistics;
+    };
+    static StyleCache *styleCache(QQmlEngine *engine);
+
+    StyleCache m_styleCache;
     PaletteConfig m_config;
     QString m_name;
     QPointer<UCTheme> m_parentTheme;
@@ -29,9 +29,18 @@
 
 #include <math.h>
 
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
 #include <QtCore/QPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QtMath>
 #include <QtGui/QGuiApplication>
+#include <QtGui/QPainter>
 #include <QtQml/QQmlInfo>
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGImageNode>
+#include <QtQuick/QSGRendererInterface>
 #include <QtQuick/private/qsgadaptationlayer_p.h>
 // This private header uses the emit keyword while we build with QT_NO_KEYWORDS set. See #1507910.
 #define emit Q_EMIT
@@ -100,7 +109,8 @@ void ShapeShader::updateState(
     const ShapeMaterial::Data* data = material->constData();
 
     // Bind shape texture.
-    glBindTexture(GL_TEXTURE_2D, material->textureIds()[data->shapeTextureIndex]);
+    glBindTexture(GL_TEXTURE_2D, material->shapeTextures()->textureId(
+        data->shapeTextureIndex, data->shapeTextureBucket));
 
     // Bind source texture on the 2nd texture unit and update uniforms.
     bool textured = false;
@@ -156,95 +166,209 @@ void ShapeShader::updateState(
     }
 }
 
+ShapeBatchedShader::ShapeBatchedShader()
+{
+    setShaderSourceFile(QOpenGLShader::Vertex, QStringLiteral(":/uc/shaders/shape_batched.vert"));
+    setShaderSourceFile(
+        QOpenGLShader::Fragment,
+        UCUbuntuShape::useDistanceFields(QOpenGLContext::currentContext()) ?
+        QStringLiteral(":/uc/shaders/shape_batched.frag") :
+        QStringLiteral(":/uc/shaders/shape_batched_mipmap.frag"));
+}
+
+char const* const* ShapeBatchedShader::attributeNames() const
+{
+    // Source coordinates aren't used by untextured shapes, an empty name prevents the binding.
+    static char const* const attributes[] = {
+        "positionAttrib", "shapeCoordAttrib", "", "yCoordAttrib", "backgroundColorAttrib",
+        "shapeParamsAttrib", 0
+    };
+    return attributes;
+}
+
+void ShapeBatchedShader::initialize()
+{
+    QSGMaterialShader::initialize();
+
+    program()->bind();
+    program()->setUniformValue("shapeTexture", 0);
+    program()->setUniformValue("dropShadowShapeTexture", 1);
+    // Anti-aliasing distance in distance field space divided by 2 for the shader, the per-vertex
+    // distanceAAFactor is dequantized by the normalized attribute fetch.
+    program()->setUniformValue(
+        "distanceAA", (shapeTextureDistanceAA * distanceAApx) / 2.0f);
+
+    m_functions = QOpenGLContext::currentContext()->functions();
+    m_matrixId = program()->uniformLocation("matrix");
+    m_opacityId = program()->uniformLocation("opacity");
+}
+
+void ShapeBatchedShader::updateState(
+    const RenderState& state, QSGMaterial* newEffect, QSGMaterial* oldEffect)
+{
+    Q_UNUSED(oldEffect);
+
+    // Both shape textures are bound, the one to be sampled is selected per vertex. Shapes upload
+    // the texture they use in updateMaterial(), a missing one is never selected.
+    ShapeMaterial* material = static_cast<ShapeMaterial*>(newEffect);
+    ShapeTextures* textures = material->shapeTextures();
+    const int bucket = material->constData()->shapeTextureBucket;
+    m_functions->glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, textures->uploadedTextureId(1, bucket));
+    m_functions->glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textures->uploadedTextureId(0, bucket));
+
+    // Update QtQuick engine uniforms.
+    if (state.isOpacityDirty()) {
+        program()->setUniformValue(m_opacityId, state.opacity());
+    }
+    if (state.isMatrixDirty()) {
+        program()->setUniformValue(m_matrixId, state.combinedMatrix());
+    }
+}
+
 // --- Scene graph material ---
 
-// Create and setup shape textures.
-static void createShapeTextures(QOpenGLContext* openglContext, quint32* ids)
+// Create and setup a distance field shape texture generated at runtime.
+static void createGeneratedShapeTexture(const QByteArray& data, int size, quint32* id)
+{
+    glGenTextures(1, id);
+    glBindTexture(GL_TEXTURE_2D, *id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 data.constData());
+}
+
+// Create and setup a shape texture.
+static void createShapeTexture(QOpenGLContext* openglContext, int index, quint32* id)
 {
-    glGenTextures(shapeTextureCount, ids);
+    glGenTextures(1, id);
+    glBindTexture(GL_TEXTURE_2D, *id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     if (UCUbuntuShape::useDistanceFields(openglContext)) {
-        // Create distance field textures.
-        for (int i = 0; i < shapeTextureCount; i++) {
-            glBindTexture(GL_TEXTURE_2D, ids[i]);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, shapeTextureWidth, shapeTextureHeight, 0,
-                         GL_RGBA, GL_UNSIGNED_BYTE, shapeTextureData[i]);
-        }
+        // Create distance field texture.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, shapeTextureWidth, shapeTextureHeight, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, shapeTextureData[index]);
     } else {
-        // Create mipmap textures.
-        for (int i = 0; i < shapeTextureCount; i++) {
-            glBindTexture(GL_TEXTURE_2D, ids[i]);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            for (int j = 0; j < shapeTextureMipmapCount; j++) {
-                glTexImage2D(GL_TEXTURE_2D, j, GL_RGBA, shapeTextureMipmapWidth >> j,
-                             shapeTextureMipmapHeight >> j, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                             &shapeTextureMipmapData[i][shapeTextureMipmapOffset[j]]);
+        // Create mipmap texture.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        for (int j = 0; j < shapeTextureMipmapCount; j++) {
+            glTexImage2D(GL_TEXTURE_2D, j, GL_RGBA, shapeTextureMipmapWidth >> j,
+                         shapeTextureMipmapHeight >> j, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                         &shapeTextureMipmapData[index][shapeTextureMipmapOffset[j]]);
+        }
+    }
+}
+
+static QHash<QOpenGLContext*, ShapeTextures*> shapeTexturesHash;
+static QMutex shapeTexturesHashMutex;
+
+ShapeTextures::ShapeTextures(QOpenGLContext* openglContext)
+    : m_openglContext(openglContext)
+    , m_refCount(0)
+    , m_useDistanceFields(UCUbuntuShape::useDistanceFields(openglContext))
+{
+    memset(m_ids, 0x00, sizeof(m_ids));
+}
+
+ShapeTextures::~ShapeTextures()
+{
+    for (int i = 0; i < ShapeTextureCache::bucketCount; i++) {
+        for (int j = 0; j < shapeTextureCount; j++) {
+            if (m_ids[i][j]) {
+                glDeleteTextures(1, &m_ids[i][j]);
             }
         }
     }
 }
 
-class ShapeTextures {
-public:
-    ShapeTextures() : m_refCount(0) {}
-    quint32* ids() { return m_ids; }
-    quint32 ref() { Q_ASSERT(m_refCount < UINT_MAX); return ++m_refCount; }
-    quint32 unref() { Q_ASSERT(m_refCount > 0); return --m_refCount; }
-private:
-    quint32 m_refCount;
-    quint32 m_ids[shapeTextureCount];
-};
+// static
+ShapeTextures* ShapeTextures::ref(QOpenGLContext* openglContext)
+{
+    QMutexLocker locker(&shapeTexturesHashMutex);
+    ShapeTextures*& textures = shapeTexturesHash[openglContext];
+    if (!textures) {
+        textures = new ShapeTextures(openglContext);
+    }
+    Q_ASSERT(textures->m_refCount < UINT_MAX);
+    textures->m_refCount++;
+    return textures;
+}
 
-static QHash<QOpenGLContext*, ShapeTextures> shapeTexturesHash;
-static QMutex shapeTexturesHashMutex;
+void ShapeTextures::unref()
+{
+    // The textures are evicted along with the last material using them, that's the case when the
+    // scene graph is invalidated since all the nodes get deleted.
+    QMutexLocker locker(&shapeTexturesHashMutex);
+    Q_ASSERT(m_refCount > 0);
+    if (--m_refCount == 0) {
+        shapeTexturesHash.remove(m_openglContext);
+        delete this;
+    }
+}
+
+quint32 ShapeTextures::textureId(int index, int bucket)
+{
+    // Textures are only accessed from the render thread of their context, no locking needed.
+    Q_ASSERT(index >= 0 && index < shapeTextureCount);
+    Q_ASSERT(bucket >= 0 && bucket < ShapeTextureCache::bucketCount);
+    Q_ASSERT(QOpenGLContext::currentContext() == m_openglContext);
+    if (!m_ids[bucket][index]) {
+        if (bucket > 0) {
+            const QByteArray data = ShapeTextureCache::instance()->textureData(index, bucket);
+            if (data.isEmpty()) {
+                return textureId(index, 0);
+            }
+            createGeneratedShapeTexture(
+                data, ShapeTextureCache::bucketSize(bucket), &m_ids[bucket][index]);
+        } else {
+            createShapeTexture(m_openglContext, index, &m_ids[0][index]);
+        }
+    }
+    return m_ids[bucket][index];
+}
 
 ShapeMaterial::ShapeMaterial()
 {
     // The whole struct (with the padding bytes) must be initialized for memcmp() to work as
     // expected in ShapeMaterial::compare().
     memset(&m_data, 0x00, sizeof(Data));
+    m_shapeParams = 0;
     setFlag(Blending);
 
     // Get or create the set of textures associated with the current context. We assume that QtQuick
-    // associates the same graphics context to a material for its entire lifetime.
-    QOpenGLContext* context = QOpenGLContext::currentContext();
-    shapeTexturesHashMutex.lock();
-    ShapeTextures& textures = shapeTexturesHash[context];
-    if (textures.ref() == 1) {
-        createShapeTextures(context, textures.ids());
-    }
-    memcpy(m_shapeTexturesId, textures.ids(), shapeTextureCount * sizeof(quint32));
-    shapeTexturesHashMutex.unlock();
+    // associates the same graphics context to a material for its entire lifetime. Textures are
+    // only uploaded when first needed, see ShapeTextures::textureId().
+    m_shapeTextures = ShapeTextures::ref(QOpenGLContext::currentContext());
 }
 
 ShapeMaterial::~ShapeMaterial()
 {
-    shapeTexturesHashMutex.lock();
-    auto it = shapeTexturesHash.find(QOpenGLContext::currentContext());
-    Q_ASSERT(it != shapeTexturesHash.end());
-    if (it.value().unref() == 0) {
-        glDeleteTextures(shapeTextureCount, it.value().ids());
-        shapeTexturesHash.erase(it);
-    }
-    shapeTexturesHashMutex.unlock();
+    m_shapeTextures->unref();
 }
 
 QSGMaterialType* ShapeMaterial::type() const
 {
     static QSGMaterialType type;
-    return &type;
+    static QSGMaterialType batchedType;
+    return !(m_data.flags & ShapeMaterial::Data::Batched) ? &type : &batchedType;
 }
 
 QSGMaterialShader* ShapeMaterial::createShader() const
 {
-    return new ShapeShader;
+    if (m_data.flags & ShapeMaterial::Data::Batched) {
+        return new ShapeBatchedShader;
+    } else {
+        return new ShapeShader;
+    }
 }
 
 int ShapeMaterial::compare(const QSGMaterial* other) const
@@ -310,10 +434,11 @@ const QSGGeometry::AttributeSet& ShapeNode::attributeSet()
         QSGGeometry::Attribute::create(1, 2, GL_FLOAT),
         QSGGeometry::Attribute::create(2, 4, GL_FLOAT),
         QSGGeometry::Attribute::create(3, 1, GL_FLOAT),
-        QSGGeometry::Attribute::create(4, 4, GL_UNSIGNED_BYTE)
+        QSGGeometry::Attribute::create(4, 4, GL_UNSIGNED_BYTE),
+        QSGGeometry::Attribute::create(5, 4, GL_UNSIGNED_BYTE)
     };
     static const QSGGeometry::AttributeSet attributeSet = {
-        5, sizeof(Vertex), attributes
+        6, sizeof(Vertex), attributes
     };
     return attributeSet;
 }
@@ -382,6 +507,8 @@ UCUbuntuShape::UCUbuntuShape(QQuickItem* parent)
     setFlag(ItemHasContents);
     QObject::connect(UCUnits::instance(), SIGNAL(gridUnitChanged()), this,
                      SLOT(_q_gridUnitChanged()));
+    // Shapes relying on a runtime generated texture are using the baked one until it's ready.
+    QObject::connect(ShapeTextureCache::instance(), SIGNAL(textureReady()), this, SLOT(update()));
     _q_gridUnitChanged();
 }
 
@@ -1190,9 +1317,6 @@ QSGNode* UCUbuntuShape::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* d
         return NULL;
     }
 
-    QSGNode* node = oldNode ? oldNode : createSceneGraphNode();
-    Q_ASSERT(node);
-
     // Get the source texture info and update the source transform if needed.
     QSGTextureProvider* provider = m_source ? m_source->textureProvider() : NULL;
     QSGTexture* sourceTexture = provider ? provider->texture() : NULL;
@@ -1251,25 +1375,7 @@ QSGNode* UCUbuntuShape::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* d
                      / qGuiApp->devicePixelRatio();
     }
 
-    updateMaterial(node, radius, m_aspect != DropShadow ? 0 : 1, sourceTexture && m_sourceOpacity);
-
-    // Get the affine transformation for the source texture coordinates.
-    const QVector4D sourceCoordTransform(
-        m_sourceTransform.x() * sourceTextureRect.width(),
-        m_sourceTransform.y() * sourceTextureRect.height(),
-        m_sourceTransform.z() * sourceTextureRect.width() + sourceTextureRect.x(),
-        m_sourceTransform.w() * sourceTextureRect.height() + sourceTextureRect.y());
-
-    // Get the affine transformation for the source mask coordinates, pixels lying inside the mask
-    // (values in the range [-1, 1]) will be textured in the fragment shader. In case of a repeat
-    // wrap mode, the transformation is made so that the mask takes the whole area.
-    const QVector4D sourceMaskTransform(
-        m_sourceHorizontalWrapMode == Transparent ? m_sourceTransform.x() * 2.0f : 2.0f,
-        m_sourceVerticalWrapMode == Transparent ? m_sourceTransform.y() * 2.0f : 2.0f,
-        m_sourceHorizontalWrapMode == Transparent ? m_sourceTransform.z() * 2.0f - 1.0f : -1.0f,
-        m_sourceVerticalWrapMode == Transparent ? m_sourceTransform.w() * 2.0f - 1.0f : -1.0f);
-
-    // Select and pack the lerped and premultiplied background colors.
+    // Select the lerped background colors.
     QRgb color[2];
     if (m_flags & BackgroundApiSet) {
         color[0] = m_backgroundColor;
@@ -1288,6 +1394,33 @@ QSGNode* UCUbuntuShape::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* d
             color[1] = qRgba(0, 0, 0, 0);
         }
     }
+
+    if (window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software) {
+        return updateSoftwareNode(oldNode, itemSize, radius, sourceTexture, color);
+    }
+
+    QSGNode* node = oldNode ? oldNode : createSceneGraphNode();
+    Q_ASSERT(node);
+
+    updateMaterial(node, radius, m_aspect != DropShadow ? 0 : 1, sourceTexture && m_sourceOpacity);
+
+    // Get the affine transformation for the source texture coordinates.
+    const QVector4D sourceCoordTransform(
+        m_sourceTransform.x() * sourceTextureRect.width(),
+        m_sourceTransform.y() * sourceTextureRect.height(),
+        m_sourceTransform.z() * sourceTextureRect.width() + sourceTextureRect.x(),
+        m_sourceTransform.w() * sourceTextureRect.height() + sourceTextureRect.y());
+
+    // Get the affine transformation for the source mask coordinates, pixels lying inside the mask
+    // (values in the range [-1, 1]) will be textured in the fragment shader. In case of a repeat
+    // wrap mode, the transformation is made so that the mask takes the whole area.
+    const QVector4D sourceMaskTransform(
+        m_sourceHorizontalWrapMode == Transparent ? m_sourceTransform.x() * 2.0f : 2.0f,
+        m_sourceVerticalWrapMode == Transparent ? m_sourceTransform.y() * 2.0f : 2.0f,
+        m_sourceHorizontalWrapMode == Transparent ? m_sourceTransform.z() * 2.0f - 1.0f : -1.0f,
+        m_sourceVerticalWrapMode == Transparent ? m_sourceTransform.w() * 2.0f - 1.0f : -1.0f);
+
+    // Pack the lerped and premultiplied background colors.
     const quint32 backgroundColor[3] = {
         packColor(qAlpha(color[0]), qBlue(color[0]), qGreen(color[0]), qRed(color[0])),
         averageColor(color[0], color[1]),
@@ -1306,52 +1439,97 @@ QSGNode* UCUbuntuShape::createSceneGraphNode() const
     return new ShapeNode;
 }
 
-void UCUbuntuShape::updateMaterial(
-    QSGNode* node, float radius, quint8 shapeTextureIndex, bool textured)
+// Mapping of radius size range from [0, 4] to [0, 1] with clamping, plus quantization.
+static quint8 quantizedDistanceAAFactor(float physicalRadius)
 {
-    ShapeMaterial::Data* materialData = static_cast<ShapeNode*>(node)->material()->data();
-    quint8 flags = 0;
-
-    materialData->shapeTextureIndex = shapeTextureIndex;
-    if (textured) {
-        materialData->sourceTextureProvider = m_sourceTextureProvider;
-        materialData->sourceOpacity = m_sourceOpacity;
-        if (m_sourceHorizontalWrapMode == Repeat) {
-            flags |= ShapeMaterial::Data::HorizontallyRepeated;
-        }
-        if (m_sourceVerticalWrapMode == Repeat) {
-            flags |= ShapeMaterial::Data::VerticallyRepeated;
-        }
-        flags |= ShapeMaterial::Data::Textured;
-    } else {
-        materialData->sourceTextureProvider = NULL;
-        materialData->sourceOpacity = 0;
-    }
-
-    const float physicalRadius = radius * qGuiApp->devicePixelRatio();
-
-    // Mapping of radius size range from [0, 4] to [0, 1] with clamping, plus quantization.
     const float start = 0.0f + radiusSizeOffset;
     const float end = 4.0f + radiusSizeOffset;
+    return qMin((physicalRadius / (end - start)) - (start / (end - start)), 1.0f) * 255.0f;
+}
 
-    materialData->distanceAAFactor =
-        qMin((physicalRadius / (end - start)) - (start / (end - start)), 1.0f) * 255.0f;
-
+quint8 UCUbuntuShape::aspectFlags(float physicalRadius) const
+{
     // When the radius is equal to radiusSizeOffset (which means radius size is 0), no aspect is
     // flagged so that a dedicated (statically flow controlled) shaved off shader can be used for
     // optimal performance.
     if (physicalRadius > radiusSizeOffset) {
-        const quint8 aspectFlags[] = {
+        const quint8 flags[] = {
             ShapeMaterial::Data::Flat, ShapeMaterial::Data::Inset, ShapeMaterial::Data::DropShadow,
             ShapeMaterial::Data::Inset | ShapeMaterial::Data::Pressed
         };
-        flags |= aspectFlags[m_aspect];
+        return flags[m_aspect];
+    } else {
+        const quint8 flags[] = { 0, 0, 0, ShapeMaterial::Data::Pressed };
+        return flags[m_aspect];
+    }
+}
+
+void UCUbuntuShape::updateMaterial(
+    QSGNode* node, float radius, quint8 shapeTextureIndex, bool textured)
+{
+    // Batching can be disabled for debugging and performance comparison purposes.
+    static bool noBatching = !qgetenv("UC_SHAPE_NO_BATCHING").isEmpty();
+
+    ShapeMaterial* material = static_cast<ShapeNode*>(node)->material();
+    ShapeMaterial::Data* materialData = material->data();
+    ShapeMaterial::Data oldMaterialData;
+    memcpy(&oldMaterialData, materialData, sizeof(ShapeMaterial::Data));
+    const float physicalRadius = radius * qGuiApp->devicePixelRatio();
+
+    const quint8 distanceAAFactor = quantizedDistanceAAFactor(physicalRadius);
+    const quint8 aspect = aspectFlags(physicalRadius);
+    materialData->shapeTextureBucket = material->shapeTextures()->useDistanceFields() ?
+        ShapeTextureCache::bucket(physicalRadius) : 0;
+
+    if (!textured && !noBatching && material->isBatchable()) {
+        // Untextured shapes store their parameters in the vertices (see updateGeometry()) and all
+        // share the same material state, the renderer can then merge them in a single draw call.
+        // The aspect is stored as an index in [0, 3] scaled to [0, 255] (none, flat, inset and
+        // drop shadow), the pressed factor as a quantized RGB factor.
+        const quint32 aspectIndex =
+            (aspect & ShapeMaterial::Data::Flat) ? 85 :
+            (aspect & ShapeMaterial::Data::Inset) ? 170 :
+            (aspect & ShapeMaterial::Data::DropShadow) ? 255 : 0;
+        const quint32 pressed =
+            (aspect & ShapeMaterial::Data::Pressed) ? pressedFactor * 255.0f : 255;
+        material->setShapeParams(
+            (aspectIndex << 24) | (pressed << 16) | ((shapeTextureIndex ? 255 : 0) << 8)
+            | distanceAAFactor);
+        if (aspectIndex) {
+            material->shapeTextures()->textureId(
+                shapeTextureIndex, materialData->shapeTextureBucket);
+        }
+        materialData->sourceTextureProvider = NULL;
+        materialData->shapeTextureIndex = 0;
+        materialData->distanceAAFactor = 0;
+        materialData->sourceOpacity = 0;
+        materialData->flags = ShapeMaterial::Data::Batched;
+
     } else {
-        const quint8 aspectFlags[] = { 0, 0, 0, ShapeMaterial::Data::Pressed };
-        flags |= aspectFlags[m_aspect];
+        quint8 flags = aspect;
+        materialData->shapeTextureIndex = shapeTextureIndex;
+        if (textured) {
+            materialData->sourceTextureProvider = m_sourceTextureProvider;
+            materialData->sourceOpacity = m_sourceOpacity;
+            if (m_sourceHorizontalWrapMode == Repeat) {
+                flags |= ShapeMaterial::Data::HorizontallyRepeated;
+            }
+            if (m_sourceVerticalWrapMode == Repeat) {
+                flags |= ShapeMaterial::Data::VerticallyRepeated;
+            }
+            flags |= ShapeMaterial::Data::Textured;
+        } else {
+            materialData->sourceTextureProvider = NULL;
+            materialData->sourceOpacity = 0;
+        }
+        materialData->distanceAAFactor = distanceAAFactor;
+        materialData->flags = flags;
     }
 
-    materialData->flags = flags;
+    // Let the renderer know when the material state changed so that it can rebuild its batches.
+    if (memcmp(&oldMaterialData, materialData, sizeof(ShapeMaterial::Data))) {
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
 }
 
 void UCUbuntuShape::updateGeometry(
@@ -1363,8 +1541,10 @@ void UCUbuntuShape::updateGeometry(
     // better optimization here.
     Q_UNUSED(shapeOffset);
 
-    ShapeNode::Vertex* v = reinterpret_cast<ShapeNode::Vertex*>(
-        static_cast<ShapeNode*>(node)->geometry()->vertexData());
+    ShapeNode* shapeNode = static_cast<ShapeNode*>(node);
+    ShapeNode::Vertex* v =
+        reinterpret_cast<ShapeNode::Vertex*>(shapeNode->geometry()->vertexData());
+    const quint32 shapeParams = shapeNode->material()->shapeParams();
 
     // Set top row of 3 vertices.
     v[0].position[0] = 0.0f;
@@ -1377,6 +1557,7 @@ void UCUbuntuShape::updateGeometry(
     v[0].sourceCoordinate[3] = sourceMaskTransform.w();
     v[0].yCoordinate = -1.0f;
     v[0].backgroundColor = backgroundColor[0];
+    v[0].shapeParams = shapeParams;
     v[1].position[0] = 0.5f * itemSize.width();
     v[1].position[1] = 0.0f;
     v[1].shapeCoordinate[0] = (0.5f * itemSize.width()) / radius - shapeTextureOffset;
@@ -1387,6 +1568,7 @@ void UCUbuntuShape::updateGeometry(
     v[1].sourceCoordinate[3] = sourceMaskTransform.w();
     v[1].yCoordinate = -1.0f;
     v[1].backgroundColor = backgroundColor[0];
+    v[1].shapeParams = shapeParams;
     v[2].position[0] = itemSize.width();
     v[2].position[1] = 0.0f;
     v[2].shapeCoordinate[0] = shapeTextureOffset;
@@ -1397,6 +1579,7 @@ void UCUbuntuShape::updateGeometry(
     v[2].sourceCoordinate[3] = sourceMaskTransform.w();
     v[2].yCoordinate = -1.0f;
     v[2].backgroundColor = backgroundColor[0];
+    v[2].shapeParams = shapeParams;
 
     // Set middle row of 3 vertices.
     v[3].position[0] = 0.0f;
@@ -1409,6 +1592,7 @@ void UCUbuntuShape::updateGeometry(
     v[3].sourceCoordinate[3] = 0.5f * sourceMaskTransform.y() + sourceMaskTransform.w();
     v[3].yCoordinate = 0.0f;
     v[3].backgroundColor = backgroundColor[1];
+    v[3].shapeParams = shapeParams;
     v[4].position[0] = 0.5f * itemSize.width();
     v[4].position[1] = 0.5f * itemSize.height();
     v[4].shapeCoordinate[0] = (0.5f * itemSize.width()) / radius - shapeTextureOffset;
@@ -1419,6 +1603,7 @@ void UCUbuntuShape::updateGeometry(
     v[4].sourceCoordinate[3] = 0.5f * sourceMaskTransform.y() + sourceMaskTransform.w();
     v[4].yCoordinate = 0.0f;
     v[4].backgroundColor = backgroundColor[1];
+    v[4].shapeParams = shapeParams;
     v[5].position[0] = itemSize.width();
     v[5].position[1] = 0.5f * itemSize.height();
     v[5].shapeCoordinate[0] = shapeTextureOffset;
@@ -1429,6 +1614,7 @@ void UCUbuntuShape::updateGeometry(
     v[5].sourceCoordinate[3] = 0.5f * sourceMaskTransform.y() + sourceMaskTransform.w();
     v[5].yCoordinate = 0.0f;
     v[5].backgroundColor = backgroundColor[1];
+    v[5].shapeParams = shapeParams;
 
     // Set bottom row of 3 vertices.
     v[6].position[0] = 0.0f;
@@ -1441,6 +1627,7 @@ void UCUbuntuShape::updateGeometry(
     v[6].sourceCoordinate[3] = sourceMaskTransform.y() + sourceMaskTransform.w();
     v[6].yCoordinate = 1.0f;
     v[6].backgroundColor = backgroundColor[2];
+    v[6].shapeParams = shapeParams;
     v[7].position[0] = 0.5f * itemSize.width();
     v[7].position[1] = itemSize.height();
     v[7].shapeCoordinate[0] = (0.5f * itemSize.width()) / radius - shapeTextureOffset;
@@ -1451,6 +1638,7 @@ void UCUbuntuShape::updateGeometry(
     v[7].sourceCoordinate[3] = sourceMaskTransform.y() + sourceMaskTransform.w();
     v[7].yCoordinate = 1.0f;
     v[7].backgroundColor = backgroundColor[2];
+    v[7].shapeParams = shapeParams;
     v[8].position[0] = itemSize.width();
     v[8].position[1] = itemSize.height();
     v[8].shapeCoordinate[0] = shapeTextureOffset;
@@ -1461,8 +1649,352 @@ void UCUbuntuShape::updateGeometry(
     v[8].sourceCoordinate[3] = sourceMaskTransform.y() + sourceMaskTransform.w();
     v[8].yCoordinate = 1.0f;
     v[8].backgroundColor = backgroundColor[2];
+    v[8].shapeParams = shapeParams;
 
     node->markDirty(QSGNode::DirtyGeometry);
 }
 
+// --- Software rendering ---
+
+// The software scene graph backend can't run the shaders, the shape is instead rasterized in an
+// image. The contour is shaded using corner tiles pre-rasterized from the distance fields of the
+// shape textures and cached for all the shapes of a given radius and aspect. The shaded images
+// are cached too, for all the shapes drawing the same content at the same size. Each texel of a tile packs 4 factors applied to the pixels, from low to high bytes: the
+// inner shadow blended over the color (inset), the shape mask, the additive bevel (inset) and the
+// additive outer shadow (drop shadow).
+
+const int maxCachedSoftwareCorners = 64;
+const int maxSoftwareImageCacheCost = 8 * 1024;  // In kB.
+const quint32 identitySoftwareTexel = 0x0000ff00;
+
+struct SoftwareCorner
+{
+    // Tiles for the top and bottom halves of the shape, stored for the left corners (right corners
+    // are mirrored). The last row and column store the factors past the contour.
+    int size;
+    QVector<quint32> tiles[2];
+};
+
+static QHash<quint32, QSharedPointer<const SoftwareCorner> > softwareCornersHash;
+static QMutex softwareCornersHashMutex;
+
+// Everything a shaded image depends on, padding included so that it can be compared bytewise. The
+// key of the overlay painted by subclasses is appended.
+struct SoftwareImageKey
+{
+    qint64 sourceKey;
+    float sourceTransform[4];
+    float physicalRadius;
+    QRgb backgroundColor[2];
+    qint32 width;
+    qint32 height;
+    quint8 aspectFlags;
+    quint8 distanceAAFactor;
+    quint8 sourceOpacity;
+    quint8 sourceFlags;
+};
+
+static QCache<QByteArray, QImage> softwareImageCache(maxSoftwareImageCacheCost);
+static QMutex softwareImageCacheMutex;
+
+// Bilinearly samples a shape texture with clamp to edge wrapping, like the GPU does.
+static void sampleShapeTexture(int index, float s, float t, float texel[4])
+{
+    const float u = qBound(0.0f, s * shapeTextureWidth - 0.5f, shapeTextureWidth - 1.0f);
+    const float v = qBound(0.0f, t * shapeTextureHeight - 0.5f, shapeTextureHeight - 1.0f);
+    const int x0 = static_cast<int>(u);
+    const int y0 = static_cast<int>(v);
+    const int x1 = qMin(x0 + 1, shapeTextureWidth - 1);
+    const int y1 = qMin(y0 + 1, shapeTextureHeight - 1);
+    const float fx = u - x0;
+    const float fy = v - y0;
+    const unsigned char* data = shapeTextureData[index];
+    const unsigned char* t00 = &data[(y0 * shapeTextureWidth + x0) * 4];
+    const unsigned char* t10 = &data[(y0 * shapeTextureWidth + x1) * 4];
+    const unsigned char* t01 = &data[(y1 * shapeTextureWidth + x0) * 4];
+    const unsigned char* t11 = &data[(y1 * shapeTextureWidth + x1) * 4];
+    for (int i = 0; i < 4; i++) {
+        const float top = t00[i] + (t10[i] - t00[i]) * fx;
+        const float bottom = t01[i] + (t11[i] - t01[i]) * fx;
+        texel[i] = (top + (bottom - top) * fy) * (1.0f / 255.0f);
+    }
+}
+
+static float smoothStep(float edge0, float edge1, float x)
+{
+    if (edge0 >= edge1) {
+        return x < edge0 ? 0.0f : 1.0f;
+    }
+    const float t = qBound(0.0f, (x - edge0) / (edge1 - edge0), 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static inline quint32 packSoftwareTexel(float under, float mask, float over, float shadow)
+{
+    return qRound(under * 255.0f) | (qRound(mask * 255.0f) << 8) | (qRound(over * 255.0f) << 16)
+        | (qRound(shadow * 255.0f) << 24);
+}
+
+// Rasterizes the corner tiles, this is the CPU counterpart of the fragment shader.
+static SoftwareCorner* createSoftwareCorner(
+    quint8 aspectFlags, float physicalRadius, quint8 distanceAAFactor)
+{
+    SoftwareCorner* corner = new SoftwareCorner;
+    const int size = qMax(1, qCeil(physicalRadius * (1.0f - shapeTextureOffset)));
+    const float distance = 1.0f / physicalRadius;
+    const float distanceAA =
+        (distanceAAFactor / 255.0f) * ((shapeTextureDistanceAA * distanceAApx) / 2.0f);
+    const float distanceMin = distance * -distanceAA + 0.5f;
+    const float distanceMax = distance * distanceAA + 0.5f;
+    const int textureIndex = (aspectFlags & ShapeMaterial::Data::DropShadow) ? 1 : 0;
+
+    corner->size = size;
+    for (int side = 0; side < 2; side++) {
+        QVector<quint32>& tile = corner->tiles[side];
+        tile.resize((size + 1) * (size + 1));
+        for (int y = 0; y <= size; y++) {
+            const float t = y < size ? shapeTextureOffset + (y + 0.5f) * distance : 1.0f;
+            for (int x = 0; x <= size; x++) {
+                const float s = x < size ? shapeTextureOffset + (x + 0.5f) * distance : 1.0f;
+                float shapeData[4];
+                sampleShapeTexture(textureIndex, s, t, shapeData);
+                quint32 texel;
+                if (aspectFlags & ShapeMaterial::Data::Flat) {
+                    texel = packSoftwareTexel(
+                        0.0f, smoothStep(distanceMin, distanceMax, shapeData[2]), 0.0f, 0.0f);
+                } else if (aspectFlags & ShapeMaterial::Data::Inset) {
+                    const float maskTop = smoothStep(distanceMin, distanceMax, shapeData[2]);
+                    const float maskBottom = smoothStep(distanceMin, distanceMax, shapeData[3]);
+                    const float bevel = side ?
+                        maskTop * (1.0f - maskBottom) * qBound(0.0f, 1.0f - t, 1.0f) * 0.6f : 0.0f;
+                    texel = packSoftwareTexel(
+                        shapeData[side], side ? maskBottom : maskTop, bevel, 0.0f);
+                } else if (aspectFlags & ShapeMaterial::Data::DropShadow) {
+                    const float mask = smoothStep(distanceMin, distanceMax, shapeData[side]);
+                    texel = packSoftwareTexel(0.0f, mask, 0.0f, shapeData[2] * (1.0f - mask));
+                } else {
+                    texel = identitySoftwareTexel;
+                }
+                tile[y * (size + 1) + x] = texel;
+            }
+        }
+    }
+
+    return corner;
+}
+
+static QSharedPointer<const SoftwareCorner> softwareCorner(
+    quint8 aspectFlags, float physicalRadius, quint8 distanceAAFactor)
+{
+    // Radii are quantized to a quarter of pixel.
+    const quint32 key = (aspectFlags & ShapeMaterial::Data::AspectMask) | (distanceAAFactor << 8)
+        | (qMin(qRound(physicalRadius * 4.0f), 0xffff) << 16);
+
+    QMutexLocker locker(&softwareCornersHashMutex);
+    QSharedPointer<const SoftwareCorner> corner = softwareCornersHash.value(key);
+    if (!corner) {
+        if (softwareCornersHash.size() >= maxCachedSoftwareCorners) {
+            softwareCornersHash.clear();
+        }
+        corner = QSharedPointer<const SoftwareCorner>(
+            createSoftwareCorner(aspectFlags, physicalRadius, distanceAAFactor));
+        softwareCornersHash.insert(key, corner);
+    }
+    return corner;
+}
+
+// Applies the factors of a tile texel to a premultiplied color.
+static inline QRgb shadeSoftwarePixel(QRgb pixel, quint32 texel, int pressed)
+{
+    const int under = texel & 0xff;
+    const int mask = (texel >> 8) & 0xff;
+    const int over = (texel >> 16) & 0xff;
+    const int shadow = texel >> 24;
+    const int inverseUnder = 255 - under;
+    int r = (((qRed(pixel) * inverseUnder) / 255) * mask) / 255;
+    int g = (((qGreen(pixel) * inverseUnder) / 255) * mask) / 255;
+    int b = (((qBlue(pixel) * inverseUnder) / 255) * mask) / 255;
+    int a = ((((qAlpha(pixel) * inverseUnder) / 255) + under) * mask) / 255;
+    r = (qMin(r + over, 255) * pressed) >> 8;
+    g = (qMin(g + over, 255) * pressed) >> 8;
+    b = (qMin(b + over, 255) * pressed) >> 8;
+    a = qMin(a + over + shadow, 255);
+    return qRgba(r, g, b, a);
+}
+
+static void shadeSoftwareImage(
+    QImage* image, quint8 aspectFlags, float physicalRadius, quint8 distanceAAFactor)
+{
+    const int pressed = (aspectFlags & ShapeMaterial::Data::Pressed) ? pressedFactor * 256 : 256;
+    if (!(aspectFlags & ShapeMaterial::Data::AspectMask)) {
+        if (pressed != 256) {
+            for (int y = 0; y < image->height(); y++) {
+                QRgb* line = reinterpret_cast<QRgb*>(image->scanLine(y));
+                for (int x = 0; x < image->width(); x++) {
+                    line[x] = shadeSoftwarePixel(line[x], identitySoftwareTexel, pressed);
+                }
+            }
+        }
+        return;
+    }
+
+    const QSharedPointer<const SoftwareCorner> corner =
+        softwareCorner(aspectFlags, physicalRadius, distanceAAFactor);
+    const int size = corner->size;
+    const int width = image->width();
+    const int height = image->height();
+    for (int y = 0; y < height; y++) {
+        const int side = (y < height / 2) ? 0 : 1;
+        const int row = qMin(side ? height - 1 - y : y, size);
+        const quint32* tileLine = &corner->tiles[side][row * (size + 1)];
+        // Pixels past the contour are left untouched unless their factors aren't neutral.
+        const bool skipInterior = tileLine[size] == identitySoftwareTexel && pressed == 256;
+        QRgb* line = reinterpret_cast<QRgb*>(image->scanLine(y));
+        for (int x = 0; x < width; x++) {
+            const int column = qMin(x < width / 2 ? x : width - 1 - x, size);
+            if (column == size && skipInterior) {
+                x = qMax(x, width - 1 - size);
+                continue;
+            }
+            line[x] = shadeSoftwarePixel(line[x], tileLine[column], pressed);
+        }
+    }
+}
+
+// Gets the image of the source. The textures of the software scene graph backend can't be read
+// through the public API, so only Image sources are drawn.
+static QImage softwareSourceImage(QQuickItem* source)
+{
+    QQuickImageBase* image = qobject_cast<QQuickImageBase*>(source);
+    return image ? image->image() : QImage();
+}
+
+QSGNode* UCUbuntuShape::updateSoftwareNode(
+    QSGNode* oldNode, const QSizeF& itemSize, float radius, QSGTexture* sourceTexture,
+    const QRgb backgroundColor[2])
+{
+    QQuickWindow* window = this->window();
+    const qreal dpr = window->effectiveDevicePixelRatio();
+    const QSize imageSize(qCeil(itemSize.width() * dpr), qCeil(itemSize.height() * dpr));
+    const float physicalRadius = radius * dpr;
+    const QImage source = (sourceTexture && m_sourceOpacity) ?
+        softwareSourceImage(m_source) : QImage();
+
+    SoftwareImageKey key;
+    memset(&key, 0, sizeof(key));
+    key.sourceKey = source.isNull() ? 0 : source.cacheKey();
+    if (!source.isNull()) {
+        key.sourceTransform[0] = m_sourceTransform.x();
+        key.sourceTransform[1] = m_sourceTransform.y();
+        key.sourceTransform[2] = m_sourceTransform.z();
+        key.sourceTransform[3] = m_sourceTransform.w();
+        key.sourceOpacity = m_sourceOpacity;
+        key.sourceFlags = m_sourceHorizontalWrapMode | (m_sourceVerticalWrapMode << 1)
+            | (smooth() << 2);
+    }
+    key.physicalRadius = physicalRadius;
+    key.backgroundColor[0] = backgroundColor[0];
+    key.backgroundColor[1] = backgroundColor[1];
+    key.width = imageSize.width();
+    key.height = imageSize.height();
+    key.aspectFlags = aspectFlags(physicalRadius);
+    key.distanceAAFactor = quantizedDistanceAAFactor(physicalRadius);
+    const QByteArray keyData =
+        QByteArray(reinterpret_cast<const char*>(&key), sizeof(key)) + softwareOverlayKey();
+
+    QSGImageNode* node = static_cast<QSGImageNode*>(oldNode);
+    if (node && keyData == m_softwareImageKey) {
+        node->setRect(QRectF(QPointF(0.0, 0.0), itemSize));
+        return node;
+    }
+    m_softwareImageKey = keyData;
+
+    QImage image;
+    softwareImageCacheMutex.lock();
+    if (QImage* cached = softwareImageCache.object(keyData)) {
+        image = *cached;
+    }
+    softwareImageCacheMutex.unlock();
+
+    if (image.isNull()) {
+        image = QImage(imageSize, QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&image);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        if (backgroundColor[0] == backgroundColor[1]) {
+            painter.fillRect(image.rect(), QColor::fromRgba(backgroundColor[0]));
+        } else {
+            QLinearGradient gradient(0.0, 0.0, 0.0, imageSize.height());
+            gradient.setColorAt(0.0, QColor::fromRgba(backgroundColor[0]));
+            gradient.setColorAt(1.0, QColor::fromRgba(backgroundColor[1]));
+            painter.fillRect(image.rect(), gradient);
+        }
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+        // Draw the source using the inverse of the source coordinates affine transformation.
+        if (!source.isNull()) {
+            const QRectF sourceRect(
+                (-m_sourceTransform.z() / m_sourceTransform.x()) * imageSize.width(),
+                (-m_sourceTransform.w() / m_sourceTransform.y()) * imageSize.height(),
+                imageSize.width() / m_sourceTransform.x(),
+                imageSize.height() / m_sourceTransform.y());
+            painter.setOpacity(m_sourceOpacity / 255.0);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, smooth());
+            if (m_sourceHorizontalWrapMode == Transparent
+                && m_sourceVerticalWrapMode == Transparent) {
+                painter.drawImage(sourceRect, source, source.rect());
+            } else {
+                QBrush brush(source);
+                QTransform transform;
+                transform.translate(sourceRect.x(), sourceRect.y());
+                transform.scale(sourceRect.width() / source.width(),
+                                sourceRect.height() / source.height());
+                brush.setTransform(transform);
+                QRectF repeatRect(sourceRect);
+                if (m_sourceHorizontalWrapMode == Repeat) {
+                    repeatRect.setLeft(0.0);
+                    repeatRect.setWidth(imageSize.width());
+                }
+                if (m_sourceVerticalWrapMode == Repeat) {
+                    repeatRect.setTop(0.0);
+                    repeatRect.setHeight(imageSize.height());
+                }
+                painter.fillRect(repeatRect, brush);
+            }
+            painter.setOpacity(1.0);
+        }
+
+        paintSoftwareOverlay(&painter, imageSize);
+        painter.end();
+
+        shadeSoftwareImage(&image, key.aspectFlags, physicalRadius, key.distanceAAFactor);
+
+        softwareImageCacheMutex.lock();
+        softwareImageCache.insert(keyData, new QImage(image), qMax(1, image.byteCount() / 1024));
+        softwareImageCacheMutex.unlock();
+    }
+
+    // The node deletes the texture it is given when it's replaced or when the node is deleted.
+    if (!node) {
+        node = window->createImageNode();
+        node->setOwnsTexture(true);
+    }
+    node->setTexture(window->createTextureFromImage(image));
+    node->setRect(QRectF(QPointF(0.0, 0.0), itemSize));
+    node->setSourceRect(QRectF(QPointF(0.0, 0.0), imageSize));
+    return node;
+}
+
+void UCUbuntuShape::paintSoftwareOverlay(QPainter* painter, const QSize& imageSize)
+{
+    // Used by subclasses.
+    Q_UNUSED(painter);
+    Q_UNUSED(imageSize);
+}
+
+QByteArray UCUbuntuShape::softwareOverlayKey() const
+{
+    // Used by subclasses.
+    return QByteArray();
+}
+
 UT_NAMESPACE_END
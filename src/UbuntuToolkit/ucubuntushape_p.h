@@ -25,8 +25,12 @@
 #include <QtQuick/qsgmaterial.h>
 
 #include <UbuntuToolkit/private/ucimportversionchecker_p.h>
+#include <UbuntuToolkit/private/ucubuntushapetexturecache_p.h>
 #include <UbuntuToolkit/private/ucubuntushapetextures_p.h>
 
+class QPainter;
+class QSGTexture;
+
 // --- Scene graph shader ---
 
 UT_NAMESPACE_BEGIN
@@ -52,8 +56,48 @@ private:
     int m_aspectId;
 };
 
+// Shader used to render untextured shapes with all the per-item parameters stored in the vertices
+// so that the renderer can merge them in a single draw call.
+class ShapeBatchedShader : public QSGMaterialShader
+{
+public:
+    ShapeBatchedShader();
+    char const* const* attributeNames() const override;
+    void initialize() override;
+    void updateState(
+        const RenderState& state, QSGMaterial* newEffect, QSGMaterial* oldEffect) override;
+
+private:
+    QOpenGLFunctions* m_functions;
+    int m_matrixId;
+    int m_opacityId;
+};
+
 // --- Scene graph material ---
 
+// Shape textures shared by all the materials of an OpenGL context. Each texture is uploaded the
+// first time a shape with the matching aspect is rendered. Textures of the size buckets generated at
+// runtime (see ShapeTextureCache) fall back to the baked ones until they're available.
+class ShapeTextures
+{
+public:
+    static ShapeTextures* ref(QOpenGLContext* openglContext);
+    void unref();
+    quint32 textureId(int index, int bucket = 0);
+    quint32 uploadedTextureId(int index, int bucket) const {
+        return m_ids[bucket][index] ? m_ids[bucket][index] : m_ids[0][index]; }
+    bool useDistanceFields() const { return m_useDistanceFields; }
+
+private:
+    ShapeTextures(QOpenGLContext* openglContext);
+    ~ShapeTextures();
+
+    QOpenGLContext* m_openglContext;
+    quint32 m_refCount;
+    quint32 m_ids[ShapeTextureCache::bucketCount][shapeTextureCount];
+    bool m_useDistanceFields;
+};
+
 class ShapeMaterial : public QSGMaterial
 {
 public:
@@ -67,13 +111,15 @@ public:
             Inset                = (1 << 4),
             DropShadow           = (1 << 5),
             AspectMask           = (Flat | Inset | DropShadow),
-            Pressed              = (1 << 6)
+            Pressed              = (1 << 6),
+            Batched              = (1 << 7)
         };
         QSGTextureProvider* sourceTextureProvider;
         quint8 shapeTextureIndex;
         quint8 distanceAAFactor;
         quint8 sourceOpacity;
         quint8 flags;
+        quint8 shapeTextureBucket;
     };
 
     ShapeMaterial();
@@ -82,13 +128,17 @@ public:
     QSGMaterialShader* createShader() const override;
     int compare(const QSGMaterial* other) const override;
     virtual void updateTextures();
+    virtual bool isBatchable() const { return true; }
     const Data* constData() const { return &m_data; }
     Data* data() { return &m_data; }
-    quint32* textureIds() { return m_shapeTexturesId; }
+    ShapeTextures* shapeTextures() { return m_shapeTextures; }
+    quint32 shapeParams() const { return m_shapeParams; }
+    void setShapeParams(quint32 shapeParams) { m_shapeParams = shapeParams; }
 
 private:
     Data m_data;
-    quint32 m_shapeTexturesId[shapeTextureCount];
+    quint32 m_shapeParams;
+    ShapeTextures* m_shapeTextures;
 };
 
 // --- Scene graph node ---
@@ -102,6 +152,7 @@ public:
         float sourceCoordinate[4];
         float yCoordinate;
         quint32 backgroundColor;
+        quint32 shapeParams;
     };
 
     static const int indexCount = 14;
@@ -109,7 +160,7 @@ public:
     static const int indexTypeSize = sizeof(unsigned short);
     static const int vertexCount = 9;
     static const QSGGeometry::DataPattern indexDataPattern = QSGGeometry::StaticPattern;
-    static const QSGGeometry::DataPattern vertexDataPattern = QSGGeometry::AlwaysUploadPattern;
+    static const QSGGeometry::DataPattern vertexDataPattern = QSGGeometry::StaticPattern;
     static const GLenum drawingMode = GL_TRIANGLE_STRIP;
     static const unsigned short* indices();
     static const QSGGeometry::AttributeSet& attributeSet();
@@ -308,6 +359,9 @@ protected:
         QSGNode* node, const QSizeF& itemSize, float radius, float shapeOffset,
         const QVector4D& sourceCoordTransform, const QVector4D& sourceMaskTransform,
         const quint32 backgroundColor[3]);
+    virtual void paintSoftwareOverlay(QPainter* painter, const QSize& imageSize);
+    // Identifies what paintSoftwareOverlay() paints, the software images are cached by content.
+    virtual QByteArray softwareOverlayKey() const;
 
 private Q_SLOTS:
     void _q_imagePropertiesChanged();
@@ -326,6 +380,10 @@ private:
     void updateSourceTransform(
         float itemWidth, float itemHeight, FillMode fillMode, HAlignment horizontalAlignment,
         VAlignment verticalAlignment, const QSize& textureSize);
+    quint8 aspectFlags(float physicalRadius) const;
+    QSGNode* updateSoftwareNode(
+        QSGNode* oldNode, const QSizeF& itemSize, float radius, QSGTexture* sourceTexture,
+        const QRgb backgroundColor[2]);
 
     enum Radius { Small = 0, Medium = 1, Large = 2 };
     enum { Pressed = 3 };  // Aspect extension (to keep support for deprecated aspects).
@@ -340,6 +398,7 @@ private:
 
     QQuickItem* m_source;
     QSGTextureProvider* m_sourceTextureProvider;
+    QByteArray m_softwareImageKey;
     QRgb m_backgroundColor;
     QRgb m_secondaryBackgroundColor;
     QVector2D m_sourceScale;
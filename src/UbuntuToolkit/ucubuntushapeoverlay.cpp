@@ -22,6 +22,8 @@
 
 #include "ucubuntushapeoverlay_p.h"
 
+#include <QtGui/QPainter>
+
 // -- Scene graph shader ---
 
 UT_NAMESPACE_BEGIN
@@ -371,4 +373,24 @@ void UCUbuntuShapeOverlay::updateGeometry(
     node->markDirty(QSGNode::DirtyGeometry);
 }
 
+void UCUbuntuShapeOverlay::paintSoftwareOverlay(QPainter* painter, const QSize& imageSize)
+{
+    const QRectF rect = overlayRect();
+    if (!rect.isEmpty()) {
+        painter->fillRect(
+            QRectF(rect.x() * imageSize.width(), rect.y() * imageSize.height(),
+                   rect.width() * imageSize.width(), rect.height() * imageSize.height()),
+            overlayColor());
+    }
+}
+
+QByteArray UCUbuntuShapeOverlay::softwareOverlayKey() const
+{
+    const quint16 key[6] = {
+        m_overlayX, m_overlayY, m_overlayWidth, m_overlayHeight,
+        static_cast<quint16>(m_overlayColor & 0xffff), static_cast<quint16>(m_overlayColor >> 16)
+    };
+    return QByteArray(reinterpret_cast<const char*>(key), sizeof(key));
+}
+
 UT_NAMESPACE_END
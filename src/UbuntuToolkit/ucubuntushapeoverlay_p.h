@@ -39,6 +39,7 @@ class ShapeOverlayMaterial : public ShapeMaterial
 public:
     QSGMaterialType* type() const override;
     QSGMaterialShader* createShader() const override;
+    bool isBatchable() const override { return false; }
 };
 
 // --- Scene graph node ---
@@ -99,6 +100,8 @@ protected:
         QSGNode* node, const QSizeF& itemSize, float radius, float shapeOffset,
         const QVector4D& sourceCoordTransform, const QVector4D& sourceMaskTransform,
         const quint32 backgroundColor[3]) override;
+    void paintSoftwareOverlay(QPainter* painter, const QSize& imageSize) override;
+    QByteArray softwareOverlayKey() const override;
 
 private:
     quint16 m_overlayX;
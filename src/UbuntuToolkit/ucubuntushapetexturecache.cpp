@@ -0,0 +1,377 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The textures are created the same way as the baked ones (see tools/createshapetextures.cpp),
+// except that the EDTAA3 distance transform is replaced by a faster separable Euclidean distance
+// transform on the thresholded shape, corrected by the coverage of the anti-aliased pixels. Both
+// passes are branch-free loops over contiguous rows of floats, which compilers turn into SIMD code
+// on x86 and ARM without having to maintain intrinsics for each architecture.
+
+#include "ucubuntushapetexturecache_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QRunnable>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QVector>
+#include <QtCore/QtMath>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtSvg/QSvgRenderer>
+
+#include "ucubuntushapetextures_p.h"
+
+UT_NAMESPACE_BEGIN
+
+static const quint32 cacheMagic = 0x55435354;  // "UCST"
+// Must be incremented whenever the generated data changes so that stale files are regenerated.
+static const quint32 cacheVersion = 1;
+
+// --- Distance field generation ---
+
+struct DistanceFieldBuffers
+{
+    DistanceFieldBuffers(int size)
+        : svg(QStringLiteral(":/uc/tools/shape.svg"))
+        , image(size, size, QImage::Format_ARGB32_Premultiplied)
+        , coverage(size * size)
+        , distanceIn(size * size)
+        , distanceOut(size * size)
+        , scratch(size * size)
+        , size(size)
+    {
+    }
+
+    QSvgRenderer svg;
+    QImage image;
+    QVector<float> coverage;
+    QVector<float> distanceIn;
+    QVector<float> distanceOut;
+    QVector<float> scratch;
+    int size;
+};
+
+// Renders the shape translated by (tx, ty) from the shape offset and stores its coverage.
+static void renderShape(DistanceFieldBuffers* buffers, double tx, double ty)
+{
+    const int size = buffers->size;
+    buffers->image.fill(Qt::transparent);
+    QPainter painter(&buffers->image);
+    painter.translate((shapeTextureOffset + tx) * size, (shapeTextureOffset + ty) * size);
+    buffers->svg.render(&painter);
+    painter.end();
+
+    const QRgb* pixels = reinterpret_cast<const QRgb*>(buffers->image.constBits());
+    float* coverage = buffers->coverage.data();
+    for (int i = 0; i < size * size; i++) {
+        coverage[i] = qAlpha(pixels[i]) * (1.0f / 255.0f);
+    }
+}
+
+static void invertCoverage(DistanceFieldBuffers* buffers)
+{
+    float* coverage = buffers->coverage.data();
+    for (int i = 0, count = buffers->size * buffers->size; i < count; i++) {
+        coverage[i] = 1.0f - coverage[i];
+    }
+}
+
+// Stores in distance the distance of each pixel to the closest pixel covered by the shape (0 for
+// covered pixels), clamped to maxDistance. The squared distance is computed with a vertical then
+// an horizontal pass, the horizontal one being bounded by maxDistance.
+static void distanceTransform(DistanceFieldBuffers* buffers, float* distance, float maxDistance)
+{
+    const int size = buffers->size;
+    const float* coverage = buffers->coverage.constData();
+    float* column = buffers->scratch.data();
+    const float infinity = maxDistance + 1.0f;
+
+    // Vertical distances with a top-down and a bottom-up sweep, then squared.
+    for (int x = 0; x < size; x++) {
+        column[x] = coverage[x] >= 0.5f ? 0.0f : infinity;
+    }
+    for (int y = 1; y < size; y++) {
+        const float* rowCoverage = &coverage[y * size];
+        const float* previous = &column[(y - 1) * size];
+        float* current = &column[y * size];
+        for (int x = 0; x < size; x++) {
+            current[x] = rowCoverage[x] >= 0.5f ? 0.0f : qMin(previous[x] + 1.0f, infinity);
+        }
+    }
+    for (int y = size - 2; y >= 0; y--) {
+        const float* next = &column[(y + 1) * size];
+        float* current = &column[y * size];
+        for (int x = 0; x < size; x++) {
+            current[x] = qMin(current[x], next[x] + 1.0f);
+        }
+    }
+    for (int i = 0; i < size * size; i++) {
+        column[i] *= column[i];
+    }
+
+    // Horizontal minimum of the squared distances over the window.
+    const int window = qMin(qCeil(maxDistance), size - 1);
+    for (int y = 0; y < size; y++) {
+        const float* squared = &column[y * size];
+        float* row = &distance[y * size];
+        memcpy(row, squared, size * sizeof(float));
+        for (int dx = 1; dx <= window; dx++) {
+            const float dx2 = static_cast<float>(dx * dx);
+            for (int x = 0; x < size - dx; x++) {
+                row[x] = qMin(row[x], squared[x + dx] + dx2);
+            }
+            for (int x = dx; x < size; x++) {
+                row[x] = qMin(row[x], squared[x - dx] + dx2);
+            }
+        }
+
+        // Distances are between pixel centers, move them to the anti-aliased contour.
+        const float* rowCoverage = &coverage[y * size];
+        for (int x = 0; x < size; x++) {
+            const float d = qMin(sqrtf(row[x]), maxDistance) - 0.5f - rowCoverage[x];
+            row[x] = rowCoverage[x] >= 0.5f ? 0.0f : qMax(d, 0.0f);
+        }
+    }
+}
+
+// Stores the signed distance field of the shape translated by (tx, ty) at the given bit shift.
+static void storeDistanceField(
+    DistanceFieldBuffers* buffers, double tx, double ty, quint32* texels, int shift)
+{
+    const int size = buffers->size;
+    const float maxDistance = size / 4.0f + 1.0f;
+    const double imageScale = 255.0 / size;
+
+    renderShape(buffers, tx, ty);
+    distanceTransform(buffers, buffers->distanceOut.data(), maxDistance);
+    invertCoverage(buffers);
+    distanceTransform(buffers, buffers->distanceIn.data(), maxDistance);
+    for (int i = 0; i < size * size; i++) {
+        const double distance = buffers->distanceIn[i] - buffers->distanceOut[i];
+        const quint32 value =
+            qBound(0, qRound(distance * shapeTextureDistanceAA * imageScale + 127.5), 255);
+        texels[i] |= value << shift;
+    }
+}
+
+// Stores the shadow of the shape translated by (tx, ty) at the given bit shift. Inner shadows
+// are the complement of drop shadows.
+static void storeShadow(
+    DistanceFieldBuffers* buffers, double tx, double ty, double scale, double translucency,
+    bool inner, quint32* texels, int shift)
+{
+    const int size = buffers->size;
+    const float maxDistance = size / 4.0f + 1.0f;
+    const double imageScale = 255.0 / size;
+
+    renderShape(buffers, tx, ty);
+    invertCoverage(buffers);
+    distanceTransform(buffers, buffers->distanceIn.data(), maxDistance);
+    for (int i = 0; i < size * size; i++) {
+        double shadow = qBound(0.0, (buffers->distanceIn[i] * scale * imageScale) / 255.0, 1.0);
+        shadow = 2.0 * shadow - shadow * shadow;
+        if (inner) {
+            shadow = 1.0 - shadow;
+        }
+        const quint32 value = qBound(0, qRound(shadow * 255.0 * translucency), 255);
+        texels[i] |= value << shift;
+    }
+}
+
+// static
+QByteArray ShapeTextureCache::generate(int index, int size)
+{
+    Q_ASSERT(index >= 0 && index < shapeTextureCount);
+    Q_ASSERT(size > 0);
+
+    DistanceFieldBuffers buffers(size);
+    if (!buffers.svg.isValid()) {
+        qWarning("ShapeTextureCache: can't load the shape SVG");
+        return QByteArray();
+    }
+    QVector<quint32> texels(size * size, 0);
+    const double distanceBottomTY = 0.0546875;
+
+    if (index == 0) {
+        // Inset and flat aspects: top and bottom masks in B and A, inner shadows in R and G.
+        const double shadowScale = 7.5;
+        const double shadowTranslucency = 0.37;
+        storeDistanceField(&buffers, 0.0, 0.0, texels.data(), 16);
+        storeDistanceField(&buffers, 0.0, distanceBottomTY, texels.data(), 24);
+        storeShadow(&buffers, -0.01171875, 0.03125, shadowScale, shadowTranslucency, true,
+                    texels.data(), 0);
+        storeShadow(&buffers, -0.01171875, -0.00390625, shadowScale, shadowTranslucency, true,
+                    texels.data(), 8);
+    } else {
+        // Drop shadow aspect: top and bottom masks in R and G, drop shadow in B.
+        const double shadowScale = 4.5;
+        const double shadowTranslucency = 0.8;
+        const double distanceTX = distanceBottomTY * 0.5;
+        storeDistanceField(&buffers, distanceTX, 0.0, texels.data(), 0);
+        storeDistanceField(&buffers, distanceTX, distanceBottomTY, texels.data(), 8);
+        storeShadow(&buffers, 0.0, 0.0, shadowScale, shadowTranslucency, false,
+                    texels.data(), 16);
+    }
+
+    QByteArray data(size * size * 4, Qt::Uninitialized);
+    uchar* bytes = reinterpret_cast<uchar*>(data.data());
+    for (int i = 0; i < size * size; i++) {
+        bytes[i * 4] = texels[i] & 0xff;
+        bytes[i * 4 + 1] = (texels[i] >> 8) & 0xff;
+        bytes[i * 4 + 2] = (texels[i] >> 16) & 0xff;
+        bytes[i * 4 + 3] = (texels[i] >> 24) & 0xff;
+    }
+    return data;
+}
+
+// --- Cache ---
+
+class ShapeTextureJob : public QRunnable
+{
+public:
+    ShapeTextureJob(ShapeTextureCache* cache, int index, int bucket)
+        : m_cache(cache), m_index(index), m_bucket(bucket) {}
+    void run() override { m_cache->load(m_index, m_bucket); }
+
+private:
+    ShapeTextureCache* m_cache;
+    int m_index;
+    int m_bucket;
+};
+
+ShapeTextureCache::ShapeTextureCache()
+    : m_directory(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+                  + QStringLiteral("/ubuntu-ui-toolkit/shapes/"))
+{
+    // A single worker is enough, a bucket is generated once and then loaded from disk.
+    m_threadPool.setMaxThreadCount(1);
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+// static
+ShapeTextureCache* ShapeTextureCache::instance()
+{
+    static ShapeTextureCache* cache = new ShapeTextureCache;
+    return cache;
+}
+
+// static
+quint8 ShapeTextureCache::bucket(float physicalRadius)
+{
+    // The baked textures can be forced for debugging and performance comparison purposes.
+    static bool bakedOnly = !qgetenv("UC_SHAPE_BAKED_TEXTURES").isEmpty();
+    if (bakedOnly) {
+        return 0;
+    }
+
+    // Pick the smallest texture with at least one texel per pixel of radius.
+    quint8 bucket = 0;
+    while (bucket < bucketCount - 1 && physicalRadius > bucketSize(bucket)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+// static
+int ShapeTextureCache::bucketSize(int bucket)
+{
+    Q_ASSERT(bucket >= 0 && bucket < bucketCount);
+    return shapeTextureWidth << bucket;
+}
+
+QByteArray ShapeTextureCache::textureData(int index, int bucket)
+{
+    Q_ASSERT(index >= 0 && index < shapeTextureCount);
+    Q_ASSERT(bucket > 0 && bucket < bucketCount);
+
+    const int key = index * bucketCount + bucket;
+    QMutexLocker locker(&m_mutex);
+    QHash<int, QByteArray>::const_iterator it = m_textures.constFind(key);
+    if (it != m_textures.constEnd()) {
+        return it.value();
+    }
+    if (!m_pending.contains(key)) {
+        m_pending.insert(key);
+        m_threadPool.start(new ShapeTextureJob(this, index, bucket));
+    }
+    return QByteArray();
+}
+
+void ShapeTextureCache::clear()
+{
+    m_threadPool.waitForDone();
+    QMutexLocker locker(&m_mutex);
+    m_textures.clear();
+    for (int i = 0; i < shapeTextureCount; i++) {
+        for (int j = 1; j < bucketCount; j++) {
+            QFile::remove(filePath(i, j));
+        }
+    }
+}
+
+QString ShapeTextureCache::filePath(int index, int bucket) const
+{
+    return m_directory + QStringLiteral("shape%1_%2.bin").arg(index).arg(bucketSize(bucket));
+}
+
+// Called from the worker thread.
+void ShapeTextureCache::load(int index, int bucket)
+{
+    const int size = bucketSize(bucket);
+    const QString path = filePath(index, bucket);
+    QByteArray data;
+
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+        quint32 magic, version, fileSize;
+        stream >> magic >> version >> fileSize >> data;
+        if (stream.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion
+            || fileSize != static_cast<quint32>(size) || data.size() != size * size * 4) {
+            data.clear();
+        }
+        file.close();
+    }
+
+    if (data.isEmpty()) {
+        data = generate(index, size);
+        if (!data.isEmpty() && QDir().mkpath(m_directory)) {
+            QSaveFile saveFile(path);
+            if (saveFile.open(QIODevice::WriteOnly)) {
+                QDataStream stream(&saveFile);
+                stream << cacheMagic << cacheVersion << static_cast<quint32>(size) << data;
+                saveFile.commit();
+            }
+        }
+    }
+
+    // On failure, the empty data makes the shapes stick to the baked textures.
+    const int key = index * bucketCount + bucket;
+    m_mutex.lock();
+    m_textures.insert(key, data);
+    m_pending.remove(key);
+    m_mutex.unlock();
+    if (!data.isEmpty()) {
+        QMetaObject::invokeMethod(this, "textureReady", Qt::QueuedConnection);
+    }
+}
+
+UT_NAMESPACE_END
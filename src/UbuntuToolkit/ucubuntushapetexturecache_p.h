@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UCUBUNTUSHAPETEXTURECACHE_P_H
+#define UCUBUNTUSHAPETEXTURECACHE_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+
+#include <UbuntuToolkit/ubuntutoolkitglobal.h>
+
+UT_NAMESPACE_BEGIN
+
+// Distance field shape textures generated at runtime. The textures baked in the library are 32x32,
+// bigger radii sample bigger textures so that the bevel and the shadows keep their details. A size
+// bucket is generated on a worker thread the first time it's requested and stored in the XDG cache
+// directory, shapes use the baked textures until it's ready.
+class UBUNTUTOOLKIT_EXPORT ShapeTextureCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Bucket 0 refers to the baked textures.
+    static const int bucketCount = 3;
+
+    static ShapeTextureCache* instance();
+    static quint8 bucket(float physicalRadius);
+    static int bucketSize(int bucket);
+
+    // Synchronously generates the RGBA data of the shape texture at the given index and size.
+    static QByteArray generate(int index, int size);
+
+    // Returns the RGBA data of the shape texture at the given index and bucket, or an empty array
+    // while it's being loaded or generated. Can be called from any thread.
+    QByteArray textureData(int index, int bucket);
+
+    // Drops the textures in memory and removes the ones stored on disk.
+    void clear();
+
+Q_SIGNALS:
+    // Emitted in the GUI thread when a requested texture is available.
+    void textureReady();
+
+private:
+    ShapeTextureCache();
+    void load(int index, int bucket);
+    QString filePath(int index, int bucket) const;
+
+    QMutex m_mutex;
+    QHash<int, QByteArray> m_textures;
+    QSet<int> m_pending;
+    QThreadPool m_threadPool;
+    QString m_directory;
+
+    friend class ShapeTextureJob;
+};
+
+UT_NAMESPACE_END
+
+#endif // UCUBUNTUSHAPETEXTURECACHE_P_H
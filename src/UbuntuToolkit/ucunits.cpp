@@ -168,7 +168,10 @@ void UCUnits::setGridUnit(float gridUnit)
         return;
     }
     m_gridUnit = gridUnit;
+    // resolved resources depend on the grid unit, the asset indexes don't
+    m_resourceCache.clear();
     Q_EMIT gridUnitChanged();
+    m_gridUnitNotifier.notify();
 }
 
 /*!
@@ -179,6 +182,7 @@ void UCUnits::setGridUnit(float gridUnit)
 // Density-independent pixels (and not physical pixels) because Qt sizes in terms of density-independent pixels.
 float UCUnits::dp(float value)
 {
+    m_gridUnitNotifier.capture();
     const float ratio = m_gridUnit / DEFAULT_GRID_UNIT_PX;
     if (value <= 2.0) {
         // for values under 2dp, return only multiples of the value
@@ -197,15 +201,49 @@ float UCUnits::dp(float value)
 
 float UCUnits::gu(float value)
 {
+    m_gridUnitNotifier.capture();
     return qRound(value * m_gridUnit) / m_devicePixelRatio;
 }
 
+/*
+ * Returns the resource to be used for the \a url at the current grid unit, in
+ * the form of "<scale factor>/<path>". Results are cached until the grid unit
+ * changes, as resolving hits the disk. Unresolved resources are not cached as
+ * the files may be created later on.
+ */
 QString UCUnits::resolveResource(const QUrl& url)
 {
     if (url.isEmpty()) {
         return QString();
     }
 
+    QHash<QUrl, QString>::const_iterator i = m_resourceCache.constFind(url);
+    if (i != m_resourceCache.constEnd()) {
+        return i.value();
+    }
+    const QString resolved = resolveResourceUncached(url);
+    if (!resolved.isEmpty()) {
+        m_resourceCache.insert(url, resolved);
+    }
+    return resolved;
+}
+
+/*
+ * Drops the resolved resources and the asset indexes, to be called when assets
+ * are added or removed at runtime.
+ */
+void UCUnits::clearResourceCache()
+{
+    m_resourceCache.clear();
+    m_assetIndexes.clear();
+}
+
+QString UCUnits::resolveResourceUncached(const QUrl& url)
+{
+    if (url.isEmpty()) {
+        return QString();
+    }
+
     QString path = QQmlFile::urlToLocalFileOrQrc(url);
 
     if (path.isEmpty()) {
@@ -249,15 +287,13 @@ QString UCUnits::resolveResource(const QUrl& url)
        file would be resource@14.png since it is above 10 and smaller
        than resource@18.png.
     */
-    QStringList nameFilters;
-    nameFilters << fileInfo.baseName() + "@[0-9]*" + suffix;
-    const QStringList files = fileInfo.dir().entryList(nameFilters, QDir::Files);
+    const QList<float> &gridUnits =
+        assetGridUnits(fileInfo.dir(), fileInfo.baseName(), fileInfo.completeSuffix());
 
-    if (!files.empty()) {
-        float selectedGridUnitSuffix = gridUnitSuffixFromFileName(files.first());
+    if (!gridUnits.empty()) {
+        float selectedGridUnitSuffix = gridUnits.first();
 
-        Q_FOREACH (const QString& fileName, files) {
-            float gridUnitSuffix = gridUnitSuffixFromFileName(fileName);
+        Q_FOREACH (float gridUnitSuffix, gridUnits) {
             if ((selectedGridUnitSuffix >= m_gridUnit && gridUnitSuffix >= m_gridUnit && gridUnitSuffix < selectedGridUnitSuffix)
                 || (selectedGridUnitSuffix < m_gridUnit && gridUnitSuffix > selectedGridUnitSuffix)) {
                 selectedGridUnitSuffix = gridUnitSuffix;
@@ -272,6 +308,40 @@ QString UCUnits::resolveResource(const QUrl& url)
     return QString();
 }
 
+/*
+ * Returns the grid units of the available baseName@<grid unit>.suffix assets
+ * in \a dir. The directory is listed once for all its assets, the result is
+ * kept in the directory's asset index until the directory is modified.
+ */
+const QList<float> &UCUnits::assetGridUnits(const QDir &dir, const QString &baseName, const QString &suffix)
+{
+    const QString dirPath = dir.absolutePath();
+    const QDateTime modified = QFileInfo(dirPath).lastModified();
+    QHash<QString, AssetIndex>::iterator i = m_assetIndexes.find(dirPath);
+    const bool listed = i != m_assetIndexes.end();
+    if (!listed) {
+        i = m_assetIndexes.insert(dirPath, AssetIndex());
+    }
+    AssetIndex &index = *i;
+    if (!listed || index.modified != modified) {
+        index.modified = modified;
+        index.gridUnits.clear();
+        const QStringList files = dir.entryList(QStringList(QStringLiteral("*@[0-9]*")), QDir::Files);
+        Q_FOREACH (const QString &fileName, files) {
+            // baseName@<grid unit>[anything].completeSuffix
+            const int at = fileName.indexOf('@');
+            const int dot = fileName.indexOf('.', at);
+            const QString key = fileName.left(at) + '/' + (dot < 0 ? QString() : fileName.mid(dot + 1));
+            index.gridUnits[key].append(gridUnitSuffixFromFileName(fileName));
+        }
+    }
+
+    static const QList<float> noGridUnits;
+    QHash<QString, QList<float> >::const_iterator gridUnits =
+        index.gridUnits.constFind(baseName + '/' + suffix);
+    return gridUnits != index.gridUnits.constEnd() ? gridUnits.value() : noGridUnits;
+}
+
 QString UCUnits::suffixForGridUnit(float gridUnit)
 {
     return "@" + QString::number(gridUnit);
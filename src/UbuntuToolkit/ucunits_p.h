@@ -19,6 +19,8 @@
 #ifndef UCUNITS_P_H
 #define UCUNITS_P_H
 
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
 #include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QString>
@@ -26,6 +28,7 @@
 #include <QtGui/QWindow>
 
 #include <UbuntuToolkit/ubuntutoolkitglobal.h>
+#include <UbuntuToolkit/private/listener_p.h>
 
 class QPlatformWindow;
 
@@ -54,6 +57,7 @@ public:
     Q_INVOKABLE float dp(float value);
     Q_INVOKABLE float gu(float value);
     QString resolveResource(const QUrl& url);
+    void clearResourceCache();
 
     // getters
     float gridUnit();
@@ -67,6 +71,8 @@ Q_SIGNALS:
 protected:
     QString suffixForGridUnit(float gridUnit);
     float gridUnitSuffixFromFileName(const QString &fileName);
+    QString resolveResourceUncached(const QUrl& url);
+    const QList<float> &assetGridUnits(const QDir &dir, const QString &baseName, const QString &suffix);
 
 private Q_SLOTS:
     void windowPropertyChanged(QPlatformWindow *window, const QString &propertyName);
@@ -74,7 +80,20 @@ private Q_SLOTS:
     void devicePixelRatioChanged(qreal dpi);
 
 private:
+    // index of the grid unit suffixed assets of a directory, maps base name
+    // and suffix (joined with '/') to the grid units available; the directory
+    // is listed again when modified
+    struct AssetIndex {
+        QDateTime modified;
+        QHash<QString, QList<float> > gridUnits;
+    };
+
     static UCUnits *m_units;
+    // resolved resources for the current grid unit
+    QHash<QUrl, QString> m_resourceCache;
+    QHash<QString, AssetIndex> m_assetIndexes;
+    // re-evaluates the bindings calling dp() and gu() when the grid unit changes
+    BindingNotifier m_gridUnitNotifier;
     float m_devicePixelRatio;
     QScreen *m_screen;
     float m_gridUnit;
@@ -14,6 +14,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include <QtCore/QAbstractItemModel>
 #include <QtQml/QQmlInfo>
 #include <QtQml/private/qqmlcomponentattached_p.h>
@@ -23,6 +25,8 @@
 
 #include "i18n_p.h"
 #include "privates/listitemdragarea_p.h"
+#include "privates/listitempool_p.h"
+#include "privates/listitemselection_p.h"
 #include "privates/listviewextensions_p.h"
 #include "propertychange_p.h"
 #include "quickutils_p.h"
@@ -107,10 +111,12 @@ UCViewItemsAttachedPrivate::UCViewItemsAttachedPrivate()
     : QObjectPrivate()
     , listView(0)
     , dragArea(0)
+    , pool(0)
     , expansionFlags(UCViewItemsAttached::Exclusive)
     , selectable(false)
     , draggable(false)
     , ready(false)
+    , dragUpdating(false)
 {
 }
 
@@ -129,6 +135,9 @@ void UCViewItemsAttachedPrivate::init()
         listView->view()->setActiveFocusOnTab(true);
         // filter ListView events to override up/down focus handling
         listView->overrideItemNavigation(true);
+        // selected and expanded indices follow the rows inserted and removed
+        QObject::connect(parent, SIGNAL(modelChanged()), q, SLOT(_q_attachToModel()));
+        _q_attachToModel();
     }
     // listen readyness
     QQmlComponentAttached *attached = QQmlComponent::qmlAttachedProperties(parent);
@@ -261,6 +270,9 @@ void UCViewItemsAttached::completed()
 {
     Q_D(UCViewItemsAttached);
     d->ready = true;
+    if (d->pool) {
+        d->pool->attachToModel();
+    }
     if (d->draggable) {
         d->enterDragMode();
     } else {
@@ -302,32 +314,59 @@ void UCViewItemsAttached::setSelectMode(bool value)
 QList<int> UCViewItemsAttached::selectedIndices() const
 {
     Q_D(const UCViewItemsAttached);
-    return d->selectedList.toList();
+    return d->selectedIndices;
 }
 void UCViewItemsAttached::setSelectedIndices(const QList<int> &list)
 {
     Q_D(UCViewItemsAttached);
-    if (d->selectedList.toList() == list) {
+    QVector<int> selectedList = list.toVector();
+    std::sort(selectedList.begin(), selectedList.end());
+    selectedList.erase(std::unique(selectedList.begin(), selectedList.end()), selectedList.end());
+    if (d->selectedList == selectedList) {
         return;
     }
-    d->selectedList = QSet<int>::fromList(list);
-    Q_EMIT selectedIndicesChanged(list);
+    d->selectedList = selectedList;
+    d->selectedListChanged();
+}
+
+// rebuilds the reported selected indices once per change
+void UCViewItemsAttachedPrivate::selectedListChanged()
+{
+    selectedIndices = selectedList.toList();
+    Q_EMIT q_func()->selectedIndicesChanged(selectedIndices);
+}
+
+// returns the position of the index in the selected list, or the position it
+// should be inserted at
+int UCViewItemsAttachedPrivate::selectedPosition(int index) const
+{
+    return std::lower_bound(selectedList.constBegin(), selectedList.constEnd(), index) - selectedList.constBegin();
+}
+
+bool UCViewItemsAttachedPrivate::isIndexSelected(int index) const
+{
+    int position = selectedPosition(index);
+    return position < selectedList.size() && selectedList.at(position) == index;
 }
 
 bool UCViewItemsAttachedPrivate::addSelectedItem(UCListItem *item)
 {
     int index = UCListItemPrivate::get(item)->index();
-    if (!selectedList.contains(index)) {
-        selectedList.insert(index);
-        Q_EMIT q_func()->selectedIndicesChanged(selectedList.toList());
+    int position = selectedPosition(index);
+    if (position == selectedList.size() || selectedList.at(position) != index) {
+        selectedList.insert(position, index);
+        selectedListChanged();
         return true;
     }
     return false;
 }
 bool UCViewItemsAttachedPrivate::removeSelectedItem(UCListItem *item)
 {
-    if (selectedList.remove(UCListItemPrivate::get(item)->index()) > 0) {
-        Q_EMIT q_func()->selectedIndicesChanged(selectedList.toList());
+    int index = UCListItemPrivate::get(item)->index();
+    int position = selectedPosition(index);
+    if (position < selectedList.size() && selectedList.at(position) == index) {
+        selectedList.remove(position);
+        selectedListChanged();
         return true;
     }
     return false;
@@ -335,7 +374,7 @@ bool UCViewItemsAttachedPrivate::removeSelectedItem(UCListItem *item)
 
 bool UCViewItemsAttachedPrivate::isItemSelected(UCListItem *item)
 {
-    return selectedList.contains(UCListItemPrivate::get(item)->index());
+    return isIndexSelected(UCListItemPrivate::get(item)->index());
 }
 
 /*!
@@ -532,40 +571,124 @@ bool UCViewItemsAttachedPrivate::isDragUpdatedConnected()
     return QObjectPrivate::get(q)->isSignalConnected(signalIdx);
 }
 
+// emits dragUpdated(), the rows the handlers move are not followed meanwhile
+void UCViewItemsAttachedPrivate::emitDragUpdated(UCDragEvent *event)
+{
+    Q_Q(UCViewItemsAttached);
+    dragUpdating = true;
+    Q_EMIT q->dragUpdated(event);
+    dragUpdating = false;
+}
+
 // updates the selected indices list in ViewAttached which is changed due to dragging
 void UCViewItemsAttachedPrivate::updateSelectedIndices(int fromIndex, int toIndex)
 {
-    if (selectedList.count() == listView->count()) {
+    if (fromIndex == toIndex || selectedList.count() == listView->count()) {
         // all indices selected, no need to reorder
         return;
     }
 
-    Q_Q(UCViewItemsAttached);
-    bool isFromSelected = selectedList.contains(fromIndex);
+    // The indices between fromIndex and toIndex shift by one towards fromIndex,
+    // being sorted, they form a single range in the selected list.
+    const bool forwards = fromIndex < toIndex;
+    const int first = forwards ? fromIndex + 1 : toIndex;
+    const int last = forwards ? toIndex : fromIndex - 1;
+    const int direction = forwards ? -1 : 1;
+    int begin = selectedPosition(first);
+    int end = selectedPosition(last + 1);
+
+    const int fromPosition = selectedPosition(fromIndex);
+    const bool isFromSelected = fromPosition < selectedList.size() && selectedList.at(fromPosition) == fromIndex;
+    if (!isFromSelected && begin == end) {
+        // nothing selected is moving
+        return;
+    }
+
+    int *data = selectedList.data();
+    for (int i = begin; i < end; i++) {
+        data[i] += direction;
+    }
     if (isFromSelected) {
-        selectedList.remove(fromIndex);
-        Q_EMIT q->selectedIndicesChanged(selectedList.toList());
-    }
-    // direction is -1 (forwards) or 1 (backwards)
-    int direction = (fromIndex < toIndex) ? -1 : 1;
-    int i = (direction < 0) ? fromIndex + 1 : fromIndex - 1;
-    // loop thru the selectedIndices and fix all indices
-    while (1) {
-        if (((direction < 0) && (i > toIndex)) ||
-            ((direction > 0) && (i < toIndex))) {
-            break;
+        // move fromIndex to toIndex, rotating the shifted range
+        if (forwards) {
+            std::rotate(data + fromPosition, data + fromPosition + 1, data + end);
+            data[end - 1] = toIndex;
+        } else {
+            std::rotate(data + begin, data + fromPosition, data + fromPosition + 1);
+            data[begin] = toIndex;
         }
+    }
+
+    selectedListChanged();
+}
 
-        if (selectedList.contains(i)) {
-            selectedList.remove(i);
-            selectedList.insert(i + direction);
-            Q_EMIT q->selectedIndicesChanged(selectedList.toList());
+// follows the rows of the ListView's model, moves are reported by the drag
+void UCViewItemsAttachedPrivate::_q_attachToModel()
+{
+    Q_Q(UCViewItemsAttached);
+    QAbstractItemModel *newModel =
+        qobject_cast<QAbstractItemModel*>(listView->model().value<QObject*>());
+    if (model.data() == newModel) {
+        return;
+    }
+    if (model) {
+        QObject::disconnect(model.data(), 0, q, 0);
+    }
+    model = newModel;
+    if (model) {
+        QObject::connect(model.data(), SIGNAL(rowsInserted(QModelIndex,int,int)),
+                         q, SLOT(_q_rowsInserted(QModelIndex,int,int)));
+        QObject::connect(model.data(), SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                         q, SLOT(_q_rowsRemoved(QModelIndex,int,int)));
+    }
+}
+
+void UCViewItemsAttachedPrivate::_q_rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (!parent.isValid()) {
+        shiftIndices(first, last - first + 1);
+    }
+}
+
+void UCViewItemsAttachedPrivate::_q_rowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (!parent.isValid()) {
+        shiftIndices(first, first - last - 1);
+    }
+}
+
+// shifts the selected and expanded indices from index on by count, a negative count
+// removing the indices of the removed rows
+void UCViewItemsAttachedPrivate::shiftIndices(int index, int count)
+{
+    if (dragUpdating) {
+        // the dragUpdated() handler moves rows, the drag shifts the indices once accepted
+        return;
+    }
+    Q_Q(UCViewItemsAttached);
+    const int begin = selectedPosition(index);
+    if (begin < selectedList.size()) {
+        if (count < 0) {
+            selectedList.remove(begin, selectedPosition(index - count) - begin);
         }
-        i -= direction;
+        int *data = selectedList.data();
+        for (int i = begin; i < selectedList.size(); i++) {
+            data[i] += count;
+        }
+        selectedListChanged();
     }
-    if (isFromSelected) {
-        selectedList.insert(toIndex);
-        Q_EMIT q->selectedIndicesChanged(selectedList.toList());
+
+    if (!expansionList.isEmpty() && expansionList.lastKey() >= index) {
+        QMap<int, QPointer<UCListItem> > shifted;
+        for (auto i = expansionList.constBegin(); i != expansionList.constEnd(); ++i) {
+            if (i.key() < index) {
+                shifted.insert(i.key(), i.value());
+            } else if (count > 0 || i.key() >= index - count) {
+                shifted.insert(i.key() + count, i.value());
+            }
+        }
+        expansionList.swap(shifted);
+        Q_EMIT q->expandedIndicesChanged(expansionList.keys());
     }
 }
 
@@ -696,4 +819,78 @@ void UCViewItemsAttachedPrivate::toggleExpansionFlags(bool enable)
     }
 }
 
+/*!
+ * \qmlattachedproperty int ViewItems::poolSize
+ * \since Ubuntu.Components 1.3
+ * The property configures how many ListItem delegates scrolled out of a ListView
+ * are kept alive to be reused when scrolling back to them, instead of being
+ * destroyed and created again. The kept items are reset to their initial state,
+ * they are not swiped, highlighted or pressed when shown again. Has effect only
+ * on ListViews with a model other than ObjectModel, and whose delegate is a
+ * ListItem. Defaults to 0, meaning the items scrolled out are destroyed.
+ * \qml
+ * import QtQuick 2.4
+ * import Ubuntu.Components 1.3
+ *
+ * ListView {
+ *     width: units.gu(40)
+ *     height: units.gu(70)
+ *     model: 1000
+ *     ViewItems.poolSize: 50
+ *     delegate: ListItem {
+ *         Label { text: "Item #" + index }
+ *     }
+ * }
+ * \endqml
+ */
+int UCViewItemsAttached::poolSize() const
+{
+    Q_D(const UCViewItemsAttached);
+    return d->pool ? d->pool->capacity() : 0;
+}
+void UCViewItemsAttached::setPoolSize(int size)
+{
+    Q_D(UCViewItemsAttached);
+    size = qMax(0, size);
+    if (poolSize() == size) {
+        return;
+    }
+    if (!d->listView) {
+        qmlWarning(parent()) << QStringLiteral("ListItem pooling requires ListView");
+        return;
+    }
+    if (size > 0 && !d->pool) {
+        d->pool = new ListItemPool(d->listView->view(), this);
+    }
+    if (d->pool) {
+        d->pool->setCapacity(size);
+    }
+    if (!size) {
+        // drop the parked items
+        delete d->pool;
+        d->pool = 0;
+    }
+    Q_EMIT poolSizeChanged();
+}
+
+// resets and hides the ListItem scrolled out of the view
+void UCViewItemsAttachedPrivate::parkItem(UCListItem *item)
+{
+    UCListItemPrivate::get(item)->park();
+    QQuickItemPrivate::get(item)->setCulled(true);
+}
+
+// re-syncs the parked ListItem the view shows again, its index may have changed meanwhile
+void UCViewItemsAttachedPrivate::reuseItem(UCListItem *item)
+{
+    UCListItemPrivate *listItem = UCListItemPrivate::get(item);
+    listItem->selection->updateSelected();
+    if (listItem->expansion) {
+        Q_EMIT listItem->expansion->expandedChanged();
+    }
+    // expanded items need the style
+    listItem->loadStyleItem(false);
+    listItem->update();
+}
+
 UT_NAMESPACE_END
@@ -18,8 +18,11 @@
 
 #include "unitythemeiconprovider_p.h"
 
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
 #include <QtCore/QSettings>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QtDebug>
@@ -35,17 +38,26 @@ public:
     // Returns the icon theme named @name, creating it if it didn't exist yet.
     static IconThemePointer get(const QString &name)
     {
-        static QHash<QString, IconThemePointer> themes;
-
-        IconThemePointer theme = themes[name];
+        IconThemePointer theme = themes()[name];
         if (theme.isNull()) {
             theme = IconThemePointer(new IconTheme(name));
-            themes[name] = theme;
+            themes()[name] = theme;
         }
 
         return theme;
     }
 
+    // Drops the loaded themes, and their index files if @removeIndexFiles is set.
+    static void clear(bool removeIndexFiles)
+    {
+        if (removeIndexFiles) {
+            Q_FOREACH(const IconThemePointer &theme, themes()) {
+                QFile::remove(theme->indexFilePath());
+            }
+        }
+        themes().clear();
+    }
+
     // Does a breadth-first search for an icon with any name in @names. Parent
     // themes are only looked at if the current theme doesn't contain any icon
     // in @names.
@@ -81,6 +93,34 @@ private:
         int size, minSize, maxSize, threshold;
     };
 
+    // An icon file found in one of the theme directories.
+    struct IconFile {
+        int directory;
+        QString filename;
+    };
+
+    // Modification time of a scanned path, -1 if it does not exist.
+    struct Stamp {
+        QString path;
+        qint64 mtime;
+    };
+
+    // Bump whenever the index file layout changes.
+    static const quint32 indexMagic = 0x55494958; // UIIX
+    static const quint32 indexVersion = 1;
+
+    static QHash<QString, IconThemePointer> &themes()
+    {
+        static QHash<QString, IconThemePointer> themes;
+        return themes;
+    }
+
+    static qint64 modificationTime(const QString &path)
+    {
+        QFileInfo info(path);
+        return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+    }
+
     IconTheme(const QString &name): name(name)
     {
         const QStringList paths = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
@@ -91,6 +131,29 @@ private:
                 baseDirs.append(dir.absolutePath());
         }
 
+        // The theme directories are listed once and their content is kept in
+        // an index, stored on disk and reused as long as the modification
+        // time of none of the listed directories changed.
+        QStringList inherits;
+        if (!loadIndex(&inherits)) {
+            stamps.clear();
+            directories.clear();
+            index.clear();
+            inherits.clear();
+            parseIndexTheme(&inherits);
+            buildIndex();
+            saveIndex(inherits);
+        }
+
+        Q_FOREACH(const QString &name, inherits) {
+            if (name != QLatin1String("hicolor")) {
+                parents.append(IconTheme::get(name));
+            }
+        }
+    }
+
+    void parseIndexTheme(QStringList *inherits)
+    {
         Q_FOREACH(const QString &baseDir, baseDirs) {
             QString filename = baseDir + "/index.theme";
             if (QFileInfo::exists(filename)) {
@@ -110,13 +173,7 @@ private:
                     directories.append(dir);
                 }
 
-                const QStringList themeInherits =
-                    settings.value(QStringLiteral("Icon Theme/Inherits")).toStringList();
-                Q_FOREACH(const QString &name, themeInherits) {
-                    if (name != QLatin1String("hicolor")) {
-                        parents.append(IconTheme::get(name));
-                    }
-                }
+                *inherits = settings.value(QStringLiteral("Icon Theme/Inherits")).toStringList();
 
                 // there can only be one index.theme
                 break;
@@ -124,6 +181,131 @@ private:
         }
     }
 
+    // Lists every theme directory in every base directory. For a given theme
+    // directory the first base directory containing an icon wins, PNG files
+    // being preferred over SVG ones.
+    void buildIndex()
+    {
+        static const QStringList pngFilter(QStringLiteral("*.png"));
+        static const QStringList svgFilter(QStringLiteral("*.svg"));
+
+        Q_FOREACH(const QString &baseDir, baseDirs) {
+            QString filename = baseDir + "/index.theme";
+            stamps.append({filename, modificationTime(filename)});
+        }
+
+        for (int i = 0; i < directories.size(); i++) {
+            Q_FOREACH(const QString &baseDir, baseDirs) {
+                QString path = baseDir + "/" + directories[i].path;
+                stamps.append({path, modificationTime(path)});
+                QDir dir(path);
+                if (!dir.exists())
+                    continue;
+                Q_FOREACH(const QStringList &filter, QList<QStringList>() << pngFilter << svgFilter) {
+                    Q_FOREACH(const QString &file, dir.entryList(filter, QDir::Files)) {
+                        QVector<IconFile> &files = index[file.left(file.size() - 4)];
+                        if (files.isEmpty() || files.last().directory != i)
+                            files.append({i, path + "/" + file});
+                    }
+                }
+            }
+        }
+    }
+
+    QString indexFilePath() const
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QStringLiteral("/ubuntu-ui-toolkit/icons/") + name + QStringLiteral(".index");
+    }
+
+    bool loadIndex(QStringList *inherits)
+    {
+        QFile file(indexFilePath());
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        uchar *data = file.map(0, file.size());
+        if (!data)
+            return false;
+
+        QDataStream stream(QByteArray::fromRawData(reinterpret_cast<const char*>(data), file.size()));
+        quint32 magic, version;
+        QStringList indexBaseDirs;
+        stream >> magic >> version;
+        if (magic != indexMagic || version != indexVersion)
+            return false;
+        stream >> indexBaseDirs;
+        if (indexBaseDirs != baseDirs)
+            return false;
+
+        quint32 count;
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+            Stamp stamp;
+            stream >> stamp.path >> stamp.mtime;
+            if (modificationTime(stamp.path) != stamp.mtime)
+                return false;
+            stamps.append(stamp);
+        }
+
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+            Directory dir;
+            qint32 sizeType;
+            stream >> dir.path >> sizeType >> dir.size >> dir.minSize >> dir.maxSize >> dir.threshold;
+            dir.sizeType = static_cast<SizeType>(sizeType);
+            directories.append(dir);
+        }
+
+        stream >> *inherits >> count;
+        index.reserve(count);
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+            QString name;
+            quint32 fileCount;
+            stream >> name >> fileCount;
+            if (stream.status() != QDataStream::Ok || fileCount > quint32(directories.size()))
+                return false;
+            QVector<IconFile> &files = index[name];
+            files.resize(fileCount);
+            for (quint32 j = 0; j < fileCount; j++) {
+                stream >> files[j].directory >> files[j].filename;
+                if (files[j].directory < 0 || files[j].directory >= directories.size())
+                    return false;
+            }
+        }
+
+        return stream.status() == QDataStream::Ok;
+    }
+
+    void saveIndex(const QStringList &inherits)
+    {
+        const QString path = indexFilePath();
+        if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+            return;
+
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+
+        QDataStream stream(&file);
+        stream << indexMagic << indexVersion << baseDirs;
+        stream << quint32(stamps.size());
+        Q_FOREACH(const Stamp &stamp, stamps) {
+            stream << stamp.path << stamp.mtime;
+        }
+        stream << quint32(directories.size());
+        Q_FOREACH(const Directory &dir, directories) {
+            stream << dir.path << qint32(dir.sizeType) << dir.size << dir.minSize << dir.maxSize << dir.threshold;
+        }
+        stream << inherits << quint32(index.size());
+        for (QHash<QString, QVector<IconFile> >::const_iterator i = index.constBegin(); i != index.constEnd(); ++i) {
+            stream << i.key() << quint32(i->size());
+            Q_FOREACH(const IconFile &icon, *i) {
+                stream << icon.directory << icon.filename;
+            }
+        }
+        file.commit();
+    }
+
     SizeType sizeTypeFromString(const QString &string)
     {
         if (string == QLatin1String("Fixed"))
@@ -173,24 +355,6 @@ private:
         }
     }
 
-    QString lookupIconFile(const QString &dir, const QString &name)
-    {
-        QString png = QStringLiteral("%1/%2.png").arg(dir, name);
-        QString svg = QStringLiteral("%1/%2.svg").arg(dir, name);
-
-        Q_FOREACH(const QString &baseDir, baseDirs) {
-            QString filename = baseDir + "/" + png;
-            if (QFileInfo::exists(filename))
-                return filename;
-
-            filename = baseDir + "/" + svg;
-            if (QFileInfo::exists(filename))
-                return filename;
-        }
-
-        return QString();
-    }
-
     QImage lookupIcon(const QString &iconName, QSize *impsize, const QSize &size)
     {
         const int iconSize = qMax(size.width(), size.height());
@@ -205,20 +369,17 @@ private:
         int minDistance = 10000;
         QString bestFilename;
 
-        Q_FOREACH(const Directory &dir, directories) {
-            int dist = directorySizeDistance(dir, size);
+        Q_FOREACH(const IconFile &icon, index.value(iconName)) {
+            int dist = directorySizeDistance(directories[icon.directory], size);
             if (dist >= minDistance)
                 continue;
 
-            QString filename = lookupIconFile(dir.path, iconName);
-            if (!filename.isNull()) {
-                minDistance = dist;
-                bestFilename = filename;
+            minDistance = dist;
+            bestFilename = icon.filename;
 
-                // bail out early if we can't get a better size match
-                if (minDistance == 0)
-                    break;
-            }
+            // bail out early if we can't get a better size match
+            if (minDistance == 0)
+                break;
         }
 
         if (!bestFilename.isNull())
@@ -232,16 +393,14 @@ private:
         int maxSize = 0;
         QString bestFilename;
 
-        Q_FOREACH(const Directory &dir, directories) {
+        Q_FOREACH(const IconFile &icon, index.value(iconName)) {
+            const Directory &dir = directories[icon.directory];
             int size = dir.sizeType == Scalable ? dir.maxSize : dir.size;
             if (size < maxSize)
                 continue;
 
-            QString filename = lookupIconFile(dir.path, iconName);
-            if (!filename.isNull()) {
-                maxSize = size;
-                bestFilename = filename;
-            }
+            maxSize = size;
+            bestFilename = icon.filename;
         }
 
         if (!bestFilename.isNull())
@@ -272,6 +431,9 @@ private:
     QStringList baseDirs;
     QList<Directory> directories;
     QList<IconThemePointer> parents;
+    QList<Stamp> stamps;
+    // icon name -> files, ordered by directory
+    QHash<QString, QVector<IconFile> > index;
 };
 
 UnityThemeIconProvider::UnityThemeIconProvider(const QString &themeName):
@@ -296,4 +458,9 @@ QImage UnityThemeIconProvider::requestImage(const QString &id, QSize *size, cons
     return image;
 }
 
+void UnityThemeIconProvider::clearThemes(bool removeIndexFiles)
+{
+    IconTheme::clear(removeIndexFiles);
+}
+
 UT_NAMESPACE_END
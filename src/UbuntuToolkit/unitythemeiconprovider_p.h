@@ -32,6 +32,9 @@ public:
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
 
 private:
+    // drops the loaded themes, so that their index is loaded again
+    static void clearThemes(bool removeIndexFiles);
+
     QSharedPointer<class IconTheme> theme;
 };
 
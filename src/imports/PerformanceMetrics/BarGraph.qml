@@ -39,9 +39,9 @@ Item {
         color: Qt.rgba(0.0, 0.0, 0.0, 0.8)
     }
 
-    PerformanceMetrics.TextureFromImage {
+    PerformanceMetrics.GraphTexture {
         id: texture
-        image: graph.model.image
+        model: graph.model
     }
 
     ShaderEffect {
@@ -5,6 +5,7 @@ SOURCES += \
     $$PWD/upmplugin.cpp \
     $$PWD/upmgraphmodel.cpp \
     $$PWD/upmtexturefromimage.cpp \
+    $$PWD/upmgraphtexture.cpp \
     $$PWD/upmrenderingtimes.cpp \
     $$PWD/upmcpuusage.cpp \
     $$PWD/rendertimer.cpp
@@ -13,6 +14,7 @@ HEADERS += \
     $$PWD/upmplugin.h \
     $$PWD/upmgraphmodel.h \
     $$PWD/upmtexturefromimage.h \
+    $$PWD/upmgraphtexture.h \
     $$PWD/upmrenderingtimes.h \
     $$PWD/upmcpuusage.h \
     $$PWD/rendertimer.h
@@ -22,6 +22,7 @@
 
 UPMGraphModel::UPMGraphModel(QObject *parent) :
     QObject(parent),
+    m_writtenColumns(0),
     m_shift(0),
     m_samples(100),
     m_currentValue(0)
@@ -32,9 +33,8 @@ UPMGraphModel::UPMGraphModel(QObject *parent) :
 
 void UPMGraphModel::appendValue(int width, int value)
 {
-    /* FIXME: modifying m_image here implicitly triggers a deep copy
-       of its data because UCTextureFromImage usually holds a reference
-       to that image
+    /* Modifying m_image triggers a deep copy of its data if a reference to it
+       is held, GraphTexture only reads the new columns while synchronizing.
     */
     width = qMax(1, width);
     QRgb* line = (QRgb*)m_image.scanLine(0);
@@ -50,6 +50,7 @@ void UPMGraphModel::appendValue(int width, int value)
         memset(&line[m_shift], value, width * 4);
     }
     m_shift = (m_shift + width) % m_samples;
+    m_writtenColumns += width;
     m_currentValue = value;
 
     Q_EMIT imageChanged();
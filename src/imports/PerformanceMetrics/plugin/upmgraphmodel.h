@@ -36,6 +36,9 @@ public:
 
     void appendValue(int width, int value);
 
+    // Number of columns written since the creation of the model, the last ones end at shift.
+    qint64 writtenColumns() const { return m_writtenColumns; }
+
     // getters
     QImage image() const;
     int shift() const;
@@ -53,6 +56,7 @@ Q_SIGNALS:
 
 private:
     QImage m_image;
+    qint64 m_writtenColumns;
     int m_shift;
     int m_samples;
     int m_currentValue;
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "upmgraphtexture.h"
+#include "upmgraphmodel.h"
+
+#include <QtCore/QRunnable>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+#include <QtQuick/QQuickWindow>
+
+UPMRingTexture::UPMRingTexture() :
+    QSGTexture(),
+    m_front(0),
+    m_uploadPending(false),
+    m_stagedColumns(0),
+    m_stagedShift(0)
+{
+    m_textureIds[0] = m_textureIds[1] = 0;
+    m_uploadedColumns[0] = m_uploadedColumns[1] = -1;
+    // The graph is scrolled by shifting the texture coordinates.
+    setHorizontalWrapMode(QSGTexture::Repeat);
+}
+
+UPMRingTexture::~UPMRingTexture()
+{
+    // Without a context, the textures went away with the context.
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    if (context != NULL) {
+        for (int i = 0; i < 2; i++) {
+            if (m_textureIds[i] != 0) {
+                context->functions()->glDeleteTextures(1, &m_textureIds[i]);
+            }
+        }
+    }
+}
+
+void UPMRingTexture::sync(const UPMGraphModel* model)
+{
+    if (model == NULL) {
+        return;
+    }
+    const QImage image = model->image();
+    const int width = image.width();
+    const qint64 writtenColumns = model->writtenColumns();
+    if (width <= 0) {
+        return;
+    }
+    if (width != m_staging.size()) {
+        m_staging.resize(width);
+        m_uploadedColumns[0] = m_uploadedColumns[1] = -1;
+    } else if (writtenColumns == m_stagedColumns) {
+        return;
+    }
+
+    // Copy the columns missed by the most outdated buffer, they end at the shift.
+    const qint64 oldestColumns = qMin(m_uploadedColumns[0], m_uploadedColumns[1]);
+    const int count = oldestColumns < 0
+        ? width : static_cast<int>(qMin<qint64>(width, writtenColumns - oldestColumns));
+    const int shift = model->shift();
+    const int start = (shift - count + width) % width;
+    const int firstCount = qMin(count, width - start);
+    const quint32* line = reinterpret_cast<const quint32*>(image.constScanLine(0));
+    memcpy(m_staging.data() + start, line + start, firstCount * sizeof(quint32));
+    memcpy(m_staging.data(), line, (count - firstCount) * sizeof(quint32));
+
+    m_stagedColumns = writtenColumns;
+    m_stagedShift = shift;
+    m_uploadPending = true;
+}
+
+int UPMRingTexture::textureId() const
+{
+    return m_textureIds[m_front];
+}
+
+QSize UPMRingTexture::textureSize() const
+{
+    return QSize(m_staging.size(), 1);
+}
+
+bool UPMRingTexture::hasAlphaChannel() const
+{
+    return false;
+}
+
+bool UPMRingTexture::hasMipmaps() const
+{
+    return false;
+}
+
+void UPMRingTexture::bind()
+{
+    // The buffer used by the previous frame is left alone, the other one is brought up to date
+    // and becomes the front buffer.
+    if (m_uploadPending) {
+        const int back = 1 - m_front;
+        if (m_uploadedColumns[back] != m_stagedColumns) {
+            upload(back);
+            m_front = back;
+        }
+        m_uploadPending = false;
+    }
+
+    QOpenGLContext::currentContext()->functions()->glBindTexture(
+        GL_TEXTURE_2D, m_textureIds[m_front]);
+    updateBindOptions(true);
+}
+
+void UPMRingTexture::upload(int buffer)
+{
+    QOpenGLFunctions* functions = QOpenGLContext::currentContext()->functions();
+    const int width = m_staging.size();
+
+    // The pixels of a column have all their components set to the value, the component order
+    // doesn't matter.
+    if (m_uploadedColumns[buffer] < 0) {
+        if (m_textureIds[buffer] == 0) {
+            functions->glGenTextures(1, &m_textureIds[buffer]);
+        }
+        functions->glBindTexture(GL_TEXTURE_2D, m_textureIds[buffer]);
+        functions->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, 1, 0, GL_RGBA,
+                                GL_UNSIGNED_BYTE, m_staging.constData());
+    } else {
+        const int count = static_cast<int>(
+            qMin<qint64>(width, m_stagedColumns - m_uploadedColumns[buffer]));
+        const int start = (m_stagedShift - count + width) % width;
+        const int firstCount = qMin(count, width - start);
+        functions->glBindTexture(GL_TEXTURE_2D, m_textureIds[buffer]);
+        functions->glTexSubImage2D(GL_TEXTURE_2D, 0, start, 0, firstCount, 1, GL_RGBA,
+                                   GL_UNSIGNED_BYTE, m_staging.constData() + start);
+        if (count > firstCount) {
+            functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, count - firstCount, 1, GL_RGBA,
+                                       GL_UNSIGNED_BYTE, m_staging.constData());
+        }
+    }
+    m_uploadedColumns[buffer] = m_stagedColumns;
+}
+
+
+// Deletes the texture provider in the render thread, or right away if the window can't render.
+class UPMGraphTextureCleanup : public QRunnable
+{
+public:
+    explicit UPMGraphTextureCleanup(UPMGraphTextureProvider* provider) : m_provider(provider) {}
+    ~UPMGraphTextureCleanup() { delete m_provider; }
+    void run() override {}
+
+private:
+    UPMGraphTextureProvider* m_provider;
+};
+
+UPMGraphTexture::UPMGraphTexture(QQuickItem* parent) :
+    QQuickItem(parent),
+    m_textureProvider(NULL)
+{
+    setFlag(QQuickItem::ItemHasContents);
+}
+
+UPMGraphTexture::~UPMGraphTexture()
+{
+    if (window() != NULL) {
+        releaseResources();
+    } else {
+        delete m_textureProvider;
+    }
+}
+
+bool UPMGraphTexture::isTextureProvider() const
+{
+    return true;
+}
+
+QSGTextureProvider* UPMGraphTexture::textureProvider() const
+{
+    if (m_textureProvider == NULL) {
+        const_cast<UPMGraphTexture*>(this)->m_textureProvider = new UPMGraphTextureProvider;
+        m_textureProvider->ringTexture()->sync(m_model.data());
+    }
+    return m_textureProvider;
+}
+
+QSGNode* UPMGraphTexture::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* updatePaintNodeData)
+{
+    Q_UNUSED(oldNode)
+    Q_UNUSED(updatePaintNodeData)
+
+    if (m_textureProvider != NULL) {
+        m_textureProvider->ringTexture()->sync(m_model.data());
+    }
+    return NULL;
+}
+
+void UPMGraphTexture::releaseResources()
+{
+    if (m_textureProvider != NULL) {
+        window()->scheduleRenderJob(new UPMGraphTextureCleanup(m_textureProvider),
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+            QQuickWindow::NoStage);
+#else
+            QQuickWindow::BeforeSynchronizingStage);
+        window()->update();  // Wake up the render loop.
+#endif
+        m_textureProvider = NULL;
+    }
+}
+
+UPMGraphModel* UPMGraphTexture::model() const
+{
+    return m_model.data();
+}
+
+void UPMGraphTexture::setModel(UPMGraphModel* model)
+{
+    if (model != m_model) {
+        if (m_model != NULL) {
+            QObject::disconnect(m_model.data(), 0, this, 0);
+        }
+        m_model = model;
+        if (m_model != NULL) {
+            QObject::connect(m_model.data(), &UPMGraphModel::shiftChanged,
+                             this, &QQuickItem::update);
+            QObject::connect(m_model.data(), &UPMGraphModel::samplesChanged,
+                             this, &QQuickItem::update);
+        }
+        Q_EMIT modelChanged();
+        update();
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPMGRAPHTEXTURE_H
+#define UPMGRAPHTEXTURE_H
+
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+#include <QtGui/qopengl.h>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QSGTexture>
+#include <QtQuick/QSGTextureProvider>
+
+class UPMGraphModel;
+
+/* Texture of the ring buffer of a graph model. Only the columns written since the last upload
+   are copied while synchronizing and uploaded at the next bind. The texture is double-buffered
+   so that a new column isn't uploaded to the texture used by the frame being rendered, each
+   buffer catches up on the columns it missed when it's updated.
+*/
+class UPMRingTexture : public QSGTexture
+{
+    Q_OBJECT
+
+public:
+    UPMRingTexture();
+    ~UPMRingTexture();
+
+    // Called in the render thread while synchronizing.
+    void sync(const UPMGraphModel* model);
+
+    int textureId() const override;
+    QSize textureSize() const override;
+    bool hasAlphaChannel() const override;
+    bool hasMipmaps() const override;
+    void bind() override;
+
+private:
+    void upload(int buffer);
+
+    GLuint m_textureIds[2];
+    // Written columns of the model at the last upload of each buffer, -1 if it must be
+    // allocated.
+    qint64 m_uploadedColumns[2];
+    int m_front;
+    bool m_uploadPending;
+
+    // Copy of the ring buffer of the model, only the columns to upload are up to date.
+    QVector<quint32> m_staging;
+    qint64 m_stagedColumns;
+    int m_stagedShift;
+};
+
+class UPMGraphTextureProvider : public QSGTextureProvider
+{
+    Q_OBJECT
+
+public:
+    UPMGraphTextureProvider() : m_texture(new UPMRingTexture) {}
+    ~UPMGraphTextureProvider() { delete m_texture; }
+    QSGTexture* texture() const override { return m_texture; }
+    UPMRingTexture* ringTexture() const { return m_texture; }
+
+private:
+    UPMRingTexture* m_texture;
+};
+
+class UPMGraphTexture : public QQuickItem
+{
+    Q_OBJECT
+
+    Q_PROPERTY(UPMGraphModel* model READ model WRITE setModel NOTIFY modelChanged)
+
+public:
+    explicit UPMGraphTexture(QQuickItem* parent = 0);
+    virtual ~UPMGraphTexture();
+    bool isTextureProvider() const override;
+    QSGTextureProvider* textureProvider() const override;
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* updatePaintNodeData) override;
+
+    // getter
+    UPMGraphModel* model() const;
+
+    // setter
+    void setModel(UPMGraphModel* model);
+
+Q_SIGNALS:
+    void modelChanged();
+
+protected:
+    void releaseResources() override;
+
+private:
+    QPointer<UPMGraphModel> m_model;
+    UPMGraphTextureProvider* m_textureProvider;
+};
+
+#endif // UPMGRAPHTEXTURE_H
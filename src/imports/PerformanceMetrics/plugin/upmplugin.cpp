@@ -24,6 +24,7 @@
 
 #include "upmcpuusage.h"
 #include "upmtexturefromimage.h"
+#include "upmgraphtexture.h"
 #include "upmgraphmodel.h"
 #include "upmrenderingtimes.h"
 
@@ -32,6 +33,7 @@ void UbuntuPerformanceMetricsPlugin::registerTypeVersion(const char *uri, int ma
     qmlRegisterType<UPMRenderingTimes>(uri, major, minor, "RenderingTimes");
     qmlRegisterType<UPMCpuUsage>(uri, major, minor, "CpuUsage");
     qmlRegisterType<UPMTextureFromImage>(uri, major, minor, "TextureFromImage");
+    qmlRegisterType<UPMGraphTexture>(uri, major, minor, "GraphTexture");
     qmlRegisterType<UPMGraphModel>();
 }
 
@@ -17,7 +17,10 @@
  */
 
 #include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QString>
+#include <QtCore/QTemporaryDir>
 #include <QtCore/QTextCodec>
 #include <QtCore/QTimeZone>
 #include <QtQml/QQmlEngine>
@@ -28,6 +31,7 @@
 #include <UbuntuToolkit/private/alarmmanager_p_p.h>
 #include <UbuntuToolkit/private/ucalarmmodel_p.h>
 #include <UbuntuToolkit/private/alarmsadapter_p.h>
+#include <UbuntuToolkit/private/alarmjournal_p.h>
 
 #include "uctestcase.h"
 
@@ -89,6 +93,19 @@ private:
         cancelSpy->clear();
     }
 
+    static AlarmRecord journalRecord(quint32 key, const QString &message)
+    {
+        AlarmRecord record;
+        record.key = key;
+        record.message = message;
+        record.date = QDateTime(QDate(2017, 5, 4), QTime(8, 30));
+        record.sound = QStringLiteral("file:///usr/share/sounds/ubuntu/ringtones/Marimbach.ogg");
+        record.type = UCAlarm::Repeating;
+        record.days = UCAlarm::Monday | UCAlarm::Friday;
+        record.enabled = true;
+        return record;
+    }
+
     bool containsAlarm(UCAlarm *alarm, bool trace = false)
     {
         for (int i = 0; i < AlarmManager::instance().alarmCount(); i++) {
@@ -115,6 +132,8 @@ private Q_SLOTS:
         UbuntuToolkitModule::initializeContextProperties(engine);
 
         AlarmManager::instance();
+        // the fallback manager loads the stored alarms asynchronously
+        QTRY_VERIFY(AlarmManager::instance().loadTime() >= 0);
 
         // connect alarmUpdated() and alarmMoveFinished to the test signal so we get either of those on alarm updates
 
@@ -588,6 +607,235 @@ private Q_SLOTS:
         // check the tags
         QVERIFY(AlarmManager::instance().verifyChange(&alarm, AlarmManager::Enabled, enabled));
     }
+
+    void test_model_loadTime()
+    {
+        UCAlarmModel model;
+        QVERIFY(model.loadTime() >= 0);
+    }
+
+    void test_model_refresh_keeps_rows()
+    {
+        UCAlarmModel model;
+        QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+        QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy removeSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+        QSignalSpy changeSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+        const int count = model.rowCount(QModelIndex());
+        QVERIFY(count > 0);
+
+        syncFetch();
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(insertSpy.count(), 0);
+        QCOMPARE(removeSpy.count(), 0);
+        // the alarm objects are recreated
+        QCOMPARE(changeSpy.count(), 1);
+        QCOMPARE(model.rowCount(QModelIndex()), count);
+        for (int i = 0; i < count; i++) {
+            QCOMPARE(model.data(model.index(i), 0).toString(),
+                     AlarmManager::instance().alarmAt(i)->message());
+        }
+    }
+
+    // Alarms removed, inserted and reordered while the model doesn't follow the individual
+    // changes are notified by the refresh as row removals, insertions and moves.
+    void test_model_refresh_diff()
+    {
+        const QDateTime date = QDateTime::currentDateTime().addDays(2);
+        QList<QSharedPointer<UCAlarm> > alarms;
+        for (int i = 0; i < 6; i++) {
+            alarms.append(QSharedPointer<UCAlarm>(new UCAlarm(
+                date.addSecs(3600 * i), QStringLiteral("test_model_refresh_diff_%1").arg(i))));
+            alarms.last()->save();
+            waitForInsert();
+        }
+
+        UCAlarmModel model;
+        QObject::disconnect(&AlarmManager::instance(), 0, &model, 0);
+        QObject::connect(&AlarmManager::instance(), SIGNAL(alarmsRefreshed()),
+                         &model, SLOT(refreshEnd()), Qt::DirectConnection);
+
+        // the rows as seen by a view, updated from the change notifications only
+        QStringList rows;
+        for (int i = 0; i < model.rowCount(QModelIndex()); i++) {
+            rows.append(model.data(model.index(i), 0).toString());
+        }
+        connect(&model, &QAbstractItemModel::rowsRemoved,
+                [&rows](const QModelIndex &, int first, int last) {
+            rows.erase(rows.begin() + first, rows.begin() + last + 1);
+        });
+        connect(&model, &QAbstractItemModel::rowsInserted,
+                [&rows, &model](const QModelIndex &, int first, int last) {
+            for (int i = first; i <= last; i++) {
+                rows.insert(i, model.data(model.index(i), 0).toString());
+            }
+        });
+        connect(&model, &QAbstractItemModel::rowsMoved,
+                [&rows](const QModelIndex &, int start, int end, const QModelIndex &, int row) {
+            QStringList moved = rows.mid(start, end - start + 1);
+            rows.erase(rows.begin() + start, rows.begin() + end + 1);
+            const int to = row > end ? row - moved.count() : row;
+            for (int i = 0; i < moved.count(); i++) {
+                rows.insert(to + i, moved[i]);
+            }
+        });
+        QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+        QSignalSpy removeSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+        QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy moveSpy(&model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+        QSignalSpy countSpy(&model, SIGNAL(countChanged()));
+
+        // removals
+        alarms[1]->cancel();
+        waitForRemove();
+        alarms[3]->cancel();
+        waitForRemove();
+        // insertions, one between the remaining alarms and two adjacent ones at the end
+        for (int i = 0; i < 3; i++) {
+            const int hours = i == 0 ? 1 : 10 + i;
+            alarms.append(QSharedPointer<UCAlarm>(new UCAlarm(
+                date.addSecs(3600 * hours + 60),
+                QStringLiteral("test_model_refresh_diff_new%1").arg(i))));
+            alarms.last()->save();
+            waitForInsert();
+        }
+        // reorder, the last alarm goes first and the first one after the fourth
+        alarms[5]->setDate(date.addSecs(-3600));
+        alarms[5]->save();
+        waitForUpdate();
+        alarms[0]->setDate(date.addSecs(3600 * 4 + 60));
+        alarms[0]->save();
+        waitForUpdate();
+        QCOMPARE(removeSpy.count() + insertSpy.count() + moveSpy.count(), 0);
+
+        syncFetch();
+        QCOMPARE(resetSpy.count(), 0);
+        QVERIFY(removeSpy.count() > 0);
+        QVERIFY(insertSpy.count() > 0);
+        QVERIFY(moveSpy.count() > 0);
+        // only the two reordered alarms are moved, the others stay in order
+        QVERIFY(moveSpy.count() <= 2);
+        QCOMPARE(countSpy.count(), 1);
+
+        QStringList expected;
+        for (int i = 0; i < AlarmManager::instance().alarmCount(); i++) {
+            expected.append(AlarmManager::instance().alarmAt(i)->message());
+        }
+        QCOMPARE(rows, expected);
+        QCOMPARE(model.rowCount(QModelIndex()), expected.count());
+        for (int i = 0; i < expected.count(); i++) {
+            QCOMPARE(model.data(model.index(i), 0).toString(), expected[i]);
+        }
+    }
+
+    void test_journal_round_trip()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QStringLiteral("/alarms.journal");
+        AlarmJournal journal(fileName);
+        QVERIFY(!journal.exists());
+        QVERIFY(journal.load().isEmpty());
+
+        const quint32 first = journal.takeKey();
+        const quint32 second = journal.takeKey();
+        QVERIFY(journal.put(journalRecord(first, "first")));
+        QVERIFY(journal.put(journalRecord(second, "second")));
+        AlarmRecord changed = journalRecord(first, "changed");
+        changed.enabled = false;
+        changed.type = UCAlarm::OneTime;
+        QVERIFY(journal.put(changed));
+        QVERIFY(journal.remove(second));
+        QCOMPARE(journal.recordCount(), 4);
+
+        AlarmJournal reloaded(fileName);
+        const QVector<AlarmRecord> records = reloaded.load();
+        QCOMPARE(records.count(), 1);
+        QCOMPARE(records[0].key, first);
+        QCOMPARE(records[0].message, QStringLiteral("changed"));
+        QCOMPARE(records[0].date, changed.date);
+        QCOMPARE(records[0].sound, changed.sound);
+        QCOMPARE(records[0].type, static_cast<qint32>(UCAlarm::OneTime));
+        QCOMPARE(records[0].days, changed.days);
+        QCOMPARE(records[0].enabled, false);
+        QCOMPARE(reloaded.recordCount(), 4);
+        // removed keys are not reused
+        QVERIFY(reloaded.takeKey() > second);
+    }
+
+    void test_journal_damaged_tail()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QStringLiteral("/alarms.journal");
+        AlarmJournal journal(fileName);
+        QVERIFY(journal.put(journalRecord(1, "first")));
+        QVERIFY(journal.put(journalRecord(2, "second")));
+
+        // cut the last record as an interrupted write would do
+        QFile file(fileName);
+        QVERIFY(file.resize(file.size() - 3));
+
+        AlarmJournal reloaded(fileName);
+        QVector<AlarmRecord> records = reloaded.load();
+        QCOMPARE(records.count(), 1);
+        QCOMPARE(records[0].message, QStringLiteral("first"));
+
+        // the damaged tail is replaced by the next record
+        QVERIFY(reloaded.put(journalRecord(3, "third")));
+        records = AlarmJournal(fileName).load();
+        QCOMPARE(records.count(), 2);
+        QCOMPARE(records[1].message, QStringLiteral("third"));
+
+        // a corrupted payload ends the journal too
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.seek(file.size() - 4));
+        QVERIFY(file.putChar('x'));
+        file.close();
+        records = AlarmJournal(fileName).load();
+        QCOMPARE(records.count(), 1);
+        QCOMPARE(records[0].message, QStringLiteral("first"));
+    }
+
+    void test_journal_compaction()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QStringLiteral("/alarms.journal");
+        AlarmJournal journal(fileName);
+        const int updates = AlarmJournal::compactionSlack + 3;
+        for (int i = 0; i < updates; i++) {
+            QVERIFY(journal.put(journalRecord(1, QString::number(i))));
+        }
+        QVERIFY(journal.needsCompaction(1));
+
+        const qint64 size = QFileInfo(fileName).size();
+        QVERIFY(journal.compact(AlarmJournal(fileName).load()));
+        QCOMPARE(journal.recordCount(), 1);
+        QVERIFY(!journal.needsCompaction(1));
+        QVERIFY(QFileInfo(fileName).size() < size / (updates / 2));
+
+        const QVector<AlarmRecord> records = AlarmJournal(fileName).load();
+        QCOMPARE(records.count(), 1);
+        QCOMPARE(records[0].message, QString::number(updates - 1));
+    }
+
+    void benchmark_journal_load()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QStringLiteral("/alarms.journal");
+        AlarmJournal journal(fileName);
+        QVector<AlarmRecord> records;
+        for (int i = 0; i < 500; i++) {
+            records.append(journalRecord(journal.takeKey(), QStringLiteral("alarm %1").arg(i)));
+        }
+        QVERIFY(journal.compact(records));
+
+        QBENCHMARK {
+            QCOMPARE(AlarmJournal(fileName).load().count(), 500);
+        }
+    }
 };
 
 QTEST_MAIN(tst_UCAlarms)
@@ -20,15 +20,24 @@
 #include <QtCore/QUrl>
 #include <QtQml/QQmlComponent>
 #include <QtQml/QQmlEngine>
+#include <QtQuick/QQuickItem>
 #include <QtTest/QtTest>
+#include <UbuntuToolkit/private/uctheme_p.h>
+#include <UbuntuToolkit/private/ucunits_p.h>
 
 #include "ucnamespace.h"
 
+UT_USE_NAMESPACE
+
 class tst_components_benchmark: public QObject
 {
     Q_OBJECT
 
 private Q_SLOTS:
+    void initTestCase() {
+        engine.addImportPath(UBUNTU_QML_IMPORT_PATH);
+    }
+
     void benchmark_creation_components_data() {
         QTest::addColumn<QString>("fileName");
 
@@ -96,6 +105,85 @@ private Q_SLOTS:
         }
     }
 
+    void benchmark_style_cache_data() {
+        QTest::addColumn<QString>("styledItem");
+
+        QTest::newRow("Button") << "Button";
+        QTest::newRow("CheckBox") << "CheckBox";
+        QTest::newRow("Switch") << "Switch";
+        QTest::newRow("TextField") << "TextField";
+        QTest::newRow("ProgressBar") << "ProgressBar";
+    }
+
+    void benchmark_style_cache() {
+        QFETCH(QString, styledItem);
+
+        QQmlComponent component(&engine);
+        component.setData(QString("import QtQuick 2.4\n"
+                                  "import Ubuntu.Components 1.3\n"
+                                  "Column { Repeater { model: 50; %1 {} } }").arg(styledItem).toUtf8(), QUrl());
+        UCTheme::clearStyleCache(&engine);
+        QObject *obj = component.create();
+        QVERIFY2(obj, qPrintable(component.errorString()));
+        delete obj;
+
+        QBENCHMARK {
+            QObject *obj = component.create();
+            delete obj;
+        }
+
+        // all but the first instances must be served by the cache
+        UCTheme::StyleCacheStatistics statistics = UCTheme::styleCacheStatistics(&engine);
+        QVERIFY(statistics.componentMisses > 0);
+        QVERIFY(statistics.componentHits > statistics.componentMisses);
+    }
+
+    // only the bindings using units are re-evaluated when the grid unit changes
+    void benchmark_grid_unit_change() {
+        QQmlComponent component(&engine);
+        component.setData("import QtQuick 2.4\n"
+                          "import Ubuntu.Components 1.3\n"
+                          "Column {\n"
+                          "    width: 400\n"
+                          "    Repeater {\n"
+                          "        model: 200\n"
+                          "        ListItem {\n"
+                          "            objectName: 'listItem' + index\n"
+                          "            height: units.gu(7)\n"
+                          "            Label {\n"
+                          "                x: units.gu(2)\n"
+                          "                width: parent.width - 2 * x\n"
+                          "                anchors.verticalCenter: parent.verticalCenter\n"
+                          "                text: 'Item ' + index\n"
+                          "                textSize: Label.Large\n"
+                          "            }\n"
+                          "        }\n"
+                          "    }\n"
+                          "}", QUrl());
+        QScopedPointer<QObject> page(component.create());
+        QVERIFY2(page, qPrintable(component.errorString()));
+
+        UCUnits *units = UCUnits::instance();
+        const float gridUnit = units->gridUnit();
+        bool scaled = false;
+        QBENCHMARK {
+            scaled = !scaled;
+            units->setGridUnit(scaled ? gridUnit * 2 : gridUnit);
+        }
+        units->setGridUnit(gridUnit * 2);
+
+        QQuickItem *listItem = Q_NULLPTR;
+        Q_FOREACH(QQuickItem *child, qobject_cast<QQuickItem*>(page.data())->childItems()) {
+            if (child->objectName() == QStringLiteral("listItem199")) {
+                listItem = child;
+            }
+        }
+        QVERIFY(listItem);
+        QCOMPARE(listItem->height(), static_cast<qreal>(units->gu(7)));
+        units->setGridUnit(gridUnit);
+        QCOMPARE(listItem->height(), static_cast<qreal>(units->gu(7)));
+    }
+
 private:
     QQmlEngine engine;
 };
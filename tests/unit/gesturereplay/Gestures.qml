@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.4
+import Ubuntu.Components 1.3
+
+Rectangle {
+    width: units.gu(40)
+    height: units.gu(71)
+    color: "white"
+
+    SwipeArea {
+        objectName: "leftSwipeArea"
+        anchors {
+            left: parent.left
+            top: parent.top
+            bottom: parent.bottom
+            bottomMargin: units.gu(8)
+        }
+        width: units.gu(2)
+        direction: SwipeArea.Rightwards
+    }
+
+    BottomEdge {
+        id: bottomEdge
+        objectName: "bottomEdge"
+        height: parent.height
+        hint.text: "Compose"
+        contentComponent: Rectangle {
+            width: bottomEdge.width
+            height: bottomEdge.height
+            color: "lightblue"
+        }
+    }
+}
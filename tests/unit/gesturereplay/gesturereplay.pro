@@ -0,0 +1,8 @@
+include(../test-include-x11.pri)
+QT += core-private qml-private quick-private gui-private UbuntuGestures UbuntuGestures_private UbuntuToolkit
+
+SOURCES += \
+    tst_gesturereplay.cpp
+
+OTHER_FILES += \
+    Gestures.qml
@@ -0,0 +1,334 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replays touch recordings through SwipeArea, TouchRegistry and BottomEdge with fake timers, and
+// reports for each gesture the time to recognition (in recording time), the number of touch
+// events processed per second and the number of allocations per touch event.
+//
+// Recordings of real gestures can be captured on a device by running an application with
+// UBUNTU_GESTURES_TOUCH_RECORDING=<file> and replayed by putting them in the directory given by
+// UBUNTU_GESTURES_REPLAY_DIR. The recorded window must have the size of the Gestures.qml scene.
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/qpa/qwindowsysteminterface.h>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QQuickView>
+#include <QtTest/QtTest>
+#include <UbuntuGestures/private/timer_p.h>
+#include <UbuntuGestures/private/touchrecording_p.h>
+#include <UbuntuGestures/private/touchregistry_p.h>
+#include <UbuntuGestures/private/ucswipearea_p_p.h>
+#include <UbuntuToolkit/private/ucbottomedge_p.h>
+#include <UbuntuToolkit/private/ucbottomedgehint_p.h>
+#include <UbuntuToolkit/private/quickutils_p.h>
+
+#include "uctestcase.h"
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define COUNT_ALLOCATIONS
+
+// glibc lets the executable interpose the allocation functions, operator new and the Qt
+// containers end up here. All the threads are accounted, a realloc() counts as one allocation.
+extern "C" void *__libc_malloc(size_t size) __THROW;
+extern "C" void *__libc_calloc(size_t count, size_t size) __THROW;
+extern "C" void *__libc_realloc(void *ptr, size_t size) __THROW;
+extern "C" void *__libc_memalign(size_t alignment, size_t size) __THROW;
+static QAtomicInt allocationCount;
+static QAtomicInt countingAllocations;
+
+static inline void countAllocation()
+{
+    if (countingAllocations.load()) {
+        allocationCount.fetchAndAddRelaxed(1);
+    }
+}
+
+extern "C" void *malloc(size_t size) __THROW
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) __THROW
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) __THROW
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) __THROW
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) __THROW
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **ptr, size_t alignment, size_t size) __THROW
+{
+    if (alignment % sizeof(void*) || alignment & (alignment - 1)) {
+        return EINVAL;
+    }
+    countAllocation();
+    void *memory = __libc_memalign(alignment, size);
+    if (!memory && size) {
+        return ENOMEM;
+    }
+    *ptr = memory;
+    return 0;
+}
+#endif
+
+UG_USE_NAMESPACE
+UT_USE_NAMESPACE
+
+static QVector<TouchRecording::Point> singlePoint(Qt::TouchPointState state, const QPointF &pos)
+{
+    return QVector<TouchRecording::Point>() << TouchRecording::Point{0, state, pos};
+}
+
+class tst_GestureReplay : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTouchDevice *m_device = nullptr;
+    UbuntuTestCase *m_view = nullptr;
+    TouchRegistry *m_touchRegistry = nullptr;
+    FakeTimerFactory *m_fakeTimerFactory = nullptr;
+    QHash<UCSwipeArea*, qint64> m_recognitionTimes;
+    qint64 m_replayStartTime = 0;
+    QTemporaryDir m_recordingsDir;
+
+    UCSwipeArea *swipeArea(const QString &name) const
+    {
+        if (name == QStringLiteral("bottomEdge")) {
+            return m_view->findItem<UCBottomEdge*>(name)->hint()->swipeArea();
+        }
+        return m_view->findItem<UCSwipeArea*>(name);
+    }
+
+    void setupSwipeArea(UCSwipeArea *area)
+    {
+        UCSwipeAreaPrivate *d = UCSwipeAreaPrivate::get(area);
+        d->setRecognitionTimer(m_fakeTimerFactory->createTimer(area));
+        d->setTimeSource(m_fakeTimerFactory->timeSource());
+        connect(area, &UCSwipeArea::draggingChanged, this, [this, area](bool dragging) {
+            if (dragging && !m_recognitionTimes.contains(area)) {
+                m_recognitionTimes.insert(
+                    area, m_fakeTimerFactory->timeSource()->msecsSinceReference());
+            }
+        });
+    }
+
+    // Single finger gestures in window coordinates, sampled at 60 Hz. A slow start crawls a few
+    // pixels before the actual swipe.
+    TouchRecording createRecording(const QString &gesture)
+    {
+        const qint64 frameTime = 16;
+        QPointF from, to;
+        int frameCount = 15;
+        int slowFrameCount = 0;
+        if (gesture.startsWith(QStringLiteral("leftEdge"))) {
+            UCSwipeArea *area = swipeArea(QStringLiteral("leftSwipeArea"));
+            from = UbuntuTestCase::centerOf(area, true);
+            to = from + QPointF(m_view->width() * 0.6, 0.0);
+            if (gesture == QStringLiteral("leftEdgeSlowStart")) {
+                slowFrameCount = 12;
+            }
+        } else {
+            UCSwipeArea *area = swipeArea(QStringLiteral("bottomEdge"));
+            from = UbuntuTestCase::centerOf(area, true);
+            to = QPointF(from.x(), m_view->height() * 0.3);
+            frameCount = 30;
+        }
+
+        TouchRecording recording;
+        qint64 time = 0;
+        QPointF pos = from;
+        recording.append(QEvent::TouchBegin, time, singlePoint(Qt::TouchPointPressed, pos));
+        for (int i = 0; i < slowFrameCount; i++) {
+            time += frameTime;
+            pos += (to - from) * 0.005;
+            recording.append(QEvent::TouchUpdate, time, singlePoint(Qt::TouchPointMoved, pos));
+        }
+        const QPointF start = pos;
+        for (int i = 1; i <= frameCount; i++) {
+            time += frameTime;
+            pos = start + (to - start) * (static_cast<qreal>(i) / frameCount);
+            recording.append(QEvent::TouchUpdate, time, singlePoint(Qt::TouchPointMoved, pos));
+        }
+        time += frameTime;
+        recording.append(QEvent::TouchEnd, time, singlePoint(Qt::TouchPointReleased, pos));
+        return recording;
+    }
+
+    void replayRecording(const TouchRecording &recording)
+    {
+        m_replayStartTime = m_fakeTimerFactory->timeSource()->msecsSinceReference() + 1000;
+        const qint64 firstTimestamp = recording.at(0).timestamp;
+        for (int i = 0; i < recording.count(); i++) {
+            m_fakeTimerFactory->updateTime(
+                m_replayStartTime + recording.at(i).timestamp - firstTimestamp);
+            QScopedPointer<QTouchEvent> event(recording.createTouchEvent(i, m_device, m_view));
+            QCoreApplication::sendEvent(m_view, event.data());
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        m_device = new QTouchDevice;
+        m_device->setType(QTouchDevice::TouchScreen);
+        QWindowSystemInterface::registerTouchDevice(m_device);
+        QVERIFY(m_recordingsDir.isValid());
+    }
+
+    void init()
+    {
+        m_view = new UbuntuTestCase(QStringLiteral("Gestures.qml"),
+                                    QQuickView::SizeRootObjectToView, true);
+        // Touch mode, the BottomEdge hint can't be swiped when a mouse is attached.
+        QuickUtils::instance()->setMouseAttached(false);
+
+        m_fakeTimerFactory = new FakeTimerFactory;
+        m_touchRegistry = TouchRegistry::instance();
+        m_touchRegistry->setTimerFactory(m_fakeTimerFactory);
+        m_view->installEventFilter(m_touchRegistry);
+
+        setupSwipeArea(swipeArea(QStringLiteral("leftSwipeArea")));
+        setupSwipeArea(swipeArea(QStringLiteral("bottomEdge")));
+        m_recognitionTimes.clear();
+        QCoreApplication::processEvents();
+    }
+
+    void cleanup()
+    {
+        m_view->removeEventFilter(m_touchRegistry);
+        // Takes down the timer factory along with it.
+        delete m_touchRegistry;
+        m_touchRegistry = nullptr;
+        m_fakeTimerFactory = nullptr;
+        delete m_view;
+        m_view = nullptr;
+        QTest::qWait(400);
+    }
+
+    void replay_data()
+    {
+        QTest::addColumn<QString>("gesture");
+        QTest::addColumn<QString>("fileName");
+        QTest::addColumn<QString>("expectedSwipeArea");
+
+        QTest::newRow("leftEdgeSwipe")
+            << "leftEdgeSwipe" << QString() << "leftSwipeArea";
+        // The crawl stays under the distance threshold, the swipe following it is recognized
+        // before the recognition timer runs out.
+        QTest::newRow("leftEdgeSlowStart")
+            << "leftEdgeSlowStart" << QString() << "leftSwipeArea";
+        QTest::newRow("bottomEdgeSwipe")
+            << "bottomEdgeSwipe" << QString() << "bottomEdge";
+
+        const QString directory = QString::fromLocal8Bit(qgetenv("UBUNTU_GESTURES_REPLAY_DIR"));
+        if (!directory.isEmpty()) {
+            QDir dir(directory);
+            Q_FOREACH(const QString &file, dir.entryList(QStringList() << "*.touches")) {
+                QTest::newRow(qPrintable(file))
+                    << file << dir.absoluteFilePath(file) << QString();
+            }
+        }
+    }
+    void replay()
+    {
+        QFETCH(QString, gesture);
+        QFETCH(QString, fileName);
+        QFETCH(QString, expectedSwipeArea);
+
+        // Synthesized gestures go through the file format too.
+        if (fileName.isEmpty()) {
+            const TouchRecording synthesized = createRecording(gesture);
+            fileName = m_recordingsDir.path() + QStringLiteral("/%1.touches").arg(gesture);
+            QVERIFY(synthesized.save(fileName));
+        }
+        TouchRecording recording;
+        QVERIFY(recording.load(fileName));
+        QVERIFY(recording.count() > 0);
+
+        QElapsedTimer timer;
+#if defined(COUNT_ALLOCATIONS)
+        allocationCount.store(0);
+        countingAllocations.store(1);
+#endif
+        timer.start();
+        replayRecording(recording);
+        const qint64 elapsed = timer.nsecsElapsed();
+#if defined(COUNT_ALLOCATIONS)
+        countingAllocations.store(0);
+#endif
+
+        qDebug("%s: %d events over %lld ms", qPrintable(gesture), recording.count(),
+               recording.duration());
+        Q_FOREACH(const QString &name, QStringList() << "leftSwipeArea" << "bottomEdge") {
+            UCSwipeArea *area = swipeArea(name);
+            if (m_recognitionTimes.contains(area)) {
+                qDebug("  %s recognized after %lld ms", qPrintable(name),
+                       m_recognitionTimes.value(area) - m_replayStartTime);
+            }
+        }
+        qDebug("  %.0f events per second", recording.count() * 1e9 / qMax(elapsed, Q_INT64_C(1)));
+#if defined(COUNT_ALLOCATIONS)
+        qDebug("  %.1f allocations per event",
+               static_cast<double>(allocationCount.load()) / recording.count());
+#endif
+
+        if (!expectedSwipeArea.isEmpty()) {
+            UCSwipeArea *area = swipeArea(expectedSwipeArea);
+            QVERIFY2(m_recognitionTimes.contains(area), "The gesture wasn't recognized.");
+            QVERIFY(m_recognitionTimes.value(area) - m_replayStartTime
+                    < UCSwipeAreaPrivate::get(area)->maxTime);
+            QCOMPARE(m_recognitionTimes.count(), 1);
+        }
+    }
+
+    // The left edge swipe leaves no state behind, it can be replayed in a loop.
+    void benchmarkReplay()
+    {
+        const TouchRecording recording = createRecording(QStringLiteral("leftEdgeSwipe"));
+        QBENCHMARK {
+            replayRecording(recording);
+        }
+        QVERIFY(m_recognitionTimes.contains(swipeArea(QStringLiteral("leftSwipeArea"))));
+    }
+};
+
+QTEST_MAIN(tst_GestureReplay)
+
+#include "tst_gesturereplay.moc"
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <UbuntuMetrics/private/histogram_p.h>
+
+static const quint64 msecs = 1000000;
+
+// Gets the duration at a single percentile.
+static quint64 percentile(const UMHistogram& histogram, float percentile)
+{
+    quint64 value;
+    histogram.percentiles(&percentile, &value, 1);
+    return value;
+}
+
+class tst_Histogram : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void bucketBoundaries_data()
+    {
+        QTest::addColumn<quint64>("nsecs");
+        QTest::addColumn<quint64>("upperBound");
+
+        // 1 µs buckets up to 32 µs, then 16 buckets per power of two.
+        QTest::newRow("zero") << Q_UINT64_C(0) << Q_UINT64_C(1000);
+        QTest::newRow("sub-microsecond") << Q_UINT64_C(999) << Q_UINT64_C(1000);
+        QTest::newRow("first group end") << Q_UINT64_C(15999) << Q_UINT64_C(16000);
+        QTest::newRow("second group start") << Q_UINT64_C(16000) << Q_UINT64_C(17000);
+        QTest::newRow("second group end") << Q_UINT64_C(31999) << Q_UINT64_C(32000);
+        QTest::newRow("third group start") << Q_UINT64_C(32000) << Q_UINT64_C(34000);
+        QTest::newRow("third group bucket end") << Q_UINT64_C(33999) << Q_UINT64_C(34000);
+        QTest::newRow("third group next bucket") << Q_UINT64_C(34000) << Q_UINT64_C(36000);
+        QTest::newRow("1 ms") << msecs << Q_UINT64_C(1024000);
+        QTest::newRow("16 ms") << 16 * msecs << Q_UINT64_C(16384000);
+        QTest::newRow("overflow") << (Q_UINT64_C(1) << 50) << (Q_UINT64_C(1000) << 32);
+    }
+    void bucketBoundaries()
+    {
+        QFETCH(quint64, nsecs);
+        QFETCH(quint64, upperBound);
+
+        // The max value being bigger, the median is the upper bound of the bucket.
+        UMHistogram histogram;
+        histogram.record(nsecs);
+        histogram.record(Q_UINT64_C(1) << 60);
+        QCOMPARE(histogram.count(), 2u);
+        QCOMPARE(percentile(histogram, 50.0f), upperBound);
+
+        // Values are clamped to the max value.
+        histogram.reset();
+        histogram.record(nsecs);
+        QCOMPARE(percentile(histogram, 50.0f), qMin(nsecs, upperBound));
+    }
+
+    void percentiles()
+    {
+        UMHistogram histogram;
+        for (int i = 1; i <= 100; ++i) {
+            histogram.record(i * msecs);
+        }
+        QCOMPARE(histogram.count(), 100u);
+        QCOMPARE(histogram.max(), 100 * msecs);
+
+        const float percentiles[5] = { 0.0f, 50.0f, 90.0f, 99.0f, 100.0f };
+        const quint64 expected[5] = { 1 * msecs, 50 * msecs, 90 * msecs, 99 * msecs, 100 * msecs };
+        quint64 values[5];
+        histogram.percentiles(percentiles, values, 5);
+        for (int i = 0; i < 5; ++i) {
+            // Upper bound of the bucket, within the relative precision.
+            QVERIFY2(values[i] >= expected[i] && values[i] <= expected[i] * 17 / 16,
+                     qPrintable(QString::number(values[i])));
+        }
+        QCOMPARE(values[4], 100 * msecs);
+    }
+
+    void emptyPercentiles()
+    {
+        UMHistogram histogram;
+        QCOMPARE(histogram.count(), 0u);
+        QCOMPARE(percentile(histogram, 50.0f), Q_UINT64_C(0));
+        QCOMPARE(percentile(histogram, 100.0f), Q_UINT64_C(0));
+    }
+
+    void addSubtract()
+    {
+        UMHistogram first;
+        UMHistogram second;
+        for (int i = 1; i <= 10; ++i) {
+            first.record(i * msecs);
+            second.record(100 * i * msecs);
+        }
+        const quint64 median = percentile(first, 50.0f);
+
+        UMHistogram total;
+        total.add(first);
+        total.add(second);
+        QCOMPARE(total.count(), 20u);
+        QCOMPARE(total.max(), 1000 * msecs);
+        QVERIFY(percentile(total, 90.0f) >= 800 * msecs);
+
+        total.subtract(second);
+        QCOMPARE(total.count(), 10u);
+        QCOMPARE(percentile(total, 50.0f), median);
+    }
+
+    void rollingWindow()
+    {
+        const int period = 1000;
+        UMRollingHistogram rolling;
+
+        // First half period.
+        rolling.record(50 * msecs, 0, period);
+        rolling.record(50 * msecs, 400, period);
+        QCOMPARE(rolling.histogram().count(), 2u);
+
+        // Second half, the first one is still covered.
+        rolling.record(5 * msecs, 500, period);
+        QCOMPARE(rolling.histogram().count(), 3u);
+        QCOMPARE(rolling.histogram().max(), 50 * msecs);
+
+        // Third half, the first one is dropped along with its max.
+        rolling.record(5 * msecs, 1000, period);
+        QCOMPARE(rolling.histogram().count(), 2u);
+        QCOMPARE(rolling.histogram().max(), 5 * msecs);
+        QCOMPARE(percentile(rolling.histogram(), 99.0f), 5 * msecs);
+
+        // More than a period without frames drops everything.
+        rolling.record(10 * msecs, 2600, period);
+        QCOMPARE(rolling.histogram().count(), 1u);
+        QCOMPARE(rolling.histogram().max(), 10 * msecs);
+
+        rolling.reset();
+        QCOMPARE(rolling.histogram().count(), 0u);
+        QCOMPARE(rolling.histogram().max(), Q_UINT64_C(0));
+    }
+};
+
+QTEST_MAIN(tst_Histogram)
+
+#include "tst_histogram.moc"
@@ -6,6 +6,7 @@ DOMAIN = localizedApp
 mo.target = mo
 mo.commands = set -e;
 mo.commands += msgfmt $$PWD/po/en_US.po -o $$PWD/$${DOMAIN}/share/locale/en/LC_MESSAGES/$${DOMAIN}.mo;
+mo.commands += msgfmt $$PWD/po/single_form.po -o $$PWD/$${DOMAIN}/share/locale/en/LC_MESSAGES/$${DOMAIN}SingleForm.mo;
 QMAKE_EXTRA_TARGETS += mo
 PRE_TARGETDEPS += mo
 
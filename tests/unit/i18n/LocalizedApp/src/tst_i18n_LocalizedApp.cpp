@@ -193,6 +193,126 @@ private Q_SLOTS:
         QCOMPARE(i18n->tr(QString("Count the kittens")), QString("Contar los gatitos"));
         QCOMPARE(i18n->ctr(QString("All Cats"), QString("All")), QString("Cada"));
     }
+
+    void testCase_TranslationCache()
+    {
+        UbuntuI18n* i18n = UbuntuI18n::instance();
+        QCOMPARE(i18n->domain(), QString("localizedApp"));
+        i18n->clearCache();
+
+        QCOMPARE(i18n->tr(QString("Welcome")), QString("Greets"));
+        QCOMPARE(i18n->cacheStatistics().misses, 1u);
+        QCOMPARE(i18n->tr(QString("Welcome")), QString("Greets"));
+        QCOMPARE(i18n->dtr(i18n->domain(), QString("Welcome")), QString("Greets"));
+        QCOMPARE(i18n->cacheStatistics().hits, 2u);
+
+        // contexts are cached separately
+        QCOMPARE(i18n->ctr(QString("All Contacts"), QString("All")), QString("Todos"));
+        QCOMPARE(i18n->ctr(QString("All Calls"), QString("All")), QString("Todas"));
+        QCOMPARE(i18n->ctr(QString("All Contacts"), QString("All")), QString("Todos"));
+        QCOMPARE(i18n->cacheStatistics().misses, 3u);
+        QCOMPARE(i18n->cacheStatistics().hits, 3u);
+
+        // plural forms are cached per form, not per count
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 1), QString("%1 kotek"));
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 2), QString("%1 kotki"));
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 5), QString("%1 kotkow"));
+        QCOMPARE(i18n->cacheStatistics().misses, 6u);
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 3), QString("%1 kotki"));
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 22), QString("%1 kotki"));
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 12), QString("%1 kotkow"));
+        QCOMPARE(i18n->cacheStatistics().misses, 6u);
+        QCOMPARE(i18n->cacheStatistics().hits, 6u);
+
+        // changing the language drops the cache
+        i18n->setLanguage("C");
+        QCOMPARE(i18n->tr(QString("Welcome")), QString("Welcome"));
+        QCOMPARE(i18n->tr(QString("%1 kitten"), QString("%1 kittens"), 5), QString("%1 kittens"));
+    }
+
+    void testCase_SingleFormCatalogCache()
+    {
+        UbuntuI18n* i18n = UbuntuI18n::instance();
+        i18n->setLanguage("en_US.utf8");
+        QSignalSpy spy(i18n, SIGNAL(languageChanged()));
+        spy.wait();
+        const QString domain("localizedAppSingleForm");
+        i18n->bindtextdomain(domain, QDir::currentPath() + "/localizedApp/share/locale");
+
+        // all counts share the only form of the catalog
+        QCOMPARE(i18n->dtr(domain, QString("%1 apple"), QString("%1 apples"), 1), QString("%1 ringo"));
+        QCOMPARE(i18n->dtr(domain, QString("%1 apple"), QString("%1 apples"), 5), QString("%1 ringo"));
+        QCOMPARE(i18n->dtr(domain, QString("%1 apple"), QString("%1 apples"), 0), QString("%1 ringo"));
+
+        // untranslated messages take the English forms whatever the catalog says
+        QCOMPARE(i18n->dtr(domain, QString("%1 pear"), QString("%1 pears"), 1), QString("%1 pear"));
+        QCOMPARE(i18n->dtr(domain, QString("%1 pear"), QString("%1 pears"), 2), QString("%1 pears"));
+        QCOMPARE(i18n->dtr(domain, QString("%1 pear"), QString("%1 pears"), 0), QString("%1 pears"));
+        QCOMPARE(i18n->dtr(domain, QString("%1 pear"), QString("%1 pears"), 1), QString("%1 pear"));
+        QCOMPARE(i18n->cacheStatistics().misses, 4u);
+        QCOMPARE(i18n->cacheStatistics().hits, 3u);
+
+        i18n->setLanguage("C");
+    }
+
+    void testCase_PluralExpression_data()
+    {
+        QTest::addColumn<QByteArray>("expression");
+        QTest::addColumn<int>("n");
+        QTest::addColumn<int>("index");
+
+        QTest::newRow("single form") << QByteArray("0") << 5 << 0;
+        QTest::newRow("germanic 1") << QByteArray("n != 1") << 1 << 0;
+        QTest::newRow("germanic 0") << QByteArray("n != 1") << 0 << 1;
+        QTest::newRow("french 0") << QByteArray("n>1") << 0 << 0;
+        QTest::newRow("french 2") << QByteArray("(n > 1)") << 2 << 1;
+
+        const QByteArray polish("(n==1 ? 0 : n%10>=2 && n%10<=4 && (n%100<10 || n%100>=20) ? 1 : 2)");
+        QTest::newRow("polish 1") << polish << 1 << 0;
+        QTest::newRow("polish 3") << polish << 3 << 1;
+        QTest::newRow("polish 12") << polish << 12 << 2;
+        QTest::newRow("polish 22") << polish << 22 << 1;
+        QTest::newRow("polish 25") << polish << 25 << 2;
+
+        const QByteArray russian("n%10==1 && n%100!=11 ? 0 : n%10>=2 && n%10<=4 && "
+                                 "(n%100<10 || n%100>=20) ? 1 : 2");
+        QTest::newRow("russian 21") << russian << 21 << 0;
+        QTest::newRow("russian 11") << russian << 11 << 2;
+        QTest::newRow("russian 104") << russian << 104 << 1;
+
+        const QByteArray arabic("n==0 ? 0 : n==1 ? 1 : n==2 ? 2 : n%100>=3 && n%100<=10 ? 3 : "
+                                "n%100>=11 ? 4 : 5");
+        QTest::newRow("arabic 0") << arabic << 0 << 0;
+        QTest::newRow("arabic 2") << arabic << 2 << 2;
+        QTest::newRow("arabic 105") << arabic << 105 << 3;
+        QTest::newRow("arabic 111") << arabic << 111 << 4;
+        QTest::newRow("arabic 100") << arabic << 100 << 5;
+
+        // precedence and unary operators
+        QTest::newRow("additive") << QByteArray("n - 1 * 2") << 5 << 3;
+        QTest::newRow("not") << QByteArray("!(n == 1)") << 1 << 0;
+        QTest::newRow("not not") << QByteArray("!!n") << 7 << 1;
+        QTest::newRow("or over and") << QByteArray("n == 1 || n == 2 && 0") << 1 << 1;
+        QTest::newRow("tabs") << QByteArray("\tn\t!=\t1 ") << 2 << 1;
+
+        // invalid expressions
+        QTest::newRow("empty") << QByteArray("") << 1 << -1;
+        QTest::newRow("unknown variable") << QByteArray("x != 1") << 1 << -1;
+        QTest::newRow("trailing operator") << QByteArray("n +") << 1 << -1;
+        QTest::newRow("unbalanced") << QByteArray("(n != 1") << 1 << -1;
+        QTest::newRow("missing else") << QByteArray("n ? 1") << 1 << -1;
+        QTest::newRow("division by zero") << QByteArray("n / 0") << 1 << -1;
+        QTest::newRow("modulo zero") << QByteArray("n % (n - 1)") << 1 << -1;
+        QTest::newRow("trailing garbage") << QByteArray("n != 1;") << 1 << -1;
+    }
+    void testCase_PluralExpression()
+    {
+        QFETCH(QByteArray, expression);
+        QFETCH(int, n);
+        QFETCH(int, index);
+
+        QCOMPARE(UbuntuI18n::evaluatePluralExpression(expression, n), index);
+    }
 };
 
 // The C++ equivalent of QTEST_MAIN(tst_I18n_LocalizedApp) with added initialization
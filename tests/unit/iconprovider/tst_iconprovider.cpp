@@ -27,11 +27,16 @@ class tst_IconProvider : public QObject
 public:
     tst_IconProvider() {}
 
+private:
+    QTemporaryDir cacheDir;
+
 private Q_SLOTS:
 
     void initTestCase()
     {
+        QVERIFY(cacheDir.isValid());
         qputenv("XDG_DATA_DIRS", SRCDIR);
+        qputenv("XDG_CACHE_HOME", cacheDir.path().toLocal8Bit());
     }
 
     void test_loadIcon_data()
@@ -93,6 +98,69 @@ private Q_SLOTS:
         QVERIFY(!i.isNull());
         QCOMPARE(QColor(i.pixel(0,0)), QColor(Qt::black));
     }
+
+    void test_indexInvalidated()
+    {
+        QTemporaryDir dataDir;
+        QVERIFY(dataDir.isValid());
+        const QString themeDir = dataDir.path() + "/icons/indexTheme";
+        QVERIFY(QDir().mkpath(themeDir + "/apps/512"));
+        QVERIFY(QFile::copy(SRCDIR "icons/mockTheme/index.theme", themeDir + "/index.theme"));
+        QVERIFY(QFile::copy(SRCDIR "icons/mockTheme/apps/512/gallery-app.png", themeDir + "/apps/512/gallery-app.png"));
+
+        const QByteArray dataDirs = qgetenv("XDG_DATA_DIRS");
+        qputenv("XDG_DATA_DIRS", dataDir.path().toLocal8Bit());
+        QSize returnedSize;
+        UnityThemeIconProvider::clearThemes(true);
+        {
+            UnityThemeIconProvider provider("indexTheme");
+            QVERIFY(!provider.requestImage("gallery-app", &returnedSize, QSize(-1, -1)).isNull());
+            QVERIFY(provider.requestImage("other-app", &returnedSize, QSize(-1, -1)).isNull());
+        }
+
+        // adding an icon changes the directory modification time, which drops the stored index
+        QTest::qWait(1000);
+        QVERIFY(QFile::copy(SRCDIR "icons/mockTheme/apps/512/gallery-app.png", themeDir + "/apps/512/other-app.png"));
+        UnityThemeIconProvider::clearThemes(false);
+        {
+            UnityThemeIconProvider provider("indexTheme");
+            QVERIFY(!provider.requestImage("other-app", &returnedSize, QSize(-1, -1)).isNull());
+        }
+
+        UnityThemeIconProvider::clearThemes(true);
+        qputenv("XDG_DATA_DIRS", dataDirs);
+    }
+
+    void benchmark_lookup_data()
+    {
+        QTest::addColumn<bool>("dropThemes");
+        QTest::addColumn<bool>("dropIndex");
+
+        QTest::newRow("cold") << true << true;
+        QTest::newRow("stored index") << true << false;
+        QTest::newRow("warm") << false << false;
+    }
+
+    void benchmark_lookup()
+    {
+        QFETCH(bool, dropThemes);
+        QFETCH(bool, dropIndex);
+
+        const QStringList icons = QStringList() << "battery-100-charging" << "gallery-app" << "myapp" << "myapp2" << "missing";
+        QSize returnedSize;
+        UnityThemeIconProvider::clearThemes(true);
+        UnityThemeIconProvider("mockTheme").requestImage("myapp", &returnedSize, QSize(16, 16));
+
+        QBENCHMARK {
+            if (dropThemes) {
+                UnityThemeIconProvider::clearThemes(dropIndex);
+            }
+            UnityThemeIconProvider provider("mockTheme");
+            Q_FOREACH(const QString &icon, icons) {
+                provider.requestImage(icon, &returnedSize, QSize(16, 16));
+            }
+        }
+    }
 };
 
 QTEST_MAIN(tst_IconProvider)
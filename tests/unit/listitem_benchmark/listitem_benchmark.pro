@@ -0,0 +1,3 @@
+include(../test-include.pri)
+
+SOURCES += tst_listitem_benchmark.cpp
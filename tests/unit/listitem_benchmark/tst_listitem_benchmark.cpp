@@ -0,0 +1,141 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QPointer>
+#include <QtCore/QUrl>
+#include <QtQml/QQmlComponent>
+#include <QtQml/QQmlEngine>
+#include <QtQuick/QQuickItem>
+#include <QtTest/QtTest>
+
+/*
+ * This benchmark has its own binary as it interposes malloc() for the whole process to count
+ * the allocations made while scrolling.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define COUNT_ALLOCATIONS
+
+// glibc lets the executable interpose malloc(), operator new and the Qt containers end up here.
+extern "C" void *__libc_malloc(size_t size) __THROW;
+static QAtomicInt allocationCount;
+static QAtomicInt countingAllocations;
+
+extern "C" void *malloc(size_t size) __THROW
+{
+    if (countingAllocations.load()) {
+        allocationCount.fetchAndAddRelaxed(1);
+    }
+    return __libc_malloc(size);
+}
+#endif
+
+class tst_listitem_benchmark: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase() {
+        engine.addImportPath(UBUNTU_QML_IMPORT_PATH);
+    }
+
+    // scrolls a ListView of ListItems row by row down and back up, with and without reusing
+    // the delegates scrolled out
+    void benchmark_listitem_flick_data() {
+        QTest::addColumn<int>("poolSize");
+
+        QTest::newRow("no pool") << 0;
+        QTest::newRow("pool") << 60;
+    }
+    void benchmark_listitem_flick() {
+        QFETCH(int, poolSize);
+
+        QQmlComponent component(&engine);
+        component.setData(QString("import QtQuick 2.4\n"
+                                  "import Ubuntu.Components 1.3\n"
+                                  "ListView {\n"
+                                  "    width: 400\n"
+                                  "    height: 800\n"
+                                  "    cacheBuffer: 0\n"
+                                  "    model: 1000\n"
+                                  "    ViewItems.poolSize: %1\n"
+                                  "    delegate: ListItem {\n"
+                                  "        height: %2\n"
+                                  "        Label {\n"
+                                  "            anchors.centerIn: parent\n"
+                                  "            text: 'Item ' + index\n"
+                                  "        }\n"
+                                  "        trailingActions: ListItemActions {\n"
+                                  "            actions: Action { iconName: 'delete' }\n"
+                                  "        }\n"
+                                  "    }\n"
+                                  "}").arg(poolSize).arg(rowHeight).toUtf8(), QUrl());
+        QScopedPointer<QQuickItem> listView(qobject_cast<QQuickItem*>(component.create()));
+        QVERIFY2(listView, qPrintable(component.errorString()));
+        const int rowCount = 40;
+
+        QPointer<QQuickItem> firstItem = itemAt(listView.data(), 0.0);
+        QVERIFY(firstItem);
+#if defined(COUNT_ALLOCATIONS)
+        allocationCount.store(0);
+        countingAllocations.store(1);
+#endif
+        flick(listView.data(), rowCount);
+#if defined(COUNT_ALLOCATIONS)
+        countingAllocations.store(0);
+        qDebug("pool size %d: %.1f allocations per scrolled row", poolSize,
+               static_cast<double>(allocationCount.load()) / (2 * rowCount));
+#endif
+        // the first row is shown by the same item when kept in the pool
+        QCOMPARE(firstItem.isNull(), poolSize == 0);
+        if (poolSize > 0) {
+            QCOMPARE(itemAt(listView.data(), 0.0), firstItem.data());
+        }
+
+        QBENCHMARK {
+            flick(listView.data(), rowCount);
+        }
+    }
+
+private:
+    static const int rowHeight = 80;
+    QQmlEngine engine;
+
+    static QQuickItem *itemAt(QQuickItem *listView, qreal y)
+    {
+        QQuickItem *item = Q_NULLPTR;
+        QMetaObject::invokeMethod(listView, "itemAt", Q_RETURN_ARG(QQuickItem*, item),
+                                  Q_ARG(qreal, 1.0), Q_ARG(qreal, y));
+        return item;
+    }
+
+    // moves the content one row at a time, letting the pool and the deferred deletes run
+    static void flick(QQuickItem *listView, int rowCount)
+    {
+        for (int i = -rowCount; i <= rowCount; i++) {
+            listView->setProperty("contentY", (rowCount - qAbs(i)) * rowHeight);
+            QMetaObject::invokeMethod(listView, "forceLayout");
+            QCoreApplication::processEvents();
+            QCoreApplication::sendPostedEvents(Q_NULLPTR, QEvent::DeferredDelete);
+        }
+    }
+};
+
+QTEST_MAIN(tst_listitem_benchmark)
+
+#include "tst_listitem_benchmark.moc"
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.4
+import Ubuntu.Components 1.3
+
+Item {
+    width: units.gu(40)
+    height: units.gu(80)
+
+    function insertRows(index, count) {
+        for (var i = 0; i < count; i++) {
+            listModel.insert(index, {label: "inserted"});
+        }
+    }
+    function removeRows(index, count) {
+        listModel.remove(index, count);
+    }
+
+    ListModel {
+        id: listModel
+        Component.onCompleted: {
+            for (var i = 0; i < 10; i++) {
+                append({label: "item" + i});
+            }
+        }
+    }
+
+    ListView {
+        objectName: "listView"
+        anchors.fill: parent
+        model: listModel
+        delegate: ListItem {
+            objectName: "listItem" + index
+            Label {
+                text: label
+            }
+        }
+    }
+}
@@ -0,0 +1,9 @@
+include(../test-include-x11.pri)
+QT += core-private qml-private quick-private gui-private
+
+SOURCES += \
+    tst_listitems.cpp
+
+DISTFILES += \
+    ListItemsInListView.qml \
+    ListItemPool.qml
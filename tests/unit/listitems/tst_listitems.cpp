@@ -0,0 +1,304 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <QtQml/QQmlEngine>
+#include <QtQuick/private/qquickitem_p.h>
+#include <QtQuick/private/qquicklistview_p.h>
+#include <QtTest/QtTest>
+#include <UbuntuToolkit/private/uclistitem_p.h>
+#include <UbuntuToolkit/private/uclistitem_p_p.h>
+
+#include "uctestcase.h"
+
+UT_USE_NAMESPACE
+
+typedef QList<int> IndexList;
+
+class ListItemsTestCase : public UbuntuTestCase
+{
+    Q_OBJECT
+public:
+    ListItemsTestCase(const QString &file)
+        : UbuntuTestCase(file)
+    {
+    }
+
+    QQuickListView *listView()
+    {
+        return findItem<QQuickListView*>("listView");
+    }
+
+    UCListItem *listItem(int index)
+    {
+        return findItem<UCListItem*>(QStringLiteral("listItem%1").arg(index));
+    }
+
+    UCViewItemsAttached *viewItems()
+    {
+        return qobject_cast<UCViewItemsAttached*>(
+            qmlAttachedPropertiesObject<UCViewItemsAttached>(listView(), false));
+    }
+
+    UCViewItemsAttachedPrivate *viewItemsPrivate()
+    {
+        return UCViewItemsAttachedPrivate::get(viewItems());
+    }
+
+    void insertRows(int index, int count)
+    {
+        QMetaObject::invokeMethod(rootObject(), "insertRows",
+                                  Q_ARG(QVariant, index), Q_ARG(QVariant, count));
+    }
+
+    void removeRows(int index, int count)
+    {
+        QMetaObject::invokeMethod(rootObject(), "removeRows",
+                                  Q_ARG(QVariant, index), Q_ARG(QVariant, count));
+    }
+
+    // moves the view content, letting the pool park and reuse the delegates
+    void scrollTo(qreal contentY)
+    {
+        listView()->setContentY(contentY);
+        listView()->forceLayout();
+        QCoreApplication::processEvents();
+    }
+
+    static bool isParked(UCListItem *item)
+    {
+        return QQuickItemPrivate::get(item)->culled;
+    }
+};
+
+class tst_ListItems : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void test_select_out_of_order()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        QVERIFY(test->viewItems());
+        QSignalSpy spy(test->viewItems(), SIGNAL(selectedIndicesChanged(QList<int>)));
+
+        Q_FOREACH(int index, IndexList() << 7 << 2 << 9 << 0 << 4) {
+            test->listItem(index)->setProperty("selected", true);
+        }
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 0 << 2 << 4 << 7 << 9);
+        QCOMPARE(spy.count(), 5);
+
+        // selecting again does not duplicate
+        test->listItem(4)->setProperty("selected", true);
+        QCOMPARE(spy.count(), 5);
+
+        Q_FOREACH(int index, IndexList() << 4 << 9 << 0) {
+            test->listItem(index)->setProperty("selected", false);
+        }
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 2 << 7);
+        QVERIFY(test->listItem(2)->property("selected").toBool());
+        QVERIFY(!test->listItem(4)->property("selected").toBool());
+        QCOMPARE(spy.count(), 8);
+    }
+
+    void test_set_selected_indices_sorted()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        test->viewItems()->setSelectedIndices(IndexList() << 8 << 3 << 5 << 3 << 1);
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 1 << 3 << 5 << 8);
+        QVERIFY(test->listItem(5)->property("selected").toBool());
+        QVERIFY(!test->listItem(4)->property("selected").toBool());
+    }
+
+    void test_drag_shifts_selection_data()
+    {
+        QTest::addColumn<IndexList>("selected");
+        QTest::addColumn<int>("from");
+        QTest::addColumn<int>("to");
+
+        QTest::newRow("selected forwards") << (IndexList() << 1 << 3 << 5 << 8) << 3 << 6;
+        QTest::newRow("selected backwards") << (IndexList() << 1 << 3 << 5 << 8) << 8 << 2;
+        QTest::newRow("unselected forwards") << (IndexList() << 1 << 3 << 5 << 8) << 0 << 9;
+        QTest::newRow("unselected backwards") << (IndexList() << 1 << 3 << 5 << 8) << 6 << 1;
+        QTest::newRow("next to each other") << (IndexList() << 4 << 5) << 4 << 5;
+        QTest::newRow("outside the range") << (IndexList() << 0 << 9) << 3 << 6;
+        QTest::newRow("all selected")
+            << (IndexList() << 0 << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8 << 9) << 2 << 7;
+    }
+    void test_drag_shifts_selection()
+    {
+        QFETCH(IndexList, selected);
+        QFETCH(int, from);
+        QFETCH(int, to);
+
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        test->viewItems()->setSelectedIndices(selected);
+
+        // the rows after the move, holding the index each had before
+        IndexList rows;
+        for (int i = 0; i < test->listView()->count(); i++) {
+            rows << i;
+        }
+        rows.move(from, to);
+        IndexList expected;
+        Q_FOREACH(int index, selected) {
+            expected << rows.indexOf(index);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        test->viewItemsPrivate()->updateSelectedIndices(from, to);
+        QCOMPARE(test->viewItems()->selectedIndices(), expected);
+    }
+
+    void test_rows_inserted_shift_selection()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        test->viewItems()->setSelectedIndices(IndexList() << 1 << 4 << 6);
+        QSignalSpy spy(test->viewItems(), SIGNAL(selectedIndicesChanged(QList<int>)));
+
+        test->insertRows(4, 2);
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 1 << 6 << 8);
+        QCOMPARE(spy.count(), 1);
+
+        // appended rows leave the selection untouched
+        test->insertRows(test->listView()->count(), 1);
+        QCOMPARE(spy.count(), 1);
+
+        test->insertRows(0, 1);
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 2 << 7 << 9);
+        QTRY_VERIFY(test->listItem(2)->property("selected").toBool());
+        QVERIFY(!test->listItem(1)->property("selected").toBool());
+    }
+
+    void test_rows_removed_shift_selection()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        test->viewItems()->setSelectedIndices(IndexList() << 1 << 3 << 4 << 7 << 9);
+        QSignalSpy spy(test->viewItems(), SIGNAL(selectedIndicesChanged(QList<int>)));
+
+        // removing selected rows drops their indices
+        test->removeRows(3, 2);
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 1 << 5 << 7);
+        QCOMPARE(spy.count(), 1);
+
+        test->removeRows(2, 1);
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 1 << 4 << 6);
+        QTRY_VERIFY(test->listItem(4)->property("selected").toBool());
+        QVERIFY(!test->listItem(5)->property("selected").toBool());
+
+        // removing rows after the last selected one leaves the selection untouched
+        spy.clear();
+        test->removeRows(7, 1);
+        QCOMPARE(spy.count(), 0);
+    }
+
+    void test_drag_moving_rows_shifts_once()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        test->viewItems()->setSelectedIndices(IndexList() << 2 << 4 << 7);
+        ListItemsTestCase *view = test.data();
+        // the handler moves the row by removing and inserting it
+        connect(test->viewItems(), &UCViewItemsAttached::dragUpdated, [view](UCDragEvent *event) {
+            view->removeRows(event->from(), 1);
+            view->insertRows(event->to(), 1);
+        });
+
+        UCDragEvent drag(UCDragEvent::Moving, 2, 5, -1, -1);
+        test->viewItemsPrivate()->emitDragUpdated(&drag);
+        test->viewItemsPrivate()->updateSelectedIndices(2, 5);
+        QCOMPARE(test->viewItems()->selectedIndices(), IndexList() << 3 << 5 << 7);
+    }
+
+    void test_rows_removed_shift_expansion()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemsInListView.qml"));
+        test->viewItems()->setExpansionFlags(0);
+        test->viewItems()->setExpandedIndices(IndexList() << 2 << 5 << 8);
+
+        test->removeRows(4, 2);
+        QCOMPARE(test->viewItems()->expandedIndices(), IndexList() << 2 << 6);
+        test->insertRows(0, 1);
+        QCOMPARE(test->viewItems()->expandedIndices(), IndexList() << 3 << 7);
+    }
+
+    void test_pooled_item_reset()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemPool.qml"));
+        QPointer<UCListItem> item = test->listItem(0);
+        UCListItemPrivate *d = UCListItemPrivate::get(item.data());
+        const qreal contentX = d->contentItem->x();
+
+        // swipe and highlight the item
+        d->lockContentItem(false);
+        d->contentItem->setX(contentX - 50);
+        d->setSwiped(true);
+        d->setHighlighted(true);
+        QVERIFY(item->isSwiped());
+        QVERIFY(item->highlighted());
+
+        test->scrollTo(50 * item->height());
+        QVERIFY(item);
+        QVERIFY(ListItemsTestCase::isParked(item.data()));
+        QVERIFY(!item->isSwiped());
+        QVERIFY(!item->highlighted());
+
+        // the same item shows the row again
+        test->scrollTo(0);
+        QCOMPARE(test->listItem(0), item.data());
+        QVERIFY(!ListItemsTestCase::isParked(item.data()));
+        QVERIFY(!item->isSwiped());
+        QVERIFY(!item->highlighted());
+        QCOMPARE(d->contentItem->x(), contentX);
+    }
+
+    void test_pooled_item_resync()
+    {
+        QScopedPointer<ListItemsTestCase> test(new ListItemsTestCase("ListItemPool.qml"));
+        QPointer<UCListItem> first = test->listItem(0);
+        QPointer<UCListItem> second = test->listItem(1);
+
+        test->scrollTo(50 * first->height());
+        QVERIFY(first && second);
+        QVERIFY(ListItemsTestCase::isParked(first.data()));
+        QVERIFY(ListItemsTestCase::isParked(second.data()));
+
+        // change the selection and the expansion of the parked rows
+        test->viewItems()->setSelectedIndices(IndexList() << 0);
+        test->viewItems()->setExpandedIndices(IndexList() << 1);
+
+        test->scrollTo(0);
+        QCOMPARE(test->listItem(0), first.data());
+        QCOMPARE(test->listItem(1), second.data());
+        QVERIFY(first->property("selected").toBool());
+        QVERIFY(!second->property("selected").toBool());
+        QVERIFY(!first->expansion()->expanded());
+        QVERIFY(second->expansion()->expanded());
+
+        // and back while parked
+        test->scrollTo(50 * first->height());
+        test->viewItems()->setSelectedIndices(IndexList() << 1);
+        test->viewItems()->setExpandedIndices(IndexList());
+        test->scrollTo(0);
+        QVERIFY(!first->property("selected").toBool());
+        QVERIFY(second->property("selected").toBool());
+        QVERIFY(!second->expansion()->expanded());
+    }
+};
+
+QTEST_MAIN(tst_ListItems)
+
+#include "tst_listitems.moc"
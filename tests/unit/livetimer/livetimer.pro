@@ -0,0 +1,6 @@
+include(../test-include.pri)
+
+QT *= UbuntuToolkit
+
+SOURCES += \
+    tst_livetimer.cpp
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtCore/QDateTime>
+#include <QtTest/QtTest>
+#include <UbuntuToolkit/private/livetimer_p.h>
+#include <UbuntuToolkit/private/livetimer_p_p.h>
+#include <UbuntuToolkit/private/timeutils_p.h>
+
+UT_USE_NAMESPACE
+
+class tst_LiveTimer : public QObject
+{
+    Q_OBJECT
+
+private:
+    // The current time rounded to the second, the tests step through time by whole seconds.
+    static QDateTime currentTime()
+    {
+        return QDateTime::fromMSecsSinceEpoch(
+            QDateTime::currentMSecsSinceEpoch() / 1000 * 1000).addSecs(1);
+    }
+
+    // Relative timers spread over the last and the next week.
+    void createRelativeTimers(int count, QObject *parent)
+    {
+        const QDateTime now = QDateTime::currentDateTime();
+        for (int i = 0; i < count; i++) {
+            LiveTimer *timer = new LiveTimer(parent);
+            timer->setFrequency(LiveTimer::Relative);
+            timer->setRelativeTime(now.addSecs((i * 613) % (14 * 24 * 3600) - 7 * 24 * 3600));
+        }
+    }
+
+private Q_SLOTS:
+    void wheelExpiry_data()
+    {
+        QTest::addColumn<int>("maxStep");
+
+        QTest::newRow("seconds") << 3;
+        QTest::newRow("minutes") << 200;
+        QTest::newRow("hours") << 4000;
+    }
+    void wheelExpiry()
+    {
+        QFETCH(int, maxStep);
+
+        const int count = 1000;
+        QVector<LiveTimer*> timers;
+        QHash<LiveTimer*, qint64> due;
+        QObject parent;
+        LiveTimerWheel wheel;
+        qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        wheel.reset(now);
+        qsrand(1);
+        for (int i = 0; i < count; i++) {
+            LiveTimer *timer = new LiveTimer(&parent);
+            // From a few seconds to a few months, covering all the levels and the overflow.
+            const qint64 dueSecs = now + 1 + (static_cast<qint64>(qrand()) % (1 << (i % 26)));
+            wheel.insert(timer, dueSecs);
+            timers.append(timer);
+            due.insert(timer, dueSecs);
+        }
+        for (int i = 0; i < count; i += 7) {
+            wheel.remove(timers[i]);
+            due.remove(timers[i]);
+        }
+        QCOMPARE(wheel.count(), due.count());
+
+        // Timers expire on the first advance reaching their due time. The steps get longer after
+        // a while to reach the overflow in a reasonable time.
+        QVector<LiveTimer*> expired;
+        for (int i = 0; wheel.count() > 0; i++) {
+            const qint64 previous = now;
+            now += 1 + qrand() % (i < 10000 ? maxStep : 4000);
+            wheel.advance(now, &expired);
+            Q_FOREACH(LiveTimer *timer, expired) {
+                QVERIFY(due.contains(timer));
+                QVERIFY(due.value(timer) > previous);
+                QVERIFY(due.value(timer) <= now);
+                due.remove(timer);
+            }
+            expired.clear();
+        }
+        QVERIFY(due.isEmpty());
+    }
+
+    void wheelTimeJump()
+    {
+        QObject parent;
+        LiveTimerWheel wheel;
+        const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        wheel.reset(now);
+        wheel.insert(new LiveTimer(&parent), now + 10);
+        wheel.insert(new LiveTimer(&parent), now + 100000);
+
+        // Going back in time expires everything so that it gets re-evaluated.
+        QVector<LiveTimer*> expired;
+        wheel.advance(now - 3600, &expired);
+        QCOMPARE(expired.count(), 2);
+        QCOMPARE(wheel.count(), 0);
+    }
+
+    void relativeFrequency_data()
+    {
+        QTest::addColumn<int>("offset");
+        QTest::addColumn<int>("step");
+        QTest::addColumn<int>("duration");
+
+        // Offsets of the relative time, crossing the now, hour and last week thresholds.
+        QTest::newRow("future") << 2 * 3600 << 5 << 3 * 3600;
+        QTest::newRow("now") << 40 << 1 << 120;
+        QTest::newRow("past") << -50 * 60 << 3 << 20 * 60;
+        QTest::newRow("last week") << -6 * 24 * 3600 << 300 << 3 * 24 * 3600;
+    }
+    void relativeFrequency()
+    {
+        QFETCH(int, offset);
+        QFETCH(int, step);
+        QFETCH(int, duration);
+
+        const QDateTime start = currentTime();
+        const QDateTime relativeTime = start.addSecs(offset);
+        LiveTimer timer;
+        timer.setFrequency(LiveTimer::Relative);
+        timer.setRelativeTime(relativeTime);
+
+        // The effective frequency always matches the proximity of the relative time.
+        QSet<LiveTimer::Frequency> frequencies;
+        for (QDateTime now = start; now <= start.addSecs(duration); now = now.addSecs(step)) {
+            SharedLiveTimer::instance().update(now);
+            const LiveTimer::Frequency expected =
+                frequencyForProximity(getDateProximity(now, relativeTime));
+            QCOMPARE(timer.effectiveFrequency(), expected);
+            frequencies.insert(expected);
+        }
+        QVERIFY(frequencies.count() > 1);
+    }
+
+    void triggers()
+    {
+        LiveTimer second, minute, hour;
+        second.setFrequency(LiveTimer::Second);
+        minute.setFrequency(LiveTimer::Minute);
+        hour.setFrequency(LiveTimer::Hour);
+        QSignalSpy secondSpy(&second, SIGNAL(trigger()));
+        QSignalSpy minuteSpy(&minute, SIGNAL(trigger()));
+        QSignalSpy hourSpy(&hour, SIGNAL(trigger()));
+
+        QDateTime now = currentTime();
+        now.setTime(QTime(now.time().hour(), 59, 58));
+        SharedLiveTimer::instance().update(now);
+        secondSpy.clear();
+        minuteSpy.clear();
+        hourSpy.clear();
+        for (int i = 0; i < 4; i++) {
+            now = now.addSecs(1);
+            SharedLiveTimer::instance().update(now);
+        }
+        QCOMPARE(secondSpy.count(), 4);
+        QCOMPARE(minuteSpy.count(), 1);
+        QCOMPARE(hourSpy.count(), 1);
+    }
+
+    void benchmarkRegistration()
+    {
+        QBENCHMARK {
+            QObject parent;
+            createRelativeTimers(2000, &parent);
+        }
+    }
+
+    void benchmarkTick()
+    {
+        QObject parent;
+        createRelativeTimers(2000, &parent);
+        QDateTime now = currentTime();
+        SharedLiveTimer::instance().update(now);
+        QBENCHMARK {
+            now = now.addSecs(1);
+            SharedLiveTimer::instance().update(now);
+        }
+    }
+};
+
+QTEST_MAIN(tst_LiveTimer)
+
+#include "tst_livetimer.moc"
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.4
+
+// The Row is polished on every frame as the width of its first child changes.
+Item {
+    width: 100
+    height: 100
+
+    Row {
+        Rectangle {
+            height: 50
+            color: "red"
+            NumberAnimation on width {
+                from: 10
+                to: 50
+                duration: 1000
+                loops: Animation.Infinite
+            }
+        }
+        Rectangle {
+            width: 20
+            height: 50
+            color: "blue"
+        }
+    }
+}
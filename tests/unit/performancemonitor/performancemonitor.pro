@@ -0,0 +1,11 @@
+include(../test-include-x11.pri)
+
+QT += gui-private UbuntuToolkit-private
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+SOURCES += \
+    tst_performancemonitor.cpp
+
+OTHER_FILES += \
+    AnimatedRectangle.qml \
+    AnimatedRow.qml
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtGui/qpa/qwindowsysteminterface.h>
+#include <QtQuick/QQuickView>
+#include <QtTest/QtTest>
+#include <UbuntuToolkit/private/ucperformancemonitor_p.h>
+
+UT_USE_NAMESPACE
+
+class RecordingSink : public UCFrameReportSink
+{
+public:
+    RecordingSink(QList<UCFrameReport> *reports, bool itemClasses = true)
+        : m_reports(reports), m_itemClasses(itemClasses) {}
+    void report(const UCFrameReport &report) override
+    {
+        m_reports->append(report);
+    }
+    bool wantsItemClasses() const override
+    {
+        return m_itemClasses;
+    }
+
+private:
+    QList<UCFrameReport> *m_reports;
+    bool m_itemClasses;
+};
+
+class tst_PerformanceMonitor : public QObject
+{
+    Q_OBJECT
+
+private:
+    UCPerformanceMonitor *m_monitor = nullptr;
+    RecordingSink *m_sink = nullptr;
+    QList<UCFrameReport> m_reports;
+
+    // Every frame is reported, the reports are recorded instead of being logged.
+    UCPerformanceMonitor *createMonitor(QList<UCFrameReport> *reports,
+                                        RecordingSink **sink = nullptr)
+    {
+        UCPerformanceMonitor *monitor = new UCPerformanceMonitor(this);
+        monitor->removeSink(monitor->sinks().first());
+        RecordingSink *recordingSink = new RecordingSink(reports);
+        monitor->installSink(recordingSink);
+        if (sink) {
+            *sink = recordingSink;
+        }
+        return monitor;
+    }
+
+    // windows are monitored once they get the focus
+    QQuickView *createView(const QString &title,
+                           const QString &source = QStringLiteral("AnimatedRectangle.qml"))
+    {
+        QQuickView *view = new QQuickView;
+        view->setTitle(title);
+        view->setSource(QUrl::fromLocalFile(QLatin1String(SRCDIR) + source));
+        view->show();
+        view->requestActivate();
+        return view;
+    }
+
+    static int reportCount(const QList<UCFrameReport> &reports, const QString &window)
+    {
+        int count = 0;
+        Q_FOREACH(const UCFrameReport &report, reports) {
+            count += report.window == window;
+        }
+        return count;
+    }
+
+    int reportCount(const QString &window) const
+    {
+        return reportCount(m_reports, window);
+    }
+
+    static bool hasItemClass(const UCFrameReport::ItemClasses &classes, const QByteArray &name)
+    {
+        for (int i = 0; i < classes.count(); i++) {
+            if (classes[i].first == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void setApplicationState(Qt::ApplicationState state)
+    {
+        QWindowSystemInterface::handleApplicationStateChanged(state);
+        QWindowSystemInterface::flushWindowSystemEvents();
+        QTRY_COMPARE(QGuiApplication::applicationState(), state);
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qputenv("UC_PERFORMANCE_MONITOR_SINGLE_FRAME_THRESHOLD", "0");
+        qputenv("UC_PERFORMANCE_MONITOR_WARNING_COUNT_THRESHOLD", "-1");
+        qunsetenv("UC_PERFORMANCE_MONITOR_ITEM_CLASSES");
+        setApplicationState(Qt::ApplicationActive);
+        m_monitor = createMonitor(&m_reports, &m_sink);
+        QCOMPARE(m_monitor->sinks().count(), 2);
+    }
+
+    void cleanupTestCase()
+    {
+        delete m_monitor;
+        m_monitor = nullptr;
+    }
+
+    void init()
+    {
+        setApplicationState(Qt::ApplicationActive);
+        m_reports.clear();
+    }
+
+    void test_reports_of_each_window()
+    {
+        QScopedPointer<QQuickView> first(createView(QStringLiteral("first")));
+        QVERIFY(QTest::qWaitForWindowActive(first.data()));
+        QScopedPointer<QQuickView> second(createView(QStringLiteral("second")));
+        QVERIFY(QTest::qWaitForWindowActive(second.data()));
+
+        QTRY_VERIFY(reportCount(QStringLiteral("first")) > 2);
+        QTRY_VERIFY(reportCount(QStringLiteral("second")) > 2);
+    }
+
+    void test_report_contents()
+    {
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("contents")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("contents")) > 2);
+
+        bool rectangleUpdated = false;
+        quint32 frameNumber = 0;
+        Q_FOREACH(const UCFrameReport &report, m_reports) {
+            if (report.window != QStringLiteral("contents")) {
+                continue;
+            }
+            QCOMPARE(report.frameCount, 1);
+            QVERIFY(report.frameNumber > frameNumber);
+            frameNumber = report.frameNumber;
+            QVERIFY(report.syncTime >= 0);
+            QVERIFY(report.renderTime >= 0);
+            QVERIFY(report.swapTime >= 0);
+            QVERIFY(report.totalTime >= report.syncTime + report.renderTime);
+            QVERIFY(report.updatedItems.count() <= 8);
+            for (int i = 0; i < report.updatedItems.count(); i++) {
+                if (i > 0) {
+                    QVERIFY(report.updatedItems[i - 1].second >= report.updatedItems[i].second);
+                }
+                rectangleUpdated |= report.updatedItems[i].first == "QQuickRectangle";
+            }
+        }
+        QVERIFY(rectangleUpdated);
+    }
+
+    void test_polished_items()
+    {
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("polished"),
+                                                   QStringLiteral("AnimatedRow.qml")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("polished")) > 2);
+
+        int rowPolished = 0;
+        Q_FOREACH(const UCFrameReport &report, m_reports) {
+            if (report.window != QStringLiteral("polished")) {
+                continue;
+            }
+            QVERIFY(report.polishedItems.count() <= 8);
+            for (int i = 1; i < report.polishedItems.count(); i++) {
+                QVERIFY(report.polishedItems[i - 1].second >= report.polishedItems[i].second);
+            }
+            rowPolished += hasItemClass(report.polishedItems, "QQuickRow");
+        }
+        QVERIFY(rowPolished > 0);
+    }
+
+    void test_item_classes_on_demand()
+    {
+        // the default sinks and this one do not list the items, none are recorded
+        m_monitor->removeSink(m_sink);
+        m_sink = new RecordingSink(&m_reports, false);
+        m_monitor->installSink(m_sink);
+
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("no classes"),
+                                                   QStringLiteral("AnimatedRow.qml")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("no classes")) > 2);
+        Q_FOREACH(const UCFrameReport &report, m_reports) {
+            if (report.window != QStringLiteral("no classes")) {
+                continue;
+            }
+            QVERIFY(report.polishedItems.isEmpty());
+            QVERIFY(report.updatedItems.isEmpty());
+        }
+
+        m_monitor->removeSink(m_sink);
+        m_sink = new RecordingSink(&m_reports);
+        m_monitor->installSink(m_sink);
+        m_reports.clear();
+        QTRY_VERIFY(reportCount(QStringLiteral("no classes")) > 2);
+        QTRY_VERIFY(hasItemClass(m_reports.last().polishedItems, "QQuickRow"));
+    }
+
+    void test_window_monitored_once()
+    {
+        // a second engine does not report the windows of the first one again
+        QList<UCFrameReport> reports;
+        QScopedPointer<UCPerformanceMonitor> monitor(createMonitor(&reports));
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("once")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("once")) > 2);
+        QCOMPARE(reports.count(), 0);
+    }
+
+    void test_window_destroyed()
+    {
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("destroyed")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("destroyed")) > 0);
+        view.reset();
+        QTest::qWait(100);
+        m_reports.clear();
+        QTest::qWait(100);
+        QCOMPARE(reportCount(QStringLiteral("destroyed")), 0);
+    }
+
+    void test_inactive_application()
+    {
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("inactive")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("inactive")) > 0);
+
+        setApplicationState(Qt::ApplicationInactive);
+        QTest::qWait(100);
+        m_reports.clear();
+        QTest::qWait(200);
+        QCOMPARE(reportCount(QStringLiteral("inactive")), 0);
+
+        setApplicationState(Qt::ApplicationActive);
+        QTRY_VERIFY(reportCount(QStringLiteral("inactive")) > 0);
+    }
+
+    void test_monitor_deleted_while_rendering()
+    {
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("deleted")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_VERIFY(reportCount(QStringLiteral("deleted")) > 0);
+
+        // the sink goes with the monitor, no report may reach it afterwards
+        delete m_monitor;
+        m_monitor = nullptr;
+        m_sink = nullptr;
+        m_reports.clear();
+        QTest::qWait(200);
+        QCOMPARE(m_reports.count(), 0);
+
+        // the window is released to the other monitors
+        m_monitor = createMonitor(&m_reports, &m_sink);
+        QTRY_VERIFY(reportCount(QStringLiteral("deleted")) > 0);
+    }
+
+    void test_warning_count_threshold()
+    {
+        delete m_monitor;
+        qputenv("UC_PERFORMANCE_MONITOR_WARNING_COUNT_THRESHOLD", "3");
+        m_reports.clear();
+        m_monitor = createMonitor(&m_reports, &m_sink);
+
+        QScopedPointer<QQuickView> view(createView(QStringLiteral("threshold")));
+        QVERIFY(QTest::qWaitForWindowActive(view.data()));
+        QTRY_COMPARE(m_reports.count(), 3);
+        QTest::qWait(200);
+        QCOMPARE(m_reports.count(), 3);
+
+        // the monitoring does not start again
+        setApplicationState(Qt::ApplicationInactive);
+        setApplicationState(Qt::ApplicationActive);
+        QTest::qWait(200);
+        QCOMPARE(m_reports.count(), 3);
+    }
+};
+
+QTEST_MAIN(tst_PerformanceMonitor)
+
+#include "tst_performancemonitor.moc"
@@ -93,6 +93,133 @@ private Q_SLOTS:
         QCOMPARE(size, returnedSize);
         QCOMPARE(result.size(), resultSize);
     }
+
+    void asynchronousResponse() {
+        UCScalingImageProvider provider;
+        QString id("0.5/" + QDir::currentPath() + QDir::separator() + "input.png");
+
+        for (int i = 0; i < 2; i++) {
+            // second iteration is served from the cache
+            QScopedPointer<QQuickImageResponse> response(provider.requestImageResponse(id, QSize()));
+            QSignalSpy finishedSpy(response.data(), SIGNAL(finished()));
+            // finished() is queued, even for cached images
+            QCOMPARE(finishedSpy.count(), 0);
+            QVERIFY(finishedSpy.wait());
+            QCOMPARE(finishedSpy.count(), 1);
+            QVERIFY(response->errorString().isEmpty());
+            QScopedPointer<QQuickTextureFactory> factory(response->textureFactory());
+            QCOMPARE(factory->image(), QImage("scaled_half.png"));
+        }
+    }
+
+    void asynchronousResponseError() {
+        UCScalingImageProvider provider;
+        QScopedPointer<QQuickImageResponse> response(
+            provider.requestImageResponse("1/" + QDir::currentPath() + QDir::separator() + "missing.png", QSize()));
+        // the missing file fails fast, but finished() is still queued to this thread so it
+        // cannot be emitted before the spy connects
+        QSignalSpy finishedSpy(response.data(), SIGNAL(finished()));
+        QCOMPARE(finishedSpy.count(), 0);
+        QVERIFY(finishedSpy.wait());
+        QCOMPARE(finishedSpy.count(), 1);
+        QVERIFY(!response->errorString().isEmpty());
+    }
+
+    void sharedDecoding() {
+        UCScalingImageProvider provider;
+        QString id("0.5/" + QDir::currentPath() + QDir::separator() + "input.png");
+
+        // concurrent requests of the same image are served by a single decoding
+        QScopedPointer<QQuickImageResponse> first(provider.requestImageResponse(id, QSize()));
+        QScopedPointer<QQuickImageResponse> second(provider.requestImageResponse(id, QSize()));
+        QSignalSpy firstSpy(first.data(), SIGNAL(finished()));
+        QSignalSpy secondSpy(second.data(), SIGNAL(finished()));
+        QTRY_COMPARE(firstSpy.count(), 1);
+        QTRY_COMPARE(secondSpy.count(), 1);
+
+        QScopedPointer<QQuickTextureFactory> firstFactory(first->textureFactory());
+        QScopedPointer<QQuickTextureFactory> secondFactory(second->textureFactory());
+        QCOMPARE(firstFactory->image(), QImage("scaled_half.png"));
+        QCOMPARE(firstFactory->image().cacheKey(), secondFactory->image().cacheKey());
+    }
+
+    void cancelledResponseFinishes() {
+        UCScalingImageProvider provider;
+        QString id("0.5/" + QDir::currentPath() + QDir::separator() + "input.png");
+
+        QPointer<QQuickImageResponse> cancelled(provider.requestImageResponse(id, QSize()));
+        QScopedPointer<QQuickImageResponse> response(provider.requestImageResponse(id, QSize()));
+        QSignalSpy cancelledSpy(cancelled.data(), SIGNAL(finished()));
+        QSignalSpy responseSpy(response.data(), SIGNAL(finished()));
+
+        // the engine deletes cancelled responses once finished
+        cancelled->cancel();
+        connect(cancelled.data(), &QQuickImageResponse::finished,
+                cancelled.data(), &QObject::deleteLater);
+        QTRY_VERIFY(cancelled.isNull());
+        QCOMPARE(cancelledSpy.count(), 1);
+
+        // the decoding goes on for the other response
+        QTRY_COMPARE(responseSpy.count(), 1);
+        QScopedPointer<QQuickTextureFactory> factory(response->textureFactory());
+        QCOMPARE(factory->image(), QImage("scaled_half.png"));
+    }
+
+    void pendingResponsesFinishOnDestruction() {
+        QList<QSharedPointer<QQuickImageResponse> > responses;
+        QList<QSharedPointer<QSignalSpy> > spies;
+        {
+            UCScalingImageProvider provider;
+            QString id("1/" + QDir::currentPath() + QDir::separator() + "input.png");
+            // distinct sizes are distinct decodings, more than the threads to run them
+            for (int i = 1; i <= 32; i++) {
+                QSharedPointer<QQuickImageResponse> response(
+                    provider.requestImageResponse(id, QSize(i, i)));
+                spies.append(QSharedPointer<QSignalSpy>(
+                    new QSignalSpy(response.data(), SIGNAL(finished()))));
+                responses.append(response);
+            }
+        }
+        for (int i = 0; i < spies.count(); i++) {
+            QTRY_COMPARE(spies.at(i)->count(), 1);
+        }
+    }
+
+    void cachedImageSurvivesFileRemoval() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path(dir.path() + "/input.png");
+        QVERIFY(QFile::copy("input.png", path));
+
+        UCScalingImageProvider provider;
+        QSize size;
+        QImage expected = QImage("scaled_half.png");
+        QCOMPARE(provider.requestImage("0.5/" + path, &size, QSize()), expected);
+
+        QVERIFY(QFile::remove(path));
+        QCOMPARE(provider.requestImage("0.5/" + path, &size, QSize()), expected);
+        QCOMPARE(size, expected.size());
+
+        provider.clearCache();
+        QVERIFY(provider.requestImage("0.5/" + path, &size, QSize()).isNull());
+    }
+
+    void cacheSize() {
+        UCScalingImageProvider provider;
+        QCOMPARE(provider.cacheSize(), int(UCScalingImageProvider::defaultCacheSize));
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path(dir.path() + "/input.png");
+        QVERIFY(QFile::copy("input.png", path));
+
+        // images bigger than the cache are not kept
+        provider.setCacheSize(0);
+        QSize size;
+        QVERIFY(!provider.requestImage("1/" + path, &size, QSize()).isNull());
+        QVERIFY(QFile::remove(path));
+        QVERIFY(provider.requestImage("1/" + path, &size, QSize()).isNull());
+    }
 };
 
 QTEST_MAIN(tst_UCScalingImageProvider)
@@ -15,7 +15,16 @@
  */
 
 #include <QtCore/QDebug>
+#include <QtCore/QMutex>
+#include <QtCore/QProcess>
 #include <QtCore/QString>
+#include <QtCore/QThread>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusVariant>
+#include <QtDBus/QDBusVirtualObject>
 #include <QtTest/QSignalSpy>
 #include <QtTest/QTest>
 #include <UbuntuToolkit/private/ucserviceproperties_p_p.h>
@@ -24,6 +33,114 @@
 
 UT_USE_NAMESPACE
 
+static const QString fixtureBus = QStringLiteral("fixture");
+static const QString accountsService = QStringLiteral("org.freedesktop.Accounts");
+static const QString accountsPath = QStringLiteral("/org/freedesktop/Accounts");
+static const QString userPath = QStringLiteral("/org/freedesktop/Accounts/User1000");
+static const QString soundInterface = QStringLiteral("com.ubuntu.touch.AccountsService.Sound");
+static const QString propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+
+// AccountsService stand-in on a private bus, counting the calls it receives. It lives in its own
+// thread so that it can answer the synchronous calls made from the GUI thread.
+class FakeAccountsService : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    FakeAccountsService()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_properties.clear();
+        m_properties.insert(QStringLiteral("IncomingCallVibrate"), true);
+        m_properties.insert(QStringLiteral("SilentMode"), false);
+        m_properties.insert(QStringLiteral("IncomingCallSound"), QStringLiteral("ring.ogg"));
+        m_calls.clear();
+    }
+
+    void setValue(const QString &property, const QVariant &value)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_properties.insert(property, value);
+    }
+
+    int callCount(const QString &member) const
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_calls.value(member);
+    }
+
+    int totalCallCount() const
+    {
+        QMutexLocker lock(&m_mutex);
+        int count = 0;
+        Q_FOREACH(int calls, m_calls) {
+            count += calls;
+        }
+        return count;
+    }
+
+    QString introspect(const QString &path) const override
+    {
+        Q_UNUSED(path);
+        countCall(QStringLiteral("Introspect"));
+        return QString();
+    }
+
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override
+    {
+        countCall(message.member());
+        QMutexLocker lock(&m_mutex);
+        QDBusMessage reply;
+        if (message.member() == QStringLiteral("FindUserById")) {
+            reply = message.createReply(QVariant::fromValue(QDBusObjectPath(userPath)));
+        } else if (message.path() != userPath || message.interface() != propertiesInterface) {
+            reply = message.createErrorReply(QDBusError::UnknownMethod, message.member());
+        } else if (message.member() == QStringLiteral("GetAll")) {
+            const bool sound = message.arguments().value(0).toString() == soundInterface;
+            reply = message.createReply(sound ? m_properties : QVariantMap());
+        } else if (message.member() == QStringLiteral("Get")) {
+            const QString property = message.arguments().value(1).toString();
+            reply = m_properties.contains(property)
+                ? message.createReply(QVariant::fromValue(QDBusVariant(m_properties.value(property))))
+                : message.createErrorReply(QDBusError::InvalidArgs,
+                                           QStringLiteral("No such property '%1'").arg(property));
+        } else if (message.member() == QStringLiteral("Set")) {
+            const QString property = message.arguments().value(1).toString();
+            m_properties.insert(property, message.arguments().value(2).value<QDBusVariant>().variant());
+            connection.send(message.createReply());
+            connection.send(propertiesChanged(QVariantMap(), QStringList() << property));
+            return true;
+        } else {
+            reply = message.createErrorReply(QDBusError::UnknownMethod, message.member());
+        }
+        connection.send(reply);
+        return true;
+    }
+
+    static QDBusMessage propertiesChanged(const QVariantMap &changed, const QStringList &invalidated)
+    {
+        QDBusMessage signal = QDBusMessage::createSignal(
+            userPath, propertiesInterface, QStringLiteral("PropertiesChanged"));
+        signal << soundInterface << changed << invalidated;
+        return signal;
+    }
+
+private:
+    void countCall(const QString &member) const
+    {
+        QMutexLocker lock(&m_mutex);
+        m_calls[member]++;
+    }
+
+    mutable QMutex m_mutex;
+    mutable QHash<QString, int> m_calls;
+    QVariantMap m_properties;
+};
+
 class tst_ServiceProperties : public QObject
 {
     Q_OBJECT
@@ -34,6 +151,50 @@ public:
 private:
 
     QString error;
+    QString busError;
+    QProcess busDaemon;
+    QThread serviceThread;
+    FakeAccountsService *accounts = nullptr;
+
+    // Starts a private session bus serving the AccountsService stand-in. It must be the session bus
+    // of the process, so it has to be up before anything connects to the session bus.
+    void startPrivateBus()
+    {
+        busDaemon.start(QStringLiteral("dbus-daemon"),
+                        QStringList() << "--session" << "--nofork" << "--print-address");
+        if (!busDaemon.waitForStarted()) {
+            busError = "Skip test: dbus-daemon is not available";
+            return;
+        }
+        while (!busDaemon.canReadLine() && busDaemon.waitForReadyRead()) {
+        }
+        const QByteArray address = busDaemon.readLine().trimmed();
+        qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+
+        QDBusConnection bus = QDBusConnection::connectToBus(QString::fromLatin1(address), fixtureBus);
+        if (!bus.isConnected() || !bus.registerService(accountsService)) {
+            busError = "Skip test: cannot connect to the private bus";
+            return;
+        }
+        accounts = new FakeAccountsService;
+        accounts->moveToThread(&serviceThread);
+        serviceThread.start();
+        bus.registerVirtualObject(accountsPath, accounts, QDBusConnection::SubPath);
+
+        if (!QDBusConnection::sessionBus().interface()->isServiceRegistered(bus.baseService())) {
+            busError = "Skip test: the session bus is not the private one";
+        }
+    }
+
+    UCServiceProperties *waitForActive(UbuntuTestCase *test)
+    {
+        UCServiceProperties *watcher = static_cast<UCServiceProperties*>(test->rootObject()->property("service").value<QObject*>());
+        if (watcher && watcher->status() == UCServiceProperties::Synchronizing) {
+            QSignalSpy wait(watcher, SIGNAL(statusChanged()));
+            wait.wait();
+        }
+        return watcher;
+    }
 
     // FIXME use UbuntuTestCase::ignoreWaring in Vivid
     void ignoreWarning(const QString& fileName, uint line, uint column, const QString& message, uint occurences=1)
@@ -50,6 +211,8 @@ private Q_SLOTS:
 
     void initTestCase()
     {
+        startPrivateBus();
+
         // check if the connection is possible, otherwise we must skip all tests
         QScopedPointer<UbuntuTestCase> test(new UbuntuTestCase("IncomingCallVibrateWatcher.qml"));
         UCServiceProperties *watcher = static_cast<UCServiceProperties*>(test->rootObject()->property("service").value<QObject*>());
@@ -64,6 +227,23 @@ private Q_SLOTS:
         }
     }
 
+    void cleanupTestCase()
+    {
+        QDBusConnection::disconnectFromBus(fixtureBus);
+        serviceThread.quit();
+        serviceThread.wait();
+        delete accounts;
+        busDaemon.terminate();
+        busDaemon.waitForFinished();
+    }
+
+    void init()
+    {
+        if (accounts) {
+            accounts->reset();
+        }
+    }
+
     void cleanup()
     {
         // restore env var setting
@@ -211,6 +391,71 @@ private Q_SLOTS:
         QCOMPARE(watcher->property("error").toString(), QString("Changing connection parameters forbidden."));
     }
 
+    void test_startup_round_trips()
+    {
+        if (!busError.isEmpty()) {
+            QSKIP(qPrintable(busError));
+        }
+        QScopedPointer<UbuntuTestCase> test(new UbuntuTestCase("SessionBusWatcher.qml"));
+        UCServiceProperties *watcher = waitForActive(test.data());
+        QVERIFY(watcher);
+        QCOMPARE(watcher->status(), UCServiceProperties::Active);
+        QCOMPARE(watcher->property("incomingCallVibrate").toBool(), true);
+        QCOMPARE(watcher->property("incomingCallSound").toString(), QString("ring.ogg"));
+
+        qDebug() << "startup round-trips:" << accounts->totalCallCount();
+        // one call to find the user and one to read all the properties, no introspection
+        QCOMPARE(accounts->callCount("FindUserById"), 1);
+        QCOMPARE(accounts->callCount("GetAll"), 1);
+        QCOMPARE(accounts->callCount("Get"), 0);
+        QCOMPARE(accounts->callCount("Introspect"), 0);
+    }
+
+    void test_coalesced_updates()
+    {
+        if (!busError.isEmpty()) {
+            QSKIP(qPrintable(busError));
+        }
+        QScopedPointer<UbuntuTestCase> test(new UbuntuTestCase("SessionBusWatcher.qml"));
+        UCServiceProperties *watcher = waitForActive(test.data());
+        QVERIFY(watcher);
+        const int getAllCount = accounts->callCount("GetAll");
+
+        accounts->setValue("IncomingCallVibrate", false);
+        accounts->setValue("SilentMode", true);
+        QDBusConnection bus(fixtureBus);
+        bus.send(FakeAccountsService::propertiesChanged(QVariantMap(), QStringList() << "IncomingCallVibrate"));
+        bus.send(FakeAccountsService::propertiesChanged(QVariantMap(), QStringList() << "SilentMode"));
+        bus.send(FakeAccountsService::propertiesChanged(QVariantMap(), QStringList() << "IncomingCallVibrate" << "SilentMode"));
+        // let the signals queue up so that they're handled in the same event loop iteration
+        QThread::msleep(200);
+
+        QTRY_COMPARE(watcher->property("silentMode").toBool(), true);
+        QCOMPARE(watcher->property("incomingCallVibrate").toBool(), false);
+        QCOMPARE(accounts->callCount("GetAll") - getAllCount, 1);
+        QCOMPARE(accounts->callCount("Get"), 0);
+    }
+
+    void test_changed_values_without_round_trip()
+    {
+        if (!busError.isEmpty()) {
+            QSKIP(qPrintable(busError));
+        }
+        QScopedPointer<UbuntuTestCase> test(new UbuntuTestCase("SessionBusWatcher.qml"));
+        UCServiceProperties *watcher = waitForActive(test.data());
+        QVERIFY(watcher);
+        const int callCount = accounts->totalCallCount();
+
+        QVariantMap changed;
+        changed.insert("SilentMode", true);
+        QSignalSpy spy(watcher, SIGNAL(silentModeChanged()));
+        QDBusConnection(fixtureBus).send(FakeAccountsService::propertiesChanged(changed, QStringList()));
+        spy.wait(400);
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(watcher->property("silentMode").toBool(), true);
+        QCOMPARE(accounts->totalCallCount(), callCount);
+    }
+
 };
 
 QTEST_MAIN(tst_ServiceProperties)
@@ -45,6 +45,13 @@
 
 UT_USE_NAMESPACE
 
+// has no QDataStream operators
+struct Unstreamable
+{
+    int value;
+};
+Q_DECLARE_METATYPE(Unstreamable)
+
 class tst_StateSaverTest : public QObject
 {
     Q_OBJECT
@@ -224,6 +231,52 @@ private Q_SLOTS:
         QVERIFY(testItem->property("horizontalAlignment") == Qt::AlignRight);
     }
 
+    void test_BinaryArchive()
+    {
+        StateSaverBackend::instance()->setArchiveFormat(StateSaverBackend::BinaryFormat);
+        QScopedPointer<QQuickView> view(createView("SaveEnum.qml"));
+        QVERIFY(view);
+        QObject *testItem = view->rootObject();
+        QVERIFY(testItem);
+
+        testItem->setProperty("horizontalAlignment", Qt::AlignRight);
+
+        resetView(view, "SaveEnum.qml");
+        QVERIFY(QFile::exists(stateFile("savedstate") + ".bin"));
+        QVERIFY(view);
+        testItem = view->rootObject();
+        QVERIFY(testItem);
+        QVERIFY(testItem->property("horizontalAlignment") == Qt::AlignRight);
+
+        StateSaverBackend::instance()->setArchiveFormat(StateSaverBackend::IniFormat);
+        QVERIFY(!QFile::exists(stateFile("savedstate") + ".bin"));
+    }
+
+    void test_BinaryArchiveUnstreamableValue()
+    {
+        StateSaverBackend::instance()->setArchiveFormat(StateSaverBackend::BinaryFormat);
+        StateSaverArchive *archive = StateSaverBackend::instance()->m_archive.data();
+        QVariantHash properties;
+        properties.insert("text", QString("saved"));
+        properties.insert("unstreamable", QVariant::fromValue(Unstreamable{42}));
+        properties.insert("number", 7);
+
+        QTest::ignoreMessage(QtWarningMsg, QRegularExpression("unable to save type"));
+        QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Cannot save property.*unstreamable"));
+        archive->store("item", properties);
+        archive->sync();
+        QVERIFY(QFile::exists(stateFile("savedstate") + ".bin"));
+
+        // reload the archive, the other values survive
+        archive->sync();
+        QVariantHash restored = archive->take("item");
+        QCOMPARE(restored.size(), 2);
+        QCOMPARE(restored.value("text"), QVariant(QString("saved")));
+        QCOMPARE(restored.value("number"), QVariant(7));
+
+        StateSaverBackend::instance()->setArchiveFormat(StateSaverBackend::IniFormat);
+    }
+
     void test_SavePropertyGroup()
     {
         QScopedPointer<QQuickView> view(createView("SavePropertyGroups.qml"));
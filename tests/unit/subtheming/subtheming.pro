@@ -32,6 +32,7 @@ OTHER_FILES += \
     StyledItemAppThemeVersioned.qml \
     StyleOverride.qml \
     StyleKept.qml \
+    DeferredStyles.qml \
     SimplePropertyHints.qml \
     StyleHintsWithSignal.qml \
     StyleHintsWithObject.qml \
@@ -805,6 +805,57 @@ private Q_SLOTS:
         QCOMPARE(QuickUtils::className(styleItem), QString("ButtonStyle"));
     }
 
+    void test_style_loaded_when_visible()
+    {
+        QScopedPointer<ThemeTestCase> view(new ThemeTestCase("DeferredStyles.qml"));
+        UCStyledItemBase *visible = view->findItem<UCStyledItemBase*>("VisibleButton");
+        UCStyledItemBase *hidden = view->findItem<UCStyledItemBase*>("HiddenButton");
+
+        QTRY_VERIFY(UCStyledItemBasePrivate::get(visible)->styleInstance());
+        QVERIFY(!UCStyledItemBasePrivate::get(hidden)->styleInstance());
+
+        hidden->setY(0);
+        QTRY_VERIFY(UCStyledItemBasePrivate::get(hidden)->styleInstance());
+    }
+
+    void test_deferred_style_loaded_when_mode_changes()
+    {
+        QScopedPointer<ThemeTestCase> view(new ThemeTestCase("DeferredStyles.qml"));
+        UCStyledItemBase *hidden = view->findItem<UCStyledItemBase*>("HiddenButton");
+        QVERIFY(!UCStyledItemBasePrivate::get(hidden)->styleInstance());
+
+        hidden->setProperty("styleLoading", UCStyledItemBase::Immediate);
+        QVERIFY(UCStyledItemBasePrivate::get(hidden)->styleInstance());
+    }
+
+    void test_style_incubated_asynchronously()
+    {
+        UCStyledItemBasePrivate::resetStyleCreationCounters();
+        QScopedPointer<ThemeTestCase> view(new ThemeTestCase("DeferredStyles.qml"));
+        UCStyledItemBase *button = view->findItem<UCStyledItemBase*>("AsynchronousButton");
+
+        QTRY_VERIFY(UCStyledItemBasePrivate::get(button)->styleInstance());
+        QCOMPARE(QuickUtils::className(UCStyledItemBasePrivate::get(button)->styleInstance()),
+                 QString("ButtonStyle"));
+        QCOMPARE(UCStyledItemBasePrivate::get(button)->styleInstance()->parentItem(),
+                 static_cast<QQuickItem*>(button));
+
+        const UCStyleCreationCounter counter =
+            UCStyledItemBasePrivate::styleCreationCounters().value("ButtonStyle");
+        QCOMPARE(counter.asynchronousCount, 1);
+        QVERIFY(counter.count >= counter.asynchronousCount);
+        QVERIFY(counter.maximumTime > 0);
+        QVERIFY(counter.totalTime >= counter.maximumTime);
+    }
+
+    void test_deferred_style_cancelled_on_deletion()
+    {
+        QScopedPointer<ThemeTestCase> view(new ThemeTestCase("DeferredStyles.qml"));
+        UCStyledItemBase *button = view->findItem<UCStyledItemBase*>("AsynchronousButton");
+        delete button;
+        QTest::qWait(100);
+    }
+
     void test_stylename_extension_failure()
     {
         ThemeTestCase::ignoreWarning("DeprecatedTheme.qml", 19, 1, "QML StyledItem: Warning: Style OptionSelectorStyle.qml.qml not found in theme Ubuntu.Components.Themes.SuruGradient");
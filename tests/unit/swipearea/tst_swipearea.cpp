@@ -962,9 +962,9 @@ void tst_UCSwipeArea::withdrawTouchOwnershipCandidacyIfDisabledDuringRecognition
     // edgeDragArea should be an undecided candidate
     {
         auto touchInfo = m_touchRegistry->findTouchInfo(0);
-        QCOMPARE(touchInfo->candidates.size(), 1);
-        QCOMPARE(touchInfo->candidates.at(0).item.data(), edgeDragArea);
-        QCOMPARE(touchInfo->candidates.at(0).state, TouchRegistry::CandidateInfo::Undecided);
+        QCOMPARE(touchInfo->candidateCount(), 1);
+        QCOMPARE(touchInfo->candidateItems.at(0).data(), edgeDragArea);
+        QCOMPARE(touchInfo->candidateStates.at(0), TouchRegistry::CandidateInfo::Undecided);
     }
 
     // disable the swipeArea while it's still recognizing a possible drag gesture.
@@ -978,7 +978,7 @@ void tst_UCSwipeArea::withdrawTouchOwnershipCandidacyIfDisabledDuringRecognition
     // edgeDragArea should no longer be a candidate
     {
         auto touchInfo = m_touchRegistry->findTouchInfo(0);
-        QCOMPARE(touchInfo->candidates.size(), 0);
+        QCOMPARE(touchInfo->candidateCount(), 0);
     }
 
     QCOMPARE((int)d->status, (int)UCSwipeAreaPrivate::WaitingForTouch);
@@ -48,6 +48,14 @@ Q_SIGNALS:
     void lostOwnership();
 };
 
+// Only counts the events it gets, for benchmarking.
+class CountingCandidate : public QQuickItem
+{
+public:
+    bool event(QEvent *e) override;
+    int unownedTouchEventCount = 0;
+};
+
 class tst_TouchRegistry : public QObject
 {
     Q_OBJECT
@@ -73,6 +81,7 @@ private Q_SLOTS:
     void interimOwnerWontGetUnownedTouchEvents();
     void candidateVanishes();
     void candicateOwnershipReentrace();
+    void benchmarkTenFingers();
 
 private:
     TouchRegistry *touchRegistry;
@@ -920,6 +929,75 @@ void tst_TouchRegistry::candicateOwnershipReentrace()
     QCOMPARE(candicate3.lostTouches.count(), 1);
 }
 
+/*
+  Replays a ten finger sequence as it would be recorded on a 120 Hz touchscreen: fingers land one
+  after the other, each one getting two undecided candidates and a watcher, move together for a
+  second and then lift off, the candidates giving up on them.
+ */
+void tst_TouchRegistry::benchmarkTenFingers()
+{
+    const int fingerCount = 10;
+    const int moveFrameCount = 120;
+
+    QList<QTouchEvent*> events;
+    for (int frame = 0; frame < fingerCount * 2 + moveFrameCount; ++frame) {
+        QList<QTouchEvent::TouchPoint> touchPoints;
+        Qt::TouchPointStates states = 0;
+        for (int finger = 0; finger < fingerCount; ++finger) {
+            Qt::TouchPointState state;
+            if (frame < fingerCount) {
+                if (finger > frame)
+                    break;
+                state = finger == frame ? Qt::TouchPointPressed : Qt::TouchPointStationary;
+            } else if (frame < fingerCount + moveFrameCount) {
+                state = Qt::TouchPointMoved;
+            } else {
+                const int releasedFinger = frame - fingerCount - moveFrameCount;
+                if (finger < releasedFinger)
+                    continue;
+                state = finger == releasedFinger ? Qt::TouchPointReleased
+                                                 : Qt::TouchPointStationary;
+            }
+            QTouchEvent::TouchPoint touchPoint(finger);
+            touchPoint.setState(state);
+            touchPoint.setPos(QPointF(finger * 50.0, frame * 2.0));
+            touchPoints.append(touchPoint);
+            states |= state;
+        }
+        const QEvent::Type type = frame == 0 ? QEvent::TouchBegin
+            : frame == fingerCount * 2 + moveFrameCount - 1 ? QEvent::TouchEnd
+            : QEvent::TouchUpdate;
+        events.append(new QTouchEvent(type, 0 /* device */, Qt::NoModifier, states,
+                                      touchPoints));
+    }
+
+    touchRegistry->setTimerFactory(new FakeTimerFactory);
+    CountingCandidate candidates[fingerCount][2];
+    CountingCandidate watcher;
+
+    QBENCHMARK {
+        Q_FOREACH(QTouchEvent *event, events) {
+            touchRegistry->update(event);
+            Q_FOREACH(const QTouchEvent::TouchPoint &touchPoint, event->touchPoints()) {
+                const int id = touchPoint.id();
+                if (touchPoint.state() == Qt::TouchPointPressed) {
+                    touchRegistry->addCandidateOwnerForTouch(id, &candidates[id][0]);
+                    touchRegistry->addCandidateOwnerForTouch(id, &candidates[id][1]);
+                    touchRegistry->addTouchWatcher(id, &watcher);
+                } else if (touchPoint.state() == Qt::TouchPointReleased) {
+                    touchRegistry->removeCandidateOwnerForTouch(id, &candidates[id][0]);
+                    touchRegistry->removeCandidateOwnerForTouch(id, &candidates[id][1]);
+                }
+            }
+        }
+    }
+
+    QVERIFY(touchRegistry->m_touchInfoPool.isEmpty());
+    QVERIFY(candidates[0][0].unownedTouchEventCount > 0);
+    QVERIFY(watcher.unownedTouchEventCount > 0);
+    qDeleteAll(events);
+}
+
 ////////////// TouchMemento //////////
 
 TouchMemento::TouchMemento(const QTouchEvent *touchEvent)
@@ -968,6 +1046,20 @@ bool DummyCandidate::event(QEvent *e)
     }
 }
 
+////////////// CountingCandidate //////////
+
+bool CountingCandidate::event(QEvent *e)
+{
+    if (e->type() == UnownedTouchEvent::unownedTouchEventType()) {
+        ++unownedTouchEventCount;
+        return true;
+    } else if (e->type() == TouchOwnershipEvent::touchOwnershipEventType()) {
+        return true;
+    } else {
+        return QObject::event(e);
+    }
+}
+
 UG_NAMESPACE_END
 
 QTEST_GUILESS_MAIN(UG_PREPEND_NAMESPACE(tst_TouchRegistry))
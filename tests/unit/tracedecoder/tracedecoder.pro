@@ -0,0 +1,13 @@
+include(../test-include.pri)
+
+QT += UbuntuMetrics-private
+
+DECODER_DIR = $$ROOT_SOURCE_DIR/src/UbuntuMetrics/tools/tracedecoder
+INCLUDEPATH += $$DECODER_DIR
+
+HEADERS += \
+    $$DECODER_DIR/decoder.h
+
+SOURCES += \
+    $$DECODER_DIR/decoder.cpp \
+    tst_tracedecoder.cpp
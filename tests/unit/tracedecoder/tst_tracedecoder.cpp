@@ -0,0 +1,275 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+#include <UbuntuMetrics/events.h>
+#include <UbuntuMetrics/logger.h>
+#include <UbuntuMetrics/private/logger_p.h>
+
+#include "decoder.h"
+
+// Cycles through the event types.
+static UMEvent sampleEvent(int index)
+{
+    UMEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = static_cast<UMEvent::Type>(index % UMEvent::TypeCount);
+    event.timeStamp = 1000000 * (index + 1);
+    switch (event.type) {
+    case UMEvent::Process:
+        event.process.vszMemory = 1000 + index;
+        event.process.rssMemory = 500 + index;
+        event.process.cpuUsage = index % 100;
+        event.process.threadCount = 4;
+        break;
+    case UMEvent::Window:
+        event.window.id = 1;
+        event.window.width = 320 + index;
+        event.window.height = 240;
+        event.window.state = UMWindowEvent::Resized;
+        break;
+    case UMEvent::Frame:
+        event.frame.window = 1;
+        event.frame.number = index;
+        event.frame.deltaTime = 16000000;
+        event.frame.syncTime = 1000 * index;
+        event.frame.renderTime = 2000 * index;
+        event.frame.gpuTime = 3000 * index;
+        event.frame.swapTime = 4000 * index;
+        break;
+    case UMEvent::Generic: {
+        const QByteArray string = QByteArray("event \"") + QByteArray::number(index) + '"';
+        event.generic.id = 2;
+        event.generic.stringSize = string.size() + 1;
+        memcpy(event.generic.string, string.constData(), event.generic.stringSize);
+        break;
+    }
+    default:
+        break;
+    }
+    return event;
+}
+
+class tst_TraceDecoder : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_dir;
+
+    QString path(const QString &name) const
+    {
+        return m_dir.path() + QLatin1Char('/') + name;
+    }
+
+    static QByteArray readFile(const QString &fileName)
+    {
+        QFile file(fileName);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    // Logs the events in a binary trace and in the expected text output.
+    QByteArray writeTrace(int eventCount, quint32 eventCapacity, QByteArray *text = nullptr)
+    {
+        const QString traceName = path(QStringLiteral("trace.bin"));
+        const QString textName = path(QStringLiteral("trace.txt"));
+        {
+            UMBinaryLogger logger(traceName,
+                                  sizeof(UMBinaryLogHeader) + eventCapacity * sizeof(UMEvent));
+            UMFileLogger textLogger(textName, true);
+            if (!logger.isOpen() || !textLogger.isOpen()) {
+                return QByteArray();
+            }
+            for (int i = 0; i < eventCount; i++) {
+                const UMEvent event = sampleEvent(i);
+                logger.log(event);
+                // the trace only keeps the last events
+                if (i >= eventCount - static_cast<int>(eventCapacity)) {
+                    textLogger.log(event);
+                }
+            }
+        }
+        if (text) {
+            *text = readFile(textName);
+        }
+        return readFile(traceName);
+    }
+
+    static bool decode(const QByteArray &trace, bool csv, QByteArray *output, QString *error)
+    {
+        FILE *file = tmpfile();
+        if (!file) {
+            return false;
+        }
+        const bool decoded = umDecodeTrace(reinterpret_cast<const uchar*>(trace.constData()),
+                                           trace.size(), csv, file, error);
+        fflush(file);
+        rewind(file);
+        QFile reader;
+        reader.open(file, QIODevice::ReadOnly);
+        *output = reader.readAll();
+        reader.close();
+        fclose(file);
+        return decoded;
+    }
+
+    static UMBinaryLogHeader *header(QByteArray *trace)
+    {
+        return reinterpret_cast<UMBinaryLogHeader*>(trace->data());
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_dir.isValid());
+    }
+
+    void roundTrip_data()
+    {
+        QTest::addColumn<int>("eventCount");
+        QTest::addColumn<int>("eventCapacity");
+
+        QTest::newRow("empty") << 0 << 8;
+        QTest::newRow("partial") << 5 << 8;
+        QTest::newRow("full") << 8 << 8;
+        QTest::newRow("wrapped") << 13 << 8;
+        QTest::newRow("wrapped twice") << 21 << 4;
+    }
+    void roundTrip()
+    {
+        QFETCH(int, eventCount);
+        QFETCH(int, eventCapacity);
+
+        QByteArray text;
+        const QByteArray trace = writeTrace(eventCount, eventCapacity, &text);
+        QVERIFY(trace.size() >= static_cast<int>(sizeof(UMBinaryLogHeader)));
+
+        QByteArray output;
+        QString error;
+        QVERIFY2(decode(trace, false, &output, &error), qPrintable(error));
+        QCOMPARE(output.count('\n'), qMin(eventCount, eventCapacity));
+        QCOMPARE(output, text);
+    }
+
+    void csv()
+    {
+        const QByteArray trace = writeTrace(4, 8);
+        QByteArray output;
+        QString error;
+        QVERIFY2(decode(trace, true, &output, &error), qPrintable(error));
+
+        const QList<QByteArray> lines = output.split('\n');
+        QCOMPARE(lines.count(), 6);
+        QCOMPARE(lines[0], QByteArray("type,timeStamp,field1,field2,field3,field4,field5,field6,"
+                                      "field7,string"));
+        QCOMPARE(lines[1], QByteArray("process,1000000,0,1000,500,4,,,,"));
+        QCOMPARE(lines[2], QByteArray("window,2000000,1,2,321,240,,,,"));
+        QCOMPARE(lines[3], QByteArray("frame,3000000,1,2,16000000,2000,4000,6000,8000,"));
+        QCOMPARE(lines[4], QByteArray("generic,4000000,2,,,,,,,\"event \"\"3\"\"\""));
+        QCOMPARE(lines[5], QByteArray());
+    }
+
+    // A crashed application may leave fewer records than it logged.
+    void truncatedPartialTrace()
+    {
+        QByteArray trace = writeTrace(3, 8);
+        trace.chop(sizeof(UMEvent) + 1);
+        header(&trace)->eventCount = 3;
+
+        QByteArray output;
+        QString error;
+        QVERIFY2(decode(trace, false, &output, &error), qPrintable(error));
+        QCOMPARE(output.count('\n'), 1);
+    }
+
+    void invalidTrace_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::addColumn<QByteArray>("magic");
+        QTest::addColumn<quint32>("version");
+        QTest::addColumn<quint32>("byteOrder");
+        QTest::addColumn<quint32>("headerSize");
+        QTest::addColumn<quint32>("eventSize");
+        QTest::addColumn<quint32>("eventCapacity");
+
+        // -1 keeps the size of the trace, 0 keeps the value of the field
+        const QByteArray magic("UMTRACE");
+        const quint32 headerSize = sizeof(UMBinaryLogHeader);
+        QTest::newRow("empty") << 0 << magic << 0u << 0u << 0u << 0u << 0u;
+        QTest::newRow("short header") << 64 << magic << 0u << 0u << 0u << 0u << 0u;
+        QTest::newRow("magic") << -1 << QByteArray("UMTRACX") << 0u << 0u << 0u << 0u << 0u;
+        QTest::newRow("version") << -1 << magic << 2u << 0u << 0u << 0u << 0u;
+        QTest::newRow("byte order") << -1 << magic << 0u << 0x04030201u << 0u << 0u << 0u;
+        QTest::newRow("event size") << -1 << magic << 0u << 0u << 0u << 64u << 0u;
+        QTest::newRow("no capacity") << -1 << magic << 0u << 0u << 0u << 0u << ~0u;
+        QTest::newRow("header size too small") << -1 << magic << 0u << 0u << 64u << 0u << 0u;
+        QTest::newRow("header size null") << -1 << magic << 0u << 0u << ~0u << 0u << 0u;
+        QTest::newRow("header size beyond file")
+            << -1 << magic << 0u << 0u << headerSize + 9 * 128 << 0u << 0u;
+        QTest::newRow("header size overflow") << -1 << magic << 0u << 0u << 0xffffff80u
+                                              << 0u << 0u;
+        QTest::newRow("truncated ring") << int(headerSize + 3 * 128) << magic << 0u << 0u << 0u
+                                        << 0u << 0u;
+    }
+    void invalidTrace()
+    {
+        QFETCH(int, size);
+        QFETCH(QByteArray, magic);
+        QFETCH(quint32, version);
+        QFETCH(quint32, byteOrder);
+        QFETCH(quint32, headerSize);
+        QFETCH(quint32, eventSize);
+        QFETCH(quint32, eventCapacity);
+
+        // a wrapped ring buffer of 8 records
+        QByteArray trace = writeTrace(10, 8);
+        QCOMPARE(trace.size(), static_cast<int>(sizeof(UMBinaryLogHeader) + 8 * sizeof(UMEvent)));
+        UMBinaryLogHeader *traceHeader = header(&trace);
+        memcpy(traceHeader->magic, magic.constData(), sizeof(traceHeader->magic));
+        if (version) {
+            traceHeader->version = version;
+        }
+        if (byteOrder) {
+            traceHeader->byteOrder = byteOrder;
+        }
+        if (headerSize) {
+            traceHeader->headerSize = headerSize == ~0u ? 0 : headerSize;
+        }
+        if (eventSize) {
+            traceHeader->eventSize = eventSize;
+        }
+        if (eventCapacity) {
+            traceHeader->eventCapacity = eventCapacity == ~0u ? 0 : eventCapacity;
+        }
+        if (size >= 0) {
+            trace.resize(size);
+        }
+
+        QByteArray output;
+        QString error;
+        QVERIFY(!decode(trace, false, &output, &error));
+        QVERIFY(!error.isEmpty());
+        QCOMPARE(output, QByteArray());
+    }
+};
+
+QTEST_MAIN(tst_TraceDecoder)
+
+#include "tst_tracedecoder.moc"
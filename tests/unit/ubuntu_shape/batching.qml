@@ -0,0 +1,47 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.4
+import Ubuntu.Components 1.3
+
+// Grid of untextured shapes with different sizes, radii, aspects and colors.
+Item {
+    id: root
+    width: 900
+    height: 500
+
+    property int frame: 0
+
+    Grid {
+        columns: 20
+        spacing: 5
+
+        Repeater {
+            objectName: "shapes"
+            model: 200
+
+            UbuntuShape {
+                width: 30 + (index % 3) * 5
+                height: 30 + (index % 2) * 5
+                radius: ["small", "medium", "large"][index % 3]
+                aspect: [UbuntuShape.Flat, UbuntuShape.Inset, UbuntuShape.DropShadow][index % 3]
+                backgroundColor: Qt.hsla(((index + root.frame) % 200) / 200, 0.5, 0.5, 1.0)
+                backgroundMode: index % 2 ? UbuntuShape.VerticalGradient : UbuntuShape.SolidColor
+                secondaryBackgroundColor: "white"
+            }
+        }
+    }
+}
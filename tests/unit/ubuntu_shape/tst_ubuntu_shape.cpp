@@ -16,9 +16,39 @@
  * Author: Florian Boucault <florian.boucault@canonical.com>
  */
 
+#include <QtCore/QMutex>
+#include <QtCore/QRegularExpression>
+#include <QtQml/QQmlContext>
 #include <QtQml/QQmlEngine>
+#include <QtQuick/QQuickItem>
 #include <QtQuick/QQuickView>
 #include <QtTest/QtTest>
+#include <UbuntuToolkit/private/ucubuntushapetexturecache_p.h>
+#include <UbuntuToolkit/private/ucubuntushapetextures_p.h>
+
+UT_USE_NAMESPACE
+
+// The Qt Quick batch renderer logs its batches when QSG_RENDERER_DEBUG contains "render", the
+// message handler below extracts the alpha batch counts (untextured shapes are blended).
+static QMutex alphaBatchesMutex;
+static int alphaNodes = -1;
+static int alphaBatches = -1;
+static QtMessageHandler previousMessageHandler = 0;
+
+static void batchesMessageHandler(
+    QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    static const QRegularExpression alpha(
+        QStringLiteral("Alpha: (\\d+) nodes in (\\d+) batches"));
+    const QRegularExpressionMatch match = alpha.match(message);
+    if (match.hasMatch()) {
+        QMutexLocker locker(&alphaBatchesMutex);
+        alphaNodes = match.captured(1).toInt();
+        alphaBatches = match.captured(2).toInt();
+    } else if (previousMessageHandler) {
+        previousMessageHandler(type, context, message);
+    }
+}
 
 class tst_UbuntuShape: public QObject
 {
@@ -27,20 +57,28 @@ class tst_UbuntuShape: public QObject
 private:
     QQuickView *m_quickView;
 
+    void addImportPath(QQmlEngine *engine)
+    {
+        // add modules folder so we have access to the plugin from QML
+        QString modules(UBUNTU_QML_IMPORT_PATH);
+        QStringList imports = engine->importPathList();
+        imports.prepend(QDir(modules).absolutePath());
+        engine->setImportPathList(imports);
+    }
+
 private Q_SLOTS:
 
     void initTestCase()
     {
+        // Must be set before the first frame is rendered.
+        qputenv("QSG_RENDERER_DEBUG", "render");
+        previousMessageHandler = qInstallMessageHandler(batchesMessageHandler);
+
         m_quickView = new QQuickView;
         m_quickView->setGeometry(0, 0, 900, 500);
         m_quickView->show();
 
-        // add modules folder so we have access to the plugin from QML
-        QQmlEngine *engine = m_quickView->engine();
-        QString modules(UBUNTU_QML_IMPORT_PATH);
-        QStringList imports = engine->importPathList();
-        imports.prepend(QDir(modules).absolutePath());
-        engine->setImportPathList(imports);
+        addImportPath(m_quickView->engine());
     }
 
     void noDistortion() {
@@ -56,6 +94,103 @@ private Q_SLOTS:
 
         QCOMPARE(result, expected);
     }
+
+    // Untextured shapes with different sizes, radii, aspects and colors must be merged in a single
+    // draw call by the batch renderer. Run on the offscreen platform (or any llvmpipe backed
+    // display) to get comparable frame times.
+    void benchmarkBatching() {
+        m_quickView->setSource(QUrl::fromLocalFile("batching.qml"));
+        QQuickItem* root = m_quickView->rootObject();
+        QVERIFY(root);
+        QVERIFY(!m_quickView->grabWindow().isNull());
+
+        {
+            QMutexLocker locker(&alphaBatchesMutex);
+            if (alphaBatches == -1) {
+                QSKIP("The scene graph renderer doesn't report its batches.");
+            }
+            qDebug() << "Alpha batches:" << alphaBatches << "for" << alphaNodes << "nodes";
+            QCOMPARE(alphaNodes, 200);
+            QVERIFY2(alphaBatches <= 2, "Untextured shapes aren't merged.");
+        }
+
+        // Update the colors of all the shapes at every frame.
+        int frame = 0;
+        QBENCHMARK {
+            root->setProperty("frame", ++frame);
+            m_quickView->grabWindow();
+        }
+    }
+
+    // The runtime generator must give the same contours as the baked textures, which were
+    // generated with EDTAA3 by the createshapetextures tool.
+    void generatedTextures_data() {
+        QTest::addColumn<int>("index");
+        QTest::addColumn<QVector<int> >("distanceChannels");
+        QTest::newRow("flat and inset") << 0 << (QVector<int>() << 2 << 3);
+        QTest::newRow("drop shadow") << 1 << (QVector<int>() << 0 << 1);
+    }
+    void generatedTextures() {
+        QFETCH(int, index);
+        QFETCH(QVector<int>, distanceChannels);
+
+        const QByteArray data = ShapeTextureCache::generate(index, shapeTextureWidth);
+        QCOMPARE(data.size(), shapeTextureWidth * shapeTextureHeight * 4);
+        const uchar* generated = reinterpret_cast<const uchar*>(data.constData());
+        const uchar* baked = shapeTextureData[index];
+
+        Q_FOREACH(int channel, distanceChannels) {
+            int matching = 0;
+            for (int i = 0; i < shapeTextureWidth * shapeTextureHeight; i++) {
+                if ((generated[i * 4 + channel] > 127) == (baked[i * 4 + channel] > 127)) {
+                    matching++;
+                }
+            }
+            QVERIFY2(matching >= shapeTextureWidth * shapeTextureHeight * 97 / 100,
+                     qPrintable(QStringLiteral("Contour mismatch in channel %1").arg(channel)));
+        }
+    }
+
+    void benchmarkGeneration_data() {
+        QTest::addColumn<int>("size");
+        QTest::newRow("64") << 64;
+        QTest::newRow("128") << 128;
+    }
+    void benchmarkGeneration() {
+        QFETCH(int, size);
+
+        QBENCHMARK {
+            QVERIFY(!ShapeTextureCache::generate(0, size).isEmpty());
+            QVERIFY(!ShapeTextureCache::generate(1, size).isEmpty());
+        }
+    }
+
+    // Shape textures are uploaded the first time a shape with the matching aspect is rendered,
+    // every iteration creates a new window (and so a new graphics context with the threaded render
+    // loop) and renders its first frame. Comparing the rows gives the upload time saved by
+    // applications not using DropShadow.
+    void benchmarkFirstFrame_data() {
+        QTest::addColumn<QVariantList>("aspects");
+        QTest::newRow("flat") << (QVariantList() << 0);
+        QTest::newRow("inset") << (QVariantList() << 1);
+        QTest::newRow("dropShadow") << (QVariantList() << 2);
+        QTest::newRow("all") << (QVariantList() << 0 << 1 << 2);
+    }
+    void benchmarkFirstFrame() {
+        QFETCH(QVariantList, aspects);
+
+        QBENCHMARK {
+            QQuickView view;
+            addImportPath(view.engine());
+            view.rootContext()->setContextProperty(QStringLiteral("shapeAspects"), aspects);
+            view.setSource(QUrl::fromLocalFile("first_frame.qml"));
+            QVERIFY(view.rootObject());
+            view.setGeometry(0, 0, 200, 100);
+            view.show();
+            QVERIFY(QTest::qWaitForWindowExposed(&view));
+            QVERIFY(!view.grabWindow().isNull());
+        }
+    }
 };
 
 QTEST_MAIN(tst_UbuntuShape)
@@ -1,5 +1,7 @@
 include(../test-include-x11.pri)
 SOURCES += tst_ubuntu_shape.cpp
 OTHER_FILES += no_distortion.qml \
+               batching.qml \
+               first_frame.qml \
                no_distortion_source.png \
                no_distortion_expected.png
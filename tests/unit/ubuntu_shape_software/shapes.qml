@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.4
+import Ubuntu.Components 1.3
+import Ubuntu.Components.Private 1.3
+
+// Flat shapes on a white background, the sourceUrl context property is a blue image.
+Rectangle {
+    width: 400
+    height: 100
+    color: "white"
+
+    property alias shapeColor: shape.backgroundColor
+
+    UbuntuShape {
+        id: shape
+        objectName: "shape"
+        x: 0
+        width: 80
+        height: 80
+        aspect: UbuntuShape.Flat
+        backgroundColor: "red"
+    }
+
+    UbuntuShape {
+        objectName: "sameShape"
+        x: 100
+        width: 80
+        height: 80
+        aspect: UbuntuShape.Flat
+        backgroundColor: "red"
+    }
+
+    UbuntuShapeOverlay {
+        objectName: "overlay"
+        x: 200
+        width: 80
+        height: 80
+        aspect: UbuntuShape.Flat
+        backgroundColor: "red"
+        overlayColor: "lime"
+        overlayRect: Qt.rect(0.5, 0.0, 0.5, 1.0)
+    }
+
+    UbuntuShape {
+        objectName: "source"
+        x: 300
+        width: 80
+        height: 80
+        aspect: UbuntuShape.Flat
+        source: Image { source: sourceUrl }
+    }
+
+    Frame {
+        x: 0
+        y: 85
+        width: 380
+        height: 15
+        thickness: 2
+        radius: 2
+        color: "black"
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 Canonical Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtCore/QTemporaryDir>
+#include <QtQml/QQmlContext>
+#include <QtQml/QQmlEngine>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QQuickView>
+#include <QtQuick/QSGRendererInterface>
+#include <QtTest/QtTest>
+
+// Renders the shapes with the software scene graph backend, which can't run their shaders.
+class tst_UbuntuShapeSoftware: public QObject
+{
+    Q_OBJECT
+
+private:
+    QQuickView *m_quickView;
+    QTemporaryDir m_dir;
+
+    static bool fuzzyCompare(QRgb pixel, QRgb expected)
+    {
+        return qAbs(qRed(pixel) - qRed(expected)) <= 2
+            && qAbs(qGreen(pixel) - qGreen(expected)) <= 2
+            && qAbs(qBlue(pixel) - qBlue(expected)) <= 2;
+    }
+
+    // Pixel of the grabbed window at the given offset from the top left corner of an item.
+    QRgb pixel(const QImage &image, const char *objectName, int x, int y)
+    {
+        QQuickItem *item = m_quickView->rootObject()->findChild<QQuickItem*>(objectName);
+        if (!item) {
+            return 0;
+        }
+        const qreal dpr = m_quickView->effectiveDevicePixelRatio();
+        return image.pixel(qRound((item->x() + x) * dpr), qRound((item->y() + y) * dpr));
+    }
+
+private Q_SLOTS:
+
+    void initTestCase()
+    {
+        // Must be set before the first window is created.
+        qputenv("QT_QUICK_BACKEND", "software");
+        QVERIFY(m_dir.isValid());
+
+        const QString sourcePath = m_dir.path() + QStringLiteral("/source.png");
+        QImage source(16, 16, QImage::Format_ARGB32);
+        source.fill(Qt::blue);
+        QVERIFY(source.save(sourcePath));
+
+        m_quickView = new QQuickView;
+        QQmlEngine *engine = m_quickView->engine();
+        QStringList imports = engine->importPathList();
+        imports.prepend(QDir(QStringLiteral(UBUNTU_QML_IMPORT_PATH)).absolutePath());
+        engine->setImportPathList(imports);
+        m_quickView->rootContext()->setContextProperty(
+            QStringLiteral("sourceUrl"), QUrl::fromLocalFile(sourcePath));
+        m_quickView->setSource(QUrl::fromLocalFile(QStringLiteral("shapes.qml")));
+        QVERIFY(m_quickView->rootObject());
+        m_quickView->show();
+        QVERIFY(QTest::qWaitForWindowExposed(m_quickView));
+        QCOMPARE(m_quickView->rendererInterface()->graphicsApi(), QSGRendererInterface::Software);
+    }
+
+    void cleanupTestCase()
+    {
+        delete m_quickView;
+    }
+
+    void shapes()
+    {
+        const QImage image = m_quickView->grabWindow();
+        QVERIFY(!image.isNull());
+
+        // the corners are cut by the radius
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 40, 40), qRgb(255, 0, 0)));
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 0, 0), qRgb(255, 255, 255)));
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 79, 79), qRgb(255, 255, 255)));
+
+        // shapes with the same content are drawn the same way
+        for (int y = 0; y < 80; y += 4) {
+            for (int x = 0; x < 80; x += 4) {
+                QCOMPARE(pixel(image, "sameShape", x, y), pixel(image, "shape", x, y));
+            }
+        }
+
+        QVERIFY(fuzzyCompare(pixel(image, "overlay", 20, 40), qRgb(255, 0, 0)));
+        QVERIFY(fuzzyCompare(pixel(image, "overlay", 60, 40), qRgb(0, 255, 0)));
+
+        QVERIFY(fuzzyCompare(pixel(image, "source", 40, 40), qRgb(0, 0, 255)));
+        QVERIFY(fuzzyCompare(pixel(image, "source", 0, 0), qRgb(255, 255, 255)));
+
+        // the frame outlines its rectangle
+        const qreal dpr = m_quickView->effectiveDevicePixelRatio();
+        QVERIFY(fuzzyCompare(image.pixel(qRound(190 * dpr), qRound(86 * dpr)), qRgb(0, 0, 0)));
+        QVERIFY(fuzzyCompare(image.pixel(qRound(190 * dpr), qRound(92 * dpr)),
+                             qRgb(255, 255, 255)));
+    }
+
+    // The shaded images are cached by content, a change must give a new image.
+    void update()
+    {
+        QQuickItem *root = m_quickView->rootObject();
+        root->setProperty("shapeColor", QColor(Qt::yellow));
+        QImage image = m_quickView->grabWindow();
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 40, 40), qRgb(255, 255, 0)));
+        QVERIFY(fuzzyCompare(pixel(image, "sameShape", 40, 40), qRgb(255, 0, 0)));
+
+        root->setProperty("shapeColor", QColor(Qt::red));
+        image = m_quickView->grabWindow();
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 40, 40), qRgb(255, 0, 0)));
+
+        QQuickItem *shape = root->findChild<QQuickItem*>("shape");
+        QVERIFY(shape);
+        shape->setSize(QSizeF(60, 60));
+        image = m_quickView->grabWindow();
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 30, 30), qRgb(255, 0, 0)));
+        QVERIFY(fuzzyCompare(pixel(image, "shape", 70, 70), qRgb(255, 255, 255)));
+    }
+};
+
+QTEST_MAIN(tst_UbuntuShapeSoftware)
+
+#include "tst_ubuntu_shape_software.moc"
@@ -11,12 +11,14 @@ SUBDIRS += testparser
 #######################################
 #!contains(QMAKE_HOST.arch,armv7l) {
     SUBDIRS += components \
-        components_benchmark
+        components_benchmark \
+        listitem_benchmark
 #}
 
 SUBDIRS += \
     visual \
     ubuntu_shape \
+    ubuntu_shape_software \
     page \
     test \
     iconprovider \
@@ -31,6 +33,7 @@ SUBDIRS += \
     serviceproperties \
     subtheming \
     swipearea \
+    gesturereplay \
     touchregistry \
     bottomedge \
     asyncloader \
@@ -48,4 +51,9 @@ SUBDIRS += \
     alarms \
     theme \
     quickutils \
-    tree
+    tree \
+    livetimer \
+    performancemonitor \
+    tracedecoder \
+    histogram \
+    listitems
@@ -16,7 +16,11 @@
  * Author: Florian Boucault <florian.boucault@canonical.com>
  */
 
+#include <QtQml/QQmlComponent>
+#include <QtQml/QQmlContext>
+#include <QtQml/QQmlEngine>
 #include <QtTest/QtTest>
+#include <UbuntuToolkit/private/listener_p.h>
 #include <UbuntuToolkit/private/ucunits_p.h>
 
 UT_USE_NAMESPACE
@@ -282,6 +286,71 @@ private Q_SLOTS:
         expected = QString("0.875/" + QDir::currentPath() + QDir::separator() + "resource@8.png");
         QCOMPARE(resolved, expected);
     }
+
+    void resolveCachedUntilGridUnitChanges() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QVERIFY(QFile::copy("resource@10.png", dir.path() + "/asset@10.png"));
+        QVERIFY(QFile::copy("resource@15.png", dir.path() + "/asset@15.png"));
+        UCUnits units;
+        QString resolved;
+        QString expected;
+
+        units.setGridUnit(12);
+        resolved = units.resolveResource(QUrl::fromLocalFile(dir.path() + "/asset.png"));
+        expected = QString("0.8/" + dir.path() + "/asset@15.png");
+        QCOMPARE(resolved, expected);
+
+        // the resolution is cached, the disk is not hit anymore
+        // (wait so that the directory modification time changes)
+        QTest::qSleep(10);
+        QVERIFY(QFile::remove(dir.path() + "/asset@15.png"));
+        resolved = units.resolveResource(QUrl::fromLocalFile(dir.path() + "/asset.png"));
+        QCOMPARE(resolved, expected);
+
+        // grid unit changes drop the resolved resources, the modified directory is listed again
+        units.setGridUnit(14);
+        resolved = units.resolveResource(QUrl::fromLocalFile(dir.path() + "/asset.png"));
+        expected = QString("1.4/" + dir.path() + "/asset@10.png");
+        QCOMPARE(resolved, expected);
+
+        // assets added at runtime are found
+        QTest::qSleep(10);
+        QVERIFY(QFile::copy("resource@15.png", dir.path() + "/asset@14.png"));
+        units.setGridUnit(13);
+        resolved = units.resolveResource(QUrl::fromLocalFile(dir.path() + "/asset.png"));
+        expected = QString(QString::number(13.0f / 14.0f) + "/" + dir.path() + "/asset@14.png");
+        QCOMPARE(resolved, expected);
+
+        // clearing the cache lists the directory again
+        units.clearResourceCache();
+        resolved = units.resolveResource(QUrl::fromLocalFile(dir.path() + "/asset.png"));
+        QCOMPARE(resolved, expected);
+    }
+
+    // bindings calling dp() and gu() follow the grid unit, the context property isn't set again
+    void bindingsFollowGridUnit() {
+        QQmlEngine engine;
+        UCUnits units;
+        BindingNotifier::registerEngine(&engine);
+        engine.rootContext()->setContextProperty("units", &units);
+        QQmlComponent component(&engine);
+        component.setData("import QtQuick 2.4\n"
+                          "QtObject {\n"
+                          "    property real size: units.gu(2)\n"
+                          "    property real line: units.dp(3)\n"
+                          "}", QUrl());
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY2(object, qPrintable(component.errorString()));
+        QCOMPARE(object->property("size").toFloat(), 16.0f);
+
+        units.setGridUnit(10);
+        QCOMPARE(object->property("size").toFloat(), 20.0f);
+        QCOMPARE(object->property("line").toFloat(), units.dp(3));
+        units.setGridUnit(16);
+        QCOMPARE(object->property("size").toFloat(), 32.0f);
+        QCOMPARE(object->property("line").toFloat(), 6.0f);
+    }
 };
 
 QTEST_MAIN(tst_UCUnits)